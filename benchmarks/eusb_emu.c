@@ -0,0 +1,408 @@
+/**
+ * @file eusb_emu.c
+ *
+ * E-USB drive emulator. One or more virtual drives (multi-drop) are served
+ * on a pseudo-terminal, speaking the E-USB binary protocol byte-for-byte, so
+ * that the full serial stack (sercomm, listener) can be benchmarked and
+ * stress-tested without hardware. The ASCII binary mode switch message is
+ * accepted (discarded as non-frame data).
+ *
+ * Usage:
+ *	eusb_emu [-n ids] [-b baudrate] [-l latency] [-j jitter] [-g garbage]
+ *		 [-x drop] [-d dictionary]
+ *
+ *	-n: Comma separated node ids (default: 1).
+ *	-b: Baudrate to throttle to (default: 0, unthrottled).
+ *	-l: Response latency, us (default: 0).
+ *	-j: Response latency jitter, us (default: 0).
+ *	-g: Per-mille of frames preceded by random garbage (default: 0).
+ *	-x: Per-mille of frames dropped (default: 0).
+ *	-d: Dictionary used to seed the register map.
+ *
+ * The pseudo-terminal path is printed on startup.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "public/ingenialink/err.h"
+#include "ingenialink/eusb/vdrive.h"
+#include "ingenialink/utils.h"
+#include "osal/osal.h"
+
+/** Maximum number of drives. */
+#define DRIVES_MAX	32
+
+/** Output buffer size (must be a power of 2). */
+#define OBUF_SZ		65536U
+
+/** Maximum transfer chunk (bytes). */
+#define CHUNK_SZ	64U
+
+/** Maximum garbage burst (bytes). */
+#define GARBAGE_MAX	16U
+
+/** Emulator. */
+typedef struct {
+	/** Pseudo-terminal master. */
+	int master;
+	/** Pseudo-terminal slave (kept open). */
+	int slave;
+	/** Baudrate (0 if unthrottled). */
+	int baudrate;
+	/** Garbage per-mille. */
+	int garbage;
+	/** Dropped frames per-mille. */
+	int drop;
+	/** Random seed. */
+	uint32_t seed;
+	/** Output buffer. */
+	uint8_t obuf[OBUF_SZ];
+	/** Output buffer head. */
+	size_t head;
+	/** Output buffer tail. */
+	size_t tail;
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** Output available condition variable. */
+	osal_cond_t *avail;
+	/** Stop flag. */
+	int stop;
+} emu_t;
+
+/** Emulator instance. */
+static emu_t emu;
+
+/** Stop request (signals). */
+static volatile sig_atomic_t stop;
+
+/**
+ * Obtain a pseudo-random number.
+ */
+static uint32_t rnd(void)
+{
+	return il_utils__rnd(&emu.seed);
+}
+
+/**
+ * Obtain current (monotonic) time in microseconds.
+ */
+static long long now_us(void)
+{
+	osal_timespec_t ts;
+
+	(void)osal_clock_gettime(&ts);
+
+	return (long long)ts.s * 1000000 + ts.ns / OSAL_CLOCK_NANOSPERUSEC;
+}
+
+/**
+ * Throttle a transfer to the configured baudrate.
+ *
+ * @param [in, out] t
+ *	Line available time (us).
+ * @param [in] sz
+ *	Transfer size.
+ */
+static void throttle(long long *t, size_t sz)
+{
+	long long now;
+
+	if (emu.baudrate <= 0)
+		return;
+
+	/* 10 bits per byte (start, 8 data, stop) */
+	now = now_us();
+	if (*t < now)
+		*t = now;
+
+	*t += (long long)sz * 10 * 1000000 / emu.baudrate;
+
+	if (*t > now)
+		osal_clock_sleep_us((int)(*t - now));
+}
+
+/**
+ * Append bytes to the output buffer.
+ *
+ * @note
+ *	Lock must be held. Bytes are dropped on overflow.
+ */
+static void obuf_put(const uint8_t *buf, size_t sz)
+{
+	size_t i;
+
+	for (i = 0; i < sz; i++) {
+		if (CIRC_SPACE(emu.head, emu.tail, OBUF_SZ) == 0)
+			break;
+
+		emu.obuf[emu.head] = buf[i];
+		emu.head = (emu.head + 1) & (OBUF_SZ - 1);
+	}
+}
+
+/**
+ * Virtual drive transmission callback.
+ */
+static void on_tx(void *ctx, const uint8_t *buf, size_t sz)
+{
+	(void)ctx;
+
+	osal_mutex_lock(emu.lock);
+
+	if (emu.drop > 0 && (rnd() % 1000) < (uint32_t)emu.drop)
+		goto unlock;
+
+	if (emu.garbage > 0 && (rnd() % 1000) < (uint32_t)emu.garbage) {
+		uint8_t garbage[GARBAGE_MAX];
+		size_t i, n;
+
+		n = 1 + rnd() % GARBAGE_MAX;
+		for (i = 0; i < n; i++)
+			garbage[i] = (uint8_t)rnd();
+
+		obuf_put(garbage, n);
+	}
+
+	obuf_put(buf, sz);
+
+	osal_cond_signal(emu.avail);
+
+unlock:
+	osal_mutex_unlock(emu.lock);
+}
+
+/**
+ * Writer thread (output buffer to the line).
+ */
+static int writer(void *args)
+{
+	long long t = 0;
+
+	(void)args;
+
+	osal_mutex_lock(emu.lock);
+
+	while (!emu.stop) {
+		uint8_t chunk[CHUNK_SZ];
+		size_t n = 0, sent = 0;
+
+		if (emu.head == emu.tail) {
+			(void)osal_cond_wait(emu.avail, emu.lock, 100);
+			continue;
+		}
+
+		while ((n < sizeof(chunk)) && (emu.tail != emu.head)) {
+			chunk[n++] = emu.obuf[emu.tail];
+			emu.tail = (emu.tail + 1) & (OBUF_SZ - 1);
+		}
+
+		osal_mutex_unlock(emu.lock);
+
+		while (sent < n) {
+			ssize_t r;
+
+			r = write(emu.master, &chunk[sent], n - sent);
+			if (r < 0) {
+				if (errno != EINTR && errno != EAGAIN)
+					break;
+				continue;
+			}
+
+			sent += (size_t)r;
+		}
+
+		throttle(&t, n);
+
+		osal_mutex_lock(emu.lock);
+	}
+
+	osal_mutex_unlock(emu.lock);
+
+	return 0;
+}
+
+/**
+ * Signal handler.
+ */
+static void on_signal(int sig)
+{
+	(void)sig;
+
+	stop = 1;
+}
+
+/**
+ * Open the pseudo-terminal.
+ *
+ * @return
+ *	0 on success, -1 otherwise.
+ */
+static int pty_open(void)
+{
+	struct termios tio;
+
+	emu.master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (emu.master < 0)
+		return -1;
+
+	if (grantpt(emu.master) < 0 || unlockpt(emu.master) < 0)
+		goto close_master;
+
+	/* keep the slave open, so that the line survives client reconnects */
+	emu.slave = open(ptsname(emu.master), O_RDWR | O_NOCTTY);
+	if (emu.slave < 0)
+		goto close_master;
+
+	if (tcgetattr(emu.slave, &tio) < 0)
+		goto close_slave;
+
+	cfmakeraw(&tio);
+	if (tcsetattr(emu.slave, TCSANOW, &tio) < 0)
+		goto close_slave;
+
+	return 0;
+
+close_slave:
+	close(emu.slave);
+
+close_master:
+	close(emu.master);
+
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	int r = 0, opt;
+	char *ids = "1", *tok;
+	il_net_virtual_opts_t vopts = { NULL, 0, 0 };
+	il_eusb_vdrive_t *drives[DRIVES_MAX];
+	size_t drives_cnt = 0, i;
+	osal_thread_t *writer_td;
+	long long t = 0;
+
+	while ((opt = getopt(argc, argv, "n:b:l:j:g:x:d:")) != -1) {
+		switch (opt) {
+		case 'n':
+			ids = optarg;
+			break;
+		case 'b':
+			emu.baudrate = atoi(optarg);
+			break;
+		case 'l':
+			vopts.latency = atoi(optarg);
+			break;
+		case 'j':
+			vopts.jitter = atoi(optarg);
+			break;
+		case 'g':
+			emu.garbage = atoi(optarg);
+			break;
+		case 'x':
+			emu.drop = atoi(optarg);
+			break;
+		case 'd':
+			vopts.dict = optarg;
+			break;
+		default:
+			fprintf(stderr,
+				"Usage: %s [-n ids] [-b baudrate] [-l latency] "
+				"[-j jitter] [-g garbage] [-x drop] "
+				"[-d dictionary]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	emu.seed = 2463534242U;
+
+	emu.lock = osal_mutex_create();
+	emu.avail = osal_cond_create();
+	if (!emu.lock || !emu.avail) {
+		fprintf(stderr, "Could not allocate resources\n");
+		return 1;
+	}
+
+	if (pty_open() < 0) {
+		fprintf(stderr, "Could not open pseudo-terminal: %s\n",
+			strerror(errno));
+		return 1;
+	}
+
+	/* create drives */
+	for (tok = strtok(ids, ","); tok && drives_cnt < DRIVES_MAX;
+	     tok = strtok(NULL, ",")) {
+		drives[drives_cnt] = il_eusb_vdrive__create(
+			(uint8_t)strtoul(tok, NULL, 0), &vopts, on_tx, NULL);
+		if (!drives[drives_cnt]) {
+			fprintf(stderr, "Could not create drive: %s\n",
+				ilerr_last());
+			r = 1;
+			goto cleanup_drives;
+		}
+
+		drives_cnt++;
+	}
+
+	writer_td = osal_thread_create(writer, NULL);
+	if (!writer_td) {
+		fprintf(stderr, "Could not create writer thread\n");
+		r = 1;
+		goto cleanup_drives;
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	printf("%s\n", ptsname(emu.master));
+	fflush(stdout);
+
+	/* reader: line to all drives (multi-drop) */
+	while (!stop) {
+		struct pollfd pfd = { emu.master, POLLIN, 0 };
+		uint8_t chunk[CHUNK_SZ];
+		ssize_t n;
+
+		if (poll(&pfd, 1, 100) <= 0)
+			continue;
+
+		n = read(emu.master, chunk, sizeof(chunk));
+		if (n <= 0)
+			continue;
+
+		throttle(&t, (size_t)n);
+
+		for (i = 0; i < drives_cnt; i++)
+			(void)il_eusb_vdrive__write(drives[i], chunk,
+						    (size_t)n);
+	}
+
+	osal_mutex_lock(emu.lock);
+	emu.stop = 1;
+	osal_cond_signal(emu.avail);
+	osal_mutex_unlock(emu.lock);
+
+	osal_thread_join(writer_td, NULL);
+
+cleanup_drives:
+	for (i = 0; i < drives_cnt; i++)
+		il_eusb_vdrive__destroy(drives[i]);
+
+	close(emu.slave);
+	close(emu.master);
+
+	osal_cond_destroy(emu.avail);
+	osal_mutex_destroy(emu.lock);
+
+	return r;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file eusb_frame.c
+ *
+ * E-USB frame decoder benchmark: compares the byte-at-a-time state machine
+ * (il_eusb_frame__push) with the in-place scanner (il_eusb_frame__find) on
+ * clean and corrupted streams.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ingenialink/eusb/frame.h"
+#include "ingenialink/utils.h"
+
+/** Stream size (bytes). */
+#define STREAM_SZ	(4U * 1024U * 1024U)
+
+/** Reception chunk size (bytes). */
+#define CHUNK_SZ	512U
+
+/** Number of benchmark runs. */
+#define RUNS		10
+
+/** Stream buffer. */
+static uint8_t stream[STREAM_SZ];
+
+/** Pseudo-random number generator seed. */
+static uint32_t seed = 2463534242U;
+
+/**
+ * Obtain a pseudo-random number.
+ */
+static uint32_t rnd(void)
+{
+	return il_utils__rnd(&seed);
+}
+
+/**
+ * Fill the stream with response frames.
+ *
+ * @param [in] corrupt
+ *	Per-mille of frames that are corrupted or preceded by garbage.
+ */
+static void stream_fill(unsigned int corrupt)
+{
+	size_t sz = 0;
+
+	for (;;) {
+		il_eusb_frame_t frame;
+		uint8_t data[IL_EUSB_FRAME_MAX_DATA_SZ];
+		size_t data_sz, i;
+
+		data_sz = rnd() % (IL_EUSB_FRAME_MAX_DATA_SZ + 1);
+		for (i = 0; i < data_sz; i++)
+			data[i] = (uint8_t)rnd();
+
+		(void)il_eusb_frame__init(&frame, (uint8_t)(1 + rnd() % 8),
+					  0x6000 + rnd() % 0x100, data,
+					  data_sz);
+
+		if (sz + frame.sz + 16 > sizeof(stream))
+			break;
+
+		if ((rnd() % 1000) < corrupt) {
+			if (rnd() & 1) {
+				/* garbage burst before the frame */
+				size_t n = 1 + rnd() % 16;
+
+				for (i = 0; i < n; i++)
+					stream[sz++] = (uint8_t)rnd();
+			} else {
+				/* flip one byte of the frame */
+				frame.buf[rnd() % frame.sz] ^= 0xFF;
+			}
+		}
+
+		memcpy(&stream[sz], frame.buf, frame.sz);
+		sz += frame.sz;
+	}
+
+	/* pad with zeros (never a valid header) */
+	memset(&stream[sz], 0, sizeof(stream) - sz);
+}
+
+/**
+ * Decode using the byte-at-a-time state machine.
+ */
+static size_t decode_push(void)
+{
+	il_eusb_frame_t frame = IL_EUSB_FRAME_INIT_DEF;
+	size_t i, frames = 0;
+
+	for (i = 0; i < sizeof(stream); i++) {
+		if (il_eusb_frame__push(&frame, stream[i]) < 0) {
+			il_eusb_frame__reset(&frame);
+			(void)il_eusb_frame__push(&frame, stream[i]);
+			continue;
+		}
+
+		if (frame.state == IL_EUSB_FRAME_STATE_COMPLETE) {
+			frames++;
+			il_eusb_frame__reset(&frame);
+		}
+	}
+
+	return frames;
+}
+
+/**
+ * Decode using the in-place scanner, as the listener does (chunked
+ * reception, unprocessed tail moved to the front).
+ */
+static size_t decode_find(void)
+{
+	uint8_t rbuf[CHUNK_SZ + IL_EUSB_FRAME_MAX_SZ];
+	size_t pos = 0, cnt = 0, frames = 0;
+
+	while (pos < sizeof(stream)) {
+		size_t n, used = 0;
+
+		n = sizeof(rbuf) - cnt;
+		if (n > sizeof(stream) - pos)
+			n = sizeof(stream) - pos;
+
+		memcpy(&rbuf[cnt], &stream[pos], n);
+		pos += n;
+		cnt += n;
+
+		for (;;) {
+			size_t start, sz;
+
+			sz = il_eusb_frame__find(&rbuf[used], cnt - used,
+						 &start);
+			used += start;
+			if (sz == 0)
+				break;
+
+			frames++;
+			used += sz;
+		}
+
+		cnt -= used;
+		memmove(rbuf, &rbuf[used], cnt);
+	}
+
+	return frames;
+}
+
+/**
+ * Run a decoder benchmark.
+ */
+static void run(const char *name, size_t (*decode)(void))
+{
+	clock_t start, end;
+	double elapsed;
+	size_t frames = 0;
+	int i;
+
+	start = clock();
+	for (i = 0; i < RUNS; i++)
+		frames = decode();
+	end = clock();
+
+	elapsed = (double)(end - start) / CLOCKS_PER_SEC;
+
+	printf("  %-6s %8.1f MB/s  (%zu frames)\n", name,
+	       (double)sizeof(stream) * RUNS / elapsed / 1e6, frames);
+}
+
+int main(void)
+{
+	static const unsigned int corrupt[] = { 0, 10, 100, 500 };
+	size_t i;
+
+	for (i = 0; i < sizeof(corrupt) / sizeof(corrupt[0]); i++) {
+		stream_fill(corrupt[i]);
+
+		printf("Corrupted frames: %.1f %%\n", corrupt[i] / 10.);
+		run("push", decode_push);
+		run("find", decode_find);
+	}
+
+	return 0;
+}
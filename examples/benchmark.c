@@ -50,9 +50,8 @@ static int run(int loops, il_net_prot_t prot, const char *port, uint8_t id)
 	double elapsed;
 
 	/* create network */
+	il_net_opts_init(&opts);
 	opts.port = port;
-	opts.timeout_rd = IL_NET_TIMEOUT_RD_DEF;
-	opts.timeout_wr = IL_NET_TIMEOUT_WR_DEF;
 
 	/*net = il_net_eusb_create(&opts);*/
 	net = il_net_create(prot, &opts);
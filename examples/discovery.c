@@ -0,0 +1,53 @@
+/**
+ * @example discovery.c
+ *
+ * This example discovers all servos on every network device at once.
+ */
+
+#include "utils.h"
+
+#include <stdio.h>
+
+/**
+ * Node found callback.
+ */
+static void on_found(void *ctx, const char *port, uint8_t id)
+{
+	(void)ctx;
+
+	printf("Found node 0x%02x on %s\n", id, port);
+}
+
+int main(int argc, const char *argv[])
+{
+	il_net_prot_t prot;
+	il_net_discovery_list_t *nodes, *node;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: ./discovery PROT\n");
+		return -1;
+	}
+
+	prot = str2prot(argv[1]);
+
+	printf("Discovering...\n");
+
+	nodes = il_net_discovery_list_get(prot, on_found, NULL);
+	if (!nodes) {
+		fprintf(stderr, "No nodes found: %s\n", ilerr_last());
+		return 1;
+	}
+
+	il_net_discovery_list_foreach(node, nodes) {
+		printf("-------------------------------------------\n");
+		printf("%s, 0x%02x\n", node->port, node->id);
+		printf("\tSerial number: %u\n", node->serial);
+		printf("\tProduct code: 0x%08x\n", node->prod_code);
+	}
+
+	printf("-------------------------------------------\n");
+
+	il_net_discovery_list_destroy(nodes);
+
+	return 0;
+}
@@ -27,9 +27,8 @@ int main(int argc, const char *argv[])
 		il_net_opts_t opts;
 
 		/* create network */
+		il_net_opts_init(&opts);
 		opts.port = dev->port;
-		opts.timeout_rd = IL_NET_TIMEOUT_RD_DEF;
-		opts.timeout_wr = IL_NET_TIMEOUT_WR_DEF;
 
 		/*net = il_net_eusb_create(&opts);*/
 		net = il_net_create(prot, &opts);
@@ -49,9 +49,8 @@ static int run(const char *port, uint8_t id, const char *log_fname)
 	};
 
 	/* create network */
+	il_net_opts_init(&opts);
 	opts.port = port;
-	opts.timeout_rd = IL_NET_TIMEOUT_RD_DEF;
-	opts.timeout_wr = IL_NET_TIMEOUT_WR_DEF;
 
 	net = il_net_create(IL_NET_PROT_EUSB, &opts);
 	if (!net) {
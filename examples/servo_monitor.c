@@ -27,9 +27,8 @@ void on_evt(void *ctx, il_net_dev_evt_t evt, const char *port)
 		printf("Plugged device %s\n", port);
 
 		/* create network */
+		il_net_opts_init(&opts);
 		opts.port = port;
-		opts.timeout_rd = IL_NET_TIMEOUT_RD_DEF;
-		opts.timeout_wr = IL_NET_TIMEOUT_WR_DEF;
 
 		net = il_net_create(*prot, &opts);
 		if (!net)
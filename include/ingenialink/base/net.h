@@ -25,10 +25,30 @@
 #ifndef INGENIALINK_BASE_NET_H_
 #define INGENIALINK_BASE_NET_H_
 
-#include "public/ingenialink/net.h"
+#include "ingenialink/net.h"
 
 void il_net_base__state_set(il_net_t *net, il_net_state_t state);
 
+int il_net_base__read_async(il_net_t *net, uint16_t id, uint32_t address,
+			    size_t sz, il_net_async_cb_t cb, void *ctx,
+			    il_net_prio_t prio);
+
+int il_net_base__write_async(il_net_t *net, uint16_t id, uint32_t address,
+			     const void *buf, size_t sz, int confirmed,
+			     il_net_async_cb_t cb, void *ctx,
+			     il_net_prio_t prio);
+
+int il_net_base__transfer_batch(il_net_t *net, il_net_xfer_t *xfers,
+				size_t cnt, il_net_prio_t prio);
+
+int il_net_base__read_segmented(il_net_t *net, uint16_t id, uint32_t address,
+				void *buf, size_t sz, il_net_progress_cb_t cb,
+				void *ctx);
+
+int il_net_base__write_segmented(il_net_t *net, uint16_t id, uint32_t address,
+				 const void *buf, size_t sz, int confirmed,
+				 il_net_progress_cb_t cb, void *ctx);
+
 int il_net_base__sw_subscribe(il_net_t *net, uint16_t id,
 			      il_net_sw_subscriber_cb_t cb, void *ctx);
 
@@ -34,6 +34,22 @@ void il_servo_base__deinit(il_servo_t *servo);
 void il_servo_base__state_get(il_servo_t *servo, il_servo_state_t *state,
 			      int *flags);
 
+uint16_t il_servo_base__sw_get(il_servo_t *servo);
+
+int il_servo_base__sw_wait_change(il_servo_t *servo, uint16_t *sw,
+				  int *timeout);
+
+int il_servo_base__sw_wait_value(il_servo_t *servo, uint16_t msk,
+				 uint16_t val, int *timeout);
+
+int il_servo_base__disable(il_servo_t *servo);
+
+int il_servo_base__switch_on(il_servo_t *servo, int timeout);
+
+int il_servo_base__enable(il_servo_t *servo, int timeout);
+
+int il_servo_base__fault_reset(il_servo_t *servo);
+
 int il_servo_base__state_subscribe(il_servo_t *servo,
 				   il_servo_state_subscriber_cb_t cb,
 				   void *ctx);
@@ -66,6 +82,10 @@ il_units_acc_t il_servo_base__units_acc_get(il_servo_t *servo);
 
 void il_servo_base__units_acc_set(il_servo_t *servo, il_units_acc_t units);
 
+void il_servo_base__units_factors_update(il_servo_t *servo);
+
+double il_servo_base__units_factor(il_servo_t *servo, const il_reg_t *reg);
+
 int il_servo_base__raw_read_u8(il_servo_t *servo, const il_reg_t *reg,
 			       const char *id, uint8_t *buf);
 
@@ -93,6 +113,12 @@ int il_servo_base__raw_read_s64(il_servo_t *servo, const il_reg_t *reg,
 int il_servo_base__raw_read_float(il_servo_t *servo, const il_reg_t *reg,
 				  const char *id, float *buf);
 
+int il_servo_base__sw_read(il_servo_t *servo, const il_reg_t *reg,
+			   const char *id, uint16_t *sw);
+
+int il_servo_base__raw_read_str(il_servo_t *servo, const il_reg_t *reg,
+				const char *id, char *buf, size_t sz);
+
 int il_servo_base__read(il_servo_t *servo, const il_reg_t *reg, const char *id,
 			double *buf);
 
@@ -123,8 +149,44 @@ int il_servo_base__raw_write_s64(il_servo_t *servo, const il_reg_t *reg,
 int il_servo_base__raw_write_float(il_servo_t *servo, const il_reg_t *reg,
 				   const char *id, float val, int confirm);
 
+int il_servo_base__raw_write_str(il_servo_t *servo, const il_reg_t *reg,
+				 const char *id, const char *val, int confirm);
+
 int il_servo_base__write(il_servo_t *servo, const il_reg_t *reg, const char *id,
 			 double val, int confirm);
 
+int il_servo_base__read_async(il_servo_t *servo, const il_reg_t *reg,
+			      const char *id, il_servo_async_cb_t cb,
+			      void *ctx);
+
+int il_servo_base__write_async(il_servo_t *servo, const il_reg_t *reg,
+			       const char *id, double val, int confirm,
+			       il_servo_async_cb_t cb, void *ctx);
+
+il_servo_reg_handle_t *il_servo_base__reg_bind(il_servo_t *servo,
+					       const il_reg_t *reg,
+					       const char *id);
+
+void il_servo_base__reg_unbind(il_servo_reg_handle_t *hnd);
+
+int il_servo_base__reg_read(il_servo_reg_handle_t *hnd, double *buf);
+
+int il_servo_base__reg_write(il_servo_reg_handle_t *hnd, double val,
+			     int confirm);
+
+int il_servo_base__write_behind_enable(il_servo_t *servo, const il_reg_t *reg,
+				       const char *id);
+
+int il_servo_base__write_behind_disable(il_servo_t *servo,
+					const il_reg_t *reg, const char *id);
+
+int il_servo_base__write_behind_stats_get(il_servo_t *servo,
+					  const il_reg_t *reg, const char *id,
+					  il_net_wb_stats_t *stats);
+
+int il_servo_base__read_batch(il_servo_batch_t *batch, size_t cnt);
+
+int il_servo_base__write_batch(il_servo_batch_t *batch, size_t cnt);
+
 #endif
 
@@ -0,0 +1,101 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef INGENIALINK_CACHE_H_
+#define INGENIALINK_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Persistent cache. */
+typedef struct il_cache il_cache_t;
+
+/**
+ * Create a persistent cache.
+ *
+ * @note
+ *	The cache file is not accessed until the first lookup/store, and it is
+ *	created on the first store if it does not exist. Caches created with
+ *	the same path share the same instance (and lock), so that concurrent
+ *	updates from different networks do not race.
+ *
+ * @param [in] path
+ *	Cache file path.
+ *
+ * @return
+ *	Cache instance (NULL if it could not be created).
+ */
+il_cache_t *il_cache__create(const char *path);
+
+/**
+ * Destroy a persistent cache (released once all its users destroy it).
+ *
+ * @param [in] cache
+ *	Cache instance.
+ */
+void il_cache__destroy(il_cache_t *cache);
+
+/**
+ * Look up a cache record.
+ *
+ * @param [in] cache
+ *	Cache instance.
+ * @param [in] key
+ *	Record key.
+ * @param [in] fp
+ *	Expected record fingerprint (records with a different fingerprint are
+ *	considered stale).
+ * @param [out] data
+ *	Record data buffer.
+ * @param [in] sz
+ *	Record data size.
+ *
+ * @return
+ *	0 on success, error code otherwise (IL_EFAIL if not found or stale).
+ */
+int il_cache__get(il_cache_t *cache, uint32_t key, uint64_t fp, void *data,
+		  size_t sz);
+
+/**
+ * Store (or replace) a cache record.
+ *
+ * @param [in] cache
+ *	Cache instance.
+ * @param [in] key
+ *	Record key.
+ * @param [in] fp
+ *	Record fingerprint.
+ * @param [in] data
+ *	Record data.
+ * @param [in] sz
+ *	Record data size.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+int il_cache__put(il_cache_t *cache, uint32_t key, uint64_t fp,
+		  const void *data, size_t sz);
+
+#endif
@@ -93,6 +93,33 @@ typedef struct {
 int il_eusb_frame__init(il_eusb_frame_t *frame, uint8_t id, uint32_t address,
 			const void *data, size_t sz);
 
+/**
+ * Initialize a segment frame.
+ *
+ * @note
+ *	Segments of registers larger than IL_EUSB_FRAME_MAX_DATA_SZ are
+ *	addressed by their byte offset (starting address field).
+ *
+ * @param [in, out] frame
+ *     Frame.
+ * @param [in] id
+ *     Node ID.
+ * @param [in] address
+ *     Address.
+ * @param [in] offset
+ *     Segment offset.
+ * @param [in] data
+ *     Data.
+ * @param [in] sz
+ *     Data size.
+ *
+ * @returns
+ *      IL_EINVAL if the data size is too large.
+ */
+int il_eusb_frame__init_seg(il_eusb_frame_t *frame, uint8_t id,
+			    uint32_t address, uint16_t offset, const void *data,
+			    size_t sz);
+
 /**
  * Reset frame.
  *
@@ -123,6 +150,94 @@ void il_eusb_frame__reset(il_eusb_frame_t *frame);
  */
 int il_eusb_frame__push(il_eusb_frame_t *frame, uint8_t c);
 
+/**
+ * Find the next complete frame in a buffer.
+ *
+ * @note
+ *	The buffer is scanned in place: frame headers are located directly, the
+ *	data size field is used to jump to the trailing sync block, which is
+ *	validated at once. On framing errors, scanning resumes at the next
+ *	candidate header.
+ *
+ * @param [in] buf
+ *	Buffer.
+ * @param [in] sz
+ *	Buffer size.
+ * @param [out] start
+ *	Where frame start offset will be stored. If no complete frame is found,
+ *	number of leading bytes that can be discarded.
+ *
+ * @returns
+ *	Frame size, 0 if no complete frame is found.
+ */
+size_t il_eusb_frame__find(const uint8_t *buf, size_t sz, size_t *start);
+
+/**
+ * Obtain raw frame node ID.
+ *
+ * @param [in] buf
+ *	Complete frame buffer.
+ *
+ * @returns
+ *	Frame node ID.
+ */
+uint8_t il_eusb_frame__raw_get_id(const uint8_t *buf);
+
+/**
+ * Obtain raw frame address.
+ *
+ * @param [in] buf
+ *	Complete frame buffer.
+ *
+ * @returns
+ *	Frame address.
+ */
+uint32_t il_eusb_frame__raw_get_address(const uint8_t *buf);
+
+/**
+ * Obtain raw frame segment offset.
+ *
+ * @param [in] buf
+ *	Complete frame buffer.
+ *
+ * @returns
+ *	Frame segment offset.
+ */
+uint16_t il_eusb_frame__raw_get_offset(const uint8_t *buf);
+
+/**
+ * Obtain raw frame data size.
+ *
+ * @param [in] buf
+ *	Complete frame buffer.
+ *
+ * @returns
+ *	Frame data size.
+ */
+size_t il_eusb_frame__raw_get_sz(const uint8_t *buf);
+
+/**
+ * Obtain raw frame data pointer.
+ *
+ * @param [in] buf
+ *	Complete frame buffer.
+ *
+ * @returns
+ *	Pointer to the frame data field.
+ */
+const void *il_eusb_frame__raw_get_data(const uint8_t *buf);
+
+/**
+ * Check if raw frame is a response.
+ *
+ * @param [in] buf
+ *	Complete frame buffer.
+ *
+ * @returns
+ *	Non-zero is frame is a response.
+ */
+int il_eusb_frame__raw_is_resp(const uint8_t *buf);
+
 /**
  * Obtain frame node ID.
  *
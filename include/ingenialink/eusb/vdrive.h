@@ -0,0 +1,100 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef INGENIALINK_EUSB_VDRIVE_H_
+#define INGENIALINK_EUSB_VDRIVE_H_
+
+#include "public/ingenialink/net.h"
+
+/** E-USB virtual drive. */
+typedef struct il_eusb_vdrive il_eusb_vdrive_t;
+
+/**
+ * Virtual drive transmission callback.
+ *
+ * @note
+ *	Called from the virtual drive thread, once per frame.
+ *
+ * @param [in] ctx
+ *	Callback context.
+ * @param [in] buf
+ *	Frame buffer.
+ * @param [in] sz
+ *	Frame size.
+ */
+typedef void (*il_eusb_vdrive_on_tx_t)(void *ctx, const uint8_t *buf,
+				       size_t sz);
+
+/**
+ * Create a virtual drive.
+ *
+ * @param [in] id
+ *	Node ID.
+ * @param [in] opts
+ *	Options (NULL to use defaults).
+ * @param [in] on_tx
+ *	Transmission callback (responses, statusword and emergencies).
+ * @param [in] ctx
+ *	Callback context.
+ *
+ * @return
+ *	Virtual drive (NULL if it could not be created).
+ */
+il_eusb_vdrive_t *il_eusb_vdrive__create(uint8_t id,
+					 const il_net_virtual_opts_t *opts,
+					 il_eusb_vdrive_on_tx_t on_tx,
+					 void *ctx);
+
+/**
+ * Destroy a virtual drive.
+ *
+ * @note
+ *	Pending responses are discarded.
+ *
+ * @param [in] vdrive
+ *	Virtual drive.
+ */
+void il_eusb_vdrive__destroy(il_eusb_vdrive_t *vdrive);
+
+/**
+ * Write data to a virtual drive.
+ *
+ * @note
+ *	Data is parsed as a byte stream, so frames can be split or batched.
+ *
+ * @param [in] vdrive
+ *	Virtual drive.
+ * @param [in] buf
+ *	Data buffer.
+ * @param [in] sz
+ *	Data size.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+int il_eusb_vdrive__write(il_eusb_vdrive_t *vdrive, const void *buf,
+			  size_t sz);
+
+#endif
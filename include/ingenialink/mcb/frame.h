@@ -28,17 +28,71 @@
 #include "public/ingenialink/common.h"
 
 /**
- * Swap a buffer word-wise on LE systems.
+ * Compute the CRC of a buffer (CRC-16/CCITT, zero initial value).
  *
- * @param [in, out] frame
- *	Frame.
+ * @note
+ *	Table driven (slicing-by-4).
+ *
+ * @param [in] buf
+ *	Buffer.
  * @param [in] sz
- *	Size.
+ *	Buffer size.
+ *
+ * @return
+ *	CRC.
  */
-#ifndef IL_BIG_ENDIAN
-void il_mcb_frame__swap(uint8_t *frame, size_t sz);
-#else
-#define il_mcb_frame__swap(frame, sz)
-#endif
+uint16_t il_mcb_frame__crc(const uint8_t *buf, size_t sz);
+
+/**
+ * Obtain the number of frames needed to transfer the given data.
+ *
+ * @param [in] sz
+ *	Data size.
+ *
+ * @return
+ *	Number of frames (at least one).
+ */
+size_t il_mcb_frame__cnt(size_t sz);
+
+/**
+ * Encode a transfer.
+ *
+ * @note
+ *	All frames are encoded contiguously (il_mcb_frame__cnt(sz) frames),
+ *	each one in a single pass (header, data and CRC).
+ *
+ * @param [out] buf
+ *	Output buffer.
+ * @param [in] address
+ *	Register address.
+ * @param [in] cmd
+ *	Command.
+ * @param [in] data
+ *	Data (optional).
+ * @param [in] sz
+ *	Data size.
+ * @param [in] more
+ *	Flag to indicate that more data follows (pending flag on last frame).
+ *
+ * @return
+ *	Encoded size (bytes).
+ */
+size_t il_mcb_frame__encode(uint8_t *buf, uint16_t address, uint8_t cmd,
+			    const void *data, size_t sz, int more);
+
+/**
+ * Decode a frame.
+ *
+ * @param [in] frame
+ *	Frame (MCB_FRAME_SZ bytes).
+ * @param [out] hdr
+ *	Header.
+ * @param [out] data
+ *	Data (MCB_DATA_SZ bytes).
+ *
+ * @return
+ *	0 on success, IL_EIO if the CRC does not match.
+ */
+int il_mcb_frame__decode(const uint8_t *frame, uint16_t *hdr, uint8_t *data);
 
 #endif
@@ -27,12 +27,33 @@
 
 #include "public/ingenialink/net.h"
 
+#include "ingenialink/cache.h"
+#include "osal/clock.h"
+
 /** Virtual network port. */
 #define EUSB_VIRTUAL_PORT "virtual"
 
 /** Virtual network servo ID. */
 #define EUSB_VIRTUAL_ID 0x01
 
+/**
+ * Request priority classes.
+ *
+ * @note
+ *	Classes are chosen by the caller of each request. Public register
+ *	accesses default to control for writes and bulk for reads, batches
+ *	are bulk unless they involve control registers.
+ */
+typedef enum {
+	/** Control (e.g. control word, statusword, set-points). */
+	IL_NET_PRIO_CTL,
+	/** Bulk (e.g. monitoring, polling, parameter dumps). */
+	IL_NET_PRIO_BULK,
+} il_net_prio_t;
+
+/** Number of request priority classes. */
+#define IL_NET_PRIO_CNT		2
+
 /** Statusword updates subcriber. */
 typedef struct il_net_sw_subscriber il_net_sw_subscriber_t;
 
@@ -45,6 +66,27 @@ typedef struct il_net_emcy_subscriber il_net_emcy_subscriber_t;
 /** Emergency subcriber callback. */
 typedef void (*il_net_emcy_subscriber_cb_t)(void *ctx, uint32_t code);
 
+/**
+ * Asynchronous transfer completion callback.
+ *
+ * @note
+ *	Callbacks are invoked from the network reception context, so they must
+ *	not block on synchronous transfers. New asynchronous transfers may be
+ *	submitted, but they never wait for a free in-flight transfer (IL_EBUSY
+ *	is returned instead).
+ *
+ * @param [in] ctx
+ *	Callback context.
+ * @param [in] r
+ *	Result (0 on success, error code otherwise).
+ * @param [in] buf
+ *	Received data (reads only, NULL on failure).
+ * @param [in] sz
+ *	Received data size.
+ */
+typedef void (*il_net_async_cb_t)(void *ctx, int r, const void *buf,
+				  size_t sz);
+
 /**
  * Retain a reference of the network.
  *
@@ -71,6 +113,98 @@ void il_net__release(il_net_t *net);
  */
 void il_net__state_set(il_net_t *net, il_net_state_t state);
 
+/**
+ * Account a round trip in the node statistics.
+ *
+ * @note
+ *	The round trip is also used to update the node read timeout estimator.
+ *	Calls must be serialized per network.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node id.
+ * @param [in] start
+ *	Time when the request was sent.
+ */
+void il_net__stats_rtt_add(il_net_t *net, uint16_t id,
+			   const osal_timespec_t *start);
+
+/**
+ * Obtain the read timeout of a node.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node id.
+ *
+ * @returns
+ *	Read timeout (ms).
+ */
+int il_net__timeout_rd(il_net_t *net, uint16_t id);
+
+/**
+ * Back off the read timeout of a node (after a timeout).
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node id.
+ */
+void il_net__timeout_backoff(il_net_t *net, uint16_t id);
+
+/**
+ * Acquire the network for transmission.
+ *
+ * @note
+ *	Requests of the same class are served in arrival order. Bulk requests
+ *	are not served while control requests are pending.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] prio
+ *	Priority class.
+ */
+void il_net__tx_lock(il_net_t *net, il_net_prio_t prio);
+
+/**
+ * Release the network after transmission.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] prio
+ *	Priority class (as acquired).
+ */
+void il_net__tx_unlock(il_net_t *net, il_net_prio_t prio);
+
+/**
+ * Check if control requests are waiting for the network.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] prio
+ *	Priority class (as acquired).
+ *
+ * @returns
+ *	Non-zero if control requests (other than the caller) are waiting.
+ */
+int il_net__tx_contended(il_net_t *net, il_net_prio_t prio);
+
+/**
+ * Yield the network to pending control requests (frame boundary).
+ *
+ * @note
+ *	The network is released and acquired again only if needed. Control
+ *	holders yield to control requests queued after them, bulk holders to
+ *	any control request.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] prio
+ *	Priority class (as acquired).
+ */
+void il_net__tx_yield(il_net_t *net, il_net_prio_t prio);
+
 /**
  * Write.
  *
@@ -86,12 +220,14 @@ void il_net__state_set(il_net_t *net, il_net_state_t state);
  *	Data buffer size.
  * @param [in] confirmed
  *	Flag to confirm the write.
+ * @param [in] prio
+ *	Priority class.
  *
  * @returns
  *	0 on success, error code otherwise.
  */
 int il_net__write(il_net_t *net, uint16_t id, uint32_t address, const void *buf,
-		  size_t sz, int confirmed);
+		  size_t sz, int confirmed, il_net_prio_t prio);
 
 /**
  * Read.
@@ -106,12 +242,142 @@ int il_net__write(il_net_t *net, uint16_t id, uint32_t address, const void *buf,
  *	Data output buffer.
  * @param [in] sz
  *	Data buffer size.
+ * @param [in] prio
+ *	Priority class.
  *
  * @returns
  *	0 on success, error code otherwise.
  */
 int il_net__read(il_net_t *net, uint16_t id, uint32_t address, void *buf,
-		 size_t sz);
+		 size_t sz, il_net_prio_t prio);
+
+/**
+ * Asynchronous read.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Expected node id.
+ * @param [in] address
+ *	Expected address.
+ * @param [in] sz
+ *	Data size.
+ * @param [in] cb
+ *	Completion callback.
+ * @param [in] ctx
+ *	Completion callback context.
+ * @param [in] prio
+ *	Priority class.
+ *
+ * @returns
+ *	0 if the transfer was submitted, IL_EBUSY if submitted from a
+ *	completion callback with no transfers available, error code otherwise
+ *	(callback will not be invoked).
+ */
+int il_net__read_async(il_net_t *net, uint16_t id, uint32_t address,
+		       size_t sz, il_net_async_cb_t cb, void *ctx,
+		       il_net_prio_t prio);
+
+/**
+ * Asynchronous write.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node id.
+ * @param [in] address
+ *	Address.
+ * @param [in] buf
+ *	Data buffer.
+ * @param [in] sz
+ *	Data buffer size.
+ * @param [in] confirmed
+ *	Flag to confirm the write.
+ * @param [in] cb
+ *	Completion callback.
+ * @param [in] ctx
+ *	Completion callback context.
+ * @param [in] prio
+ *	Priority class.
+ *
+ * @returns
+ *	0 if the transfer was submitted, IL_EBUSY if submitted from a
+ *	completion callback with no transfers available, error code otherwise
+ *	(callback will not be invoked).
+ */
+int il_net__write_async(il_net_t *net, uint16_t id, uint32_t address,
+			const void *buf, size_t sz, int confirmed,
+			il_net_async_cb_t cb, void *ctx, il_net_prio_t prio);
+
+/**
+ * Perform a batch of raw transfers.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in, out] xfers
+ *	Transfers.
+ * @param [in] cnt
+ *	Number of transfers.
+ * @param [in] prio
+ *	Priority class.
+ *
+ * @returns
+ *	0 if all transfers succeeded, first error code otherwise.
+ */
+int il_net__transfer_batch(il_net_t *net, il_net_xfer_t *xfers, size_t cnt,
+			   il_net_prio_t prio);
+
+/**
+ * Read a register segmented (arbitrary size).
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node id.
+ * @param [in] address
+ *	Address.
+ * @param [out] buf
+ *	Buffer where to store received data.
+ * @param [in] sz
+ *	Number of bytes to be read.
+ * @param [in] cb
+ *	Progress callback (optional).
+ * @param [in] ctx
+ *	Progress callback context.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+int il_net__read_segmented(il_net_t *net, uint16_t id, uint32_t address,
+			   void *buf, size_t sz, il_net_progress_cb_t cb,
+			   void *ctx);
+
+/**
+ * Write a register segmented (arbitrary size).
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node id.
+ * @param [in] address
+ *	Address.
+ * @param [in] buf
+ *	Buffer to be sent.
+ * @param [in] sz
+ *	Number of bytes to be sent.
+ * @param [in] confirmed
+ *	Confirm write (read back).
+ * @param [in] cb
+ *	Progress callback (optional).
+ * @param [in] ctx
+ *	Progress callback context.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+int il_net__write_segmented(il_net_t *net, uint16_t id, uint32_t address,
+			    const void *buf, size_t sz, int confirmed,
+			    il_net_progress_cb_t cb, void *ctx);
 
 /**
  * Subscribe to statusword updates.
@@ -169,6 +435,202 @@ int il_net__emcy_subscribe(il_net_t *net, uint16_t id,
  */
 void il_net__emcy_unsubscribe(il_net_t *net, int slot);
 
+/**
+ * Initialize the subscriber events queue (and dispatcher).
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] mode
+ *	Dispatch mode.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+int il_net__events_init(il_net_t *net, il_net_dispatch_t mode);
+
+/**
+ * Deinitialize the subscriber events queue (and dispatcher).
+ *
+ * @note
+ *	Pending events are discarded.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ */
+void il_net__events_deinit(il_net_t *net);
+
+/**
+ * Initialize the write-behind writer.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+int il_net__wb_init(il_net_t *net);
+
+/**
+ * Deinitialize the write-behind writer.
+ *
+ * @note
+ *	Pending values are discarded.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ */
+void il_net__wb_deinit(il_net_t *net);
+
+/**
+ * Enable write-behind on a register.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] address
+ *	Address.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+int il_net__wb_enable(il_net_t *net, uint16_t id, uint32_t address);
+
+/**
+ * Disable write-behind on a register.
+ *
+ * @note
+ *	The pending value, if any, is written before returning.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] address
+ *	Address.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+int il_net__wb_disable(il_net_t *net, uint16_t id, uint32_t address);
+
+/**
+ * Disable write-behind on all the registers of a node.
+ *
+ * @note
+ *	Pending values are discarded (used when a servo is destroyed).
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node ID.
+ */
+void il_net__wb_drop(il_net_t *net, uint16_t id);
+
+/**
+ * Write to a register with write-behind enabled.
+ *
+ * @note
+ *	The value replaces the pending value (if any) and it is transmitted in
+ *	the background.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] address
+ *	Address.
+ * @param [in] buf
+ *	Data buffer.
+ * @param [in] sz
+ *	Data buffer size.
+ * @param [in] confirmed
+ *	Flag to confirm the write.
+ *
+ * @returns
+ *	1 if the value was queued, 0 if write-behind is not enabled on the
+ *	register.
+ */
+int il_net__wb_write(il_net_t *net, uint16_t id, uint32_t address,
+		     const void *buf, size_t sz, int confirmed);
+
+/**
+ * Obtain write-behind statistics of a register.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] address
+ *	Address.
+ * @param [out] stats
+ *	Where statistics will be stored.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+int il_net__wb_stats_get(il_net_t *net, uint16_t id, uint32_t address,
+			 il_net_wb_stats_t *stats);
+
+/**
+ * Check if the calling thread is delivering the network events.
+ *
+ * @note
+ *	True from statusword and emergency subscriber callbacks (dispatcher
+ *	thread or il_net_events_process), where waiting for the delivery to
+ *	complete would deadlock.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ *
+ * @returns
+ *	Non-zero if delivering, zero otherwise.
+ */
+int il_net__in_delivery(il_net_t *net);
+
+/**
+ * Notify a statusword update.
+ *
+ * @note
+ *	The update is queued and delivered later to the subscriber, so it is
+ *	safe to use from the reception context.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] sw
+ *	Statusword.
+ */
+void il_net__sw_notify(il_net_t *net, uint16_t id, uint16_t sw);
+
+/**
+ * Notify an emergency.
+ *
+ * @note
+ *	The emergency is queued and delivered later to the subscriber, so it is
+ *	safe to use from the reception context.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] code
+ *	Emergency code.
+ */
+void il_net__emcy_notify(il_net_t *net, uint16_t id, uint32_t code);
+
+/**
+ * Obtain the servo configuration cache.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ *
+ * @return
+ *	Cache (NULL if not enabled).
+ */
+il_cache_t *il_net__cache(il_net_t *net);
+
 /** Network operations. */
 typedef struct {
 	/** Retain. */
@@ -184,11 +646,32 @@ typedef struct {
 	/** Read. */
 	int (*_read)(
 		il_net_t *net, uint16_t id, uint32_t address, void *buf,
-		size_t sz);
+		size_t sz, il_net_prio_t prio);
 	/** Write. */
 	int (*_write)(
 		il_net_t *net, uint16_t id, uint32_t address, const void *buf,
-		size_t sz, int confirmed);
+		size_t sz, int confirmed, il_net_prio_t prio);
+	/** Asynchronous read. */
+	int (*_read_async)(
+		il_net_t *net, uint16_t id, uint32_t address, size_t sz,
+		il_net_async_cb_t cb, void *ctx, il_net_prio_t prio);
+	/** Asynchronous write. */
+	int (*_write_async)(
+		il_net_t *net, uint16_t id, uint32_t address, const void *buf,
+		size_t sz, int confirmed, il_net_async_cb_t cb, void *ctx,
+		il_net_prio_t prio);
+	/** Batch transfer. */
+	int (*_transfer_batch)(
+		il_net_t *net, il_net_xfer_t *xfers, size_t cnt,
+		il_net_prio_t prio);
+	/** Segmented read. */
+	int (*_read_segmented)(
+		il_net_t *net, uint16_t id, uint32_t address, void *buf,
+		size_t sz, il_net_progress_cb_t cb, void *ctx);
+	/** Segmented write. */
+	int (*_write_segmented)(
+		il_net_t *net, uint16_t id, uint32_t address, const void *buf,
+		size_t sz, int confirmed, il_net_progress_cb_t cb, void *ctx);
 	/** Subscribe to state updates. */
 	int (*_sw_subscribe)(
 		il_net_t *net, uint16_t id, il_net_sw_subscriber_cb_t cb,
@@ -0,0 +1,151 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef INGENIALINK_REACTOR_H_
+#define INGENIALINK_REACTOR_H_
+
+#include "public/ingenialink/reactor.h"
+
+/** Reactor source (attached port). */
+typedef struct il_reactor_src il_reactor_src_t;
+
+/**
+ * Data available callback.
+ *
+ * @param [in] ctx
+ *	Callback context.
+ *
+ * @return
+ *	0 on success, error code otherwise (source will be disabled).
+ */
+typedef int (*il_reactor_on_read_t)(void *ctx);
+
+/**
+ * Periodic tick callback.
+ *
+ * @note
+ *	Ticks are only delivered while the source is armed (see
+ *	il_reactor__arm()).
+ *
+ * @param [in] ctx
+ *	Callback context.
+ *
+ * @return
+ *	Non-zero to keep the source armed.
+ */
+typedef int (*il_reactor_on_tick_t)(void *ctx);
+
+/**
+ * Open a port and attach it to the reactor.
+ *
+ * @note
+ *	The port is opened in non-blocking mode and configured as a raw line
+ *	(8N1, no flow control). The same channel is used for transmission, see
+ *	il_reactor__write().
+ *
+ * @param [in] reactor
+ *	Reactor instance.
+ * @param [in] port
+ *	Port.
+ * @param [in] baudrate
+ *	Baudrate.
+ * @param [in] on_read
+ *	Data available callback.
+ * @param [in] on_tick
+ *	Periodic tick callback.
+ * @param [in] ctx
+ *	Callbacks context.
+ *
+ * @return
+ *	Reactor source (NULL if it could not be attached).
+ */
+il_reactor_src_t *il_reactor__attach(il_reactor_t *reactor, const char *port,
+				     int baudrate, il_reactor_on_read_t on_read,
+				     il_reactor_on_tick_t on_tick, void *ctx);
+
+/**
+ * Detach a port from the reactor, and close it.
+ *
+ * @note
+ *	Once this function returns, callbacks are guaranteed not to be running
+ *	nor to be called again.
+ *
+ * @param [in] src
+ *	Reactor source.
+ */
+void il_reactor__detach(il_reactor_src_t *src);
+
+/**
+ * Read available data from a reactor source (non-blocking).
+ *
+ * @param [in] src
+ *	Reactor source.
+ * @param [out] buf
+ *	Output buffer.
+ * @param [in] sz
+ *	Output buffer size.
+ * @param [out] recvd
+ *	Number of bytes received (0 if no more data is available).
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+int il_reactor__read(il_reactor_src_t *src, void *buf, size_t sz,
+		     size_t *recvd);
+
+/**
+ * Write data to a reactor source.
+ *
+ * @note
+ *	Concurrent writers must be serialized by the caller.
+ *
+ * @param [in] src
+ *	Reactor source.
+ * @param [in] buf
+ *	Data buffer.
+ * @param [in] sz
+ *	Data size.
+ * @param [in] timeout
+ *	Timeout (ms).
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+int il_reactor__write(il_reactor_src_t *src, const void *buf, size_t sz,
+		      int timeout);
+
+/**
+ * Arm the periodic tick of a reactor source.
+ *
+ * @note
+ *	The source stays armed until its tick callback returns zero, so idle
+ *	sources do not wake up the reactor.
+ *
+ * @param [in] src
+ *	Reactor source.
+ */
+void il_reactor__arm(il_reactor_src_t *src);
+
+#endif
@@ -83,7 +83,7 @@ typedef struct {
 	int (*store_comm)(il_servo_t *servo);
 	int (*store_app)(il_servo_t *servo);
 	int (*units_update)(il_servo_t *servo);
-	double (*units_factor)(il_servo_t *servo, const il_reg_t *reg);
+	double (*units_factor)(il_servo_t *servo, il_reg_phy_t phy);
 	il_units_torque_t (*units_torque_get)(il_servo_t *servo);
 	void (*units_torque_set)(il_servo_t *servo, il_units_torque_t units);
 	il_units_pos_t (*units_pos_get)(il_servo_t *servo);
@@ -119,6 +119,9 @@ typedef struct {
 	int (*raw_read_float)(
 		il_servo_t *servo, const il_reg_t *reg, const char *id,
 		float *buf);
+	int (*raw_read_str)(
+		il_servo_t *servo, const il_reg_t *reg, const char *id,
+		char *buf, size_t sz);
 	int (*read)(
 		il_servo_t *servo, const il_reg_t *reg, const char *id,
 		double *buf);
@@ -149,9 +152,32 @@ typedef struct {
 	int (*raw_write_float)(
 		il_servo_t *servo, const il_reg_t *reg, const char *id,
 		float val, int confirm);
+	int (*raw_write_str)(
+		il_servo_t *servo, const il_reg_t *reg, const char *id,
+		const char *val, int confirm);
 	int (*write)(
 		il_servo_t *servo, const il_reg_t *reg, const char *id,
 		double val, int confirm);
+	int (*read_async)(
+		il_servo_t *servo, const il_reg_t *reg, const char *id,
+		il_servo_async_cb_t cb, void *ctx);
+	int (*write_async)(
+		il_servo_t *servo, const il_reg_t *reg, const char *id,
+		double val, int confirm, il_servo_async_cb_t cb, void *ctx);
+	int (*read_batch)(il_servo_batch_t *batch, size_t cnt);
+	int (*write_batch)(il_servo_batch_t *batch, size_t cnt);
+	il_servo_reg_handle_t *(*reg_bind)(
+		il_servo_t *servo, const il_reg_t *reg, const char *id);
+	void (*reg_unbind)(il_servo_reg_handle_t *hnd);
+	int (*reg_read)(il_servo_reg_handle_t *hnd, double *buf);
+	int (*reg_write)(il_servo_reg_handle_t *hnd, double val, int confirm);
+	int (*write_behind_enable)(
+		il_servo_t *servo, const il_reg_t *reg, const char *id);
+	int (*write_behind_disable)(
+		il_servo_t *servo, const il_reg_t *reg, const char *id);
+	int (*write_behind_stats_get)(
+		il_servo_t *servo, const il_reg_t *reg, const char *id,
+		il_net_wb_stats_t *stats);
 	int (*disable)(il_servo_t *servo);
 	int (*switch_on)(il_servo_t *servo, int timeout);
 	int (*enable)(il_servo_t *servo, int timeout);
@@ -28,10 +28,14 @@
 #include <stddef.h>
 
 #include "public/ingenialink/common.h"
+#include "public/ingenialink/registers.h"
 
 /** Obtain the minimum of a, b. */
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 
+/** Obtain the maximum of a, b. */
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+
 /** Obtain the size of an array. */
 #define ARRAY_SIZE(arr) (sizeof((arr)) / sizeof((arr)[0]))
 
@@ -41,6 +45,18 @@
 /** Return space available on a circular queue. */
 #define CIRC_SPACE(head, tail, size) CIRC_CNT((tail), ((head) + 1), (size))
 
+/** Declare a variable thread-local. */
+#ifdef __GNUC__
+# define thread_local __thread
+#elif __STDC_VERSION__ >= 201112L
+# define thread_local _Thread_local
+#elif defined(_MSC_VER)
+# define thread_local __declspec(thread)
+#else
+# define thread_local
+# warning Thread Local Storage (TLS) not available.
+#endif
+
 /** Cast a member of a structure out to the containing structure. */
 #define container_of(ptr, type, member) \
 	((type *)((char *)(ptr) - offsetof(type, member)))
@@ -151,4 +167,45 @@ void il_utils__refcnt_retain(il_utils_refcnt_t *refcnt);
  */
 void il_utils__refcnt_release(il_utils_refcnt_t *refcnt);
 
+/*
+ * Random numbers
+ */
+
+/**
+ * Pseudo-random number generator (xorshift32).
+ *
+ * @note
+ *	Not suitable for cryptographic use, intended for simulation (jitter,
+ *	test streams).
+ *
+ * @param [in, out] seed
+ *	Seed (non-zero), updated with the generator state.
+ *
+ * @return
+ *	Pseudo-random number.
+ */
+static inline uint32_t il_utils__rnd(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+
+	return *seed;
+}
+
+/*
+ * Registers
+ */
+
+/**
+ * Obtain register data size.
+ *
+ * @param [in] dtype
+ *	Data type.
+ *
+ * @return
+ *	Data size, 0 if not supported.
+ */
+size_t il_utils__reg_sz(il_reg_dtype_t dtype);
+
 #endif
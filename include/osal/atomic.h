@@ -0,0 +1,290 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef OSAL_ATOMIC_H_
+#define OSAL_ATOMIC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Lock-free 64-bit counters (relaxed ordering, suitable for statistics),
+ * 32-bit sequence numbers and pointers (sequentially consistent ordering,
+ * suitable for lock-free queues and read-mostly tables).
+ */
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+/**
+ * Atomically add to a counter.
+ *
+ * @param [in, out] cnt
+ *	Counter.
+ * @param [in] val
+ *	Value to be added.
+ */
+static __inline void osal_atomic_add_u64(volatile uint64_t *cnt, uint64_t val)
+{
+	(void)_InterlockedExchangeAdd64((volatile __int64 *)cnt, (__int64)val);
+}
+
+/**
+ * Atomically load a counter.
+ *
+ * @param [in] cnt
+ *	Counter.
+ *
+ * @return
+ *	Counter value.
+ */
+static __inline uint64_t osal_atomic_load_u64(volatile uint64_t *cnt)
+{
+	return (uint64_t)_InterlockedCompareExchange64((volatile __int64 *)cnt,
+						       0, 0);
+}
+
+/**
+ * Atomically store a counter.
+ *
+ * @param [in, out] cnt
+ *	Counter.
+ * @param [in] val
+ *	Value.
+ */
+static __inline void osal_atomic_store_u64(volatile uint64_t *cnt,
+					   uint64_t val)
+{
+	(void)_InterlockedExchange64((volatile __int64 *)cnt, (__int64)val);
+}
+
+/**
+ * Atomically load a sequence number.
+ *
+ * @param [in] seq
+ *	Sequence number.
+ *
+ * @return
+ *	Sequence number value.
+ */
+static __inline uint32_t osal_atomic_load_u32(volatile uint32_t *seq)
+{
+	return (uint32_t)_InterlockedCompareExchange((volatile long *)seq, 0,
+						     0);
+}
+
+/**
+ * Atomically store a sequence number.
+ *
+ * @param [in, out] seq
+ *	Sequence number.
+ * @param [in] val
+ *	Value.
+ */
+static __inline void osal_atomic_store_u32(volatile uint32_t *seq,
+					   uint32_t val)
+{
+	(void)_InterlockedExchange((volatile long *)seq, (long)val);
+}
+
+/**
+ * Atomically compare and swap a sequence number.
+ *
+ * @param [in, out] seq
+ *	Sequence number.
+ * @param [in, out] expected
+ *	Expected value (updated with the current value on failure).
+ * @param [in] val
+ *	New value.
+ *
+ * @return
+ *	Non-zero if swapped.
+ */
+static __inline int osal_atomic_cas_u32(volatile uint32_t *seq,
+					uint32_t *expected, uint32_t val)
+{
+	uint32_t prev;
+
+	prev = (uint32_t)_InterlockedCompareExchange((volatile long *)seq,
+						     (long)val,
+						     (long)*expected);
+	if (prev == *expected)
+		return 1;
+
+	*expected = prev;
+
+	return 0;
+}
+
+/**
+ * Atomically load a pointer.
+ *
+ * @param [in] ptr
+ *	Pointer location.
+ *
+ * @return
+ *	Pointer value.
+ */
+static __inline void *osal_atomic_load_ptr(void *volatile *ptr)
+{
+	return _InterlockedCompareExchangePointer(ptr, NULL, NULL);
+}
+
+/**
+ * Atomically exchange a pointer.
+ *
+ * @param [in, out] ptr
+ *	Pointer location.
+ * @param [in] val
+ *	New value.
+ *
+ * @return
+ *	Previous value.
+ */
+static __inline void *osal_atomic_xchg_ptr(void *volatile *ptr, void *val)
+{
+	return _InterlockedExchangePointer(ptr, val);
+}
+#else
+/**
+ * Atomically add to a counter.
+ *
+ * @param [in, out] cnt
+ *	Counter.
+ * @param [in] val
+ *	Value to be added.
+ */
+static inline void osal_atomic_add_u64(volatile uint64_t *cnt, uint64_t val)
+{
+	(void)__atomic_fetch_add(cnt, val, __ATOMIC_RELAXED);
+}
+
+/**
+ * Atomically load a counter.
+ *
+ * @param [in] cnt
+ *	Counter.
+ *
+ * @return
+ *	Counter value.
+ */
+static inline uint64_t osal_atomic_load_u64(volatile uint64_t *cnt)
+{
+	return __atomic_load_n(cnt, __ATOMIC_RELAXED);
+}
+
+/**
+ * Atomically store a counter.
+ *
+ * @param [in, out] cnt
+ *	Counter.
+ * @param [in] val
+ *	Value.
+ */
+static inline void osal_atomic_store_u64(volatile uint64_t *cnt, uint64_t val)
+{
+	__atomic_store_n(cnt, val, __ATOMIC_RELAXED);
+}
+
+/**
+ * Atomically load a sequence number.
+ *
+ * @param [in] seq
+ *	Sequence number.
+ *
+ * @return
+ *	Sequence number value.
+ */
+static inline uint32_t osal_atomic_load_u32(volatile uint32_t *seq)
+{
+	return __atomic_load_n(seq, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Atomically store a sequence number.
+ *
+ * @param [in, out] seq
+ *	Sequence number.
+ * @param [in] val
+ *	Value.
+ */
+static inline void osal_atomic_store_u32(volatile uint32_t *seq, uint32_t val)
+{
+	__atomic_store_n(seq, val, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Atomically compare and swap a sequence number.
+ *
+ * @param [in, out] seq
+ *	Sequence number.
+ * @param [in, out] expected
+ *	Expected value (updated with the current value on failure).
+ * @param [in] val
+ *	New value.
+ *
+ * @return
+ *	Non-zero if swapped.
+ */
+static inline int osal_atomic_cas_u32(volatile uint32_t *seq,
+				      uint32_t *expected, uint32_t val)
+{
+	return __atomic_compare_exchange_n(seq, expected, val, 0,
+					   __ATOMIC_SEQ_CST,
+					   __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Atomically load a pointer.
+ *
+ * @param [in] ptr
+ *	Pointer location.
+ *
+ * @return
+ *	Pointer value.
+ */
+static inline void *osal_atomic_load_ptr(void *volatile *ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Atomically exchange a pointer.
+ *
+ * @param [in, out] ptr
+ *	Pointer location.
+ * @param [in] val
+ *	New value.
+ *
+ * @return
+ *	Previous value.
+ */
+static inline void *osal_atomic_xchg_ptr(void *volatile *ptr, void *val)
+{
+	return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+#endif
+
+#endif
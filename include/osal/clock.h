@@ -109,4 +109,15 @@ int osal_clock_gettime(osal_timespec_t *ts);
  */
 void osal_clock_sleep_ms(int ms);
 
+/**
+ * Sleep (us).
+ *
+ * @note
+ *	Actual resolution is platform dependent.
+ *
+ * @param [in] us
+ *	Number of microseconds to sleep.
+ */
+void osal_clock_sleep_us(int us);
+
 #endif
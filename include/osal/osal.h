@@ -25,6 +25,7 @@
 #ifndef OSAL_OSAL_H_
 #define OSAL_OSAL_H_
 
+#include "atomic.h"
 #include "clock.h"
 #include "cond.h"
 #include "err.h"
@@ -61,6 +61,8 @@ IL_BEGIN_DECL
 #define IL_EIO		-9
 /** Not supported. */
 #define IL_ENOTSUP	-10
+/** Resource busy. */
+#define IL_EBUSY	-11
 
 /**
  * Obtain library last error details.
@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef PUBLIC_INGENIALINK_GROUP_H_
+#define PUBLIC_INGENIALINK_GROUP_H_
+
+#include "servo.h"
+
+IL_BEGIN_DECL
+
+/**
+ * @file ingenialink/group.h
+ * @brief Servo groups.
+ * @defgroup IL_GROUP Servo groups
+ * @ingroup IL
+ * @{
+ */
+
+/** IngeniaLink servo group. */
+typedef struct il_servo_group il_servo_group_t;
+
+/**
+ * Create a servo group.
+ *
+ * @note
+ *	Servos may belong to different networks. Only E-USB servos are
+ *	supported.
+ *
+ * @param [in] servos
+ *	Servos (the group keeps a reference to each of them).
+ * @param [in] cnt
+ *	Number of servos.
+ *
+ * @return
+ *	Group instance (NULL if it could not be created).
+ */
+IL_EXPORT il_servo_group_t *il_servo_group_create(il_servo_t **servos,
+						  size_t cnt);
+
+/**
+ * Destroy a servo group.
+ *
+ * @param [in] grp
+ *	Group instance.
+ */
+IL_EXPORT void il_servo_group_destroy(il_servo_group_t *grp);
+
+/**
+ * Set the position of all servos in the group (synchronized).
+ *
+ * @note
+ *	This is equivalent to calling il_servo_position_set on each servo, but
+ *	the set-point dispatch is synchronized: all targets are staged first
+ *	(pipelined per network), then the new set-point edges are fired back
+ *	to back and the set-point acknowledgements of all servos are awaited
+ *	concurrently. The measured inter-axis skew can be obtained with
+ *	il_servo_group_skew_get.
+ *
+ * @param [in] grp
+ *	Group instance.
+ * @param [in] pos
+ *	Positions, one per servo (in the current position units of each
+ *	servo).
+ * @param [in] immediate
+ *	If set, the positions will be set immediately, otherwise they will be
+ *	queued (only in profile position mode).
+ * @param [in] relative
+ *	If set, the positions are taken as relative, otherwise as absolute.
+ * @param [in] sp_timeout
+ *	Set-point acknowledge timeout (ms), shared by all servos.
+ *
+ * @return
+ *	0 on success, first error code otherwise.
+ */
+IL_EXPORT int il_servo_group_position_set(il_servo_group_t *grp,
+					  const double *pos, int immediate,
+					  int relative, int sp_timeout);
+
+/**
+ * Obtain the inter-axis skew of the last synchronized set-point dispatch.
+ *
+ * @note
+ *	The skew is the time elapsed between the first and the last
+ *	confirmed new set-point edge. It is 0 if less than two servos were
+ *	in profile position mode and enabled.
+ *
+ * @param [in] grp
+ *	Group instance.
+ *
+ * @return
+ *	Skew (us).
+ */
+IL_EXPORT double il_servo_group_skew_get(il_servo_group_t *grp);
+
+/** @} */
+
+IL_END_DECL
+
+#endif
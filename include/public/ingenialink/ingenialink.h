@@ -28,8 +28,10 @@
 #include "const.h"
 #include "dict.h"
 #include "err.h"
+#include "group.h"
 #include "monitor.h"
 #include "poller.h"
+#include "reactor.h"
 #include "version.h"
 
 /**
@@ -26,6 +26,7 @@
 #define PUBLIC_INGENIALINK_NET_H_
 
 #include "common.h"
+#include "reactor.h"
 
 IL_BEGIN_DECL
 
@@ -48,7 +49,43 @@ typedef enum {
 	IL_NET_PROT_MCB,
 } il_net_prot_t;
 
-/** Network initialization options. */
+/**
+ * Virtual drive options.
+ *
+ * @note
+ *	Used by the E-USB virtual network, which is served by an in-process
+ *	simulated drive (CiA-402 power state machine, register map). The
+ *	monitor samples mapped registers at the configured period, but
+ *	triggers are not emulated (acquisition starts when enabled).
+ */
+typedef struct {
+	/** Dictionary used to seed the register map (optional). */
+	const char *dict;
+	/** Response latency (us). */
+	int latency;
+	/** Response latency jitter (us). */
+	int jitter;
+} il_net_virtual_opts_t;
+
+/** Subscriber events dispatch mode. */
+typedef enum {
+	/** Events are delivered from a network dispatcher thread. */
+	IL_NET_DISPATCH_THREAD,
+	/**
+	 * Events are delivered by the user (il_net_events_process), which
+	 * must be called periodically for servo statusword waits to complete.
+	 */
+	IL_NET_DISPATCH_MANUAL,
+} il_net_dispatch_t;
+
+/**
+ * Network initialization options.
+ *
+ * @note
+ *	New fields may be added in future releases, so options should always
+ *	be initialized with il_net_opts_init() (or zero-initialized) before
+ *	setting the relevant fields.
+ */
 typedef struct {
 	/** Port. */
 	const char *port;
@@ -56,6 +93,43 @@ typedef struct {
 	int timeout_rd;
 	/** Write timeout (ms). */
 	int timeout_wr;
+	/** Maximum number of in-flight transfers (0 to use default). */
+	int window;
+	/**
+	 * I/O reactor (NULL to use a private one, or a dedicated listener
+	 * thread where reactors are not supported).
+	 */
+	il_reactor_t *reactor;
+	/** Virtual drive options (virtual port only, NULL to use defaults). */
+	const il_net_virtual_opts_t *virt;
+	/**
+	 * Adaptive read timeout flag (E-USB only). If set, the read timeout of
+	 * each node is derived from its measured round trip time, bounded by
+	 * the read timeout.
+	 */
+	int adaptive;
+	/** Read retries on timeout (E-USB only). */
+	int retries;
+	/** Subscriber events (statusword, emergencies) dispatch mode. */
+	il_net_dispatch_t dispatch;
+	/**
+	 * Statusword and emergencies poll period (ms, MCB only). MCB drives do
+	 * not push events, so subscribed nodes are polled in the background
+	 * (0 to use default, negative to disable).
+	 */
+	int sw_poll;
+	/**
+	 * Servo configuration cache file (E-USB only, NULL to disable). If set,
+	 * servo configuration and information (except the name, which is
+	 * always read from the servo) are restored from it when a servo is
+	 * created. Entries are keyed by serial number and validated with a
+	 * fingerprint of the registers they derive from: firmware version,
+	 * rated torque, motor type, pole pitch, stroke, pair poles, and the
+	 * position and velocity sensors with their encoder resolutions. A
+	 * change in any of them invalidates the entry, so it is read from the
+	 * servo and the cache is refreshed.
+	 */
+	const char *cache;
 } il_net_opts_t;
 
 /** Default read timeout (ms). */
@@ -64,6 +138,21 @@ typedef struct {
 /** Default write timeout (ms). */
 #define IL_NET_TIMEOUT_WR_DEF	500
 
+/** Minimum adaptive read timeout (ms). */
+#define IL_NET_TIMEOUT_RD_MIN	2
+
+/** Maximum number of read retries. */
+#define IL_NET_RETRIES_MAX	8
+
+/** Default in-flight transfers window. */
+#define IL_NET_WINDOW_DEF	4
+
+/** Maximum in-flight transfers window. */
+#define IL_NET_WINDOW_MAX	32
+
+/** Default statusword and emergencies poll period (ms, MCB only). */
+#define IL_NET_SW_POLL_DEF	20
+
 /** Network state. */
 typedef enum {
 	/** Connected. */
@@ -87,6 +176,103 @@ typedef struct il_net_dev_list {
 } il_net_dev_list_t;
 #endif
 
+/** Network transfer (batch element). */
+typedef struct {
+	/** Node id. */
+	uint16_t id;
+	/** Address. */
+	uint32_t address;
+	/** Data buffer (output on reads, input on writes). */
+	void *buf;
+	/** Data buffer size. */
+	size_t sz;
+	/** Write flag (non-zero for writes). */
+	int write;
+	/** Result (0 on success, error code otherwise). */
+	int r;
+	/**
+	 * Confirmation flag (writes only). If set, the written value is read
+	 * back and verified (IL_EIO on mismatch).
+	 */
+	int confirmed;
+} il_net_xfer_t;
+
+/**
+ * Segmented transfer progress callback.
+ *
+ * @param [in] ctx
+ *	Context.
+ * @param [in] done
+ *	Number of bytes transferred so far.
+ * @param [in] total
+ *	Total number of bytes.
+ */
+typedef void (*il_net_progress_cb_t)(void *ctx, size_t done, size_t total);
+
+/** Number of round trip time histogram buckets. */
+#define IL_NET_STATS_RTT_BUCKETS	24
+
+/**
+ * Network statistics.
+ *
+ * @note
+ *	Counters are cumulative since network creation (or last reset).
+ *	Requests are transmitted in two priority classes: control (writes,
+ *	statusword polling) and bulk (reads, monitoring, segmented transfers).
+ *	Pending control requests are always transmitted first, at the next
+ *	frame boundary.
+ */
+typedef struct {
+	/** Transmitted frames. */
+	uint64_t tx_frames;
+	/** Transmitted bytes. */
+	uint64_t tx_bytes;
+	/** Received frames. */
+	uint64_t rx_frames;
+	/** Received bytes. */
+	uint64_t rx_bytes;
+	/** Timed out transfers. */
+	uint64_t timeouts;
+	/** Decoder re-synchronizations (discarded data). */
+	uint64_t resyncs;
+	/** Confirmed writes with mismatching read-back value. */
+	uint64_t mismatches;
+	/** Frames with CRC errors. */
+	uint64_t crc_errors;
+	/** Control (high priority) requests. */
+	uint64_t ctl_requests;
+	/** Control requests total wait time for transmission (us). */
+	uint64_t ctl_wait;
+	/** Control requests maximum wait time for transmission (us). */
+	uint64_t ctl_wait_max;
+	/** Delivered subscriber events. */
+	uint64_t events;
+	/** Subscriber events dropped (events queue overflow). */
+	uint64_t events_dropped;
+	/** Statusword updates coalesced (events queue overflow). */
+	uint64_t events_coalesced;
+} il_net_stats_t;
+
+/**
+ * Write-behind statistics (per register).
+ *
+ * @note
+ *	Only the newest pending value of each register is transmitted, so
+ *	requests = writes + coalesced + pending (0 or 1).
+ */
+typedef struct {
+	/** Requested updates. */
+	uint64_t requests;
+	/** Transmitted updates. */
+	uint64_t writes;
+	/** Updates superseded by a newer value (never transmitted). */
+	uint64_t coalesced;
+	/** Failed transmissions. */
+	uint64_t errors;
+	/** Effective update rate (Hz, smoothed). */
+	double rate;
+} il_net_wb_stats_t;
+
 /** Network servos list. */
 typedef struct il_net_servos_list {
 	/** Node id. */
@@ -98,6 +284,26 @@ typedef struct il_net_servos_list {
 /** Node found callback. */
 typedef void (*il_net_servos_on_found_t)(void *ctx, uint8_t id);
 
+#ifdef IL_HAS_DEVMON
+/** Network discovery list (one element per node). */
+typedef struct il_net_discovery_list {
+	/** Port. */
+	char port[IL_NET_PORT_SZ];
+	/** Node id. */
+	uint8_t id;
+	/** Serial number (0 if not available). */
+	uint32_t serial;
+	/** Product code (0 if not available). */
+	uint32_t prod_code;
+	/** Next node. */
+	struct il_net_discovery_list *next;
+} il_net_discovery_list_t;
+
+/** Discovery node found callback. */
+typedef void (*il_net_discovery_on_found_t)(void *ctx, const char *port,
+					    uint8_t id);
+#endif
+
 /** Device monitor event types. */
 typedef enum {
 	/** Device added */
@@ -113,6 +319,18 @@ typedef struct il_net_dev_mon il_net_dev_mon_t;
 typedef void (*il_net_dev_on_evt_t)(void *ctx, il_net_dev_evt_t evt,
 				      const char *port);
 
+/**
+ * Initialize network options with default values.
+ *
+ * @note
+ *	All options are set to their defaults: no port, default timeouts and
+ *	window, dedicated listener thread, dispatcher thread and no cache.
+ *
+ * @param [out] opts
+ *	Network initialization options.
+ */
+IL_EXPORT void il_net_opts_init(il_net_opts_t *opts);
+
 /**
  * Create a network.
  *
@@ -190,6 +408,173 @@ IL_EXPORT il_net_state_t il_net_state_get(il_net_t *net);
  */
 IL_EXPORT const char *il_net_port_get(il_net_t *net);
 
+/**
+ * Perform a batch of raw transfers.
+ *
+ * @note
+ *	Frames are sent back to back, so that the network round trip is shared
+ *	by all transfers. Confirmed writes are read back right after being
+ *	written (pipelined with the rest of the batch), and verified once the
+ *	read back is received. The result of each transfer is stored in its
+ *	result field.
+ *
+ * @param [in] net
+ *	  Network.
+ * @param [in, out] xfers
+ *	Transfers.
+ * @param [in] cnt
+ *	Number of transfers.
+ *
+ * @returns
+ *	0 if all transfers succeeded, first error code otherwise.
+ */
+IL_EXPORT int il_net_transfer_batch(il_net_t *net, il_net_xfer_t *xfers,
+				    size_t cnt);
+
+/**
+ * Read a register of arbitrary size (segmented).
+ *
+ * @note
+ *	Registers larger than a frame (e.g. strings or tables) are transferred
+ *	in segments, pipelined as a batch. Progress is reported in order, from
+ *	the calling thread (the callback must not use the network).
+ *
+ * @param [in] net
+ *	  Network.
+ * @param [in] id
+ *	Node id.
+ * @param [in] address
+ *	Address.
+ * @param [out] buf
+ *	Buffer where to store received data.
+ * @param [in] sz
+ *	Number of bytes to be read.
+ * @param [in] cb
+ *	Progress callback (optional).
+ * @param [in] ctx
+ *	Progress callback context.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_net_read_segmented(il_net_t *net, uint16_t id,
+				    uint32_t address, void *buf, size_t sz,
+				    il_net_progress_cb_t cb, void *ctx);
+
+/**
+ * Write a register of arbitrary size (segmented).
+ *
+ * @note
+ *	See il_net_read_segmented. If confirmed, each segment is read back
+ *	right after being written and verified (IL_EIO on mismatch).
+ *
+ * @param [in] net
+ *	  Network.
+ * @param [in] id
+ *	Node id.
+ * @param [in] address
+ *	Address.
+ * @param [in] buf
+ *	Buffer to be sent.
+ * @param [in] sz
+ *	Number of bytes to be sent.
+ * @param [in] confirmed
+ *	Confirm write.
+ * @param [in] cb
+ *	Progress callback (optional).
+ * @param [in] ctx
+ *	Progress callback context.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_net_write_segmented(il_net_t *net, uint16_t id,
+				     uint32_t address, const void *buf,
+				     size_t sz, int confirmed,
+				     il_net_progress_cb_t cb, void *ctx);
+
+/**
+ * Obtain network statistics.
+ *
+ * @param [in] net
+ *	  Network.
+ * @param [out] stats
+ *	Where statistics will be stored.
+ */
+IL_EXPORT void il_net_stats_get(il_net_t *net, il_net_stats_t *stats);
+
+/**
+ * Obtain the round trip time histogram of a node.
+ *
+ * @note
+ *	Bucket i counts round trips whose duration (us) satisfies
+ *	2^i <= rtt < 2^(i + 1) (bucket 0 also counts rtt < 1 us). The last
+ *	bucket counts all longer round trips.
+ *
+ * @param [in] net
+ *	  Network.
+ * @param [in] id
+ *	Node id.
+ * @param [out] hist
+ *	Histogram (IL_NET_STATS_RTT_BUCKETS elements).
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_net_stats_rtt_get(il_net_t *net, uint16_t id, uint64_t *hist);
+
+/**
+ * Obtain the current read timeout of a node.
+ *
+ * @note
+ *	With adaptive timeouts, the timeout is computed from the smoothed round
+ *	trip time and its variation (Jacobson/Karels), doubled on every timeout
+ *	until a new round trip is measured. Otherwise, the network read timeout
+ *	is returned.
+ *
+ * @param [in] net
+ *	  Network.
+ * @param [in] id
+ *	Node id.
+ *
+ * @returns
+ *	Read timeout (ms).
+ */
+IL_EXPORT int il_net_timeout_rd_get(il_net_t *net, uint16_t id);
+
+/**
+ * Reset network statistics.
+ *
+ * @param [in] net
+ *	  Network.
+ */
+IL_EXPORT void il_net_stats_reset(il_net_t *net);
+
+/**
+ * Deliver pending subscriber events.
+ *
+ * @note
+ *	Statusword updates and emergencies are decoded by the reception context
+ *	and queued (bounded queue: if full, emergencies are dropped and only
+ *	the latest statusword of each node is kept). This function delivers
+ *	queued events to their subscribers from the calling thread, and it
+ *	does not block. It can only be used if the network was created with
+ *	the IL_NET_DISPATCH_MANUAL dispatch mode.
+ *
+ * @note
+ *	In IL_NET_DISPATCH_MANUAL mode, servo statusword waits (e.g.
+ *	il_servo_enable, il_servo_disable, il_servo_fault_reset or
+ *	il_servo_homing_wait) are fed by these events, so another thread must
+ *	keep calling this function while they run, otherwise they time out.
+ *
+ * @param [in] net
+ *	  Network.
+ *
+ * @returns
+ *	Number of delivered events, error code otherwise.
+ */
+IL_EXPORT int il_net_events_process(il_net_t *net);
+
 /**
  * Obtain network servos list.
  *
@@ -306,6 +691,47 @@ IL_EXPORT void il_net_dev_list_destroy(il_net_dev_list_t *lst);
 #define il_net_dev_list_foreach(item, lst) \
 	for ((item) = (lst); (item); (item) = (item)->next)
 
+/**
+ * Discover all nodes on all network devices.
+ *
+ * @note
+ *	All network devices are probed concurrently, and the node scan of each
+ *	device ends as soon as replies stop arriving. The callback may be
+ *	called from different threads, but calls are serialized.
+ *
+ * @param [in] prot
+ *	Protocol.
+ * @param [in] on_found
+ *	Callback that will be called every time a node is found (optional).
+ * @param [in] ctx
+ *	Callback context (optional).
+ *
+ * @returns
+ *	Discovery list, ordered by device and node id (NULL if none are found
+ *	or any error occurs).
+ *
+ * @see
+ *	il_net_discovery_list_destroy
+ */
+IL_EXPORT il_net_discovery_list_t *il_net_discovery_list_get(
+		il_net_prot_t prot, il_net_discovery_on_found_t on_found,
+		void *ctx);
+
+/**
+ * Destroy network discovery list.
+ *
+ * @param [in, out] lst
+ *	Network discovery list.
+ *
+ * @see
+ *	il_net_discovery_list_get
+ */
+IL_EXPORT void il_net_discovery_list_destroy(il_net_discovery_list_t *lst);
+
+/** Utility macro to iterate over a network discovery list. */
+#define il_net_discovery_list_foreach(item, lst) \
+	for ((item) = (lst); (item); (item) = (item)->next)
+
 /** @} */
 
 #endif
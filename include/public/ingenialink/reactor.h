@@ -0,0 +1,86 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef PUBLIC_INGENIALINK_REACTOR_H_
+#define PUBLIC_INGENIALINK_REACTOR_H_
+
+#include "common.h"
+
+IL_BEGIN_DECL
+
+/**
+ * @file ingenialink/reactor.h
+ * @brief I/O reactor.
+ * @defgroup IL_REACTOR I/O reactor
+ * @ingroup IL
+ * @{
+ */
+
+/**
+ * I/O reactor.
+ *
+ * @note
+ *	A reactor multiplexes the reception of multiple networks on a reduced
+ *	set of I/O threads, instead of using a listener thread per network.
+ *	Networks are attached to a reactor at creation time (see
+ *	il_net_opts_t), and the reactor must outlive all attached networks.
+ */
+typedef struct il_reactor il_reactor_t;
+
+/** Reactor initialization options. */
+typedef struct {
+	/** Number of I/O threads (0 to use one). */
+	size_t threads;
+	/** Pin each I/O thread to a CPU (thread i to CPU i). */
+	int pin;
+} il_reactor_opts_t;
+
+/**
+ * Create an I/O reactor.
+ *
+ * @note
+ *	Only supported on Linux (epoll).
+ *
+ * @param [in] opts
+ *	Initialization options (NULL to use defaults).
+ *
+ * @return
+ *	Reactor instance (NULL if it could not be created).
+ */
+IL_EXPORT il_reactor_t *il_reactor_create(const il_reactor_opts_t *opts);
+
+/**
+ * Destroy an I/O reactor.
+ *
+ * @param [in] reactor
+ *	Reactor instance.
+ */
+IL_EXPORT void il_reactor_destroy(il_reactor_t *reactor);
+
+/** @} */
+
+IL_END_DECL
+
+#endif
@@ -129,6 +129,8 @@ typedef struct {
 	il_reg_phy_t phy;
 	/** Range. */
 	il_reg_range_t range;
+	/** Data size (bytes, strings only, 0 if unknown). */
+	size_t sz;
 	/** Labels dictionary. */
 	il_dict_labels_t *labels;
 	/** Category ID. */
@@ -41,6 +41,9 @@ IL_BEGIN_DECL
 /** IngeniaLink servo instance. */
 typedef struct il_servo il_servo_t;
 
+/** Servo register handle. */
+typedef struct il_servo_reg_handle il_servo_reg_handle_t;
+
 /** Set-point acknowledge default timeout (ms). */
 #define IL_SERVO_SP_TIMEOUT_DEF	1000
 
@@ -218,6 +221,40 @@ typedef enum {
 	IL_UNITS_ACC_M_S2,
 } il_units_acc_t;
 
+/**
+ * Asynchronous transfer completion callback.
+ *
+ * @note
+ *	Callbacks are invoked from the network reception thread, so they must
+ *	not perform synchronous transfers (IL_EBUSY is returned). Submitting
+ *	new asynchronous transfers is allowed, but fails with IL_EBUSY instead
+ *	of waiting if all in-flight transfers are in use.
+ *
+ * @param [in] ctx
+ *	Callback context.
+ * @param [in] r
+ *	Result (0 on success, error code otherwise).
+ * @param [in] value
+ *	Value read, in the current operating units (reads only).
+ */
+typedef void (*il_servo_async_cb_t)(void *ctx, int r, double value);
+
+/** Batch transfer entry. */
+typedef struct {
+	/** IngeniaLink servo. */
+	il_servo_t *servo;
+	/** Pre-defined register (optional). */
+	const il_reg_t *reg;
+	/** Register ID (used if no pre-defined register is given). */
+	const char *id;
+	/** Value, in the current operating units (output on reads). */
+	double value;
+	/** Result (0 on success, error code otherwise). */
+	int r;
+	/** Confirm the write (writes only, ignored on write-only registers). */
+	int confirm;
+} il_servo_batch_t;
+
 /**
  * Create IngeniaLink servo instance.
  *
@@ -274,10 +311,12 @@ IL_EXPORT void il_servo_state_get(il_servo_t *servo, il_servo_state_t *state,
  * Subscribe to state changes (and operation flags).
  *
  * @note
- *	Callbacks should be relatively fast, otherwise consecutive state changes
- *	may be lost (as there is no buffering). Note that callbacks are
- *	decoupled from the communications thread so that they do not affect
- *	other operations.
+ *	Callbacks are invoked from the network events context (the network
+ *	dispatcher thread, or il_net_events_process if the network uses
+ *	manual dispatching), shared by all servos on the network. They should
+ *	be relatively fast and must not block waiting for servo state changes
+ *	(e.g. il_servo_enable), as state updates are delivered from the same
+ *	context. Callbacks may unsubscribe or destroy the servo.
  *
  * @param [in] servo
  *	IngeniaLink servo instance.
@@ -307,10 +346,12 @@ IL_EXPORT void il_servo_state_unsubscribe(il_servo_t *servo, int slot);
  * Subscribe to emergency messages.
  *
  * @note
- *	Callbacks should be relatively fast, otherwise some emergencies
- *	may be lost. Although an internal queue is used, it is limited. Note
- *	that callbacks are decoupled from the communications thread so that they
- *	do not affect other operations.
+ *	Callbacks are invoked from the network events context (the network
+ *	dispatcher thread, or il_net_events_process if the network uses
+ *	manual dispatching), shared by all servos on the network. They should
+ *	be relatively fast, otherwise some emergencies may be dropped (the
+ *	network events queue is bounded). Callbacks may unsubscribe or destroy
+ *	the servo.
  *
  * @param [in] servo
  *	IngeniaLink servo.
@@ -440,6 +481,7 @@ IL_EXPORT int il_servo_store_app(il_servo_t *servo);
  * @note
  *	This must be called if any encoder parameter, rated torque or pole pitch
  *	are changed, otherwise, the readings conversions will not be correct.
+ *	If a configuration cache is enabled on the network, it is refreshed.
  *
  * @param [in] servo
  *	IngeniaLink servo.
@@ -452,6 +494,10 @@ IL_EXPORT int il_servo_units_update(il_servo_t *servo);
 /**
  * Obtain the units scale factor associated with the given register.
  *
+ * @note
+ *	Factors are precomputed when units or configuration change, so that
+ *	obtaining them does not require locking.
+ *
  * @param [in] servo
  *	IngeniaLink servo.
  * @param [in] reg
@@ -709,6 +755,32 @@ IL_EXPORT int il_servo_raw_read_s64(il_servo_t *servo, const il_reg_t *reg,
 IL_EXPORT int il_servo_raw_read_float(il_servo_t *servo, const il_reg_t *reg,
 				      const char *id, float *buf);
 
+/**
+ * Read string from a register.
+ *
+ * @note
+ *	Strings larger than a frame are read in segments (see
+ *	il_net_read_segmented). At most the register size is read, so the
+ *	register size must be known (see il_reg_t). The string is always
+ *	null-terminated.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] reg
+ *	Register.
+ * @param [in] id
+ *	Register id.
+ * @param [out] buf
+ *	Buffer where to store received string.
+ * @param [in] sz
+ *	Buffer size.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_servo_raw_read_str(il_servo_t *servo, const il_reg_t *reg,
+				    const char *id, char *buf, size_t sz);
+
 /**
  * Read a register.
  *
@@ -910,6 +982,33 @@ IL_EXPORT int il_servo_raw_write_s64(il_servo_t *servo, const il_reg_t *reg,
 IL_EXPORT int il_servo_raw_write_float(il_servo_t *servo, const il_reg_t *reg,
 				       const char *id, float val, int confirm);
 
+/**
+ * Write string to a register.
+ *
+ * @note
+ *	The string is written including its null terminator, in segments if
+ *	larger than a frame (see il_net_write_segmented). If the register size
+ *	is known, longer strings are rejected and the terminator is dropped
+ *	when the string fills the register.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] reg
+ *	Pre-defined register.
+ * @param [in] id
+ *	Register ID.
+ * @param [in] val
+ *	String.
+ * @param [in] confirm
+ *	Confirm the write.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_servo_raw_write_str(il_servo_t *servo, const il_reg_t *reg,
+				     const char *id, const char *val,
+				     int confirm);
+
 /**
  * Write to a register.
  *
@@ -933,6 +1032,236 @@ IL_EXPORT int il_servo_raw_write_float(il_servo_t *servo, const il_reg_t *reg,
 IL_EXPORT int il_servo_write(il_servo_t *servo, const il_reg_t *reg,
 			     const char *id, double val, int confirm);
 
+/**
+ * Read from a register asynchronously.
+ *
+ * @note
+ *	The function returns as soon as the read petition is sent. Completion
+ *	(or timeout) is notified through the given callback. The servo must not
+ *	be destroyed while it has asynchronous transfers in flight.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] reg
+ *	Pre-defined register.
+ * @param [in] id
+ *	Register id.
+ * @param [in] cb
+ *	Completion callback.
+ * @param [in] ctx
+ *	Completion callback context.
+ *
+ * @returns
+ *	0 if the read was submitted, IL_EBUSY if submitted from a completion
+ *	callback with no transfers available, error code otherwise (the
+ *	callback will not be invoked).
+ */
+IL_EXPORT int il_servo_read_async(il_servo_t *servo, const il_reg_t *reg,
+				  const char *id, il_servo_async_cb_t cb,
+				  void *ctx);
+
+/**
+ * Write to a register asynchronously.
+ *
+ * @note
+ *	The function returns as soon as the write is sent. Completion (once
+ *	confirmed if requested) is notified through the given callback.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] reg
+ *	Pre-defined register.
+ * @param [in] id
+ *	Register ID.
+ * @param [in] val
+ *	Value (will be converted to internal units).
+ * @param [in] confirm
+ *	Confirm the write.
+ * @param [in] cb
+ *	Completion callback.
+ * @param [in] ctx
+ *	Completion callback context.
+ *
+ * @returns
+ *	0 if the write was submitted, IL_EBUSY if submitted from a completion
+ *	callback with no transfers available, error code otherwise (the
+ *	callback will not be invoked).
+ */
+IL_EXPORT int il_servo_write_async(il_servo_t *servo, const il_reg_t *reg,
+				   const char *id, double val, int confirm,
+				   il_servo_async_cb_t cb, void *ctx);
+
+/**
+ * Read a batch of registers, possibly from multiple servos.
+ *
+ * @note
+ *	Transfers targeting the same network are sent back to back, sharing the
+ *	network round trip. Unit conversion is performed as in il_servo_read.
+ *
+ * @param [in, out] batch
+ *	Batch entries.
+ * @param [in] cnt
+ *	Number of entries.
+ *
+ * @returns
+ *	0 if all entries succeeded, first error code otherwise (see the result
+ *	of each entry).
+ */
+IL_EXPORT int il_servo_read_batch(il_servo_batch_t *batch, size_t cnt);
+
+/**
+ * Write a batch of registers, possibly to multiple servos.
+ *
+ * @note
+ *	Transfers targeting the same network are sent back to back. Confirmed
+ *	entries are read back right after being written, and verified once all
+ *	read backs are received, so that confirmation does not stall the
+ *	stream. Unit conversion is performed as in il_servo_write.
+ *
+ * @param [in, out] batch
+ *	Batch entries.
+ * @param [in] cnt
+ *	Number of entries.
+ *
+ * @returns
+ *	0 if all entries succeeded, first error code otherwise (see the result
+ *	of each entry).
+ */
+IL_EXPORT int il_servo_write_batch(il_servo_batch_t *batch, size_t cnt);
+
+/**
+ * Bind a register.
+ *
+ * @note
+ *	The register is resolved and validated once, so that reads and writes
+ *	through the handle (il_servo_reg_read, il_servo_reg_write) do not need
+ *	any dictionary lookup. A handle must be unbound before destroying its
+ *	servo.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] reg
+ *	Pre-defined register.
+ * @param [in] id
+ *	Register ID.
+ *
+ * @returns
+ *	Register handle (NULL if it could not be bound).
+ */
+IL_EXPORT il_servo_reg_handle_t *il_servo_reg_bind(il_servo_t *servo,
+						   const il_reg_t *reg,
+						   const char *id);
+
+/**
+ * Unbind a register.
+ *
+ * @param [in] hnd
+ *	Register handle.
+ */
+IL_EXPORT void il_servo_reg_unbind(il_servo_reg_handle_t *hnd);
+
+/**
+ * Read a bound register.
+ *
+ * @note
+ *	Unit conversion is performed as in il_servo_read.
+ *
+ * @param [in] hnd
+ *	Register handle.
+ * @param [out] buf
+ *	Where value will be stored.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_servo_reg_read(il_servo_reg_handle_t *hnd, double *buf);
+
+/**
+ * Write a bound register.
+ *
+ * @note
+ *	Unit conversion is performed as in il_servo_write. Write-behind, if
+ *	enabled on the register, applies.
+ *
+ * @param [in] hnd
+ *	Register handle.
+ * @param [in] val
+ *	Value.
+ * @param [in] confirm
+ *	Confirm the write.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_servo_reg_write(il_servo_reg_handle_t *hnd, double val,
+				 int confirm);
+
+/**
+ * Enable write-behind (latest value wins) on a register.
+ *
+ * @note
+ *	Subsequent writes to the register (il_servo_write and derived, e.g.
+ *	il_servo_velocity_set) return immediately: the value replaces any
+ *	pending (not yet transmitted) value, and a network background writer
+ *	transmits the newest value as soon as the network is available. Hence,
+ *	stale intermediate values are skipped on high-rate set-point streams.
+ *	Transmission errors are only reported in the write-behind statistics.
+ *	Asynchronous and batch writes are not affected.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] reg
+ *	Pre-defined register.
+ * @param [in] id
+ *	Register ID.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_servo_write_behind_enable(il_servo_t *servo,
+					   const il_reg_t *reg,
+					   const char *id);
+
+/**
+ * Disable write-behind on a register.
+ *
+ * @note
+ *	The pending value, if any, is written before returning.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] reg
+ *	Pre-defined register.
+ * @param [in] id
+ *	Register ID.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_servo_write_behind_disable(il_servo_t *servo,
+					    const il_reg_t *reg,
+					    const char *id);
+
+/**
+ * Obtain write-behind statistics of a register.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] reg
+ *	Pre-defined register.
+ * @param [in] id
+ *	Register ID.
+ * @param [out] stats
+ *	Where statistics will be stored.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+IL_EXPORT int il_servo_write_behind_stats_get(il_servo_t *servo,
+					      const il_reg_t *reg,
+					      const char *id,
+					      il_net_wb_stats_t *stats);
+
 /**
  * Disable servo PDS.
  *
@@ -1220,11 +1549,14 @@ IL_EXPORT int il_servo_velocity_res_get(il_servo_t *servo, uint32_t *res);
  */
 IL_EXPORT int il_servo_wait_reached(il_servo_t *servo, int timeout);
 
-#ifdef IL_HAS_DEVMON
-
 /**
  * Utility function to connect to the first available servo drive.
  *
+ * @note
+ *	Nodes are located using network discovery when the library has device
+ *	monitoring support (IL_HAS_DEVMON). Otherwise, the well-known serial
+ *	port names of the platform are probed.
+ *
  * @param [in] prot
  *	Network protocol.
  * @param [out] net
@@ -1242,8 +1574,6 @@ IL_EXPORT int il_servo_lucky(il_net_prot_t prot, il_net_t **net,
 
 /** @} */
 
-#endif
-
 IL_END_DECL
 
 #endif
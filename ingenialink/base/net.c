@@ -39,140 +39,320 @@ void il_net_base__state_set(il_net_t *net, il_net_state_t state)
 	osal_mutex_unlock(net->state_lock);
 }
 
-int il_net_base__sw_subscribe(il_net_t *net, uint16_t id,
-			      il_net_sw_subscriber_cb_t cb, void *ctx)
+int il_net_base__read_async(il_net_t *net, uint16_t id, uint32_t address,
+			    size_t sz, il_net_async_cb_t cb, void *ctx,
+			    il_net_prio_t prio)
+{
+	int r;
+	uint8_t buf[8];
+
+	/* synchronous fallback: complete in place */
+	if (sz > sizeof(buf)) {
+		ilerr__set("Data size is too large");
+		return IL_EINVAL;
+	}
+
+	r = il_net__read(net, id, address, buf, sz, prio);
+	if (r < 0)
+		cb(ctx, r, NULL, 0);
+	else
+		cb(ctx, 0, buf, sz);
+
+	return 0;
+}
+
+int il_net_base__write_async(il_net_t *net, uint16_t id, uint32_t address,
+			     const void *buf, size_t sz, int confirmed,
+			     il_net_async_cb_t cb, void *ctx,
+			     il_net_prio_t prio)
+{
+	int r;
+
+	/* synchronous fallback: complete in place */
+	r = il_net__write(net, id, address, buf, sz, confirmed, prio);
+	cb(ctx, r, NULL, 0);
+
+	return 0;
+}
+
+int il_net_base__transfer_batch(il_net_t *net, il_net_xfer_t *xfers,
+				size_t cnt, il_net_prio_t prio)
 {
 	int r = 0;
-	int slot;
+	size_t i;
+
+	/* sequential fallback */
+	for (i = 0; i < cnt; i++) {
+		if (xfers[i].write)
+			xfers[i].r = il_net__write(net, xfers[i].id,
+						   xfers[i].address,
+						   xfers[i].buf, xfers[i].sz,
+						   xfers[i].confirmed, prio);
+		else
+			xfers[i].r = il_net__read(net, xfers[i].id,
+						  xfers[i].address,
+						  xfers[i].buf, xfers[i].sz,
+						  prio);
+
+		if ((xfers[i].r < 0) && (r == 0))
+			r = xfers[i].r;
+	}
 
-	osal_mutex_lock(net->sw_subs.lock);
+	return r;
+}
 
-	/* check if already subscribed */
-	for (slot = 0; slot < net->sw_subs.sz; slot++) {
-		if (net->sw_subs.subs[slot].id == id) {
-			ilerr__set("Node already subscribed");
-			r = IL_EALREADY;
-			goto unlock;
-		}
+int il_net_base__read_segmented(il_net_t *net, uint16_t id, uint32_t address,
+				void *buf, size_t sz, il_net_progress_cb_t cb,
+				void *ctx)
+{
+	int r;
+
+	/* single transfer fallback: progress reported once complete */
+	r = il_net__read(net, id, address, buf, sz, IL_NET_PRIO_BULK);
+	if ((r == 0) && cb)
+		cb(ctx, sz, sz);
+
+	return r;
+}
+
+int il_net_base__write_segmented(il_net_t *net, uint16_t id, uint32_t address,
+				 const void *buf, size_t sz, int confirmed,
+				 il_net_progress_cb_t cb, void *ctx)
+{
+	int r;
+
+	/* single transfer fallback: progress reported once complete */
+	r = il_net__write(net, id, address, buf, sz, confirmed,
+			  IL_NET_PRIO_BULK);
+	if ((r == 0) && cb)
+		cb(ctx, sz, sz);
+
+	return r;
+}
+
+/**
+ * Wait until the subscribers reader has left any delivery that may have
+ * seen unlinked entries (grace period).
+ *
+ * @note
+ *	Entries unlinked before calling this function are no longer in use
+ *	when it returns. Only the delivery in progress (if any) is waited for,
+ *	so it completes even if events are delivered back to back. Must be
+ *	called without the writers lock held, so that other writers are not
+ *	blocked meanwhile.
+ *
+ * @param [in] epoch
+ *	Reader epoch.
+ */
+static void subs_synchronize(volatile uint32_t *epoch)
+{
+	uint32_t epoch_;
+
+	epoch_ = osal_atomic_load_u32(epoch);
+	if (!(epoch_ & 1))
+		return;
+
+	while (osal_atomic_load_u32(epoch) == epoch_)
+		osal_clock_sleep_ms(NET_SUBS_GRACE_POLL);
+}
+
+/**
+ * Obtain a free subscribers slot (growing the slots array if needed).
+ *
+ * @note
+ *	Must be called with the writers lock held.
+ *
+ * @param [in, out] slots
+ *	Slots array.
+ * @param [in, out] sz
+ *	Number of slots.
+ *
+ * @return
+ *	Slot, error code otherwise.
+ */
+static int subs_slot_get(void ***slots, int *sz)
+{
+	int slot, sz_;
+	void **slots_;
+
+	for (slot = 0; slot < *sz; slot++) {
+		if (!(*slots)[slot])
+			return slot;
 	}
 
-	/* look for the first empty slot */
-	for (slot = 0; slot < net->sw_subs.sz; slot++) {
-		if (!net->sw_subs.subs[slot].cb)
-			break;
+	sz_ = *sz ? 2 * *sz : NET_SUBS_SLOTS_DEF;
+	slots_ = realloc(*slots, sz_ * sizeof(*slots_));
+	if (!slots_) {
+		ilerr__set("Subscribers slots allocation failed");
+		return IL_ENOMEM;
 	}
 
-	/* increase array if no space left */
-	if (slot == net->sw_subs.sz) {
-		size_t sz;
-		il_net_sw_subscriber_t *subs;
+	memset(&slots_[*sz], 0, (sz_ - *sz) * sizeof(*slots_));
 
-		/* double in size on each realloc */
-		sz = 2 * net->sw_subs.sz * sizeof(*subs);
-		subs = realloc(net->sw_subs.subs, sz);
-		if (!subs) {
-			ilerr__set("Subscribers re-allocation failed");
-			r = IL_ENOMEM;
-			goto unlock;
-		}
+	*slots = slots_;
+	*sz = sz_;
+
+	return slot;
+}
+
+int il_net_base__sw_subscribe(il_net_t *net, uint16_t id,
+			      il_net_sw_subscriber_cb_t cb, void *ctx)
+{
+	int r;
+	il_net_sw_subscriber_lst_t *subs = &net->sw_subs;
+	il_net_sw_subscriber_t *sub;
+
+	osal_mutex_lock(subs->lock);
+
+	r = subs_slot_get(&subs->slots, &subs->sz);
+	if (r < 0)
+		goto unlock;
 
-		net->sw_subs.subs = subs;
-		net->sw_subs.sz = sz;
+	sub = malloc(sizeof(*sub));
+	if (!sub) {
+		ilerr__set("Subscriber allocation failed");
+		r = IL_ENOMEM;
+		goto unlock;
 	}
 
-	net->sw_subs.subs[slot].id = id;
-	net->sw_subs.subs[slot].cb = cb;
-	net->sw_subs.subs[slot].ctx = ctx;
+	sub->id = id;
+	sub->cb = cb;
+	sub->ctx = ctx;
+	sub->retired = 0;
+	sub->next = subs->subs[NET_SUBS_BUCKET(id)];
+
+	/* publish */
+	(void)osal_atomic_xchg_ptr(
+		(void *volatile *)&subs->subs[NET_SUBS_BUCKET(id)], sub);
 
-	r = slot;
+	subs->slots[r] = sub;
 
 unlock:
-	osal_mutex_unlock(net->sw_subs.lock);
+	osal_mutex_unlock(subs->lock);
 
 	return r;
 }
 
 void il_net_base__sw_unsubscribe(il_net_t *net, int slot)
 {
-	osal_mutex_lock(net->sw_subs.lock);
+	il_net_sw_subscriber_lst_t *subs = &net->sw_subs;
+	il_net_sw_subscriber_t *sub;
+	il_net_sw_subscriber_t *volatile *link;
+
+	osal_mutex_lock(subs->lock);
+
+	/* skip out of range or free slot */
+	if ((slot < 0) || (slot >= subs->sz) || !subs->slots[slot])
+		goto unlock;
+
+	sub = subs->slots[slot];
+	subs->slots[slot] = NULL;
+
+	/* unlink (readers see either the entry or its successor) */
+	link = &subs->subs[NET_SUBS_BUCKET(sub->id)];
+	while (*link != sub)
+		link = &(*link)->next;
+
+	osal_atomic_store_u32(&sub->retired, 1);
+	(void)osal_atomic_xchg_ptr((void *volatile *)link, sub->next);
 
-	/* skip out of range slot */
-	if (slot >= net->sw_subs.sz)
+	/* from a callback: freed once the delivery completes */
+	if (il_net__in_delivery(net)) {
+		sub->retired_next = subs->retired;
+		subs->retired = sub;
 		goto unlock;
+	}
+
+	/* unreachable by writers: wait for readers without blocking them */
+	osal_mutex_unlock(subs->lock);
+
+	subs_synchronize(&subs->epoch);
+	free(sub);
 
-	net->sw_subs.subs[slot].id = 0;
-	net->sw_subs.subs[slot].cb = NULL;
-	net->sw_subs.subs[slot].ctx = NULL;
+	return;
 
 unlock:
-	osal_mutex_unlock(net->sw_subs.lock);
+	osal_mutex_unlock(subs->lock);
 }
 
 int il_net_base__emcy_subscribe(il_net_t *net, uint16_t id,
 				il_net_emcy_subscriber_cb_t cb, void *ctx)
 {
 	int r;
-	int slot;
-
-	/* check if already subscribed */
-	for (slot = 0; slot < net->emcy_subs.sz; slot++) {
-		if (net->emcy_subs.subs[slot].id == id) {
-			ilerr__set("Node already subscribed");
-			r = IL_EALREADY;
-			goto unlock;
-		}
-	}
-
-	/* look for the first empty slot */
-	for (slot = 0; slot < net->emcy_subs.sz; slot++) {
-		if (!net->emcy_subs.subs[slot].cb)
-			break;
-	}
+	il_net_emcy_subscriber_lst_t *subs = &net->emcy_subs;
+	il_net_emcy_subscriber_t *sub;
 
-	/* increase array if no space left */
-	if (slot == net->emcy_subs.sz) {
-		size_t sz;
-		il_net_emcy_subscriber_t *subs;
+	osal_mutex_lock(subs->lock);
 
-		/* double in size on each realloc */
-		sz = 2 * net->emcy_subs.sz * sizeof(*subs);
-		subs = realloc(net->emcy_subs.subs, sz);
-		if (!subs) {
-			ilerr__set("Subscribers re-allocation failed");
-			r = IL_ENOMEM;
-			goto unlock;
-		}
+	r = subs_slot_get(&subs->slots, &subs->sz);
+	if (r < 0)
+		goto unlock;
 
-		net->emcy_subs.subs = subs;
-		net->emcy_subs.sz = sz;
+	sub = malloc(sizeof(*sub));
+	if (!sub) {
+		ilerr__set("Subscriber allocation failed");
+		r = IL_ENOMEM;
+		goto unlock;
 	}
 
-	net->emcy_subs.subs[slot].id = id;
-	net->emcy_subs.subs[slot].cb = cb;
-	net->emcy_subs.subs[slot].ctx = ctx;
+	sub->id = id;
+	sub->cb = cb;
+	sub->ctx = ctx;
+	sub->retired = 0;
+	sub->next = subs->subs[NET_SUBS_BUCKET(id)];
 
-	r = slot;
+	/* publish */
+	(void)osal_atomic_xchg_ptr(
+		(void *volatile *)&subs->subs[NET_SUBS_BUCKET(id)], sub);
+
+	subs->slots[r] = sub;
 
 unlock:
-	osal_mutex_unlock(net->emcy_subs.lock);
+	osal_mutex_unlock(subs->lock);
 
 	return r;
 }
 
 void il_net_base__emcy_unsubscribe(il_net_t *net, int slot)
 {
-	osal_mutex_lock(net->emcy_subs.lock);
+	il_net_emcy_subscriber_lst_t *subs = &net->emcy_subs;
+	il_net_emcy_subscriber_t *sub;
+	il_net_emcy_subscriber_t *volatile *link;
+
+	osal_mutex_lock(subs->lock);
+
+	/* skip out of range or free slot */
+	if ((slot < 0) || (slot >= subs->sz) || !subs->slots[slot])
+		goto unlock;
 
-	/* skip out of range slot */
-	if (slot >= net->emcy_subs.sz)
+	sub = subs->slots[slot];
+	subs->slots[slot] = NULL;
+
+	/* unlink (readers see either the entry or its successor) */
+	link = &subs->subs[NET_SUBS_BUCKET(sub->id)];
+	while (*link != sub)
+		link = &(*link)->next;
+
+	osal_atomic_store_u32(&sub->retired, 1);
+	(void)osal_atomic_xchg_ptr((void *volatile *)link, sub->next);
+
+	/* from a callback: freed once the delivery completes */
+	if (il_net__in_delivery(net)) {
+		sub->retired_next = subs->retired;
+		subs->retired = sub;
 		goto unlock;
+	}
+
+	/* unreachable by writers: wait for readers without blocking them */
+	osal_mutex_unlock(subs->lock);
 
-	net->emcy_subs.subs[slot].id = 0;
-	net->emcy_subs.subs[slot].cb = NULL;
-	net->emcy_subs.subs[slot].ctx = NULL;
+	subs_synchronize(&subs->epoch);
+	free(sub);
+
+	return;
 
 unlock:
-	osal_mutex_unlock(net->emcy_subs.lock);
+	osal_mutex_unlock(subs->lock);
 }
 
 int il_net_base__init(il_net_t *net, const il_net_opts_t *opts)
@@ -183,76 +363,122 @@ int il_net_base__init(il_net_t *net, const il_net_opts_t *opts)
 	net->port = strdup(opts->port);
 	net->timeout_rd = opts->timeout_rd;
 	net->timeout_wr = opts->timeout_wr;
+	net->adaptive = opts->adaptive;
+	net->retries = MIN(MAX(opts->retries, 0), IL_NET_RETRIES_MAX);
+
+	/* initialize transmission scheduler */
+	memset(&net->sched, 0, sizeof(net->sched));
 
-	/* initialize network lock */
-	net->lock = osal_mutex_create();
-	if (!net->lock) {
+	net->sched.lock = osal_mutex_create();
+	if (!net->sched.lock) {
 		ilerr__set("Network lock allocation failed");
 		r = IL_ENOMEM;
 		goto cleanup_init;
 	}
 
+	net->sched.turn = osal_cond_create();
+	if (!net->sched.turn) {
+		ilerr__set("Network scheduler allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_lock;
+	}
+
 	/* initialize network state */
 	net->state_lock = osal_mutex_create();
 	if (!net->state_lock) {
 		ilerr__set("Network state lock allocation failed");
 		r = IL_ENOMEM;
-		goto cleanup_lock;
+		goto cleanup_turn;
 	}
 
 	net->state = IL_NET_STATE_DISCONNECTED;
 
 	/* initialize statusword update subscribers */
-	net->sw_subs.subs = calloc(SW_SUBS_SZ_DEF, sizeof(*net->sw_subs.subs));
-	if (!net->sw_subs.subs) {
-		ilerr__set("Network statusword subscribers allocation failed");
-		r = IL_ENOMEM;
-		goto cleanup_state_lock;
-	}
+	memset(&net->sw_subs, 0, sizeof(net->sw_subs));
 
 	net->sw_subs.lock = osal_mutex_create();
 	if (!net->sw_subs.lock) {
 		ilerr__set("Network statusword lock allocation failed");
 		r = IL_ENOMEM;
-		goto cleanup_sw_subs_subs;
+		goto cleanup_state_lock;
 	}
 
-	net->sw_subs.sz = SW_SUBS_SZ_DEF;
-
 	/* initialize emcy update subscribers */
-	net->emcy_subs.subs = calloc(EMCY_SUBS_SZ_DEF,
-				     sizeof(*net->emcy_subs.subs));
-	if (!net->emcy_subs.subs) {
-		ilerr__set("Network emergency subscribers allocation failed");
-		r = IL_ENOMEM;
-		goto cleanup_sw_subs_lock;
-	}
+	memset(&net->emcy_subs, 0, sizeof(net->emcy_subs));
 
 	net->emcy_subs.lock = osal_mutex_create();
 	if (!net->emcy_subs.lock) {
 		ilerr__set("Network emergency lock allocation failed");
 		r = IL_ENOMEM;
-		goto cleanup_emcy_subs_subs;
+		goto cleanup_sw_subs_lock;
+	}
+
+	/* initialize statistics */
+	memset(&net->stats, 0, sizeof(net->stats));
+
+	net->rtt = calloc(NET_STATS_NODES, sizeof(*net->rtt));
+	if (!net->rtt) {
+		ilerr__set("Network statistics allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_emcy_subs_lock;
+	}
+
+	net->rto = calloc(NET_STATS_NODES, sizeof(*net->rto));
+	if (!net->rto) {
+		ilerr__set("Network timeout estimators allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_rtt;
 	}
 
-	net->emcy_subs.sz = EMCY_SUBS_SZ_DEF;
+	/* initialize subscriber events queue */
+	r = il_net__events_init(net, opts->dispatch);
+	if (r < 0)
+		goto cleanup_rto;
+
+	/* initialize write-behind writer */
+	r = il_net__wb_init(net);
+	if (r < 0)
+		goto cleanup_events;
+
+	/* initialize servo configuration cache (optional) */
+	if (opts->cache) {
+		net->cache = il_cache__create(opts->cache);
+		if (!net->cache) {
+			r = IL_ENOMEM;
+			goto cleanup_wb;
+		}
+	} else {
+		net->cache = NULL;
+	}
 
 	return 0;
 
-cleanup_emcy_subs_subs:
-	free(net->emcy_subs.subs);
+cleanup_wb:
+	il_net__wb_deinit(net);
+
+cleanup_events:
+	il_net__events_deinit(net);
+
+cleanup_rto:
+	free(net->rto);
+
+cleanup_rtt:
+	free(net->rtt);
+
+cleanup_emcy_subs_lock:
+	osal_mutex_destroy(net->emcy_subs.lock);
 
 cleanup_sw_subs_lock:
 	osal_mutex_destroy(net->sw_subs.lock);
 
-cleanup_sw_subs_subs:
-	free(net->sw_subs.subs);
-
 cleanup_state_lock:
 	osal_mutex_destroy(net->state_lock);
 
+cleanup_turn:
+	osal_cond_destroy(net->sched.turn);
+
 cleanup_lock:
-	osal_mutex_destroy(net->lock);
+	osal_mutex_destroy(net->sched.lock);
 
 cleanup_init:
 	free(net->port);
@@ -262,15 +488,46 @@ cleanup_init:
 
 void il_net_base__deinit(il_net_t *net)
 {
-	osal_mutex_destroy(net->emcy_subs.lock);
-	free(net->emcy_subs.subs);
+	int slot;
+
+	if (net->cache)
+		il_cache__destroy(net->cache);
+
+	il_net__wb_deinit(net);
+	il_net__events_deinit(net);
+
+	free(net->rto);
+	free(net->rtt);
 
+	for (slot = 0; slot < net->emcy_subs.sz; slot++)
+		free(net->emcy_subs.slots[slot]);
+	free(net->emcy_subs.slots);
+
+	while (net->emcy_subs.retired) {
+		il_net_emcy_subscriber_t *sub = net->emcy_subs.retired;
+
+		net->emcy_subs.retired = sub->retired_next;
+		free(sub);
+	}
+
+	for (slot = 0; slot < net->sw_subs.sz; slot++)
+		free(net->sw_subs.slots[slot]);
+	free(net->sw_subs.slots);
+
+	while (net->sw_subs.retired) {
+		il_net_sw_subscriber_t *sub = net->sw_subs.retired;
+
+		net->sw_subs.retired = sub->retired_next;
+		free(sub);
+	}
+
+	osal_mutex_destroy(net->emcy_subs.lock);
 	osal_mutex_destroy(net->sw_subs.lock);
-	free(net->sw_subs.subs);
 
 	osal_mutex_destroy(net->state_lock);
 
-	osal_mutex_destroy(net->lock);
+	osal_cond_destroy(net->sched.turn);
+	osal_mutex_destroy(net->sched.lock);
 
 	free(net->port);
 }
@@ -23,13 +23,70 @@
  */
 
 #include "../servo.h"
+#include "../mc.h"
+
+#include <string.h>
 
 #include "ingenialink/err.h"
+#include "ingenialink/registers.h"
 
 /*******************************************************************************
  * Private
  ******************************************************************************/
 
+/**
+ * Store a units factor.
+ *
+ * @param [out] slot
+ *	Factor slot.
+ * @param [in] factor
+ *	Factor.
+ */
+static void factor_store(volatile uint64_t *slot, double factor)
+{
+	uint64_t bits;
+
+	memcpy(&bits, &factor, sizeof(bits));
+	osal_atomic_store_u64(slot, bits);
+}
+
+/**
+ * Load a units factor.
+ *
+ * @param [in] slot
+ *	Factor slot.
+ *
+ * @return
+ *	Factor.
+ */
+static double factor_load(volatile uint64_t *slot)
+{
+	uint64_t bits;
+	double factor;
+
+	bits = osal_atomic_load_u64(slot);
+	memcpy(&factor, &bits, sizeof(factor));
+
+	return factor;
+}
+
+/**
+ * Obtain the units factor of a register handle.
+ *
+ * @param [in] hnd
+ *	Register handle.
+ *
+ * @return
+ *	Units factor.
+ */
+static double hnd_factor(const il_servo_reg_handle_t *hnd)
+{
+	if (!hnd->factor)
+		return 1.;
+
+	return factor_load(hnd->factor);
+}
+
 /**
  * Obtain register (pre-defined or from dictionary).
  *
@@ -67,6 +124,233 @@ static int get_reg(il_dict_t *dict, const il_reg_t *reg_pdef,
 	return 0;
 }
 
+/**
+ * Convert a register value between network (big endian) and host byte order.
+ *
+ * @param [in] dtype
+ *	Data type.
+ * @param [in, out] v
+ *	Value.
+ */
+static void value_swap(il_reg_dtype_t dtype, il_servo_reg_value_t *v)
+{
+	switch (dtype) {
+	case IL_REG_DTYPE_U16:
+	case IL_REG_DTYPE_S16:
+		v->u16 = __swap_be_16(v->u16);
+		break;
+	case IL_REG_DTYPE_U32:
+	case IL_REG_DTYPE_S32:
+		v->u32 = __swap_be_32(v->u32);
+		break;
+	case IL_REG_DTYPE_U64:
+	case IL_REG_DTYPE_S64:
+		v->u64 = __swap_be_64(v->u64);
+		break;
+	case IL_REG_DTYPE_FLOAT:
+		v->flt = __swap_be_float(v->flt);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Check if a register value is within the register range.
+ *
+ * @param [in] reg
+ *	Register.
+ * @param [in] v
+ *	Value (host byte order).
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int value_check(const il_reg_t *reg, const il_servo_reg_value_t *v)
+{
+	int in;
+	const il_reg_range_t *range = &reg->range;
+
+	switch (reg->dtype) {
+	case IL_REG_DTYPE_U8:
+		in = (v->u8 >= range->min.u8) && (v->u8 <= range->max.u8);
+		break;
+	case IL_REG_DTYPE_S8:
+		in = (v->s8 >= range->min.s8) && (v->s8 <= range->max.s8);
+		break;
+	case IL_REG_DTYPE_U16:
+		in = (v->u16 >= range->min.u16) && (v->u16 <= range->max.u16);
+		break;
+	case IL_REG_DTYPE_S16:
+		in = (v->s16 >= range->min.s16) && (v->s16 <= range->max.s16);
+		break;
+	case IL_REG_DTYPE_U32:
+		in = (v->u32 >= range->min.u32) && (v->u32 <= range->max.u32);
+		break;
+	case IL_REG_DTYPE_S32:
+		in = (v->s32 >= range->min.s32) && (v->s32 <= range->max.s32);
+		break;
+	case IL_REG_DTYPE_U64:
+		in = (v->u64 >= range->min.u64) && (v->u64 <= range->max.u64);
+		break;
+	case IL_REG_DTYPE_S64:
+		in = (v->s64 >= range->min.s64) && (v->s64 <= range->max.s64);
+		break;
+	default:
+		in = 1;
+		break;
+	}
+
+	if (!in) {
+		ilerr__set("Value out of range");
+		return IL_EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * Obtain a register value as a double.
+ *
+ * @param [in] dtype
+ *	Data type.
+ * @param [in] v
+ *	Value (host byte order).
+ *
+ * @return
+ *	Value.
+ */
+static double value_get(il_reg_dtype_t dtype, const il_servo_reg_value_t *v)
+{
+	switch (dtype) {
+	case IL_REG_DTYPE_U8:
+		return (double)v->u8;
+	case IL_REG_DTYPE_S8:
+		return (double)v->s8;
+	case IL_REG_DTYPE_U16:
+		return (double)v->u16;
+	case IL_REG_DTYPE_S16:
+		return (double)v->s16;
+	case IL_REG_DTYPE_U32:
+		return (double)v->u32;
+	case IL_REG_DTYPE_S32:
+		return (double)v->s32;
+	case IL_REG_DTYPE_U64:
+		return (double)v->u64;
+	case IL_REG_DTYPE_S64:
+		return (double)v->s64;
+	case IL_REG_DTYPE_FLOAT:
+		return (double)v->flt;
+	default:
+		return 0.;
+	}
+}
+
+/**
+ * Set a register value from a double.
+ *
+ * @param [in] dtype
+ *	Data type.
+ * @param [out] v
+ *	Value (host byte order).
+ * @param [in] val
+ *	Value.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int value_set(il_reg_dtype_t dtype, il_servo_reg_value_t *v,
+		     double val)
+{
+	switch (dtype) {
+	case IL_REG_DTYPE_U8:
+		v->u8 = (uint8_t)val;
+		break;
+	case IL_REG_DTYPE_S8:
+		v->s8 = (int8_t)val;
+		break;
+	case IL_REG_DTYPE_U16:
+		v->u16 = (uint16_t)val;
+		break;
+	case IL_REG_DTYPE_S16:
+		v->s16 = (int16_t)val;
+		break;
+	case IL_REG_DTYPE_U32:
+		v->u32 = (uint32_t)val;
+		break;
+	case IL_REG_DTYPE_S32:
+		v->s32 = (int32_t)val;
+		break;
+	case IL_REG_DTYPE_U64:
+		v->u64 = (uint64_t)val;
+		break;
+	case IL_REG_DTYPE_S64:
+		v->s64 = (int64_t)val;
+		break;
+	case IL_REG_DTYPE_FLOAT:
+		v->flt = (float)val;
+		break;
+	default:
+		ilerr__set("Unsupported register data type");
+		return IL_EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * Decode raw register data (native units).
+ *
+ * @param [in] reg
+ *	Register.
+ * @param [in] buf
+ *	Raw data.
+ *
+ * @return
+ *	Value.
+ */
+static double reg_decode(const il_reg_t *reg, const void *buf)
+{
+	il_servo_reg_value_t v;
+
+	memcpy(&v, buf, il_utils__reg_sz(reg->dtype));
+	value_swap(reg->dtype, &v);
+
+	return value_get(reg->dtype, &v);
+}
+
+/**
+ * Encode raw register data (native units).
+ *
+ * @param [in] reg
+ *	Register.
+ * @param [in] val
+ *	Value.
+ * @param [out] buf
+ *	Raw data buffer.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int reg_encode(const il_reg_t *reg, double val, void *buf)
+{
+	int r;
+	il_servo_reg_value_t v;
+
+	r = value_set(reg->dtype, &v, val);
+	if (r < 0)
+		return r;
+
+	r = value_check(reg, &v);
+	if (r < 0)
+		return r;
+
+	value_swap(reg->dtype, &v);
+	memcpy(buf, &v, il_utils__reg_sz(reg->dtype));
+
+	return 0;
+}
+
 /**
  * Raw read.
  *
@@ -79,18 +363,22 @@ static int get_reg(il_dict_t *dict, const il_reg_t *reg_pdef,
  * @param [in] dtype
  *	Expected data type.
  * @param [out] buf
- *	Where data will be stored.
+ *	Where data will be stored (host byte order).
  * @param [in] sz
  *	Buffer size.
+ * @param [in] prio
+ *	Priority class.
  *
  * @return
  *	0 on success, error code otherwise.
  */
 static int raw_read(il_servo_t *servo, const il_reg_t *reg_pdef,
-		    const char *id, il_reg_dtype_t dtype, void *buf, size_t sz)
+		    const char *id, il_reg_dtype_t dtype, void *buf, size_t sz,
+		    il_net_prio_t prio)
 {
 	int r;
 	const il_reg_t *reg;
+	il_servo_reg_value_t v;
 
 	/* obtain register (predefined or from dictionary) */
 	r = get_reg(servo->dict, reg_pdef, id, &reg);
@@ -108,7 +396,14 @@ static int raw_read(il_servo_t *servo, const il_reg_t *reg_pdef,
 		return IL_EACCESS;
 	}
 
-	return il_net__read(servo->net, servo->id, reg->address, buf, sz);
+	r = il_net__read(servo->net, servo->id, reg->address, &v, sz, prio);
+	if (r < 0)
+		return r;
+
+	value_swap(dtype, &v);
+	memcpy(buf, &v, sz);
+
+	return 0;
 }
 
 /**
@@ -116,25 +411,36 @@ static int raw_read(il_servo_t *servo, const il_reg_t *reg_pdef,
  *
  * @param [in] servo
  *	Servo.
- * @param [in] reg
+ * @param [in] reg_pdef
  *	Pre-defined register.
+ * @param [in] id
+ *	Register ID.
  * @param [in] dtype
  *	Expected data type.
  * @param [in] data
- *	Data buffer.
+ *	Data buffer (host byte order).
  * @param [in] sz
  *	Data buffer size.
  * @param [in] confirmed
  *	Confirm write.
+ * @param [in] prio
+ *	Priority class.
  *
  * @return
  *	0 on success, error code otherwise.
  */
-static int raw_write(il_servo_t *servo, const il_reg_t *reg,
-		     il_reg_dtype_t dtype, const void *data, size_t sz,
-		     int confirmed)
+static int raw_write(il_servo_t *servo, const il_reg_t *reg_pdef,
+		     const char *id, il_reg_dtype_t dtype, const void *data,
+		     size_t sz, int confirmed, il_net_prio_t prio)
 {
-	int confirmed_;
+	int r, confirmed_;
+	const il_reg_t *reg;
+	il_servo_reg_value_t v;
+
+	/* obtain register (predefined or from dictionary) */
+	r = get_reg(servo->dict, reg_pdef, id, &reg);
+	if (r < 0)
+		return r;
 
 	/* verify register properties */
 	if (reg->dtype != dtype) {
@@ -147,11 +453,155 @@ static int raw_write(il_servo_t *servo, const il_reg_t *reg,
 		return IL_EACCESS;
 	}
 
+	memcpy(&v, data, sz);
+
+	r = value_check(reg, &v);
+	if (r < 0)
+		return r;
+
+	value_swap(dtype, &v);
+
 	/* skip confirmation on write-only registers */
 	confirmed_ = (reg->access == IL_REG_ACCESS_WO) ? 0 : confirmed;
 
-	return il_net__write(servo->net, servo->id, reg->address, data, sz,
-			     confirmed_);
+	/* write-behind registers: only the newest value is transmitted */
+	if (il_net__wb_write(servo->net, servo->id, reg->address, &v, sz,
+			     confirmed_))
+		return 0;
+
+	return il_net__write(servo->net, servo->id, reg->address, &v, sz,
+			     confirmed_, prio);
+}
+
+/** Registers whose transfers belong to the control class. */
+static const il_reg_t *ctl_regs[] = {
+	&IL_REG_CTL_WORD,
+	&IL_REG_STS_WORD,
+	&IL_REG_OP_MODE,
+	&IL_REG_POS_TGT,
+	&IL_REG_VEL_TGT,
+	&IL_REG_TORQUE_TGT,
+};
+
+/**
+ * Obtain the priority class of a register transfer.
+ *
+ * @note
+ *	Dictionary registers are matched by address, so that they are classed
+ *	as their pre-defined counterparts.
+ *
+ * @param [in] servo
+ *	Servo.
+ * @param [in] reg
+ *	Register.
+ *
+ * @return
+ *	Priority class.
+ */
+static il_net_prio_t reg_prio(il_servo_t *servo, const il_reg_t *reg)
+{
+	size_t i;
+
+	if ((reg == servo->pds.cw) || (reg == servo->pds.sw))
+		return IL_NET_PRIO_CTL;
+
+	for (i = 0; i < sizeof(ctl_regs) / sizeof(ctl_regs[0]); i++) {
+		if ((reg == ctl_regs[i]) ||
+		    (reg->address == ctl_regs[i]->address))
+			return IL_NET_PRIO_CTL;
+	}
+
+	return IL_NET_PRIO_BULK;
+}
+
+/**
+ * Prepare a register transfer.
+ *
+ * @param [in] entry
+ *	Transfer entry.
+ * @param [in] write
+ *	Write flag.
+ * @param [out] reg
+ *	Where the entry register will be stored.
+ * @param [out] xfer
+ *	Network transfer.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int xfer_prepare(il_servo_batch_t *entry, int write,
+			 const il_reg_t **reg, il_net_xfer_t *xfer)
+{
+	int r;
+	il_servo_t *servo = entry->servo;
+
+	r = get_reg(servo->dict, entry->reg, entry->id, reg);
+	if (r < 0)
+		return r;
+
+	if (!write && ((*reg)->access == IL_REG_ACCESS_WO)) {
+		ilerr__set("Register is write-only");
+		return IL_EACCESS;
+	}
+
+	if (write && ((*reg)->access == IL_REG_ACCESS_RO)) {
+		ilerr__set("Register is read-only");
+		return IL_EACCESS;
+	}
+
+	xfer->sz = il_utils__reg_sz((*reg)->dtype);
+	if (xfer->sz == 0) {
+		ilerr__set("Unsupported register data type");
+		return IL_EINVAL;
+	}
+
+	if (write) {
+		double val;
+
+		val = entry->value / il_servo_units_factor(servo, *reg);
+
+		r = reg_encode(*reg, val, xfer->buf);
+		if (r < 0)
+			return r;
+
+		/* skip confirmation on write-only registers */
+		xfer->confirmed = entry->confirm &&
+				  ((*reg)->access != IL_REG_ACCESS_WO);
+	}
+
+	xfer->id = servo->id;
+	xfer->address = (*reg)->address;
+	xfer->write = write;
+
+	return 0;
+}
+
+/**
+ * Asynchronous transfer completion callback.
+ *
+ * @param [in] ctx
+ *	Context (il_servo_async_t *).
+ * @param [in] r
+ *	Result.
+ * @param [in] buf
+ *	Received data (reads only).
+ * @param [in] sz
+ *	Received data size.
+ */
+static void on_async(void *ctx, int r, const void *buf, size_t sz)
+{
+	il_servo_async_t *async = ctx;
+	double value = 0.;
+
+	(void)sz;
+
+	if ((r == 0) && buf)
+		value = reg_decode(async->reg, buf) *
+			il_servo_units_factor(async->servo, async->reg);
+
+	async->cb(async->ctx, r, value);
+
+	free(async);
 }
 
 /**
@@ -232,7 +682,82 @@ unlock:
 }
 
 /**
- * Statusword update callback
+ * Obtain a PDS register (pre-defined or from the dictionary).
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] reg_pdef
+ *	Pre-defined register.
+ * @param [in] id
+ *	Register ID.
+ * @param [out] reg
+ *	Where register will be stored.
+ *
+ * @return
+ *	0 on success, IL_ENOTSUP if the register is not available.
+ */
+static int pds_reg_get(il_servo_t *servo, const il_reg_t *reg_pdef,
+		       const char *id, const il_reg_t **reg)
+{
+	if (reg_pdef) {
+		*reg = reg_pdef;
+		return 0;
+	}
+
+	if (!id || !servo->dict ||
+	    (il_dict_reg_get(servo->dict, id, reg) < 0)) {
+		ilerr__set("Functionality not supported (no PDS register)");
+		return IL_ENOTSUP;
+	}
+
+	return 0;
+}
+
+/**
+ * Send a PDS command.
+ *
+ * @note
+ *	If configured, the statusword is read right after, so that immediate
+ *	transitions are notified on networks where updates are not pushed.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ * @param [in] cmd
+ *	Controlword value.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int pds_cmd(il_servo_t *servo, uint16_t cmd)
+{
+	int r;
+	const il_reg_t *reg;
+	uint16_t sw;
+
+	r = pds_reg_get(servo, servo->pds.cw, servo->pds.cw_id, &reg);
+	if (r < 0)
+		return r;
+
+	r = il_servo_raw_write_u16(servo, reg, NULL, cmd, 1);
+	if (r < 0)
+		return r;
+
+	if (servo->pds.sw || servo->pds.sw_id)
+		(void)raw_read(servo, servo->pds.sw, servo->pds.sw_id,
+			       IL_REG_DTYPE_U16, &sw, sizeof(sw),
+			       IL_NET_PRIO_CTL);
+
+	return 0;
+}
+
+/**
+ * Statusword update callback.
+ *
+ * @note
+ *	Runs from the network events context (dispatcher thread or
+ *	il_net_events_process), so external state subscribers are notified
+ *	from there. Subscribers may unsubscribe or destroy the servo from the
+ *	callback.
  *
  * @param [in] ctx
  *	Context (servo_t *).
@@ -242,144 +767,204 @@ unlock:
 static void sw_update(void *ctx, uint16_t sw)
 {
 	il_servo_t *servo = ctx;
+	int changed = 0, destroyed = 0;
+	size_t i;
+	il_servo_state_t state;
+	int flags;
+	il_servo_state_subscriber_t sub;
 
 	osal_mutex_lock(servo->sw.lock);
 
 	if (servo->sw.value != sw) {
 		servo->sw.value = sw;
 		osal_cond_broadcast(servo->sw.changed);
+		changed = 1;
 	}
 
 	osal_mutex_unlock(servo->sw.lock);
-}
-
-/**
- * State change monitor, used to push state changes to external subscriptors.
- *
- * @param [in] args
- *	Arguments (il_servo_t *).
- */
-static int state_subs_monitor(void *args)
-{
-	il_servo_t *servo = args;
-	uint16_t sw;
-
-	osal_mutex_lock(servo->sw.lock);
-	sw = servo->sw.value;
-	osal_mutex_unlock(servo->sw.lock);
 
-	while (!servo->state_subs.stop) {
-		int timeout;
-		size_t i;
-		il_servo_state_t state;
-		int flags;
+	if (!changed)
+		return;
 
-		/* wait for change */
-		timeout = STATE_SUBS_TIMEOUT;
-		if (sw_wait_change(servo, &sw, &timeout) < 0)
-			continue;
+	/* obtain state/flags */
+	servo->ops->_state_decode(sw, &state, &flags);
 
-		/* obtain state/flags */
-		servo->ops->_state_decode(sw, &state, &flags);
+	/* notify all subscribers (unlocked: callbacks may unsubscribe or
+	 * destroy the servo, which must not be touched afterwards)
+	 */
+	servo->destroyed = &destroyed;
 
-		/* notify all subscribers */
-		osal_mutex_lock(servo->state_subs.lock);
+	osal_mutex_lock(servo->state_subs.lock);
 
-		for (i = 0; i < servo->state_subs.sz; i++) {
-			void *ctx;
+	for (i = 0; i < servo->state_subs.sz; i++) {
+		sub = servo->state_subs.subs[i];
+		if (!sub.cb)
+			continue;
 
-			if (!servo->state_subs.subs[i].cb)
-				continue;
+		osal_mutex_unlock(servo->state_subs.lock);
 
-			ctx = servo->state_subs.subs[i].ctx;
-			servo->state_subs.subs[i].cb(ctx, state, flags);
-		}
+		sub.cb(sub.ctx, state, flags);
+		if (destroyed)
+			return;
 
-		osal_mutex_unlock(servo->state_subs.lock);
+		osal_mutex_lock(servo->state_subs.lock);
 	}
 
-	return 0;
+	osal_mutex_unlock(servo->state_subs.lock);
+
+	servo->destroyed = NULL;
 }
 
 /**
  * Emergencies callback.
  *
+ * @note
+ *	Runs from the network events context (dispatcher thread or
+ *	il_net_events_process), so external emergency subscribers are notified
+ *	from there.
+ *
+ * @param [in] ctx
+ *	Context (servo_t *).
+ * @param [in] code
+ *	Emergency code.
  */
 static void on_emcy(void *ctx, uint32_t code)
 {
 	il_servo_t *servo = ctx;
-	il_servo_emcy_t *emcy = &servo->emcy;
+	int destroyed = 0;
+	size_t i;
+	il_servo_emcy_subscriber_t sub;
 
-	osal_mutex_lock(emcy->lock);
+	/* unlocked notification, see sw_update */
+	servo->destroyed = &destroyed;
 
-	/* if full, drop oldest item */
-	if (!CIRC_SPACE(emcy->head, emcy->tail, EMCY_QUEUE_SZ))
-		emcy->tail = (emcy->tail + 1) & (EMCY_QUEUE_SZ - 1);
+	osal_mutex_lock(servo->emcy_subs.lock);
+
+	for (i = 0; i < servo->emcy_subs.sz; i++) {
+		sub = servo->emcy_subs.subs[i];
+		if (!sub.cb)
+			continue;
+
+		osal_mutex_unlock(servo->emcy_subs.lock);
 
-	/* push emergency and notify */
-	emcy->queue[emcy->head] = code;
-	emcy->head = (emcy->head + 1) & (EMCY_QUEUE_SZ - 1);
+		sub.cb(sub.ctx, code);
+		if (destroyed)
+			return;
 
-	osal_cond_signal(emcy->not_empty);
+		osal_mutex_lock(servo->emcy_subs.lock);
+	}
+
+	osal_mutex_unlock(servo->emcy_subs.lock);
 
-	osal_mutex_unlock(emcy->lock);
+	servo->destroyed = NULL;
 }
 
 /**
- * Emergencies monitor, used to notify about emergencies to external
- * subscriptors.
+ * Perform a batch of register transfers.
  *
- * @param [in] args
- *	Arguments (il_servo_t *).
+ * @param [in, out] batch
+ *	Batch entries.
+ * @param [in] cnt
+ *	Number of entries.
+ * @param [in] write
+ *	Write flag.
+ *
+ * @return
+ *	0 if all transfers succeeded, first error code otherwise.
  */
-static int emcy_subs_monitor(void *args)
+static int transfer_batch(il_servo_batch_t *batch, size_t cnt, int write)
 {
-	il_servo_t *servo = args;
-	il_servo_emcy_t *emcy = &servo->emcy;
-	il_servo_emcy_subscriber_lst_t *emcy_subs = &servo->emcy_subs;
-
-	while (!emcy_subs->stop) {
-		int r;
+	int r = 0;
+	size_t i, j, n;
+
+	il_net_xfer_t *xfers, *group;
+	const il_reg_t **regs;
+	uint64_t *data;
+	size_t *map;
+	int *pending;
+
+	if (cnt == 0)
+		return 0;
+
+	xfers = calloc(cnt, sizeof(*xfers));
+	group = calloc(cnt, sizeof(*group));
+	regs = calloc(cnt, sizeof(*regs));
+	data = calloc(cnt, sizeof(*data));
+	map = calloc(cnt, sizeof(*map));
+	pending = calloc(cnt, sizeof(*pending));
+	if (!xfers || !group || !regs || !data || !map || !pending) {
+		ilerr__set("Batch allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup;
+	}
 
-		/* wait until emcy queue not empty */
-		osal_mutex_lock(emcy->lock);
+	/* validate and encode all entries */
+	for (i = 0; i < cnt; i++) {
+		xfers[i].buf = &data[i];
 
-		r = osal_cond_wait(emcy->not_empty, emcy->lock,
-				   EMCY_SUBS_TIMEOUT);
+		batch[i].r = xfer_prepare(&batch[i], write, &regs[i],
+					   &xfers[i]);
+		pending[i] = batch[i].r == 0;
+	}
 
-		if (r == 0) {
-			/* process all available emergencies */
-			while (CIRC_CNT(emcy->head, emcy->tail, emcy->sz)) {
-				size_t i;
-				uint32_t code;
+	/* issue one batch per network (bulk unless a control register is
+	 * part of it)
+	 */
+	for (i = 0; i < cnt; i++) {
+		il_net_t *net;
+		il_net_prio_t prio = IL_NET_PRIO_BULK;
 
-				code = emcy->queue[emcy->tail];
-				emcy->tail = (emcy->tail + 1) & (emcy->sz - 1);
+		if (!pending[i])
+			continue;
 
-				osal_mutex_unlock(emcy->lock);
+		net = batch[i].servo->net;
 
-				/* notify all subscribers */
-				osal_mutex_lock(emcy_subs->lock);
+		/* gather all pending entries on the same network */
+		for (j = i, n = 0; j < cnt; j++) {
+			if (pending[j] && (batch[j].servo->net == net)) {
+				group[n] = xfers[j];
+				map[n] = j;
+				pending[j] = 0;
+				n++;
 
-				for (i = 0; i < emcy_subs->sz; i++) {
-					void *ctx;
+				if (reg_prio(batch[j].servo, regs[j]) ==
+				    IL_NET_PRIO_CTL)
+					prio = IL_NET_PRIO_CTL;
+			}
+		}
 
-					if (!emcy_subs->subs[i].cb)
-						continue;
+		(void)il_net__transfer_batch(net, group, n, prio);
 
-					ctx = emcy_subs->subs[i].ctx;
-					emcy_subs->subs[i].cb(ctx, code);
-				}
+		/* store results (converted to current units on reads) */
+		for (j = 0; j < n; j++) {
+			il_servo_batch_t *entry = &batch[map[j]];
 
-				osal_mutex_unlock(emcy_subs->lock);
-				osal_mutex_lock(emcy->lock);
-			}
+			entry->r = group[j].r;
+			if (!write && (entry->r == 0))
+				entry->value = reg_decode(regs[map[j]],
+							  &data[map[j]]) *
+					il_servo_units_factor(entry->servo,
+							      regs[map[j]]);
 		}
+	}
 
-		osal_mutex_unlock(emcy->lock);
+	/* report first error (if any) */
+	for (i = 0; i < cnt; i++) {
+		if (batch[i].r < 0) {
+			r = batch[i].r;
+			break;
+		}
 	}
 
-	return 0;
+cleanup:
+	free(pending);
+	free(map);
+	free(data);
+	free(regs);
+	free(group);
+	free(xfers);
+
+	return r;
 }
 
 /*******************************************************************************
@@ -390,6 +975,7 @@ int il_servo_base__init(il_servo_t *servo, il_net_t *net, uint16_t id,
 			const char *dict)
 {
 	int r;
+	size_t i;
 
 	/* initialize */
 	servo->net = net;
@@ -421,36 +1007,16 @@ int il_servo_base__init(il_servo_t *servo, il_net_t *net, uint16_t id,
 	servo->units.vel = IL_UNITS_VEL_NATIVE;
 	servo->units.acc = IL_UNITS_ACC_NATIVE;
 
-	/* configure statusword subscription */
-	servo->sw.lock = osal_mutex_create();
-	if (!servo->sw.lock) {
-		ilerr__set("Statusword subscriber lock allocation failed");
-		r = IL_EFAIL;
-		goto cleanup_units_lock;
-	}
-
-	servo->sw.changed = osal_cond_create();
-	if (!servo->sw.changed) {
-		ilerr__set("Statusword subscriber condition allocation failed");
-		r = IL_EFAIL;
-		goto cleanup_sw_lock;
-	}
-
-	servo->sw.value = 0;
-
-	r = il_net__sw_subscribe(servo->net, servo->id, sw_update, servo);
-	if (r < 0)
-		goto cleanup_sw_changed;
-
-	servo->sw.slot = r;
+	for (i = 0; i < UNITS_FACTORS_SZ; i++)
+		factor_store(&servo->units.factors[i], 1.);
 
-	/* configute external state subscriptors */
+	/* configure external state subscriptors */
 	servo->state_subs.subs = calloc(STATE_SUBS_SZ_DEF,
 					sizeof(*servo->state_subs.subs));
 	if (!servo->state_subs.subs) {
 		ilerr__set("State subscribers allocation failed");
 		r = IL_EFAIL;
-		goto cleanup_sw_subscribe;
+		goto cleanup_units_lock;
 	}
 
 	servo->state_subs.sz = STATE_SUBS_SZ_DEF;
@@ -462,40 +1028,33 @@ int il_servo_base__init(il_servo_t *servo, il_net_t *net, uint16_t id,
 		goto cleanup_state_subs_subs;
 	}
 
-	servo->state_subs.stop = 0;
-
-	servo->state_subs.monitor = osal_thread_create(state_subs_monitor,
-						       servo);
-	if (!servo->state_subs.monitor) {
-		ilerr__set("State change monitor could not be created");
+	/* configure statusword subscription */
+	servo->sw.lock = osal_mutex_create();
+	if (!servo->sw.lock) {
+		ilerr__set("Statusword subscriber lock allocation failed");
 		r = IL_EFAIL;
 		goto cleanup_state_subs_lock;
 	}
 
-	/* configure emergency subscription */
-	servo->emcy.lock = osal_mutex_create();
-	if (!servo->emcy.lock) {
-		ilerr__set("Emergency subscriber lock allocation failed");
+	servo->sw.changed = osal_cond_create();
+	if (!servo->sw.changed) {
+		ilerr__set("Statusword subscriber condition allocation failed");
 		r = IL_EFAIL;
-		goto cleanup_state_subs_monitor;
+		goto cleanup_sw_lock;
 	}
 
-	servo->emcy.not_empty = osal_cond_create();
-	if (!servo->emcy.not_empty) {
-		ilerr__set("Emergency subscriber condition allocation failed");
-		r = IL_EFAIL;
-		goto cleanup_emcy_lock;
-	}
+	servo->sw.value = 0;
 
-	servo->emcy.head = 0;
-	servo->emcy.tail = 0;
-	servo->emcy.sz = EMCY_QUEUE_SZ;
+	servo->destroyed = NULL;
 
-	r = il_net__emcy_subscribe(servo->net, servo->id, on_emcy, servo);
+	/* PDS registers (set by implementations) */
+	memset(&servo->pds, 0, sizeof(servo->pds));
+
+	r = il_net__sw_subscribe(servo->net, servo->id, sw_update, servo);
 	if (r < 0)
-		goto cleanup_emcy_not_empty;
+		goto cleanup_sw_changed;
 
-	servo->emcy.slot = r;
+	servo->sw.slot = r;
 
 	/* configure external emergency subscriptors */
 	servo->emcy_subs.subs = calloc(EMCY_SUBS_SZ_DEF,
@@ -503,7 +1062,7 @@ int il_servo_base__init(il_servo_t *servo, il_net_t *net, uint16_t id,
 	if (!servo->emcy_subs.subs) {
 		ilerr__set("Emergency subscribers allocation failed");
 		r = IL_EFAIL;
-		goto cleanup_emcy_subscribe;
+		goto cleanup_sw_subscribe;
 	}
 
 	servo->emcy_subs.sz = EMCY_SUBS_SZ_DEF;
@@ -515,13 +1074,12 @@ int il_servo_base__init(il_servo_t *servo, il_net_t *net, uint16_t id,
 		goto cleanup_emcy_subs_subs;
 	}
 
-	servo->emcy_subs.stop = 0;
-	servo->emcy_subs.monitor = osal_thread_create(emcy_subs_monitor, servo);
-	if (!servo->emcy_subs.monitor) {
-		ilerr__set("Emergency monitor could not be created");
-		r = IL_EFAIL;
+	/* configure emergency subscription */
+	r = il_net__emcy_subscribe(servo->net, servo->id, on_emcy, servo);
+	if (r < 0)
 		goto cleanup_emcy_subs_lock;
-	}
+
+	servo->emcy.slot = r;
 
 	return 0;
 
@@ -531,25 +1089,6 @@ cleanup_emcy_subs_lock:
 cleanup_emcy_subs_subs:
 	free(servo->emcy_subs.subs);
 
-cleanup_emcy_subscribe:
-	il_net__emcy_unsubscribe(servo->net, servo->emcy.slot);
-
-cleanup_emcy_not_empty:
-	osal_cond_destroy(servo->emcy.not_empty);
-
-cleanup_emcy_lock:
-	osal_mutex_destroy(servo->emcy.lock);
-
-cleanup_state_subs_monitor:
-	servo->state_subs.stop = 1;
-	(void)osal_thread_join(servo->state_subs.monitor, NULL);
-
-cleanup_state_subs_lock:
-	osal_mutex_destroy(servo->state_subs.lock);
-
-cleanup_state_subs_subs:
-	free(servo->state_subs.subs);
-
 cleanup_sw_subscribe:
 	il_net__sw_unsubscribe(servo->net, servo->sw.slot);
 
@@ -559,6 +1098,12 @@ cleanup_sw_changed:
 cleanup_sw_lock:
 	osal_mutex_destroy(servo->sw.lock);
 
+cleanup_state_subs_lock:
+	osal_mutex_destroy(servo->state_subs.lock);
+
+cleanup_state_subs_subs:
+	free(servo->state_subs.subs);
+
 cleanup_units_lock:
 	osal_mutex_destroy(servo->units.lock);
 
@@ -574,24 +1119,23 @@ cleanup_net:
 
 void il_servo_base__deinit(il_servo_t *servo)
 {
-	servo->emcy_subs.stop = 1;
-	(void)osal_thread_join(servo->emcy_subs.monitor, NULL);
-	osal_mutex_destroy(servo->emcy_subs.lock);
-	free(servo->emcy_subs.subs);
+	/* destroyed from a subscriber callback: stop notifying */
+	if (il_net__in_delivery(servo->net) && servo->destroyed)
+		*servo->destroyed = 1;
 
-	il_net__emcy_unsubscribe(servo->net, servo->emcy.slot);
-	osal_cond_destroy(servo->emcy.not_empty);
-	osal_mutex_destroy(servo->emcy.lock);
+	il_net__wb_drop(servo->net, servo->id);
 
-	servo->state_subs.stop = 1;
-	(void)osal_thread_join(servo->state_subs.monitor, NULL);
-	osal_mutex_destroy(servo->state_subs.lock);
-	free(servo->state_subs.subs);
+	il_net__emcy_unsubscribe(servo->net, servo->emcy.slot);
+	osal_mutex_destroy(servo->emcy_subs.lock);
+	free(servo->emcy_subs.subs);
 
 	il_net__sw_unsubscribe(servo->net, servo->sw.slot);
 	osal_cond_destroy(servo->sw.changed);
 	osal_mutex_destroy(servo->sw.lock);
 
+	osal_mutex_destroy(servo->state_subs.lock);
+	free(servo->state_subs.subs);
+
 	osal_mutex_destroy(servo->units.lock);
 
 	if (servo->dict)
@@ -609,7 +1153,205 @@ void il_servo_base__state_get(il_servo_t *servo, il_servo_state_t *state,
 	sw = servo->sw.value;
 	osal_mutex_unlock(servo->sw.lock);
 
-	servo->ops->_state_decode(sw, state, flags);
+	servo->ops->_state_decode(sw, state, flags);
+}
+
+uint16_t il_servo_base__sw_get(il_servo_t *servo)
+{
+	uint16_t sw;
+
+	osal_mutex_lock(servo->sw.lock);
+	sw = servo->sw.value;
+	osal_mutex_unlock(servo->sw.lock);
+
+	return sw;
+}
+
+int il_servo_base__sw_wait_change(il_servo_t *servo, uint16_t *sw,
+				  int *timeout)
+{
+	return sw_wait_change(servo, sw, timeout);
+}
+
+int il_servo_base__sw_wait_value(il_servo_t *servo, uint16_t msk,
+				 uint16_t val, int *timeout)
+{
+	int r;
+	uint16_t sw;
+
+	sw = il_servo_base__sw_get(servo);
+
+	while ((sw & msk) != val) {
+		r = sw_wait_change(servo, &sw, timeout);
+		if (r < 0)
+			return r;
+	}
+
+	return 0;
+}
+
+int il_servo_base__disable(il_servo_t *servo)
+{
+	int r;
+	uint16_t sw;
+	il_servo_state_t state;
+	int timeout = PDS_TIMEOUT;
+
+	sw = il_servo_base__sw_get(servo);
+
+	do {
+		servo->ops->_state_decode(sw, &state, NULL);
+
+		/* try fault reset if faulty */
+		if ((state == IL_SERVO_STATE_FAULT) ||
+		    (state == IL_SERVO_STATE_FAULTR)) {
+			r = il_servo_fault_reset(servo);
+			if (r < 0)
+				return r;
+
+			sw = il_servo_base__sw_get(servo);
+		/* check state and command action to reach disabled */
+		} else if (state != IL_SERVO_STATE_DISABLED) {
+			r = pds_cmd(servo, IL_MC_PDS_CMD_DV);
+			if (r < 0)
+				return r;
+
+			/* wait until statusword changes */
+			r = sw_wait_change(servo, &sw, &timeout);
+			if (r < 0)
+				return r;
+		}
+	} while (state != IL_SERVO_STATE_DISABLED);
+
+	return 0;
+}
+
+int il_servo_base__switch_on(il_servo_t *servo, int timeout)
+{
+	int r;
+	uint16_t sw, cmd;
+	il_servo_state_t state;
+	int timeout_ = timeout;
+
+	sw = il_servo_base__sw_get(servo);
+
+	do {
+		servo->ops->_state_decode(sw, &state, NULL);
+
+		/* try fault reset if faulty */
+		if ((state == IL_SERVO_STATE_FAULT) ||
+		    (state == IL_SERVO_STATE_FAULTR)) {
+			r = il_servo_fault_reset(servo);
+			if (r < 0)
+				return r;
+
+			sw = il_servo_base__sw_get(servo);
+		/* check state and command action to reach switch on */
+		} else if (state != IL_SERVO_STATE_ON) {
+			if (state == IL_SERVO_STATE_NRDY)
+				cmd = IL_MC_PDS_CMD_DV;
+			else if (state == IL_SERVO_STATE_DISABLED)
+				cmd = IL_MC_PDS_CMD_SD;
+			else if (state == IL_SERVO_STATE_RDY)
+				cmd = IL_MC_PDS_CMD_SO;
+			else if (state == IL_SERVO_STATE_ENABLED)
+				cmd = IL_MC_PDS_CMD_DO;
+			else
+				cmd = IL_MC_PDS_CMD_DV;
+
+			r = pds_cmd(servo, cmd);
+			if (r < 0)
+				return r;
+
+			/* wait for state change */
+			r = sw_wait_change(servo, &sw, &timeout_);
+			if (r < 0)
+				return r;
+		}
+	} while (state != IL_SERVO_STATE_ON);
+
+	return 0;
+}
+
+int il_servo_base__enable(il_servo_t *servo, int timeout)
+{
+	int r;
+	uint16_t sw, cmd, msk;
+	il_servo_state_t state;
+	int timeout_ = timeout;
+
+	msk = servo->pds.enabled_msk;
+	sw = il_servo_base__sw_get(servo);
+
+	do {
+		servo->ops->_state_decode(sw, &state, NULL);
+
+		/* try fault reset if faulty */
+		if ((state == IL_SERVO_STATE_FAULT) ||
+		    (state == IL_SERVO_STATE_FAULTR)) {
+			r = il_servo_fault_reset(servo);
+			if (r < 0)
+				return r;
+
+			sw = il_servo_base__sw_get(servo);
+		/* check state and command action to reach enabled */
+		} else if ((state != IL_SERVO_STATE_ENABLED) ||
+			   ((sw & msk) != msk)) {
+			if (state == IL_SERVO_STATE_NRDY)
+				cmd = IL_MC_PDS_CMD_DV;
+			else if (state == IL_SERVO_STATE_DISABLED)
+				cmd = IL_MC_PDS_CMD_SD;
+			else if (state == IL_SERVO_STATE_RDY)
+				cmd = IL_MC_PDS_CMD_SOEO;
+			else
+				cmd = IL_MC_PDS_CMD_EO;
+
+			r = pds_cmd(servo, cmd);
+			if (r < 0)
+				return r;
+
+			/* wait for state change */
+			r = sw_wait_change(servo, &sw, &timeout_);
+			if (r < 0)
+				return r;
+		}
+	} while ((state != IL_SERVO_STATE_ENABLED) || ((sw & msk) != msk));
+
+	return 0;
+}
+
+int il_servo_base__fault_reset(il_servo_t *servo)
+{
+	int r;
+	uint16_t sw;
+	il_servo_state_t state;
+	int timeout = PDS_TIMEOUT;
+
+	sw = il_servo_base__sw_get(servo);
+
+	do {
+		servo->ops->_state_decode(sw, &state, NULL);
+
+		/* check if faulty, if so try to reset (0->1) */
+		if ((state == IL_SERVO_STATE_FAULT) ||
+		    (state == IL_SERVO_STATE_FAULTR)) {
+			r = pds_cmd(servo, 0);
+			if (r < 0)
+				return r;
+
+			r = pds_cmd(servo, IL_MC_PDS_CMD_FR);
+			if (r < 0)
+				return r;
+
+			/* wait until statusword changes */
+			r = sw_wait_change(servo, &sw, &timeout);
+			if (r < 0)
+				return r;
+		}
+	} while ((state == IL_SERVO_STATE_FAULT) ||
+		 (state == IL_SERVO_STATE_FAULTR));
+
+	return 0;
 }
 
 int il_servo_base__state_subscribe(il_servo_t *servo,
@@ -660,8 +1402,10 @@ void il_servo_base__state_unsubscribe(il_servo_t *servo, int slot)
 	osal_mutex_lock(servo->state_subs.lock);
 
 	/* skip out of range slot */
-	if (slot >= (int)servo->state_subs.sz)
+	if (slot >= (int)servo->state_subs.sz) {
+		osal_mutex_unlock(servo->state_subs.lock);
 		return;
+	}
 
 	servo->state_subs.subs[slot].cb = NULL;
 	servo->state_subs.subs[slot].ctx = NULL;
@@ -717,8 +1461,10 @@ void il_servo_base__emcy_unsubscribe(il_servo_t *servo, int slot)
 	osal_mutex_lock(servo->emcy_subs.lock);
 
 	/* skip out of range slot */
-	if (slot >= (int)servo->emcy_subs.sz)
+	if (slot >= (int)servo->emcy_subs.sz) {
+		osal_mutex_unlock(servo->emcy_subs.lock);
 		return;
+	}
 
 	servo->emcy_subs.subs[slot].cb = NULL;
 	servo->emcy_subs.subs[slot].ctx = NULL;
@@ -745,6 +1491,24 @@ int il_servo_base__dict_load(il_servo_t *servo, const char *dict)
 	return 0;
 }
 
+void il_servo_base__units_factors_update(il_servo_t *servo)
+{
+	size_t i;
+
+	/* units lock must be held (serializes updates) */
+	for (i = 0; i < UNITS_FACTORS_SZ; i++)
+		factor_store(&servo->units.factors[i],
+			     servo->ops->units_factor(servo, (il_reg_phy_t)i));
+}
+
+double il_servo_base__units_factor(il_servo_t *servo, const il_reg_t *reg)
+{
+	if ((size_t)reg->phy >= UNITS_FACTORS_SZ)
+		return 1.;
+
+	return factor_load(&servo->units.factors[reg->phy]);
+}
+
 il_units_torque_t il_servo_base__units_torque_get(il_servo_t *servo)
 {
 	il_units_torque_t units;
@@ -760,6 +1524,7 @@ void il_servo_base__units_torque_set(il_servo_t *servo, il_units_torque_t units)
 {
 	osal_mutex_lock(servo->units.lock);
 	servo->units.torque = units;
+	il_servo_base__units_factors_update(servo);
 	osal_mutex_unlock(servo->units.lock);
 }
 
@@ -778,6 +1543,7 @@ void il_servo_base__units_pos_set(il_servo_t *servo, il_units_pos_t units)
 {
 	osal_mutex_lock(servo->units.lock);
 	servo->units.pos = units;
+	il_servo_base__units_factors_update(servo);
 	osal_mutex_unlock(servo->units.lock);
 }
 
@@ -796,6 +1562,7 @@ void il_servo_base__units_vel_set(il_servo_t *servo, il_units_vel_t units)
 {
 	osal_mutex_lock(servo->units.lock);
 	servo->units.vel = units;
+	il_servo_base__units_factors_update(servo);
 	osal_mutex_unlock(servo->units.lock);
 }
 
@@ -814,101 +1581,118 @@ void il_servo_base__units_acc_set(il_servo_t *servo, il_units_acc_t units)
 {
 	osal_mutex_lock(servo->units.lock);
 	servo->units.acc = units;
+	il_servo_base__units_factors_update(servo);
 	osal_mutex_unlock(servo->units.lock);
 }
 
 int il_servo_base__raw_read_u8(il_servo_t *servo, const il_reg_t *reg,
 			       const char *id, uint8_t *buf)
 {
-	return raw_read(servo, reg, id, IL_REG_DTYPE_U8, buf, sizeof(*buf));
+	return raw_read(servo, reg, id, IL_REG_DTYPE_U8, buf, sizeof(*buf),
+			IL_NET_PRIO_BULK);
 }
 
 int il_servo_base__raw_read_s8(il_servo_t *servo, const il_reg_t *reg,
 			       const char *id, int8_t *buf)
 {
-	return raw_read(servo, reg, id, IL_REG_DTYPE_S8, buf, sizeof(*buf));
+	return raw_read(servo, reg, id, IL_REG_DTYPE_S8, buf, sizeof(*buf),
+			IL_NET_PRIO_BULK);
 }
 
 int il_servo_base__raw_read_u16(il_servo_t *servo, const il_reg_t *reg,
 				const char *id, uint16_t *buf)
 {
-	int r;
-
-	r = raw_read(servo, reg, id, IL_REG_DTYPE_U16, buf, sizeof(*buf));
-	if (r == 0)
-		*buf = __swap_be_16(*buf);
-
-	return r;
+	return raw_read(servo, reg, id, IL_REG_DTYPE_U16, buf, sizeof(*buf),
+			IL_NET_PRIO_BULK);
 }
 
 int il_servo_base__raw_read_s16(il_servo_t *servo, const il_reg_t *reg,
 				const char *id, int16_t *buf)
 {
-	int r;
-
-	r = raw_read(servo, reg, id, IL_REG_DTYPE_S16, buf, sizeof(*buf));
-	if (r == 0)
-		*buf = (int16_t)__swap_be_16(*buf);
-
-	return r;
+	return raw_read(servo, reg, id, IL_REG_DTYPE_S16, buf, sizeof(*buf),
+			IL_NET_PRIO_BULK);
 }
 
 int il_servo_base__raw_read_u32(il_servo_t *servo, const il_reg_t *reg,
 				const char *id, uint32_t *buf)
 {
-	int r;
-
-	r = raw_read(servo, reg, id, IL_REG_DTYPE_U32, buf, sizeof(*buf));
-	if (r == 0)
-		*buf = __swap_be_32(*buf);
-
-	return r;
+	return raw_read(servo, reg, id, IL_REG_DTYPE_U32, buf, sizeof(*buf),
+			IL_NET_PRIO_BULK);
 }
 
 int il_servo_base__raw_read_s32(il_servo_t *servo, const il_reg_t *reg,
 				const char *id, int32_t *buf)
 {
-	int r;
-
-	r = raw_read(servo, reg, id, IL_REG_DTYPE_S32, buf, sizeof(*buf));
-	if (r == 0)
-		*buf = (int32_t)__swap_be_32(*buf);
-
-	return r;
+	return raw_read(servo, reg, id, IL_REG_DTYPE_S32, buf, sizeof(*buf),
+			IL_NET_PRIO_BULK);
 }
 
 int il_servo_base__raw_read_u64(il_servo_t *servo, const il_reg_t *reg,
 				const char *id, uint64_t *buf)
 {
-	int r;
-
-	r = raw_read(servo, reg, id, IL_REG_DTYPE_U64, buf, sizeof(*buf));
-	if (r == 0)
-		*buf = __swap_be_64(*buf);
-
-	return r;
+	return raw_read(servo, reg, id, IL_REG_DTYPE_U64, buf, sizeof(*buf),
+			IL_NET_PRIO_BULK);
 }
 
 int il_servo_base__raw_read_s64(il_servo_t *servo, const il_reg_t *reg,
 				const char *id, int64_t *buf)
 {
-	int r;
-
-	r = raw_read(servo, reg, id, IL_REG_DTYPE_S64, buf, sizeof(*buf));
-	if (r == 0)
-		*buf = (int64_t)__swap_be_64(*buf);
-
-	return r;
+	return raw_read(servo, reg, id, IL_REG_DTYPE_S64, buf, sizeof(*buf),
+			IL_NET_PRIO_BULK);
 }
 
 int il_servo_base__raw_read_float(il_servo_t *servo, const il_reg_t *reg,
 				  const char *id, float *buf)
+{
+	return raw_read(servo, reg, id, IL_REG_DTYPE_FLOAT, buf, sizeof(*buf),
+			IL_NET_PRIO_BULK);
+}
+
+int il_servo_base__sw_read(il_servo_t *servo, const il_reg_t *reg,
+			   const char *id, uint16_t *sw)
+{
+	/* statusword drives the state machine: control request */
+	return raw_read(servo, reg, id, IL_REG_DTYPE_U16, sw, sizeof(*sw),
+			IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_read_str(il_servo_t *servo, const il_reg_t *reg,
+				const char *id, char *buf, size_t sz)
 {
 	int r;
+	const il_reg_t *reg_;
+	size_t sz_;
+
+	if (sz == 0) {
+		ilerr__set("Insufficient buffer size");
+		return IL_ENOMEM;
+	}
+
+	r = get_reg(servo->dict, reg, id, &reg_);
+	if (r < 0)
+		return r;
+
+	if (reg_->dtype != IL_REG_DTYPE_STR) {
+		ilerr__set("Unexpected register data type");
+		return IL_EINVAL;
+	}
+
+	if (reg_->access == IL_REG_ACCESS_WO) {
+		ilerr__set("Register is write-only");
+		return IL_EACCESS;
+	}
+
+	if (reg_->sz == 0) {
+		ilerr__set("Unknown string register size");
+		return IL_EINVAL;
+	}
+
+	/* never read past the register, terminate if truncated */
+	sz_ = MIN(reg_->sz, sz - 1);
 
-	r = raw_read(servo, reg, id, IL_REG_DTYPE_FLOAT, buf, sizeof(*buf));
-	if (r == 0)
-		*buf = __swap_be_float(*buf);
+	r = il_net__read_segmented(servo->net, servo->id, reg_->address, buf,
+				   sz_, NULL, NULL);
+	buf[sz_] = '\0';
 
 	return r;
 }
@@ -917,312 +1701,384 @@ int il_servo_base__read(il_servo_t *servo, const il_reg_t *reg, const char *id,
 			double *buf)
 {
 	int r;
-
 	const il_reg_t *reg_;
-
-	uint8_t u8_v;
-	uint16_t u16_v;
-	uint32_t u32_v;
-	uint64_t u64_v;
-	int8_t s8_v;
-	int16_t s16_v;
-	int32_t s32_v;
-	int64_t s64_v;
-	float float_v;
-
-	double buf_;
+	size_t sz;
+	il_servo_reg_value_t v;
 
 	/* obtain register (predefined or from dictionary) */
 	r = get_reg(servo->dict, reg, id, &reg_);
 	if (r < 0)
 		return r;
 
-	/* read */
-	switch (reg_->dtype) {
-	case IL_REG_DTYPE_U8:
-		r = il_servo_raw_read_u8(servo, reg_, NULL, &u8_v);
-		buf_ = (float)u8_v;
-		break;
-	case IL_REG_DTYPE_S8:
-		r = il_servo_raw_read_s8(servo, reg_, NULL, &s8_v);
-		buf_ = (float)s8_v;
-		break;
-	case IL_REG_DTYPE_U16:
-		r = il_servo_raw_read_u16(servo, reg_, NULL, &u16_v);
-		buf_ = (float)u16_v;
-		break;
-	case IL_REG_DTYPE_S16:
-		r = il_servo_raw_read_s16(servo, reg_, NULL, &s16_v);
-		buf_ = (float)s16_v;
-		break;
-	case IL_REG_DTYPE_U32:
-		r = il_servo_raw_read_u32(servo, reg_, NULL, &u32_v);
-		buf_ = (float)u32_v;
-		break;
-	case IL_REG_DTYPE_S32:
-		r = il_servo_raw_read_s32(servo, reg_, NULL, &s32_v);
-		buf_ = (float)s32_v;
-		break;
-	case IL_REG_DTYPE_U64:
-		r = il_servo_raw_read_u64(servo, reg_, NULL, &u64_v);
-		buf_ = (float)u64_v;
-		break;
-	case IL_REG_DTYPE_S64:
-		r = il_servo_raw_read_s64(servo, reg_, NULL, &s64_v);
-		buf_ = (float)s64_v;
-		break;
-	case IL_REG_DTYPE_FLOAT:
-		r = il_servo_raw_read_float(servo, reg_, NULL, &float_v);
-		buf_ = (double)float_v;
-		break;
-	default:
+	sz = il_utils__reg_sz(reg_->dtype);
+	if (sz == 0) {
 		ilerr__set("Unsupported register data type");
 		return IL_EINVAL;
 	}
 
+	r = raw_read(servo, reg_, NULL, reg_->dtype, &v, sz, IL_NET_PRIO_BULK);
 	if (r < 0)
 		return r;
 
 	/* store converted value to buffer */
-	*buf = buf_ * il_servo_units_factor(servo, reg_);
+	*buf = value_get(reg_->dtype, &v) * il_servo_units_factor(servo, reg_);
 
 	return 0;
 }
 
 int il_servo_base__raw_write_u8(il_servo_t *servo, const il_reg_t *reg,
 				const char *id, uint8_t val, int confirm)
+{
+	return raw_write(servo, reg, id, IL_REG_DTYPE_U8, &val, sizeof(val),
+			 confirm, IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_write_s8(il_servo_t *servo, const il_reg_t *reg,
+				const char *id, int8_t val, int confirm)
+{
+	return raw_write(servo, reg, id, IL_REG_DTYPE_S8, &val, sizeof(val),
+			 confirm, IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_write_u16(il_servo_t *servo, const il_reg_t *reg,
+				 const char *id, uint16_t val, int confirm)
+{
+	return raw_write(servo, reg, id, IL_REG_DTYPE_U16, &val, sizeof(val),
+			 confirm, IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_write_s16(il_servo_t *servo, const il_reg_t *reg,
+				 const char *id, int16_t val, int confirm)
+{
+	return raw_write(servo, reg, id, IL_REG_DTYPE_S16, &val, sizeof(val),
+			 confirm, IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_write_u32(il_servo_t *servo, const il_reg_t *reg,
+				 const char *id, uint32_t val, int confirm)
+{
+	return raw_write(servo, reg, id, IL_REG_DTYPE_U32, &val, sizeof(val),
+			 confirm, IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_write_s32(il_servo_t *servo, const il_reg_t *reg,
+				 const char *id, int32_t val, int confirm)
+{
+	return raw_write(servo, reg, id, IL_REG_DTYPE_S32, &val, sizeof(val),
+			 confirm, IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_write_u64(il_servo_t *servo, const il_reg_t *reg,
+				 const char *id, uint64_t val, int confirm)
+{
+	return raw_write(servo, reg, id, IL_REG_DTYPE_U64, &val, sizeof(val),
+			 confirm, IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_write_s64(il_servo_t *servo, const il_reg_t *reg,
+				 const char *id, int64_t val, int confirm)
+{
+	return raw_write(servo, reg, id, IL_REG_DTYPE_S64, &val, sizeof(val),
+			 confirm, IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_write_float(il_servo_t *servo, const il_reg_t *reg,
+				   const char *id, float val, int confirm)
+{
+	return raw_write(servo, reg, id, IL_REG_DTYPE_FLOAT, &val, sizeof(val),
+			 confirm, IL_NET_PRIO_CTL);
+}
+
+int il_servo_base__raw_write_str(il_servo_t *servo, const il_reg_t *reg,
+				 const char *id, const char *val, int confirm)
 {
 	int r;
 	const il_reg_t *reg_;
+	size_t sz;
 
 	r = get_reg(servo->dict, reg, id, &reg_);
 	if (r < 0)
 		return r;
 
-	if ((val < reg->range.min.u8) || (val > reg->range.max.u8)) {
-		ilerr__set("Value out of range");
+	if (reg_->dtype != IL_REG_DTYPE_STR) {
+		ilerr__set("Unexpected register data type");
 		return IL_EINVAL;
 	}
 
-	return raw_write(servo, reg_, IL_REG_DTYPE_U8, &val, sizeof(val),
-			 confirm);
+	if (reg_->access == IL_REG_ACCESS_RO) {
+		ilerr__set("Register is read-only");
+		return IL_EACCESS;
+	}
+
+	/* null terminator is dropped if the string fills the register */
+	sz = strlen(val) + 1;
+	if (reg_->sz) {
+		if (sz - 1 > reg_->sz) {
+			ilerr__set("String too long");
+			return IL_EINVAL;
+		}
+
+		sz = MIN(sz, reg_->sz);
+	}
+
+	/* skip confirmation on write-only registers */
+	if (reg_->access == IL_REG_ACCESS_WO)
+		confirm = 0;
+
+	return il_net__write_segmented(servo->net, servo->id, reg_->address,
+				       val, sz, confirm, NULL, NULL);
 }
 
-int il_servo_base__raw_write_s8(il_servo_t *servo, const il_reg_t *reg,
-				const char *id, int8_t val, int confirm)
+int il_servo_base__write(il_servo_t *servo, const il_reg_t *reg, const char *id,
+			 double val, int confirm)
 {
 	int r;
 	const il_reg_t *reg_;
+	il_servo_reg_value_t v;
 
+	/* obtain register (predefined or from dictionary) */
 	r = get_reg(servo->dict, reg, id, &reg_);
 	if (r < 0)
 		return r;
 
-	if ((val < reg->range.min.s8) || (val > reg->range.max.s8)) {
-		ilerr__set("Value out of range");
-		return IL_EINVAL;
-	}
+	/* convert to native units */
+	r = value_set(reg_->dtype, &v,
+		      val / il_servo_units_factor(servo, reg_));
+	if (r < 0)
+		return r;
 
-	return raw_write(servo, reg_, IL_REG_DTYPE_S8, &val, sizeof(val),
-			 confirm);
+	return raw_write(servo, reg_, NULL, reg_->dtype, &v,
+			 il_utils__reg_sz(reg_->dtype), confirm,
+			 IL_NET_PRIO_CTL);
 }
 
-int il_servo_base__raw_write_u16(il_servo_t *servo, const il_reg_t *reg,
-				 const char *id, uint16_t val, int confirm)
+int il_servo_base__read_async(il_servo_t *servo, const il_reg_t *reg,
+			      const char *id, il_servo_async_cb_t cb,
+			      void *ctx)
 {
 	int r;
-	uint16_t val_;
-	const il_reg_t *reg_;
+	il_servo_batch_t entry = { servo, reg, id, 0., 0, 0 };
+	il_servo_async_t *async;
+	il_net_xfer_t xfer;
+	uint64_t data;
 
-	r = get_reg(servo->dict, reg, id, &reg_);
-	if (r < 0)
-		return r;
+	xfer.buf = &data;
 
-	if ((val < reg->range.min.u16) || (val > reg->range.max.u16)) {
-		ilerr__set("Value out of range");
-		return IL_EINVAL;
+	async = malloc(sizeof(*async));
+	if (!async) {
+		ilerr__set("Asynchronous context allocation failed");
+		return IL_ENOMEM;
 	}
 
-	val_ = __swap_be_16(val);
+	r = xfer_prepare(&entry, 0, &async->reg, &xfer);
+	if (r < 0)
+		goto cleanup;
+
+	async->servo = servo;
+	async->cb = cb;
+	async->ctx = ctx;
+
+	r = il_net__read_async(servo->net, xfer.id, xfer.address, xfer.sz,
+			       on_async, async, IL_NET_PRIO_BULK);
+	if (r < 0)
+		goto cleanup;
 
-	return raw_write(servo, reg_, IL_REG_DTYPE_U16, &val_, sizeof(val_),
-			 confirm);
+	return 0;
+
+cleanup:
+	free(async);
+
+	return r;
 }
 
-int il_servo_base__raw_write_s16(il_servo_t *servo, const il_reg_t *reg,
-				 const char *id, int16_t val, int confirm)
+int il_servo_base__write_async(il_servo_t *servo, const il_reg_t *reg,
+			       const char *id, double val, int confirm,
+			       il_servo_async_cb_t cb, void *ctx)
 {
 	int r;
-	int16_t val_;
-	const il_reg_t *reg_;
+	il_servo_batch_t entry = { servo, reg, id, val, 0, 0 };
+	il_servo_async_t *async;
+	il_net_xfer_t xfer;
+	uint64_t data;
 
-	r = get_reg(servo->dict, reg, id, &reg_);
-	if (r < 0)
-		return r;
+	xfer.buf = &data;
 
-	if ((val < reg->range.min.s16) || (val > reg->range.max.s16)) {
-		ilerr__set("Value out of range");
-		return IL_EINVAL;
+	async = malloc(sizeof(*async));
+	if (!async) {
+		ilerr__set("Asynchronous context allocation failed");
+		return IL_ENOMEM;
 	}
 
-	val_ = (int16_t)__swap_be_16(val);
+	r = xfer_prepare(&entry, 1, &async->reg, &xfer);
+	if (r < 0)
+		goto cleanup;
+
+	async->servo = servo;
+	async->cb = cb;
+	async->ctx = ctx;
+
+	/* skip confirmation on write-only registers */
+	if (async->reg->access == IL_REG_ACCESS_WO)
+		confirm = 0;
+
+	r = il_net__write_async(servo->net, xfer.id, xfer.address, xfer.buf,
+				xfer.sz, confirm, on_async, async,
+				IL_NET_PRIO_CTL);
+	if (r < 0)
+		goto cleanup;
+
+	return 0;
 
-	return raw_write(servo, reg_, IL_REG_DTYPE_S16, &val_, sizeof(val_),
-			 confirm);
+cleanup:
+	free(async);
+
+	return r;
 }
 
-int il_servo_base__raw_write_u32(il_servo_t *servo, const il_reg_t *reg,
-				 const char *id, uint32_t val, int confirm)
+il_servo_reg_handle_t *il_servo_base__reg_bind(il_servo_t *servo,
+					       const il_reg_t *reg,
+					       const char *id)
 {
 	int r;
-	uint32_t val_;
 	const il_reg_t *reg_;
+	il_servo_reg_handle_t *hnd;
 
 	r = get_reg(servo->dict, reg, id, &reg_);
 	if (r < 0)
-		return r;
+		return NULL;
 
-	if ((val < reg->range.min.u32) || (val > reg->range.max.u32)) {
-		ilerr__set("Value out of range");
-		return IL_EINVAL;
+	if (il_utils__reg_sz(reg_->dtype) == 0) {
+		ilerr__set("Unsupported register data type");
+		return NULL;
 	}
 
-	val_ = __swap_be_32(val);
+	hnd = malloc(sizeof(*hnd));
+	if (!hnd) {
+		ilerr__set("Register handle allocation failed");
+		return NULL;
+	}
+
+	/* keep a copy (dictionary may be reloaded), labels are not needed */
+	hnd->servo = servo;
+	hnd->reg = *reg_;
+	hnd->reg.labels = NULL;
+	hnd->sz = il_utils__reg_sz(reg_->dtype);
 
-	return raw_write(servo, reg_, IL_REG_DTYPE_U32, &val_, sizeof(val_),
-			 confirm);
+	/* bound to the factors table, so units changes are followed */
+	if ((size_t)reg_->phy < UNITS_FACTORS_SZ)
+		hnd->factor = &servo->units.factors[reg_->phy];
+	else
+		hnd->factor = NULL;
+
+	return hnd;
 }
 
-int il_servo_base__raw_write_s32(il_servo_t *servo, const il_reg_t *reg,
-				 const char *id, int32_t val, int confirm)
+void il_servo_base__reg_unbind(il_servo_reg_handle_t *hnd)
+{
+	free(hnd);
+}
+
+int il_servo_base__reg_read(il_servo_reg_handle_t *hnd, double *buf)
 {
 	int r;
-	int32_t val_;
-	const il_reg_t *reg_;
+	il_servo_t *servo = hnd->servo;
+	uint8_t raw[sizeof(uint64_t)];
 
-	r = get_reg(servo->dict, reg, id, &reg_);
+	if (hnd->reg.access == IL_REG_ACCESS_WO) {
+		ilerr__set("Register is write-only");
+		return IL_EACCESS;
+	}
+
+	r = il_net__read(servo->net, servo->id, hnd->reg.address, raw,
+			 hnd->sz, IL_NET_PRIO_BULK);
 	if (r < 0)
 		return r;
 
-	if ((val < reg->range.min.s32) || (val > reg->range.max.s32)) {
-		ilerr__set("Value out of range");
-		return IL_EINVAL;
-	}
-
-	val_ = (int32_t)__swap_be_32(val);
+	*buf = reg_decode(&hnd->reg, raw) * hnd_factor(hnd);
 
-	return raw_write(servo, reg_, IL_REG_DTYPE_S32, &val_, sizeof(val_),
-			 confirm);
+	return 0;
 }
 
-int il_servo_base__raw_write_u64(il_servo_t *servo, const il_reg_t *reg,
-				 const char *id, uint64_t val, int confirm)
+int il_servo_base__reg_write(il_servo_reg_handle_t *hnd, double val,
+			     int confirm)
 {
 	int r;
-	uint64_t val_;
-	const il_reg_t *reg_;
+	il_servo_t *servo = hnd->servo;
+	uint8_t raw[sizeof(uint64_t)];
 
-	r = get_reg(servo->dict, reg, id, &reg_);
+	if (hnd->reg.access == IL_REG_ACCESS_RO) {
+		ilerr__set("Register is read-only");
+		return IL_EACCESS;
+	}
+
+	r = reg_encode(&hnd->reg, val / hnd_factor(hnd), raw);
 	if (r < 0)
 		return r;
 
-	if ((val < reg->range.min.u64) || (val > reg->range.max.u64)) {
-		ilerr__set("Value out of range");
-		return IL_EINVAL;
-	}
+	/* skip confirmation on write-only registers */
+	if (hnd->reg.access == IL_REG_ACCESS_WO)
+		confirm = 0;
 
-	val_ = __swap_be_64(val);
+	if (il_net__wb_write(servo->net, servo->id, hnd->reg.address, raw,
+			     hnd->sz, confirm))
+		return 0;
 
-	return raw_write(servo, reg_, IL_REG_DTYPE_U64, &val_, sizeof(val_),
-			 confirm);
+	return il_net__write(servo->net, servo->id, hnd->reg.address, raw,
+			     hnd->sz, confirm, IL_NET_PRIO_CTL);
 }
 
-int il_servo_base__raw_write_s64(il_servo_t *servo, const il_reg_t *reg,
-				 const char *id, int64_t val, int confirm)
+int il_servo_base__write_behind_enable(il_servo_t *servo, const il_reg_t *reg,
+				       const char *id)
 {
 	int r;
-	int64_t val_;
 	const il_reg_t *reg_;
 
 	r = get_reg(servo->dict, reg, id, &reg_);
 	if (r < 0)
 		return r;
 
-	if ((val < reg->range.min.s64) || (val > reg->range.max.s64)) {
-		ilerr__set("Value out of range");
-		return IL_EINVAL;
+	if (reg_->access == IL_REG_ACCESS_RO) {
+		ilerr__set("Register is read-only");
+		return IL_EACCESS;
 	}
 
-	val_ = (int64_t)__swap_be_64(val);
-
-	return raw_write(servo, reg_, IL_REG_DTYPE_S64, &val_, sizeof(val_),
-			 confirm);
+	return il_net__wb_enable(servo->net, servo->id, reg_->address);
 }
 
-int il_servo_base__raw_write_float(il_servo_t *servo, const il_reg_t *reg,
-				   const char *id, float val, int confirm)
+int il_servo_base__write_behind_disable(il_servo_t *servo,
+					const il_reg_t *reg, const char *id)
 {
 	int r;
-	float val_;
 	const il_reg_t *reg_;
 
 	r = get_reg(servo->dict, reg, id, &reg_);
 	if (r < 0)
 		return r;
 
-	val_ = __swap_be_float(val);
-
-	return raw_write(servo, reg_, IL_REG_DTYPE_FLOAT, &val_,
-			 sizeof(val_), confirm);
+	return il_net__wb_disable(servo->net, servo->id, reg_->address);
 }
 
-int il_servo_base__write(il_servo_t *servo, const il_reg_t *reg, const char *id,
-			 double val, int confirm)
+int il_servo_base__write_behind_stats_get(il_servo_t *servo,
+					  const il_reg_t *reg, const char *id,
+					  il_net_wb_stats_t *stats)
 {
 	int r;
-
 	const il_reg_t *reg_;
-	double val_;
 
-	/* obtain register (predefined or from dictionary) */
 	r = get_reg(servo->dict, reg, id, &reg_);
 	if (r < 0)
 		return r;
 
-	/* convert to native units */
-	val_ = val / il_servo_units_factor(servo, reg_);
+	return il_net__wb_stats_get(servo->net, servo->id, reg_->address,
+				    stats);
+}
 
-	/* write using the appropriate native type */
-	switch (reg_->dtype) {
-	case IL_REG_DTYPE_U8:
-		return il_servo_raw_write_u8(servo, reg_, NULL, (uint8_t)val_,
-					     confirm);
-	case IL_REG_DTYPE_S8:
-		return il_servo_raw_write_s8(servo, reg_, NULL, (int8_t)val_,
-					     confirm);
-	case IL_REG_DTYPE_U16:
-		return il_servo_raw_write_u16(servo, reg_, NULL, (uint16_t)val_,
-					      confirm);
-	case IL_REG_DTYPE_S16:
-		return il_servo_raw_write_s16(servo, reg_, NULL, (int16_t)val_,
-					      confirm);
-	case IL_REG_DTYPE_U32:
-		return il_servo_raw_write_u32(servo, reg_, NULL, (uint32_t)val_,
-					      confirm);
-	case IL_REG_DTYPE_S32:
-		return il_servo_raw_write_s32(servo, reg_, NULL, (int32_t)val_,
-					      confirm);
-	case IL_REG_DTYPE_U64:
-		return il_servo_raw_write_u64(servo, reg_, NULL, (uint64_t)val_,
-					      confirm);
-	case IL_REG_DTYPE_S64:
-		return il_servo_raw_write_s64(servo, reg_, NULL, (int64_t)val_,
-					      confirm);
-	case IL_REG_DTYPE_FLOAT:
-		return il_servo_raw_write_float(servo, reg_, NULL, (float)val_,
-						confirm);
-	default:
-		ilerr__set("Unsupported register data type");
-		return IL_EINVAL;
-	}
+int il_servo_base__read_batch(il_servo_batch_t *batch, size_t cnt)
+{
+	return transfer_batch(batch, cnt, 0);
+}
+
+int il_servo_base__write_batch(il_servo_batch_t *batch, size_t cnt)
+{
+	return transfer_batch(batch, cnt, 1);
 }
@@ -0,0 +1,351 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "public/ingenialink/err.h"
+#include "ingenialink/err.h"
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+/** Cache instances (shared by path). */
+static il_cache_t *caches;
+
+/** Cache instances lock (spin lock, only taken on create/destroy). */
+static volatile uint32_t caches_lock;
+
+/**
+ * Lock the cache instances.
+ */
+static void caches_lock_acquire(void)
+{
+	uint32_t unlocked;
+
+	for (;;) {
+		unlocked = 0;
+		if (osal_atomic_cas_u32(&caches_lock, &unlocked, 1))
+			break;
+
+		osal_clock_sleep_ms(CACHE_LOCK_POLL);
+	}
+}
+
+/**
+ * Unlock the cache instances.
+ */
+static void caches_lock_release(void)
+{
+	osal_atomic_store_u32(&caches_lock, 0);
+}
+
+/**
+ * Open the cache file and validate its header.
+ *
+ * @param [in] cache
+ *	Cache instance.
+ *
+ * @return
+ *	File positioned at the first record (NULL if not available or not
+ *	valid).
+ */
+static FILE *cache_open(il_cache_t *cache)
+{
+	FILE *f;
+	il_cache_hdr_t hdr;
+
+	f = fopen(cache->path, "rb");
+	if (!f)
+		return NULL;
+
+	if ((fread(&hdr, sizeof(hdr), 1, f) != 1) ||
+	    (hdr.magic != CACHE_MAGIC) || (hdr.version != CACHE_VERSION)) {
+		fclose(f);
+		return NULL;
+	}
+
+	return f;
+}
+
+/**
+ * Read the next cache record.
+ *
+ * @param [in] f
+ *	Cache file.
+ * @param [out] rec
+ *	Record header.
+ * @param [out] data
+ *	Record data buffer (CACHE_REC_SZ_MAX bytes).
+ *
+ * @return
+ *	0 on success, -1 on end of file or if the record is invalid.
+ */
+static int cache_read(FILE *f, il_cache_rec_hdr_t *rec, void *data)
+{
+	if (fread(rec, sizeof(*rec), 1, f) != 1)
+		return -1;
+
+	if (rec->sz > CACHE_REC_SZ_MAX)
+		return -1;
+
+	if (fread(data, 1, rec->sz, f) != rec->sz)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Write a cache record.
+ *
+ * @param [in] f
+ *	Cache file.
+ * @param [in] rec
+ *	Record header.
+ * @param [in] data
+ *	Record data.
+ *
+ * @return
+ *	0 on success, -1 otherwise.
+ */
+static int cache_write(FILE *f, const il_cache_rec_hdr_t *rec,
+		       const void *data)
+{
+	if (fwrite(rec, sizeof(*rec), 1, f) != 1)
+		return -1;
+
+	if (fwrite(data, 1, rec->sz, f) != rec->sz)
+		return -1;
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Internal
+ ******************************************************************************/
+
+il_cache_t *il_cache__create(const char *path)
+{
+	il_cache_t *cache;
+
+	caches_lock_acquire();
+
+	/* share the instance if the path is already in use */
+	for (cache = caches; cache; cache = cache->next) {
+		if (strcmp(cache->path, path) == 0) {
+			cache->refs++;
+			goto unlock;
+		}
+	}
+
+	cache = malloc(sizeof(*cache));
+	if (!cache) {
+		ilerr__set("Cache allocation failed");
+		goto unlock;
+	}
+
+	cache->path = strdup(path);
+	if (!cache->path) {
+		ilerr__set("Cache path allocation failed");
+		goto cleanup_cache;
+	}
+
+	cache->path_tmp = malloc(strlen(path) + sizeof(".tmp"));
+	if (!cache->path_tmp) {
+		ilerr__set("Cache path allocation failed");
+		goto cleanup_path;
+	}
+
+	strcpy(cache->path_tmp, path);
+	strcat(cache->path_tmp, ".tmp");
+
+	cache->lock = osal_mutex_create();
+	if (!cache->lock) {
+		ilerr__set("Cache lock allocation failed");
+		goto cleanup_path_tmp;
+	}
+
+	cache->refs = 1;
+	cache->next = caches;
+	caches = cache;
+
+	goto unlock;
+
+cleanup_path_tmp:
+	free(cache->path_tmp);
+
+cleanup_path:
+	free(cache->path);
+
+cleanup_cache:
+	free(cache);
+	cache = NULL;
+
+unlock:
+	caches_lock_release();
+
+	return cache;
+}
+
+void il_cache__destroy(il_cache_t *cache)
+{
+	il_cache_t **pos;
+
+	caches_lock_acquire();
+
+	if (--cache->refs > 0) {
+		caches_lock_release();
+		return;
+	}
+
+	pos = &caches;
+	while (*pos != cache)
+		pos = &(*pos)->next;
+
+	*pos = cache->next;
+
+	caches_lock_release();
+
+	osal_mutex_destroy(cache->lock);
+	free(cache->path_tmp);
+	free(cache->path);
+	free(cache);
+}
+
+int il_cache__get(il_cache_t *cache, uint32_t key, uint64_t fp, void *data,
+		  size_t sz)
+{
+	int r = IL_EFAIL;
+	FILE *f;
+	il_cache_rec_hdr_t rec;
+	uint8_t buf[CACHE_REC_SZ_MAX];
+
+	osal_mutex_lock(cache->lock);
+
+	f = cache_open(cache);
+	if (!f)
+		goto unlock;
+
+	while (cache_read(f, &rec, buf) == 0) {
+		if (rec.key != key)
+			continue;
+
+		if ((rec.fp == fp) && (rec.sz == sz)) {
+			memcpy(data, buf, sz);
+			r = 0;
+		}
+
+		break;
+	}
+
+	fclose(f);
+
+unlock:
+	osal_mutex_unlock(cache->lock);
+
+	if (r < 0)
+		ilerr__set("Cache record not found or stale");
+
+	return r;
+}
+
+int il_cache__put(il_cache_t *cache, uint32_t key, uint64_t fp,
+		  const void *data, size_t sz)
+{
+	int r = 0;
+	FILE *in, *out;
+	il_cache_hdr_t hdr;
+	il_cache_rec_hdr_t rec;
+	uint8_t buf[CACHE_REC_SZ_MAX];
+
+	if (sz > CACHE_REC_SZ_MAX) {
+		ilerr__set("Cache record too large");
+		return IL_EINVAL;
+	}
+
+	osal_mutex_lock(cache->lock);
+
+	/* write a new file (header, other records, new record) */
+	out = fopen(cache->path_tmp, "wb");
+	if (!out) {
+		ilerr__set("Cache file could not be created");
+		r = IL_EIO;
+		goto unlock;
+	}
+
+	hdr.magic = CACHE_MAGIC;
+	hdr.version = CACHE_VERSION;
+
+	if (fwrite(&hdr, sizeof(hdr), 1, out) != 1)
+		r = IL_EIO;
+
+	in = cache_open(cache);
+	if (in) {
+		while ((r == 0) && (cache_read(in, &rec, buf) == 0)) {
+			if (rec.key == key)
+				continue;
+
+			if (cache_write(out, &rec, buf) < 0)
+				r = IL_EIO;
+		}
+
+		fclose(in);
+	}
+
+	rec.key = key;
+	rec.sz = (uint32_t)sz;
+	rec.fp = fp;
+
+	if ((r == 0) && (cache_write(out, &rec, data) < 0))
+		r = IL_EIO;
+
+	if (fclose(out) != 0)
+		r = IL_EIO;
+
+	if (r < 0) {
+		ilerr__set("Cache file could not be written");
+		(void)remove(cache->path_tmp);
+		goto unlock;
+	}
+
+	/* replace the old file */
+#ifdef _WIN32
+	(void)remove(cache->path);
+#endif
+	if (rename(cache->path_tmp, cache->path) != 0) {
+		ilerr__set("Cache file could not be replaced");
+		(void)remove(cache->path_tmp);
+		r = IL_EIO;
+	}
+
+unlock:
+	osal_mutex_unlock(cache->lock);
+
+	return r;
+}
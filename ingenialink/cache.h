@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include "ingenialink/cache.h"
+
+#include "osal/osal.h"
+
+/** Cache file magic ("ILCC"). */
+#define CACHE_MAGIC		0x43434C49U
+
+/** Cache file format version. */
+#define CACHE_VERSION		2U
+
+/** Maximum record data size. */
+#define CACHE_REC_SZ_MAX	1024U
+
+/** Cache file header. */
+typedef struct {
+	/** Magic. */
+	uint32_t magic;
+	/** Format version. */
+	uint32_t version;
+} il_cache_hdr_t;
+
+/** Cache record header (followed by record data). */
+typedef struct {
+	/** Key. */
+	uint32_t key;
+	/** Data size. */
+	uint32_t sz;
+	/** Fingerprint. */
+	uint64_t fp;
+} il_cache_rec_hdr_t;
+
+/** Cache instances lock polling period (ms). */
+#define CACHE_LOCK_POLL		1
+
+/**
+ * Persistent cache.
+ *
+ * @note
+ *	Instances are shared by path (reference counted), so that networks
+ *	using the same cache file serialize their updates with the same lock.
+ */
+struct il_cache {
+	/** Cache file path. */
+	char *path;
+	/** Temporary file path (used for atomic updates). */
+	char *path_tmp;
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** References (protected by the instances lock). */
+	int refs;
+	/** Next instance. */
+	struct il_cache *next;
+};
+
+#endif
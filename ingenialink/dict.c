@@ -553,6 +553,7 @@ static int parse_reg(xmlNodePtr node, il_dict_t *dict)
 	/* initialize register */
 	reg->labels = NULL;
 	reg->cat_id = NULL;
+	reg->sz = 0;
 
 	/* parse: address */
 	param = xmlGetProp(node, (const xmlChar *)"address");
@@ -589,6 +590,13 @@ static int parse_reg(xmlNodePtr node, il_dict_t *dict)
 	if (r < 0)
 		return r;
 
+	/* parse: data size (optional, strings) */
+	param = xmlGetProp(node, (const xmlChar *)"size");
+	if (param) {
+		reg->sz = (size_t)strtoul((char *)param, NULL, 10);
+		xmlFree(param);
+	}
+
 	/* parse: phyisical units (optional) */
 	param = xmlGetProp(node, (const xmlChar *)"phy");
 	if (param) {
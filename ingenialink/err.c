@@ -23,6 +23,7 @@
  */
 
 #include "ingenialink/err.h"
+#include "ingenialink/utils.h"
 
 #define _SER_NO_LEGACY_STDINT
 #include <sercomm/sercomm.h>
@@ -34,18 +35,6 @@
  * Internal
  ******************************************************************************/
 
-/** Declare a variable thread-local. */
-#ifdef __GNUC__
-# define thread_local __thread
-#elif __STDC_VERSION__ >= 201112L
-# define thread_local _Thread_local
-#elif defined(_MSC_VER)
-# define thread_local __declspec(thread)
-#else
-# define thread_local
-# warning Thread Local Storage (TLS) not available. Last error will be global.
-#endif
-
 /** Maximum error message size. */
 #define ERR_SZ 256U
 
@@ -106,6 +106,13 @@ static int state_update(il_eusb_frame_t *frame)
 
 int il_eusb_frame__init(il_eusb_frame_t *frame, uint8_t id, uint32_t address,
 			const void *data, size_t sz)
+{
+	return il_eusb_frame__init_seg(frame, id, address, 0, data, sz);
+}
+
+int il_eusb_frame__init_seg(il_eusb_frame_t *frame, uint8_t id,
+			    uint32_t address, uint16_t offset, const void *data,
+			    size_t sz)
 {
 	uint16_t idx;
 	uint8_t sidx;
@@ -129,14 +136,14 @@ int il_eusb_frame__init(il_eusb_frame_t *frame, uint8_t id, uint32_t address,
 	frame->buf[FR_RES_FLD] = 0;
 	frame->buf[FR_NODE_FLD] = id;
 
-	/* index, subindex, address (0) */
+	/* index, subindex, address (segment offset) */
 	idx = __swap_index(IL_EUSB_FRAME_IDX(address));
 	sidx = IL_EUSB_FRAME_SIDX(address);
 
 	memcpy(&frame->buf[FR_INDEX_H_FLD], &idx, sizeof(idx));
 	frame->buf[FR_SINDEX_FLD] = sidx;
-	frame->buf[FR_SADDR_H_FLD] = 0;
-	frame->buf[FR_SADDR_L_FLD] = 0;
+	frame->buf[FR_SADDR_H_FLD] = (uint8_t)(offset >> 8);
+	frame->buf[FR_SADDR_L_FLD] = (uint8_t)offset;
 
 	/* data size, data */
 	frame->buf[FR_NDATA_H_FLD] = 0;
@@ -177,26 +184,114 @@ int il_eusb_frame__push(il_eusb_frame_t *frame, uint8_t c)
 	return state_update(frame);
 }
 
-uint8_t il_eusb_frame__get_id(const il_eusb_frame_t *frame)
+size_t il_eusb_frame__find(const uint8_t *buf, size_t sz, size_t *start)
 {
-	return frame->buf[FR_ADDR_FLD];
+	size_t pos = 0;
+
+	while (sz - pos > FR_MEI_FLD) {
+		const uint8_t *func;
+		size_t fr_start, fr_sz;
+
+		/* locate candidate header (FUNC, MEI) */
+		func = memchr(&buf[pos + FR_FUNC_FLD], FR_FUNC,
+			      sz - pos - FR_FUNC_FLD);
+		if (!func) {
+			/* keep last byte (may be a node address) */
+			pos = sz - FR_FUNC_FLD;
+			break;
+		}
+
+		fr_start = (size_t)(func - buf) - FR_FUNC_FLD;
+		pos = fr_start;
+
+		if (sz - fr_start <= FR_MEI_FLD)
+			break;
+
+		if (buf[fr_start + FR_MEI_FLD] != FR_MEI) {
+			pos++;
+			continue;
+		}
+
+		/* need data size field to go on */
+		if (sz - fr_start <= FR_NDATA_L_FLD)
+			break;
+
+		if (buf[fr_start + FR_NDATA_L_FLD] > IL_EUSB_FRAME_MAX_DATA_SZ) {
+			pos++;
+			continue;
+		}
+
+		/* jump to the trailing sync block */
+		fr_sz = IL_EUSB_FRAME_MIN_SZ + buf[fr_start + FR_NDATA_L_FLD];
+		if (sz - fr_start < fr_sz)
+			break;
+
+		if (memcmp(&buf[fr_start + fr_sz - FR_SYNC_SZ], sync,
+			   sizeof(sync)) != 0) {
+			pos++;
+			continue;
+		}
+
+		*start = fr_start;
+
+		return fr_sz;
+	}
+
+	*start = pos;
+
+	return 0;
 }
 
-uint32_t il_eusb_frame__get_address(const il_eusb_frame_t *frame)
+uint8_t il_eusb_frame__raw_get_id(const uint8_t *buf)
+{
+	return buf[FR_ADDR_FLD];
+}
+
+uint32_t il_eusb_frame__raw_get_address(const uint8_t *buf)
 {
 	uint16_t idx;
 	uint8_t sidx;
 
-	memcpy(&idx, &frame->buf[FR_INDEX_H_FLD], sizeof(idx));
+	memcpy(&idx, &buf[FR_INDEX_H_FLD], sizeof(idx));
 	idx = __swap_index(idx);
-	sidx = frame->buf[FR_SINDEX_FLD];
+	sidx = buf[FR_SINDEX_FLD];
 
 	return IL_EUSB_FRAME_ADDR(idx, sidx);
 }
 
+uint16_t il_eusb_frame__raw_get_offset(const uint8_t *buf)
+{
+	return (uint16_t)((buf[FR_SADDR_H_FLD] << 8) | buf[FR_SADDR_L_FLD]);
+}
+
+size_t il_eusb_frame__raw_get_sz(const uint8_t *buf)
+{
+	return (size_t)buf[FR_NDATA_L_FLD];
+}
+
+const void *il_eusb_frame__raw_get_data(const uint8_t *buf)
+{
+	return &buf[FR_DATA_FLD];
+}
+
+int il_eusb_frame__raw_is_resp(const uint8_t *buf)
+{
+	return (int)buf[FR_PROT_FLD];
+}
+
+uint8_t il_eusb_frame__get_id(const il_eusb_frame_t *frame)
+{
+	return il_eusb_frame__raw_get_id(frame->buf);
+}
+
+uint32_t il_eusb_frame__get_address(const il_eusb_frame_t *frame)
+{
+	return il_eusb_frame__raw_get_address(frame->buf);
+}
+
 size_t il_eusb_frame__get_sz(const il_eusb_frame_t *frame)
 {
-	return (size_t)frame->buf[FR_NDATA_L_FLD];
+	return il_eusb_frame__raw_get_sz(frame->buf);
 }
 
 void *il_eusb_frame__get_data(il_eusb_frame_t *frame)
@@ -206,5 +301,5 @@ void *il_eusb_frame__get_data(il_eusb_frame_t *frame)
 
 int il_eusb_frame__is_resp(const il_eusb_frame_t *frame)
 {
-	return (int)frame->buf[FR_PROT_FLD];
+	return il_eusb_frame__raw_is_resp(frame->buf);
 }
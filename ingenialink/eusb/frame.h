@@ -55,7 +55,7 @@
  * +===========+=========+=========+============+==========+==========+========+
  * | 1         | 2 (H-L) | 2 (H-L) | 0-8 (H..L) | 0-2 (H-L)| 4        |        |
  * +-----------+---------+---------+------------+----------+----------+--------+
- * | Subindex  | 0x0000  | 0-8     | Data       | IBM-16   | All 0x55 |        |
+ * | Subindex  | Offset  | 0-8     | Data       | IBM-16   | All 0x55 |        |
  * +-----------+---------+---------+------------+----------+----------+--------+
  */
 
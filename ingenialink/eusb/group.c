@@ -0,0 +1,363 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "group.h"
+
+#include <stdlib.h>
+
+#include "../mc.h"
+#include "../servo.h"
+
+#include "ingenialink/err.h"
+#include "ingenialink/registers.h"
+#include "ingenialink/base/servo.h"
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+/**
+ * New set-point edge completion callback.
+ *
+ * @param [in] ctx
+ *	Context (il_servo_group_sp_t *).
+ * @param [in] r
+ *	Result.
+ * @param [in] value
+ *	Unused.
+ */
+static void on_sp_fired(void *ctx, int r, double value)
+{
+	il_servo_group_sp_t *sp = ctx;
+	il_servo_group_t *grp = sp->grp;
+
+	(void)value;
+
+	(void)osal_clock_gettime(&sp->ack);
+
+	osal_mutex_lock(grp->lock);
+
+	sp->r = r;
+
+	grp->pending--;
+	if (grp->pending == 0)
+		osal_cond_signal(grp->done);
+
+	osal_mutex_unlock(grp->lock);
+}
+
+/**
+ * Compute the inter-axis skew of the last set-point dispatch.
+ *
+ * @param [in] grp
+ *	Group instance.
+ *
+ * @return
+ *	Skew (us).
+ */
+static double skew_compute(il_servo_group_t *grp)
+{
+	size_t i;
+	const osal_timespec_t *first = NULL, *last = NULL;
+
+	for (i = 0; i < grp->cnt; i++) {
+		const osal_timespec_t *ack = &grp->sps[i].ack;
+
+		if (!grp->sps[i].active)
+			continue;
+
+		if (!first || (ack->s < first->s) ||
+		    ((ack->s == first->s) && (ack->ns < first->ns)))
+			first = ack;
+
+		if (!last || (ack->s > last->s) ||
+		    ((ack->s == last->s) && (ack->ns > last->ns)))
+			last = ack;
+	}
+
+	if (!first)
+		return 0.;
+
+	return (double)(last->s - first->s) * 1000000. +
+	       (double)(last->ns - first->ns) / 1000.;
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+il_servo_group_t *il_servo_group_create(il_servo_t **servos, size_t cnt)
+{
+	il_servo_group_t *grp;
+	size_t i;
+
+	if (cnt == 0) {
+		ilerr__set("Empty servo group");
+		return NULL;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		if (il_net_prot_get(servos[i]->net) != IL_NET_PROT_EUSB) {
+			ilerr__set("Servo groups only support E-USB servos");
+			return NULL;
+		}
+	}
+
+	grp = calloc(1, sizeof(*grp));
+	if (!grp) {
+		ilerr__set("Servo group allocation failed");
+		return NULL;
+	}
+
+	grp->cnt = cnt;
+
+	grp->servos = calloc(cnt, sizeof(*grp->servos));
+	if (!grp->servos) {
+		ilerr__set("Servo group servos allocation failed");
+		goto cleanup_grp;
+	}
+
+	grp->batch = calloc(2 * cnt, sizeof(*grp->batch));
+	if (!grp->batch) {
+		ilerr__set("Servo group batch allocation failed");
+		goto cleanup_servos;
+	}
+
+	grp->sps = calloc(cnt, sizeof(*grp->sps));
+	if (!grp->sps) {
+		ilerr__set("Servo group set-points allocation failed");
+		goto cleanup_batch;
+	}
+
+	grp->dispatch = osal_mutex_create();
+	if (!grp->dispatch) {
+		ilerr__set("Servo group dispatch lock allocation failed");
+		goto cleanup_sps;
+	}
+
+	grp->lock = osal_mutex_create();
+	if (!grp->lock) {
+		ilerr__set("Servo group lock allocation failed");
+		goto cleanup_dispatch;
+	}
+
+	grp->done = osal_cond_create();
+	if (!grp->done) {
+		ilerr__set("Servo group condition allocation failed");
+		goto cleanup_lock;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		grp->servos[i] = servos[i];
+		il_servo__retain(grp->servos[i]);
+
+		grp->sps[i].grp = grp;
+	}
+
+	return grp;
+
+cleanup_lock:
+	osal_mutex_destroy(grp->lock);
+
+cleanup_dispatch:
+	osal_mutex_destroy(grp->dispatch);
+
+cleanup_sps:
+	free(grp->sps);
+
+cleanup_batch:
+	free(grp->batch);
+
+cleanup_servos:
+	free(grp->servos);
+
+cleanup_grp:
+	free(grp);
+
+	return NULL;
+}
+
+void il_servo_group_destroy(il_servo_group_t *grp)
+{
+	size_t i;
+
+	for (i = 0; i < grp->cnt; i++)
+		il_servo__release(grp->servos[i]);
+
+	osal_cond_destroy(grp->done);
+	osal_mutex_destroy(grp->lock);
+	osal_mutex_destroy(grp->dispatch);
+
+	free(grp->sps);
+	free(grp->batch);
+	free(grp->servos);
+	free(grp);
+}
+
+int il_servo_group_position_set(il_servo_group_t *grp, const double *pos,
+				int immediate, int relative, int sp_timeout)
+{
+	int r, timeout;
+	size_t i, n, active;
+	uint16_t cmd;
+
+	osal_mutex_lock(grp->dispatch);
+
+	/* stage targets (and clear new set-point on servos enabled in PP) */
+	for (i = 0, n = 0, active = 0; i < grp->cnt; i++) {
+		il_servo_t *servo = grp->servos[i];
+		il_servo_group_sp_t *sp = &grp->sps[i];
+		il_servo_batch_t *entry;
+		il_servo_state_t state;
+		int flags;
+
+		entry = &grp->batch[n++];
+		entry->servo = servo;
+		entry->reg = &IL_REG_POS_TGT;
+		entry->id = NULL;
+		entry->value = pos[i];
+		entry->confirm = 1;
+
+		il_servo_state_get(servo, &state, &flags);
+
+		sp->active = (state == IL_SERVO_STATE_ENABLED) &&
+			     (servo->mode == IL_SERVO_MODE_PP);
+		if (!sp->active)
+			continue;
+
+		entry = &grp->batch[n++];
+		entry->servo = servo;
+		entry->reg = &IL_REG_CTL_WORD;
+		entry->id = NULL;
+		entry->value = IL_MC_PDS_CMD_EO;
+		entry->confirm = 1;
+
+		active++;
+	}
+
+	r = il_servo_write_batch(grp->batch, n);
+	if (r < 0)
+		goto unlock;
+
+	grp->skew = 0.;
+
+	if (active == 0)
+		goto unlock;
+
+	/* wait set-point ack clear (all servos) */
+	timeout = sp_timeout;
+
+	for (i = 0; i < grp->cnt; i++) {
+		if (!grp->sps[i].active)
+			continue;
+
+		r = il_servo_base__sw_wait_value(grp->servos[i],
+						 IL_MC_PP_SW_SPACK, 0,
+						 &timeout);
+		if (r < 0)
+			goto unlock;
+	}
+
+	/* fire new set-point edges back to back (confirmed, so that the skew
+	 * is measured on edges known to be applied by each servo)
+	 */
+	cmd = IL_MC_PDS_CMD_EO | IL_MC_PP_CW_NEWSP;
+
+	if (immediate)
+		cmd |= IL_MC_PP_CW_IMMEDIATE;
+
+	if (relative)
+		cmd |= IL_MC_PP_CW_REL;
+
+	osal_mutex_lock(grp->lock);
+	grp->pending = active;
+	osal_mutex_unlock(grp->lock);
+
+	for (i = 0; i < grp->cnt; i++) {
+		il_servo_group_sp_t *sp = &grp->sps[i];
+		int r_;
+
+		if (!sp->active)
+			continue;
+
+		sp->r = 0;
+
+		r_ = il_servo_write_async(grp->servos[i], &IL_REG_CTL_WORD,
+					  NULL, cmd, 1, on_sp_fired, sp);
+		if (r_ < 0) {
+			osal_mutex_lock(grp->lock);
+			sp->r = r_;
+			grp->pending--;
+			osal_mutex_unlock(grp->lock);
+		}
+	}
+
+	/* wait until all edges are confirmed */
+	osal_mutex_lock(grp->lock);
+
+	while (grp->pending > 0)
+		(void)osal_cond_wait(grp->done, grp->lock, 0);
+
+	osal_mutex_unlock(grp->lock);
+
+	for (i = 0; i < grp->cnt; i++) {
+		if (grp->sps[i].active && (grp->sps[i].r < 0)) {
+			r = grp->sps[i].r;
+			goto unlock;
+		}
+	}
+
+	grp->skew = skew_compute(grp);
+
+	/* wait set-point ack (all servos) */
+	timeout = sp_timeout;
+
+	for (i = 0; i < grp->cnt; i++) {
+		if (!grp->sps[i].active)
+			continue;
+
+		r = il_servo_base__sw_wait_value(grp->servos[i],
+						 IL_MC_PP_SW_SPACK,
+						 IL_MC_PP_SW_SPACK, &timeout);
+		if (r < 0)
+			goto unlock;
+	}
+
+unlock:
+	osal_mutex_unlock(grp->dispatch);
+
+	return r;
+}
+
+double il_servo_group_skew_get(il_servo_group_t *grp)
+{
+	double skew;
+
+	osal_mutex_lock(grp->dispatch);
+	skew = grp->skew;
+	osal_mutex_unlock(grp->dispatch);
+
+	return skew;
+}
@@ -0,0 +1,67 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef EUSB_GROUP_H_
+#define EUSB_GROUP_H_
+
+#include "public/ingenialink/group.h"
+
+#include "osal/osal.h"
+
+/** Set-point dispatch state (per servo). */
+typedef struct {
+	/** Group. */
+	il_servo_group_t *grp;
+	/** Active flag (servo enabled in profile position mode). */
+	int active;
+	/** New set-point edge result. */
+	int r;
+	/** New set-point edge confirmation time. */
+	osal_timespec_t ack;
+} il_servo_group_sp_t;
+
+/** IngeniaLink servo group. */
+struct il_servo_group {
+	/** Servos. */
+	il_servo_t **servos;
+	/** Number of servos. */
+	size_t cnt;
+	/** Staging batch (target and control word per servo). */
+	il_servo_batch_t *batch;
+	/** Set-point dispatch state (one per servo). */
+	il_servo_group_sp_t *sps;
+	/** Dispatch lock (serializes set-point dispatches). */
+	osal_mutex_t *dispatch;
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** New set-point edges completed condition. */
+	osal_cond_t *done;
+	/** Number of new set-point edges in flight. */
+	size_t pending;
+	/** Last measured inter-axis skew (us). */
+	double skew;
+};
+
+#endif
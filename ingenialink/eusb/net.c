@@ -35,415 +35,1937 @@
  * Private
  ******************************************************************************/
 
+/** Set while asynchronous completion callbacks run on the calling thread. */
+static thread_local int in_cb;
+
+/**
+ * Initialize in-flight transfers table.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] window
+ *	Window depth (0 to use default).
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int xfers_init(il_eusb_net_t *this, int window)
+{
+	il_eusb_net_xfers_t *xfers = &this->xfers;
+	size_t i;
+
+	if (window <= 0)
+		xfers->depth = IL_NET_WINDOW_DEF;
+	else
+		xfers->depth = MIN((size_t)window, IL_NET_WINDOW_MAX);
+
+	xfers->cnt = 0;
+	xfers->seq = 0;
+	memset(xfers->fence, 0, sizeof(xfers->fence));
+
+	xfers->lock = osal_mutex_create();
+	if (!xfers->lock) {
+		ilerr__set("Network transfers lock allocation failed");
+		return IL_ENOMEM;
+	}
+
+	xfers->avail = osal_cond_create();
+	if (!xfers->avail) {
+		ilerr__set("Network transfers condition allocation failed");
+		goto cleanup_lock;
+	}
+
+	for (i = 0; i < xfers->depth; i++) {
+		xfers->xfers[i].used = 0;
+		xfers->xfers[i].complete = 1;
+
+		xfers->xfers[i].cond = osal_cond_create();
+		if (!xfers->xfers[i].cond) {
+			ilerr__set("Network transfer condition allocation failed");
+			goto cleanup_conds;
+		}
+	}
+
+	return 0;
+
+cleanup_conds:
+	while (i--)
+		osal_cond_destroy(xfers->xfers[i].cond);
+
+	osal_cond_destroy(xfers->avail);
+
+cleanup_lock:
+	osal_mutex_destroy(xfers->lock);
+
+	return IL_ENOMEM;
+}
+
+/**
+ * De-initialize in-flight transfers table.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ */
+static void xfers_deinit(il_eusb_net_t *this)
+{
+	il_eusb_net_xfers_t *xfers = &this->xfers;
+	size_t i;
+
+	for (i = 0; i < xfers->depth; i++)
+		osal_cond_destroy(xfers->xfers[i].cond);
+
+	osal_cond_destroy(xfers->avail);
+	osal_mutex_destroy(xfers->lock);
+}
+
+/**
+ * Release an in-flight transfer (non-threadsafe).
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] xfer
+ *	Transfer.
+ */
+static void xfer_release(il_eusb_net_t *this, il_eusb_net_xfer_t *xfer)
+{
+	xfer->used = 0;
+	xfer->complete = 1;
+	xfer->outstanding = 0;
+	xfer->orphan = 0;
+	xfer->fence = 0;
+
+	this->xfers.cnt--;
+	osal_cond_broadcast(this->xfers.avail);
+}
+
+/**
+ * Compute an expiration time.
+ *
+ * @param [out] deadline
+ *	Expiration time.
+ * @param [in] start
+ *	Start time.
+ * @param [in] timeout
+ *	Timeout (ms).
+ */
+static void deadline_set(osal_timespec_t *deadline,
+			 const osal_timespec_t *start, int timeout)
+{
+	*deadline = *start;
+	deadline->s += timeout / 1000;
+	deadline->ns += (timeout % 1000) * OSAL_CLOCK_NANOSPERMSEC;
+	if (deadline->ns >= OSAL_CLOCK_NANOSPERSEC) {
+		deadline->s++;
+		deadline->ns -= OSAL_CLOCK_NANOSPERSEC;
+	}
+}
+
+/**
+ * Put back an in-flight transfer once its owner is done (non-threadsafe).
+ *
+ * @note
+ *	If petitions are still unanswered (e.g. the transfer timed out), the
+ *	transfer is kept as an orphan, so that late responses are absorbed
+ *	instead of completing newer transfers to the same (node id, address).
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] xfer
+ *	Transfer.
+ */
+static void xfer_put(il_eusb_net_t *this, il_eusb_net_xfer_t *xfer)
+{
+	osal_timespec_t now;
+
+	if (xfer->outstanding == 0) {
+		xfer_release(this, xfer);
+		return;
+	}
+
+	(void)osal_clock_gettime(&now);
+
+	xfer->orphan = 1;
+	xfer->complete = 0;
+	xfer->cb = NULL;
+	deadline_set(&xfer->deadline, &now,
+		     this->net.timeout_rd * ORPHAN_TIMEOUTS);
+
+	this->xfers.fence[xfer->id] = 1;
+}
+
+/**
+ * Drop orphans of a node older than a completed transfer (non-threadsafe).
+ *
+ * @note
+ *	Drives answer in order, so their petitions were lost.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] xfer
+ *	Completed transfer.
+ */
+static void orphans_drop(il_eusb_net_t *this, il_eusb_net_xfer_t *xfer)
+{
+	size_t i;
+
+	for (i = 0; i < this->xfers.depth; i++) {
+		il_eusb_net_xfer_t *curr = &this->xfers.xfers[i];
+
+		if (curr->used && curr->orphan && (curr->id == xfer->id) &&
+		    ((int32_t)(curr->seq - xfer->seq) < 0))
+			xfer_release(this, curr);
+	}
+}
+
+/**
+ * Obtain the number of in-flight transfers usable by a priority class.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] prio
+ *	Priority class.
+ *
+ * @returns
+ *	Number of usable transfers.
+ */
+static size_t xfers_limit(il_eusb_net_t *this, il_net_prio_t prio)
+{
+	if ((prio == IL_NET_PRIO_BULK) && (this->xfers.depth > 1))
+		return this->xfers.depth - 1;
+
+	return this->xfers.depth;
+}
+
+/**
+ * Wait until the number of in-flight transfers drops below a limit.
+ *
+ * @note
+ *	Transfers lock and network must be held by the caller. The network is
+ *	released while waiting, since owners of in-flight transfers may need it
+ *	before releasing them.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] prio
+ *	Priority class (as acquired).
+ * @param [in] limit
+ *	Limit.
+ * @param [in] timeout
+ *	Timeout (ms).
+ *
+ * @returns
+ *	0 if the limit may have been reached, OSAL_ETIMEDOUT or other error
+ *	code otherwise.
+ */
+static int xfers_wait(il_eusb_net_t *this, il_net_prio_t prio, size_t limit,
+		      int timeout)
+{
+	il_eusb_net_xfers_t *xfers = &this->xfers;
+
+	int r = 0;
+
+	osal_mutex_unlock(xfers->lock);
+	il_net__tx_unlock(&this->net, prio);
+
+	osal_mutex_lock(xfers->lock);
+	if (xfers->cnt >= limit)
+		r = osal_cond_wait(xfers->avail, xfers->lock, timeout);
+	osal_mutex_unlock(xfers->lock);
+
+	il_net__tx_lock(&this->net, prio);
+	osal_mutex_lock(xfers->lock);
+
+	return r;
+}
+
+/**
+ * Send data.
+ *
+ * @note
+ *	Network must be acquired for transmission by the caller.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] buf
+ *	Data buffer.
+ * @param [in] sz
+ *	Data size.
+ * @param [in] frames
+ *	Number of frames contained in the data (statistics).
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int net_send(il_eusb_net_t *this, const void *buf, size_t sz,
+		    size_t frames)
+{
+	int32_t r;
+
+	/* virtual network: data is served by the virtual drive */
+	if (this->is_virtual) {
+		r = il_eusb_vdrive__write(this->vdrive, buf, sz);
+	} else if (this->reactor) {
+		r = il_reactor__write(this->src, buf, sz,
+				      this->sopts.timeouts.wr);
+	} else {
+		r = ser_write(this->ser, buf, sz, NULL);
+		if (r < 0)
+			r = ilerr__ser(r);
+	}
+
+	if (r < 0)
+		return r;
+
+	il_net__stats_add(&this->net, tx_frames, frames);
+	il_net__stats_add(&this->net, tx_bytes, sz);
+
+	return 0;
+}
+
+/**
+ * Take a free in-flight transfer (non-threadsafe).
+ *
+ * @note
+ *	A free transfer must be available.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] id
+ *	Expected node id (0 to match any).
+ * @param [in] address
+ *	Expected address.
+ * @param [in] offset
+ *	Expected segment offset.
+ *
+ * @returns
+ *	In-flight transfer.
+ */
+static il_eusb_net_xfer_t *xfer_take(il_eusb_net_t *this, uint8_t id,
+				     uint32_t address, uint16_t offset)
+{
+	il_eusb_net_xfers_t *xfers = &this->xfers;
+	il_eusb_net_xfer_t *xfer;
+	size_t i;
+
+	for (i = 0; i < xfers->depth; i++) {
+		if (!xfers->xfers[i].used)
+			break;
+	}
+
+	xfer = &xfers->xfers[i];
+
+	xfer->used = 1;
+	xfer->complete = 0;
+	xfer->id = id;
+	xfer->address = address;
+	xfer->offset = offset;
+	xfer->trunc = 0;
+	xfer->buf = NULL;
+	xfer->sz = 0;
+	xfer->seq = xfers->seq++;
+	xfer->cb = NULL;
+	xfer->ctx = NULL;
+	xfer->confirmed = 0;
+	xfer->scan = 0;
+	xfer->retry = 0;
+	xfer->outstanding = 1;
+	xfer->orphan = 0;
+	xfer->fence = 0;
+	(void)osal_clock_gettime(&xfer->start);
+
+	xfers->cnt++;
+
+	/* reactor: tick (expire transfers) only while in flight */
+	if (this->reactor)
+		il_reactor__arm(this->src);
+
+	return xfer;
+}
+
+/**
+ * Take a fence for the orphans of a node (non-threadsafe).
+ *
+ * @note
+ *	A free transfer must be available.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] id
+ *	Node id.
+ *
+ * @returns
+ *	Fence transfer.
+ */
+static il_eusb_net_xfer_t *fence_take(il_eusb_net_t *this, uint8_t id)
+{
+	il_eusb_net_xfer_t *xfer;
+
+	xfer = xfer_take(this, id, FENCE_ADDRESS, 0);
+
+	xfer->buf = xfer->data;
+	xfer->sz = sizeof(xfer->data);
+	xfer->trunc = 1;
+	xfer->fence = 1;
+	deadline_set(&xfer->deadline, &xfer->start,
+		     il_net__timeout_rd(&this->net, id));
+
+	this->xfers.fence[id] = 0;
+
+	return xfer;
+}
+
+/**
+ * Send a fence.
+ *
+ * @note
+ *	Network must be acquired for transmission by the caller.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] xfer
+ *	Fence transfer.
+ */
+static void fence_send(il_eusb_net_t *this, il_eusb_net_xfer_t *xfer)
+{
+	il_eusb_frame_t frame;
+
+	il_eusb_frame__init(&frame, xfer->id, FENCE_ADDRESS, NULL, 0);
+
+	if (net_send(this, frame.buf, frame.sz, 1) < 0) {
+		osal_mutex_lock(this->xfers.lock);
+		xfer_release(this, xfer);
+		osal_mutex_unlock(this->xfers.lock);
+	}
+}
+
+/**
+ * Acquire an in-flight transfer.
+ *
+ * @note
+ *	Network must be acquired for transmission by the caller, so that
+ *	transfers are sent in sequence order. One transfer is reserved for
+ *	control requests (if window allows). If the node has orphans, a fence
+ *	is sent first if window allows: fences count against the bulk share,
+ *	so they never take the reserved transfer.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] id
+ *	Expected node id (0 to match any).
+ * @param [in] address
+ *	Expected address.
+ * @param [in] offset
+ *	Expected segment offset.
+ * @param [out] buf
+ *	Data output buffer.
+ * @param [in] sz
+ *	Data buffer size.
+ * @param [in] cb
+ *	Completion callback (NULL for synchronous transfers).
+ * @param [in] ctx
+ *	Completion callback context.
+ * @param [in] prio
+ *	Priority class.
+ * @param [out] xfer
+ *	Where the in-flight transfer will be stored.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int xfer_acquire(il_eusb_net_t *this, uint8_t id, uint32_t address,
+			uint16_t offset, void *buf, size_t sz,
+			il_net_async_cb_t cb, void *ctx, il_net_prio_t prio,
+			il_eusb_net_xfer_t **xfer)
+{
+	il_eusb_net_xfers_t *xfers = &this->xfers;
+
+	int r = 0;
+	il_eusb_net_xfer_t *fence = NULL;
+
+	/* callbacks run on the reception context: replies cannot be awaited */
+	if (in_cb && !cb) {
+		ilerr__set("Synchronous transfer from a completion callback");
+		return IL_EBUSY;
+	}
+
+	osal_mutex_lock(xfers->lock);
+
+	/* wait until a transfer is available (never from callbacks) */
+	while (xfers->cnt >= xfers_limit(this, prio)) {
+		if (in_cb) {
+			ilerr__set("No transfers available");
+			r = IL_EBUSY;
+			goto unlock;
+		}
+
+		r = xfers_wait(this, prio, xfers_limit(this, prio),
+			       this->net.timeout_rd);
+		if (r == OSAL_ETIMEDOUT) {
+			ilerr__set("No transfers available (timed out)");
+			r = IL_ETIMEDOUT;
+			goto unlock;
+		} else if (r < 0) {
+			ilerr__set("Transfer acquisition failed");
+			r = IL_EFAIL;
+			goto unlock;
+		}
+	}
+
+	/* fence (bulk share) plus the requested transfer must fit */
+	if (xfers->fence[id] &&
+	    (xfers->cnt < xfers_limit(this, IL_NET_PRIO_BULK)) &&
+	    (xfers->cnt + 1 < xfers_limit(this, prio)))
+		fence = fence_take(this, id);
+
+	*xfer = xfer_take(this, id, address, offset);
+
+	(*xfer)->buf = buf;
+	(*xfer)->sz = sz;
+	(*xfer)->cb = cb;
+	(*xfer)->ctx = ctx;
+
+	/* asynchronous transfers: use own buffer, expire from listener */
+	if (cb) {
+		(*xfer)->buf = (*xfer)->data;
+		memset((*xfer)->data, 0, sizeof((*xfer)->data));
+
+		deadline_set(&(*xfer)->deadline, &(*xfer)->start,
+			     il_net__timeout_rd(&this->net, id));
+	}
+
+unlock:
+	osal_mutex_unlock(xfers->lock);
+
+	if (fence)
+		fence_send(this, fence);
+
+	return r;
+}
+
+/**
+ * Check if all in-flight transfers are in use.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] prio
+ *	Priority class.
+ *
+ * @returns
+ *	Non-zero if no transfers are available.
+ */
+static int xfers_full(il_eusb_net_t *this, il_net_prio_t prio)
+{
+	int full;
+
+	osal_mutex_lock(this->xfers.lock);
+	full = this->xfers.cnt >= xfers_limit(this, prio);
+	osal_mutex_unlock(this->xfers.lock);
+
+	return full;
+}
+
+/**
+ * Submit a read transfer.
+ *
+ * @note
+ *	Network must be acquired for transmission by the caller.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] id
+ *	Expected node id (0 to match any).
+ * @param [in] address
+ *	Expected address.
+ * @param [out] buf
+ *	Data output buffer.
+ * @param [in] sz
+ *	Data buffer size.
+ * @param [in] prio
+ *	Priority class.
+ * @param [out] xfer
+ *	Where the in-flight transfer will be stored.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int xfer_submit(il_eusb_net_t *this, uint8_t id, uint32_t address,
+		       void *buf, size_t sz, il_net_prio_t prio,
+		       il_eusb_net_xfer_t **xfer)
+{
+	int r;
+	il_eusb_frame_t frame;
+
+	r = xfer_acquire(this, id, address, 0, buf, sz, NULL, NULL, prio,
+			 xfer);
+	if (r < 0)
+		return r;
+
+	/* send read petition */
+	il_eusb_frame__init(&frame, id, address, NULL, 0);
+
+	r = net_send(this, frame.buf, frame.sz, 1);
+	if (r < 0) {
+		osal_mutex_lock(this->xfers.lock);
+		xfer_release(this, *xfer);
+		osal_mutex_unlock(this->xfers.lock);
+	}
+
+	return r;
+}
+
+/**
+ * Send a read petition again for an in-flight transfer.
+ *
+ * @note
+ *	Network must be acquired for transmission by the caller. Any of the
+ *	responses completes the transfer, so round trip is not measured.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] xfer
+ *	Transfer.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int xfer_resubmit(il_eusb_net_t *this, il_eusb_net_xfer_t *xfer)
+{
+	int r;
+	il_eusb_frame_t frame;
+
+	osal_mutex_lock(this->xfers.lock);
+	xfer->retry = 1;
+	xfer->outstanding++;
+	osal_mutex_unlock(this->xfers.lock);
+
+	il_eusb_frame__init(&frame, xfer->id, xfer->address, NULL, 0);
+
+	r = net_send(this, frame.buf, frame.sz, 1);
+	if (r < 0) {
+		osal_mutex_lock(this->xfers.lock);
+		xfer->outstanding--;
+		osal_mutex_unlock(this->xfers.lock);
+	}
+
+	return r;
+}
+
+/**
+ * Wait for a read transfer to complete (non-threadsafe).
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] xfer
+ *	Transfer.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int xfer_complete_wait(il_eusb_net_t *this, il_eusb_net_xfer_t *xfer)
+{
+	int r = 0;
+	int timeout;
+
+	timeout = il_net__timeout_rd(&this->net, xfer->id);
+
+	while (!xfer->complete) {
+		r = osal_cond_wait(xfer->cond, this->xfers.lock, timeout);
+		if (r == OSAL_ETIMEDOUT) {
+			ilerr__set("Reception timed out");
+			il_net__stats_add(&this->net, timeouts, 1);
+			il_net__timeout_backoff(&this->net, xfer->id);
+			r = IL_ETIMEDOUT;
+			break;
+		} else if (r < 0) {
+			ilerr__set("Reception failed");
+			r = IL_EFAIL;
+			break;
+		}
+	}
+
+	return r;
+}
+
+/**
+ * Wait for a read transfer to complete, putting it back afterwards.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] xfer
+ *	Transfer.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int xfer_wait(il_eusb_net_t *this, il_eusb_net_xfer_t *xfer)
+{
+	int r;
+
+	osal_mutex_lock(this->xfers.lock);
+
+	r = xfer_complete_wait(this, xfer);
+	xfer_put(this, xfer);
+
+	osal_mutex_unlock(this->xfers.lock);
+
+	return r;
+}
+
+/**
+ * Expire asynchronous transfers and orphans.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] abort
+ *	If set, all asynchronous transfers are expired (e.g. on disconnection).
+ */
+static void xfers_expire(il_eusb_net_t *this, int abort)
+{
+	il_eusb_net_xfers_t *xfers = &this->xfers;
+
+	size_t i, n = 0;
+	osal_timespec_t now;
+	struct {
+		il_net_async_cb_t cb;
+		void *ctx;
+		uint8_t id;
+	} expired[IL_NET_WINDOW_MAX];
+
+	(void)osal_clock_gettime(&now);
+
+	osal_mutex_lock(xfers->lock);
+
+	for (i = 0; i < xfers->depth; i++) {
+		il_eusb_net_xfer_t *xfer = &xfers->xfers[i];
+
+		if (!xfer->used || (!xfer->cb && !xfer->orphan && !xfer->fence))
+			continue;
+
+		if (!abort && ((now.s < xfer->deadline.s) ||
+			       ((now.s == xfer->deadline.s) &&
+				(now.ns < xfer->deadline.ns))))
+			continue;
+
+		if (xfer->orphan || xfer->fence) {
+			xfer_release(this, xfer);
+			continue;
+		}
+
+		expired[n].cb = xfer->cb;
+		expired[n].ctx = xfer->ctx;
+		expired[n].id = xfer->id;
+		n++;
+
+		if (abort)
+			xfer_release(this, xfer);
+		else
+			xfer_put(this, xfer);
+	}
+
+	osal_mutex_unlock(xfers->lock);
+
+	if (!abort) {
+		il_net__stats_add(&this->net, timeouts, n);
+
+		for (i = 0; i < n; i++)
+			il_net__timeout_backoff(&this->net, expired[i].id);
+	}
+
+	in_cb++;
+
+	for (i = 0; i < n; i++)
+		expired[i].cb(expired[i].ctx,
+			      abort ? IL_EDISCONN : IL_ETIMEDOUT, NULL, 0);
+
+	in_cb--;
+}
+
+/**
+ * Process asynchronous statusword messages.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] frame
+ *	IngeniaLink frame (complete, in the reception buffer).
+ */
+static void process_statusword(il_eusb_net_t *this, const uint8_t *frame)
+{
+	uint32_t address;
+
+	address = il_eusb_frame__raw_get_address(frame);
+
+	if (address == STATUSWORD_ADDRESS) {
+		uint8_t id;
+		uint16_t sw;
+
+		id = il_eusb_frame__raw_get_id(frame);
+		memcpy(&sw, il_eusb_frame__raw_get_data(frame), sizeof(sw));
+		sw = __swap_be_16(sw);
+
+		il_net__sw_notify(&this->net, id, sw);
+	}
+}
+
+/**
+ * Process asynchronous emergency messages.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] frame
+ *	IngeniaLink frame (complete, in the reception buffer).
+ */
+static void process_emcy(il_eusb_net_t *this, const uint8_t *frame)
+{
+	uint32_t address;
+
+	address = il_eusb_frame__raw_get_address(frame);
+
+	if (address == EMCY_ADDRESS) {
+		uint8_t id;
+		uint32_t code;
+
+		id = il_eusb_frame__raw_get_id(frame);
+		memcpy(&code, il_eusb_frame__raw_get_data(frame), sizeof(code));
+		code = __swap_be_32(code);
+
+		il_net__emcy_notify(&this->net, id, code);
+	}
+}
+
+/**
+ * Process synchronous messages.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] frame
+ *	IngeniaLink frame (complete, in the reception buffer).
+ */
+static void process_sync(il_eusb_net_t *this, const uint8_t *frame)
+{
+	il_eusb_net_xfers_t *xfers = &this->xfers;
+	il_eusb_net_xfer_t *xfer = NULL;
+	size_t i;
+	uint8_t id;
+	uint32_t address;
+	uint16_t offset;
+	size_t sz;
+
+	int r = 0;
+	il_net_async_cb_t cb = NULL;
+	void *ctx = NULL;
+	uint8_t data[IL_EUSB_FRAME_MAX_DATA_SZ];
+
+	id = il_eusb_frame__raw_get_id(frame);
+	address = il_eusb_frame__raw_get_address(frame);
+	offset = il_eusb_frame__raw_get_offset(frame);
+	sz = il_eusb_frame__raw_get_sz(frame);
+
+	osal_mutex_lock(xfers->lock);
+
+	/* look for the oldest matching in-flight transfer */
+	for (i = 0; i < xfers->depth; i++) {
+		il_eusb_net_xfer_t *curr = &xfers->xfers[i];
+
+		/* completed transfers may still expect responses (retries) */
+		if (!curr->used || (curr->complete && !curr->outstanding))
+			continue;
+
+		if (((curr->id == id) || (curr->id == 0)) &&
+		    (curr->address == address) && (curr->offset == offset) &&
+		    ((curr->sz >= sz) || curr->trunc)) {
+			if (!xfer || ((int32_t)(curr->seq - xfer->seq) < 0))
+				xfer = curr;
+		}
+	}
+
+	if (xfer && !xfer->scan && xfer->outstanding)
+		xfer->outstanding--;
+
+	if (xfer && (xfer->orphan || (xfer->complete && !xfer->scan))) {
+		/* late response: absorbed */
+		if (xfer->orphan && !xfer->outstanding)
+			xfer_release(this, xfer);
+	} else if (xfer && xfer->scan) {
+		/* scan: collect all node ids (data is the node id) */
+		if ((sz > 0) && (xfer->cnt < xfer->sz)) {
+			((uint8_t *)xfer->buf)[xfer->cnt] =
+				*(const uint8_t *)il_eusb_frame__raw_get_data(frame);
+			xfer->cnt++;
+		}
+
+		osal_cond_signal(xfer->cond);
+	} else if (xfer && xfer->fence) {
+		orphans_drop(this, xfer);
+		xfer_release(this, xfer);
+	} else if (xfer) {
+		if (!xfer->retry)
+			il_net__stats_rtt_add(&this->net, id, &xfer->start);
+
+		orphans_drop(this, xfer);
+
+		/* short responses are zero-extended */
+		sz = MIN(sz, xfer->sz);
+		memcpy(xfer->buf, il_eusb_frame__raw_get_data(frame), sz);
+		memset((uint8_t *)xfer->buf + sz, 0, xfer->sz - sz);
+
+		if (xfer->cb) {
+			/* asynchronous: detach and notify out of the lock */
+			cb = xfer->cb;
+			ctx = xfer->ctx;
+			sz = xfer->sz;
+			memcpy(data, xfer->data, sz);
+
+			if (xfer->confirmed &&
+			    (memcmp(data, xfer->expected, sz) != 0)) {
+				ilerr__set("Write failed (content mismatch)");
+				il_net__stats_add(&this->net, mismatches, 1);
+				r = IL_EIO;
+			}
+
+			xfer_put(this, xfer);
+		} else {
+			xfer->complete = 1;
+			osal_cond_signal(xfer->cond);
+		}
+	}
+
+	osal_mutex_unlock(xfers->lock);
+
+	if (cb) {
+		in_cb++;
+
+		if (r < 0)
+			cb(ctx, r, NULL, 0);
+		else
+			cb(ctx, 0, data, sz);
+
+		in_cb--;
+	}
+}
+
+/**
+ * Process reception buffer.
+ *
+ * @note
+ *	Complete frames are dispatched straight from the reception buffer.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] rbuf
+ *	Reception buffer.
+ * @param [in] cnt
+ *	Buffer contents size.
+ *
+ * @returns
+ *	Number of bytes consumed.
+ */
+static size_t process_rbuf(il_eusb_net_t *this, const uint8_t *rbuf,
+			   size_t cnt)
+{
+	size_t pos = 0;
+
+	for (;;) {
+		size_t start, sz;
+		const uint8_t *frame;
+
+		sz = il_eusb_frame__find(&rbuf[pos], cnt - pos, &start);
+		pos += start;
+
+		/* discarded data (garbage or corrupted frames) */
+		if (start > 0)
+			il_net__stats_add(&this->net, resyncs, 1);
+
+		if (sz == 0)
+			break;
+
+		il_net__stats_add(&this->net, rx_frames, 1);
+
+		frame = &rbuf[pos];
+		if (il_eusb_frame__raw_is_resp(frame)) {
+			process_statusword(this, frame);
+			process_emcy(this, frame);
+			process_sync(this, frame);
+		}
+
+		pos += sz;
+	}
+
+	return pos;
+}
+
+/**
+ * Append received bytes to the reception buffer and process it.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] added
+ *	Number of bytes added to the reception buffer.
+ */
+static void rbuf_added(il_eusb_net_t *this, size_t added)
+{
+	size_t used;
+
+	il_net__stats_add(&this->net, rx_bytes, added);
+
+	this->rbuf_cnt += added;
+
+	/* process buffer, keep unprocessed tail */
+	used = process_rbuf(this, this->rbuf, this->rbuf_cnt);
+	this->rbuf_cnt -= used;
+	memmove(this->rbuf, &this->rbuf[used], this->rbuf_cnt);
+}
+
+/**
+ * Listener thread.
+ *
+ * @param [in] args
+ *	E-USB Network (il_eusb_net_t *).
+ */
+int listener(void *args)
+{
+	il_eusb_net_t *this = args;
+
+	while (!this->stop) {
+		int r;
+		size_t added;
+
+		/* expire timed out asynchronous transfers */
+		xfers_expire(this, 0);
+
+		/* read more bytes */
+		r = ser_read(this->ser, &this->rbuf[this->rbuf_cnt],
+			     sizeof(this->rbuf) - this->rbuf_cnt, &added);
+		if (r == SER_EEMPTY) {
+			r = ser_read_wait(this->ser);
+			if (r == SER_ETIMEDOUT)
+				continue;
+			else if (r < 0)
+				goto err;
+		} else if ((r < 0) || ((r == 0) && (added == 0))) {
+			goto err;
+		} else {
+			rbuf_added(this, added);
+		}
+	}
+
+	ser_close(this->ser);
+	xfers_expire(this, 1);
+
+	return 0;
+
+err:
+	ser_close(this->ser);
+	il_net__state_set(&this->net, IL_NET_STATE_FAULTY);
+	xfers_expire(this, 1);
+
+	return IL_EFAIL;
+}
+
+/**
+ * Reactor data available callback.
+ *
+ * @param [in] ctx
+ *	Context (il_eusb_net_t *).
+ */
+static int on_reactor_read(void *ctx)
+{
+	il_eusb_net_t *this = ctx;
+
+	xfers_expire(this, 0);
+
+	for (;;) {
+		int r;
+		size_t added;
+
+		r = il_reactor__read(this->src, &this->rbuf[this->rbuf_cnt],
+				     sizeof(this->rbuf) - this->rbuf_cnt,
+				     &added);
+		if (r < 0) {
+			il_net__state_set(&this->net, IL_NET_STATE_FAULTY);
+			xfers_expire(this, 1);
+			return r;
+		}
+
+		if (added == 0)
+			break;
+
+		rbuf_added(this, added);
+	}
+
+	return 0;
+}
+
+/**
+ * Reactor periodic tick callback.
+ *
+ * @param [in] ctx
+ *	Context (il_eusb_net_t *).
+ *
+ * @returns
+ *	Non-zero while transfers are in flight.
+ */
+static int on_reactor_tick(void *ctx)
+{
+	il_eusb_net_t *this = ctx;
+
+	int armed;
+
+	/* expire timed out asynchronous transfers */
+	xfers_expire(this, 0);
+
+	osal_mutex_lock(this->xfers.lock);
+	armed = this->xfers.cnt > 0;
+	osal_mutex_unlock(this->xfers.lock);
+
+	return armed;
+}
+
+/**
+ * Virtual drive transmission callback.
+ *
+ * @param [in] ctx
+ *	Context (il_eusb_net_t *).
+ * @param [in] buf
+ *	Frame buffer.
+ * @param [in] sz
+ *	Frame size.
+ */
+static void on_vdrive_tx(void *ctx, const uint8_t *buf, size_t sz)
+{
+	il_eusb_net_t *this = ctx;
+
+	il_net__stats_add(&this->net, rx_bytes, sz);
+
+	xfers_expire(this, 0);
+	(void)process_rbuf(this, buf, sz);
+}
+
 /**
- * Process asynchronous statusword messages.
+ * Open the port.
+ *
+ * @note
+ *	When using the reactor, the port is attached to it (reception starts
+ *	right away) and its channel is also used for transmission.
  *
  * @param [in] this
  *	E-USB Network.
- * @param [in] frame
- *	IngeniaLink frame.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
  */
-static void process_statusword(il_eusb_net_t *this, il_eusb_frame_t *frame)
+static int port_open(il_eusb_net_t *this)
 {
-	uint32_t address;
+	int32_t r;
 
-	address = il_eusb_frame__get_address(frame);
+	this->rbuf_cnt = 0;
 
-	if (address == STATUSWORD_ADDRESS) {
-		il_net_sw_subscriber_lst_t *subs;
-		int i;
-		uint8_t id;
-		uint16_t sw;
+	if (this->reactor) {
+		this->src = il_reactor__attach(this->reactor, this->sopts.port,
+					       this->sopts.baudrate,
+					       on_reactor_read,
+					       on_reactor_tick, this);
+		if (!this->src)
+			return IL_EFAIL;
 
-		subs = &this->net.sw_subs;
+		return 0;
+	}
 
-		id = il_eusb_frame__get_id(frame);
-		sw = __swap_be_16(*(uint16_t *)il_eusb_frame__get_data(frame));
+	r = ser_open(this->ser, &this->sopts);
+	if (r < 0) {
+		ilerr__set("Serial port open failed (%s)", sererr_last());
+		return IL_EFAIL;
+	}
 
-		osal_mutex_lock(subs->lock);
+	return 0;
+}
 
-		for (i = 0; i < subs->sz; i++) {
-			if (subs->subs[i].id == id && subs->subs[i].cb) {
-				void *ctx;
+/**
+ * Close the port.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ */
+static void port_close(il_eusb_net_t *this)
+{
+	if (this->reactor)
+		il_reactor__detach(this->src);
+	else
+		ser_close(this->ser);
+}
 
-				ctx = subs->subs[i].ctx;
-				subs->subs[i].cb(ctx, sw);
+/**
+ * Start reception (listener thread, the reactor is started on port open).
+ *
+ * @param [in] this
+ *	E-USB Network.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int listener_start(il_eusb_net_t *this)
+{
+	if (this->reactor)
+		return 0;
 
-				break;
-			}
-		}
+	this->stop = 0;
 
-		osal_mutex_unlock(subs->lock);
+	this->listener = osal_thread_create(listener, this);
+	if (!this->listener) {
+		ilerr__set("Listener thread creation failed");
+		return IL_EFAIL;
 	}
+
+	return 0;
 }
 
 /**
- * Process asynchronous emergency messages.
+ * Stop reception (listener thread or reactor), and close the port.
  *
  * @param [in] this
  *	E-USB Network.
- * @param [in] frame
- *	IngeniaLink frame.
  */
-static void process_emcy(il_eusb_net_t *this, il_eusb_frame_t *frame)
+static void listener_stop(il_eusb_net_t *this)
 {
-	uint32_t address;
+	if (this->reactor) {
+		port_close(this);
+		xfers_expire(this, 1);
+		return;
+	}
 
-	address = il_eusb_frame__get_address(frame);
+	this->stop = 1;
+	osal_thread_join(this->listener, NULL);
+}
 
-	if (address == EMCY_ADDRESS) {
-		il_net_emcy_subscriber_lst_t *subs;
-		int i;
-		uint8_t id;
-		uint32_t code;
+/**
+ * Destroy network.
+ *
+ * @param [in] ctx
+ *	Context (il_net_t *).
+ */
+static void enet_destroy(void *ctx)
+{
+	il_eusb_net_t *this = ctx;
+
+	if (this->is_virtual) {
+		il_eusb_vdrive__destroy(this->vdrive);
+		xfers_expire(this, 1);
+	} else {
+		if (il_net_state_get(&this->net) != IL_NET_STATE_DISCONNECTED)
+			listener_stop(this);
+
+		ser_destroy(this->ser);
+
+		if (this->reactor_own)
+			il_reactor_destroy(this->reactor_own);
+	}
+
+	xfers_deinit(this);
+
+	il_net_base__deinit(&this->net);
+
+	free(this);
+}
+
+/**
+ * Read.
+ *
+ * @note
+ *	Timed out reads are retried as configured, on the same transfer, so
+ *	that the response to any attempt completes it. Round trips of retried
+ *	reads are not measured, as the response may belong to any attempt.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] id
+ *	Expected node id (0 to match any).
+ * @param [in] address
+ *	Expected address.
+ * @param [out] buf
+ *	Data output buffer.
+ * @param [in] sz
+ *	Data buffer size.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int net_read(il_eusb_net_t *this, uint8_t id, uint32_t address,
+		    void *buf, size_t sz, il_net_prio_t prio)
+{
+	int r, retry;
+	il_eusb_net_xfer_t *xfer;
+
+	il_net__tx_lock(&this->net, prio);
+	r = xfer_submit(this, id, address, buf, sz, prio, &xfer);
+	il_net__tx_unlock(&this->net, prio);
+
+	if (r < 0)
+		return r;
+
+	osal_mutex_lock(this->xfers.lock);
+
+	/* retry (bounded) if timed out, on the same transfer */
+	for (retry = 0;; retry++) {
+		r = xfer_complete_wait(this, xfer);
+		if ((r != IL_ETIMEDOUT) || (retry == this->net.retries))
+			break;
+
+		osal_mutex_unlock(this->xfers.lock);
+
+		il_net__tx_lock(&this->net, prio);
+		r = xfer_resubmit(this, xfer);
+		il_net__tx_unlock(&this->net, prio);
+
+		osal_mutex_lock(this->xfers.lock);
+
+		if (r < 0)
+			break;
+	}
+
+	xfer_put(this, xfer);
+
+	osal_mutex_unlock(this->xfers.lock);
+
+	return r;
+}
+
+/*******************************************************************************
+ * Implementation: Internal
+ ******************************************************************************/
+
+static void il_eusb_net__retain(il_net_t *net)
+{
+	il_eusb_net_t *this = to_eusb_net(net);
+
+	il_utils__refcnt_retain(this->refcnt);
+}
+
+static void il_eusb_net__release(il_net_t *net)
+{
+	il_eusb_net_t *this = to_eusb_net(net);
+
+	il_utils__refcnt_release(this->refcnt);
+}
+
+static int il_eusb_net__read(il_net_t *net, uint16_t id, uint32_t address,
+			     void *buf, size_t sz, il_net_prio_t prio)
+{
+	il_eusb_net_t *this = to_eusb_net(net);
+
+	if (il_net_state_get(&this->net) != IL_NET_STATE_CONNECTED) {
+		ilerr__set("Network is not connected");
+		return IL_ESTATE;
+	}
+
+	return net_read(this, (uint8_t)id, address, buf, sz, prio);
+}
+
+static int il_eusb_net__write(il_net_t *net, uint16_t id, uint32_t address,
+			      const void *buf, size_t sz, int confirmed,
+			      il_net_prio_t prio)
+{
+	il_eusb_net_t *this = to_eusb_net(net);
+
+	int r;
+	il_eusb_frame_t frame;
+	il_eusb_net_xfer_t *xfer;
+	uint8_t buf_[IL_EUSB_FRAME_MAX_DATA_SZ];
+
+	if (sz > sizeof(buf_)) {
+		ilerr__set("Data size is too large");
+		return IL_EINVAL;
+	}
+
+	if (il_net_state_get(&this->net) != IL_NET_STATE_CONNECTED) {
+		ilerr__set("Network is not connected");
+		return IL_ESTATE;
+	}
+
+	il_net__tx_lock(&this->net, prio);
+
+	/* write */
+	il_eusb_frame__init(&frame, (uint8_t)id, address, buf, sz);
+
+	r = net_send(this, frame.buf, frame.sz, 1);
+	if (r < 0)
+		goto unlock;
+
+	/* read back if confirmed (petition queued right after the write) */
+	if (confirmed)
+		r = xfer_submit(this, (uint8_t)id, address, buf_, sz, prio,
+				&xfer);
+
+unlock:
+	il_net__tx_unlock(&this->net, prio);
+
+	if (confirmed && (r == 0)) {
+		r = xfer_wait(this, xfer);
+
+		if ((r == 0) && (memcmp(buf, buf_, sz) != 0)) {
+			ilerr__set("Write failed (content mismatch)");
+			il_net__stats_add(&this->net, mismatches, 1);
+			r = IL_EIO;
+		}
+	}
+
+	return r;
+}
+
+static int il_eusb_net__read_async(il_net_t *net, uint16_t id,
+				   uint32_t address, size_t sz,
+				   il_net_async_cb_t cb, void *ctx,
+				   il_net_prio_t prio)
+{
+	il_eusb_net_t *this = to_eusb_net(net);
+
+	int r;
+	il_eusb_net_xfer_t *xfer;
+	il_eusb_frame_t frame;
+
+	if (sz > IL_EUSB_FRAME_MAX_DATA_SZ) {
+		ilerr__set("Data size is too large");
+		return IL_EINVAL;
+	}
+
+	if (il_net_state_get(&this->net) != IL_NET_STATE_CONNECTED) {
+		ilerr__set("Network is not connected");
+		return IL_ESTATE;
+	}
+
+	il_net__tx_lock(&this->net, prio);
 
-		subs = &this->net.emcy_subs;
+	r = xfer_acquire(this, (uint8_t)id, address, 0, NULL, sz, cb, ctx,
+			 prio, &xfer);
+	if (r < 0)
+		goto unlock;
+
+	il_eusb_frame__init(&frame, (uint8_t)id, address, NULL, 0);
+
+	r = net_send(this, frame.buf, frame.sz, 1);
+	if (r < 0) {
+		osal_mutex_lock(this->xfers.lock);
+		xfer_release(this, xfer);
+		osal_mutex_unlock(this->xfers.lock);
+	}
+
+unlock:
+	il_net__tx_unlock(&this->net, prio);
+
+	return r;
+}
+
+static int il_eusb_net__write_async(il_net_t *net, uint16_t id,
+				    uint32_t address, const void *buf,
+				    size_t sz, int confirmed,
+				    il_net_async_cb_t cb, void *ctx,
+				    il_net_prio_t prio)
+{
+	il_eusb_net_t *this = to_eusb_net(net);
+
+	int r;
+	il_eusb_net_xfer_t *xfer = NULL;
+	il_eusb_frame_t frame;
+
+	if (sz > IL_EUSB_FRAME_MAX_DATA_SZ) {
+		ilerr__set("Data size is too large");
+		return IL_EINVAL;
+	}
+
+	if (il_net_state_get(&this->net) != IL_NET_STATE_CONNECTED) {
+		ilerr__set("Network is not connected");
+		return IL_ESTATE;
+	}
+
+	il_net__tx_lock(&this->net, prio);
+
+	/* confirmed: register the read back before writing anything */
+	if (confirmed) {
+		r = xfer_acquire(this, (uint8_t)id, address, 0, NULL, sz, cb,
+				 ctx, prio, &xfer);
+		if (r < 0)
+			goto unlock;
+
+		osal_mutex_lock(this->xfers.lock);
+		memcpy(xfer->expected, buf, sz);
+		xfer->confirmed = 1;
+		osal_mutex_unlock(this->xfers.lock);
+	}
+
+	il_eusb_frame__init(&frame, (uint8_t)id, address, buf, sz);
+
+	r = net_send(this, frame.buf, frame.sz, 1);
+	if ((r == 0) && xfer) {
+		il_eusb_frame__init(&frame, (uint8_t)id, address, NULL, 0);
+		r = net_send(this, frame.buf, frame.sz, 1);
+	}
+
+	if (r < 0) {
+		if (xfer) {
+			osal_mutex_lock(this->xfers.lock);
+			xfer_release(this, xfer);
+			osal_mutex_unlock(this->xfers.lock);
+		}
+	}
+
+unlock:
+	il_net__tx_unlock(&this->net, prio);
+
+	/* unconfirmed writes complete once sent */
+	if ((r == 0) && !confirmed)
+		cb(ctx, 0, NULL, 0);
+
+	return r;
+}
+
+/**
+ * Flush batch transmission buffer (non-threadsafe).
+ *
+ * @note
+ *	If transmission fails, all transfers in the flushed range are marked as
+ *	failed and their in-flight transfers released.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] tx
+ *	Transmission buffer.
+ * @param [in, out] tx_sz
+ *	Transmission buffer contents size.
+ * @param [in, out] xfers
+ *	Batch transfers.
+ * @param [in, out] pending
+ *	In-flight transfers of the batch.
+ * @param [in] start
+ *	First transfer in the buffer.
+ * @param [in] end
+ *	Last transfer in the buffer (not included).
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int batch_flush(il_eusb_net_t *this, const uint8_t *tx, size_t *tx_sz,
+		       il_net_xfer_t *xfers, il_eusb_net_xfer_t **pending,
+		       size_t start, size_t end)
+{
+	int r;
+	size_t i, frames = 0;
+
+	if (*tx_sz == 0)
+		return 0;
 
-		id = il_eusb_frame__get_id(frame);
-		code = __swap_be_32(
-			*(uint32_t *)il_eusb_frame__get_data(frame));
+	/* transfers that failed to encode are not in the buffer, confirmed
+	 * writes are followed by their read back
+	 */
+	for (i = start; i < end; i++) {
+		if (xfers[i].r == 0)
+			frames += (xfers[i].write && xfers[i].confirmed) ? 2 : 1;
+	}
 
-		osal_mutex_lock(subs->lock);
+	r = net_send(this, tx, *tx_sz, frames);
+	*tx_sz = 0;
+	if (r < 0) {
 
-		for (i = 0; i < subs->sz; i++) {
-			if (subs->subs[i].id == id && subs->subs[i].cb) {
-				void *ctx;
+		osal_mutex_lock(this->xfers.lock);
 
-				ctx = subs->subs[i].ctx;
-				subs->subs[i].cb(ctx, code);
+		for (i = start; i < end; i++) {
+			xfers[i].r = r;
 
-				break;
+			if (pending[i]) {
+				xfer_release(this, pending[i]);
+				pending[i] = NULL;
 			}
 		}
 
-		osal_mutex_unlock(subs->lock);
+		osal_mutex_unlock(this->xfers.lock);
 	}
+
+	return r;
 }
 
 /**
- * Process synchronous messages.
+ * Collect the response of a batch transfer (non-threadsafe).
+ *
+ * @note
+ *	Confirmed writes are verified against their read back value.
  *
  * @param [in] this
  *	E-USB Network.
- * @param [in] frame
- *	IngeniaLink frame.
+ * @param [in, out] xfers
+ *	Batch transfers.
+ * @param [in, out] pending
+ *	In-flight transfers of the batch.
+ * @param [in] rb
+ *	Read back buffers (confirmed writes).
+ * @param [in] i
+ *	Transfer.
  */
-static void process_sync(il_eusb_net_t *this, il_eusb_frame_t *frame)
+static void batch_collect(il_eusb_net_t *this, il_net_xfer_t *xfers,
+			  il_eusb_net_xfer_t **pending,
+			  uint8_t (*rb)[IL_EUSB_FRAME_MAX_DATA_SZ], size_t i)
 {
-	il_eusb_net_sync_t *sync = &this->sync;
+	if (!pending[i])
+		return;
 
-	osal_mutex_lock(sync->lock);
+	xfers[i].r = xfer_wait(this, pending[i]);
+	pending[i] = NULL;
 
-	if (!sync->complete) {
-		uint8_t id = il_eusb_frame__get_id(frame);
-		uint32_t address = il_eusb_frame__get_address(frame);
-		size_t sz = il_eusb_frame__get_sz(frame);
+	if (xfers[i].write && (xfers[i].r == 0) &&
+	    (memcmp(xfers[i].buf, rb[i], xfers[i].sz) != 0)) {
+		ilerr__set("Write failed (content mismatch)");
+		il_net__stats_add(&this->net, mismatches, 1);
+		xfers[i].r = IL_EIO;
+	}
+}
 
-		if (((sync->id == id) || (sync->id == 0)) &&
-		    (sync->address == address) && (sync->sz >= sz)) {
-			void *data = il_eusb_frame__get_data(frame);
+/**
+ * Report the progress of a batch transfer.
+ *
+ * @note
+ *	Transfers are reported in order, once transmitted and, if a reply is
+ *	expected, collected.
+ *
+ * @param [in] xfers
+ *	Batch transfers.
+ * @param [in] pending
+ *	In-flight transfers of the batch.
+ * @param [in] flushed
+ *	Number of transmitted transfers.
+ * @param [in, out] done
+ *	Number of reported transfers.
+ * @param [in, out] done_sz
+ *	Number of reported bytes.
+ * @param [in] total
+ *	Total number of bytes.
+ * @param [in] cb
+ *	Progress callback (optional).
+ * @param [in] ctx
+ *	Progress callback context.
+ */
+static void batch_progress(const il_net_xfer_t *xfers,
+			   il_eusb_net_xfer_t *const *pending, size_t flushed,
+			   size_t *done, size_t *done_sz, size_t total,
+			   il_net_progress_cb_t cb, void *ctx)
+{
+	size_t done_ = *done;
 
-			memcpy(sync->buf, data, sz);
+	if (!cb)
+		return;
 
-			sync->complete = 1;
-			osal_cond_signal(sync->cond);
-		}
+	while ((*done < flushed) && !pending[*done]) {
+		*done_sz += xfers[*done].sz;
+		(*done)++;
 	}
 
-	osal_mutex_unlock(sync->lock);
+	if (*done != done_)
+		cb(ctx, *done_sz, total);
 }
 
 /**
- * Process reception buffer.
+ * Perform a batch of transfers.
  *
  * @param [in] this
  *	E-USB Network.
- * @param [in] rbuf
- *	Reception buffer.
- * @param [in, out] cnt
- *	Buffer contents size.
- * @param [in, out] frame
- *	IngeniaLink frame.
+ * @param [in, out] xfers
+ *	Transfers.
+ * @param [in] offsets
+ *	Segment offset of each transfer (optional, 0 if not given).
+ * @param [in] cnt
+ *	Number of transfers.
+ * @param [in] cb
+ *	Progress callback (optional).
+ * @param [in] ctx
+ *	Progress callback context.
+ * @param [in] prio
+ *	Priority class.
+ *
+ * @returns
+ *	0 if all transfers succeeded, first error code otherwise.
  */
-static void process_rbuf(il_eusb_net_t *this, uint8_t *rbuf, size_t *cnt,
-			 il_eusb_frame_t *frame)
+static int batch_transfer(il_eusb_net_t *this, il_net_xfer_t *xfers,
+			  const uint16_t *offsets, size_t cnt,
+			  il_net_progress_cb_t cb, void *ctx,
+			  il_net_prio_t prio)
 {
-	size_t i;
+	int r = 0;
+	size_t i, start = 0, oldest = 0, done = 0, done_sz = 0, total = 0;
+	il_eusb_net_xfer_t **pending;
+	uint8_t (*rb)[IL_EUSB_FRAME_MAX_DATA_SZ] = NULL;
+	uint8_t tx[IL_NET_WINDOW_MAX * IL_EUSB_FRAME_MAX_SZ];
+	size_t tx_sz = 0;
+	int confirmed = 0;
 
-	for (i = 0; *cnt; i++) {
-		int r;
+	if (il_net_state_get(&this->net) != IL_NET_STATE_CONNECTED) {
+		ilerr__set("Network is not connected");
+		return IL_ESTATE;
+	}
 
-		(*cnt)--;
+	for (i = 0; i < cnt; i++) {
+		if (xfers[i].write)
+			confirmed |= xfers[i].confirmed;
 
-		/* push to the frame (and update its state) */
-		r = il_eusb_frame__push(frame, rbuf[i]);
-		if (r < 0) {
-			/* likely garbage, reset keeping current */
-			il_eusb_frame__reset(frame);
-			(void)il_eusb_frame__push(frame, rbuf[i]);
+		total += xfers[i].sz;
+	}
 
-			continue;
+	pending = calloc(cnt, sizeof(*pending));
+	if (!pending) {
+		ilerr__set("Batch allocation failed");
+		return IL_ENOMEM;
+	}
+
+	if (confirmed) {
+		rb = calloc(cnt, sizeof(*rb));
+		if (!rb) {
+			free(pending);
+			ilerr__set("Batch allocation failed");
+			return IL_ENOMEM;
 		}
+	}
 
-		/* validate */
-		if (frame->state == IL_EUSB_FRAME_STATE_COMPLETE) {
-			if (il_eusb_frame__is_resp(frame)) {
-				process_statusword(this, frame);
-				process_emcy(this, frame);
-				process_sync(this, frame);
+	/* encode all frames back to back, flushing when the buffer is full,
+	 * when the window is exhausted (pending replies depend on it) or when
+	 * control requests are waiting (frame boundary)
+	 */
+	il_net__tx_lock(&this->net, prio);
+
+	for (i = 0; i < cnt; i++) {
+		il_eusb_frame_t frame, rb_frame;
+		int reply, rb_needed;
+		size_t frames_sz;
+		uint16_t offset = offsets ? offsets[i] : 0;
+
+		xfers[i].r = 0;
+
+		/* reads and confirmed writes (read back) expect a reply */
+		rb_needed = xfers[i].write && xfers[i].confirmed;
+		reply = !xfers[i].write || rb_needed;
+
+		if (xfers[i].write) {
+			r = il_eusb_frame__init_seg(&frame,
+						    (uint8_t)xfers[i].id,
+						    xfers[i].address, offset,
+						    xfers[i].buf, xfers[i].sz);
+			if ((r == 0) && rb_needed) {
+				if (xfers[i].sz > sizeof(rb[i])) {
+					ilerr__set("Data size is too large");
+					r = IL_EINVAL;
+				} else {
+					r = il_eusb_frame__init_seg(
+						&rb_frame,
+						(uint8_t)xfers[i].id,
+						xfers[i].address, offset,
+						NULL, 0);
+				}
 			}
+		} else {
+			r = il_eusb_frame__init_seg(&frame,
+						    (uint8_t)xfers[i].id,
+						    xfers[i].address, offset,
+						    NULL, 0);
+		}
 
-			il_eusb_frame__reset(frame);
+		if (r < 0) {
+			xfers[i].r = r;
+			continue;
 		}
-	}
-}
 
-/**
- * Listener thread.
- *
- * @param [in] args
- *	E-USB Network (il_eusb_net_t *).
- */
-int listener(void *args)
-{
-	il_eusb_net_t *this = args;
+		frames_sz = frame.sz + (rb_needed ? rb_frame.sz : 0);
 
-	il_eusb_frame_t frame = IL_EUSB_FRAME_INIT_DEF;
+		if ((tx_sz + frames_sz > sizeof(tx)) ||
+		    (reply && xfers_full(this, prio)) ||
+		    ((tx_sz > 0) && il_net__tx_contended(&this->net, prio))) {
+			(void)batch_flush(this, tx, &tx_sz, xfers, pending,
+					  start, i);
+			start = i;
 
-	uint8_t rbuf[IL_EUSB_FRAME_MAX_SZ];
-	size_t rbuf_cnt = 0;
+			batch_progress(xfers, pending, start, &done, &done_sz,
+				       total, cb, ctx);
 
-	while (!this->stop) {
-		int r;
-		size_t rbuf_free, rbuf_added;
+			/* frame boundary: let pending control requests go */
+			il_net__tx_yield(&this->net, prio);
+		}
 
-		/* process current buffer content */
-		process_rbuf(this, rbuf, &rbuf_cnt, &frame);
+		/* window exhausted: collect our oldest response (buffer is
+		 * empty, so the network is released meanwhile)
+		 */
+		if (reply && (oldest < i) && xfers_full(this, prio)) {
+			il_net__tx_unlock(&this->net, prio);
 
-		/* read more bytes */
-		rbuf_free = sizeof(rbuf) - rbuf_cnt;
+			while ((oldest < i) && xfers_full(this, prio)) {
+				batch_collect(this, xfers, pending, rb, oldest);
+				oldest++;
+			}
 
-		r = ser_read(this->ser, &rbuf[rbuf_cnt], rbuf_free,
-			     &rbuf_added);
-		if (r == SER_EEMPTY) {
-			r = ser_read_wait(this->ser);
-			if (r == SER_ETIMEDOUT)
-				continue;
-			else if (r < 0)
-				goto err;
-		} else if ((r < 0) || ((r == 0) && (rbuf_added == 0))) {
-			goto err;
-		} else {
-			rbuf_cnt += rbuf_added;
+			batch_progress(xfers, pending, start, &done, &done_sz,
+				       total, cb, ctx);
+
+			il_net__tx_lock(&this->net, prio);
 		}
-	}
 
-	ser_close(this->ser);
+		if (reply) {
+			r = xfer_acquire(this, (uint8_t)xfers[i].id,
+					 xfers[i].address, offset,
+					 rb_needed ? rb[i] : xfers[i].buf,
+					 xfers[i].sz, NULL, NULL, prio,
+					 &pending[i]);
+			if (r < 0) {
+				xfers[i].r = r;
+				continue;
+			}
 
-	return 0;
+			/* segments may be read partially */
+			if (offsets) {
+				osal_mutex_lock(this->xfers.lock);
+				pending[i]->trunc = 1;
+				osal_mutex_unlock(this->xfers.lock);
+			}
+		}
 
-err:
-	ser_close(this->ser);
-	il_net__state_set(&this->net, IL_NET_STATE_FAULTY);
+		memcpy(&tx[tx_sz], frame.buf, frame.sz);
+		tx_sz += frame.sz;
 
-	return IL_EFAIL;
-}
+		/* confirmed: read back right after the write */
+		if (rb_needed) {
+			memcpy(&tx[tx_sz], rb_frame.buf, rb_frame.sz);
+			tx_sz += rb_frame.sz;
+		}
+	}
 
+	(void)batch_flush(this, tx, &tx_sz, xfers, pending, start, cnt);
 
-/**
- * Destroy network.
- *
- * @param [in] ctx
- *	Context (il_net_t *).
- */
-static void enet_destroy(void *ctx)
-{
-	il_eusb_net_t *this = ctx;
+	il_net__tx_unlock(&this->net, prio);
 
-	if (!this->is_virtual) {
-		if (il_net_state_get(&this->net) != IL_NET_STATE_DISCONNECTED) {
-			this->stop = 1;
-			osal_thread_join(this->listener, NULL);
-		}
+	/* collect remaining responses */
+	batch_progress(xfers, pending, cnt, &done, &done_sz, total, cb, ctx);
 
-		osal_cond_destroy(this->sync.cond);
-		osal_mutex_destroy(this->sync.lock);
+	for (i = oldest; i < cnt; i++) {
+		batch_collect(this, xfers, pending, rb, i);
+		batch_progress(xfers, pending, cnt, &done, &done_sz, total, cb,
+			       ctx);
+	}
 
-		ser_destroy(this->ser);
+	free(rb);
+	free(pending);
+
+	/* report first error (if any) */
+	for (i = 0; i < cnt; i++) {
+		if (xfers[i].r < 0)
+			return xfers[i].r;
 	}
 
-	il_net_base__deinit(&this->net);
+	return 0;
+}
 
-	free(this);
+static int il_eusb_net__transfer_batch(il_net_t *net, il_net_xfer_t *xfers,
+				       size_t cnt, il_net_prio_t prio)
+{
+	il_eusb_net_t *this = to_eusb_net(net);
+
+	return batch_transfer(this, xfers, NULL, cnt, NULL, NULL, prio);
 }
 
 /**
- * Read (non-threadsafe).
+ * Perform a segmented transfer.
+ *
+ * @note
+ *	The buffer is split in frame-sized segments, addressed by offset,
+ *	which are pipelined as a batch.
  *
  * @param [in] this
  *	E-USB Network.
  * @param [in] id
- *	Expected node id (0 to match any).
+ *	Node id.
  * @param [in] address
- *	Expected address.
- * @param [out] buf
- *	Data output buffer.
+ *	Address.
+ * @param [in, out] buf
+ *	Data buffer (output on reads, input on writes).
  * @param [in] sz
  *	Data buffer size.
+ * @param [in] write
+ *	Write flag.
+ * @param [in] confirmed
+ *	Confirm write (read back).
+ * @param [in] cb
+ *	Progress callback (optional).
+ * @param [in] ctx
+ *	Progress callback context.
  *
  * @returns
  *	0 on success, error code otherwise.
  */
-static int net_read(il_eusb_net_t *this, uint8_t id, uint32_t address,
-		    void *buf, size_t sz)
+static int segmented_transfer(il_eusb_net_t *this, uint16_t id,
+			      uint32_t address, void *buf, size_t sz,
+			      int write, int confirmed,
+			      il_net_progress_cb_t cb, void *ctx)
 {
 	int r;
-	il_eusb_frame_t frame;
+	size_t i, cnt;
+	il_net_xfer_t *xfers;
+	uint16_t *offsets;
 
-	/* virtual network: read always zero */
-	if (this->is_virtual) {
-		memset(buf, 0, sz);
-		return 0;
+	if (sz > (size_t)UINT16_MAX + 1) {
+		ilerr__set("Data size is too large");
+		return IL_EINVAL;
 	}
 
-	/* register synchronous transfer */
-	osal_mutex_lock(this->sync.lock);
-
-	this->sync.id = id;
-	this->sync.address = address;
-	this->sync.buf = buf;
-	this->sync.sz = sz;
-	this->sync.complete = 0;
-
-	/* send synchronous read petition */
-	il_eusb_frame__init(&frame, id, address, NULL, 0);
+	cnt = (sz + IL_EUSB_FRAME_MAX_DATA_SZ - 1) / IL_EUSB_FRAME_MAX_DATA_SZ;
+	if (cnt == 0)
+		return 0;
 
-	r = ser_write(this->ser, frame.buf, frame.sz, NULL);
-	if (r < 0) {
-		ilerr__ser(r);
-		goto unlock;
+	xfers = calloc(cnt, sizeof(*xfers));
+	if (!xfers) {
+		ilerr__set("Segments allocation failed");
+		return IL_ENOMEM;
 	}
 
-	osal_mutex_unlock(this->sync.lock);
-
-	/* wait for response */
-	osal_mutex_lock(this->sync.lock);
-
-	if (!this->sync.complete) {
-		r = osal_cond_wait(this->sync.cond, this->sync.lock,
-				   this->net.timeout_rd);
-		if (r == OSAL_ETIMEDOUT) {
-			ilerr__set("Reception timed out");
-			r = IL_ETIMEDOUT;
-		} else if (r < 0) {
-			ilerr__set("Reception failed");
-			r = IL_EFAIL;
-		}
-	} else {
-		r = 0;
+	offsets = calloc(cnt, sizeof(*offsets));
+	if (!offsets) {
+		ilerr__set("Segments allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_xfers;
 	}
 
-unlock:
-	this->sync.complete = 1;
-
-	osal_mutex_unlock(this->sync.lock);
+	for (i = 0; i < cnt; i++) {
+		size_t offset = i * IL_EUSB_FRAME_MAX_DATA_SZ;
 
-	return r;
-}
+		xfers[i].id = id;
+		xfers[i].address = address;
+		xfers[i].buf = (uint8_t *)buf + offset;
+		xfers[i].sz = MIN(sz - offset, IL_EUSB_FRAME_MAX_DATA_SZ);
+		xfers[i].write = write;
+		xfers[i].confirmed = confirmed;
 
-/*******************************************************************************
- * Implementation: Internal
- ******************************************************************************/
+		offsets[i] = (uint16_t)offset;
+	}
 
-static void il_eusb_net__retain(il_net_t *net)
-{
-	il_eusb_net_t *this = to_eusb_net(net);
+	/* segmented transfers are large (e.g. dumps): bulk requests */
+	r = batch_transfer(this, xfers, offsets, cnt, cb, ctx,
+			   IL_NET_PRIO_BULK);
 
-	il_utils__refcnt_retain(this->refcnt);
-}
+	free(offsets);
 
-static void il_eusb_net__release(il_net_t *net)
-{
-	il_eusb_net_t *this = to_eusb_net(net);
+cleanup_xfers:
+	free(xfers);
 
-	il_utils__refcnt_release(this->refcnt);
+	return r;
 }
 
-static int il_eusb_net__read(il_net_t *net, uint16_t id, uint32_t address,
-			     void *buf, size_t sz)
+static int il_eusb_net__read_segmented(il_net_t *net, uint16_t id,
+				       uint32_t address, void *buf, size_t sz,
+				       il_net_progress_cb_t cb, void *ctx)
 {
 	il_eusb_net_t *this = to_eusb_net(net);
 
-	int r;
-
-	if (il_net_state_get(&this->net) != IL_NET_STATE_CONNECTED) {
-		ilerr__set("Network is not connected");
-		return IL_ESTATE;
-	}
-
-	osal_mutex_lock(this->net.lock);
-
-	r = net_read(this, (uint8_t)id, address, buf, sz);
-
-	osal_mutex_unlock(this->net.lock);
-
-	return r;
+	return segmented_transfer(this, id, address, buf, sz, 0, 0, cb, ctx);
 }
 
-static int il_eusb_net__write(il_net_t *net, uint16_t id, uint32_t address,
-			      const void *buf, size_t sz, int confirmed)
+static int il_eusb_net__write_segmented(il_net_t *net, uint16_t id,
+					uint32_t address, const void *buf,
+					size_t sz, int confirmed,
+					il_net_progress_cb_t cb, void *ctx)
 {
 	il_eusb_net_t *this = to_eusb_net(net);
 
-	int r;
-	il_eusb_frame_t frame;
-
-	/* virtual network: ignore write */
-	if (this->is_virtual)
-		return 0;
-
-	if (il_net_state_get(&this->net) != IL_NET_STATE_CONNECTED) {
-		ilerr__set("Network is not connected");
-		return IL_ESTATE;
-	}
-
-	osal_mutex_lock(this->net.lock);
-
-	/* write */
-	il_eusb_frame__init(&frame, (uint8_t)id, address, buf, sz);
-
-	r = ser_write(this->ser, frame.buf, frame.sz, NULL);
-	if (r < 0) {
-		ilerr__ser(r);
-		goto unlock;
-	}
-
-	/* read back if confirmed */
-	if (confirmed) {
-		void *buf_;
-
-		buf_ = malloc(sz);
-		if (!buf_) {
-			ilerr__set("Buffer allocation failed");
-			r = IL_ENOMEM;
-			goto unlock;
-		}
-
-		r = net_read(this, (uint8_t)id, address, buf_, sz);
-		if (r == 0) {
-			if (memcmp(buf, buf_, sz) != 0) {
-				ilerr__set("Write failed (content mismatch)");
-				r = IL_EIO;
-			}
-		}
-
-		free(buf_);
-	}
-
-unlock:
-	osal_mutex_unlock(this->net.lock);
-
-	return r;
+	/* transmitted as is (never written to) */
+	return segmented_transfer(this, id, address, (void *)buf, sz, 1,
+				  confirmed, cb, ctx);
 }
 
 /*******************************************************************************
@@ -474,33 +1996,40 @@ static il_net_t *il_eusb_net_create(const il_net_opts_t *opts)
 	if (!this->refcnt)
 		goto cleanup_net;
 
-	if (strcmp(opts->port, EUSB_VIRTUAL_PORT) == 0) {
-		this->is_virtual = 1;
-		(void)il_net_connect(&this->net);
-	} else {
-		this->is_virtual = 0;
+	this->is_virtual = strcmp(opts->port, EUSB_VIRTUAL_PORT) == 0;
 
-		/* initialize synchronous transfers context */
-		this->sync.lock = osal_mutex_create();
-		if (!this->sync.lock) {
-			ilerr__set("Network sync lock allocation failed");
-			goto cleanup_refcnt;
-		}
+	/* initialize in-flight transfers */
+	r = xfers_init(this, opts->window);
+	if (r < 0)
+		goto cleanup_refcnt;
 
-		this->sync.cond = osal_cond_create();
-		if (!this->sync.cond) {
-			ilerr__set("Network sync condition allocation failed");
-			goto cleanup_sync_lock;
-		}
+	if (this->is_virtual) {
+		/* virtual network: served by an in-process drive */
+		this->vdrive = il_eusb_vdrive__create(EUSB_VIRTUAL_ID,
+						      opts->virt, on_vdrive_tx,
+						      this);
+		if (!this->vdrive)
+			goto cleanup_xfers;
 
-		this->sync.complete = 1;
+		(void)il_net_connect(&this->net);
+	} else {
+		this->reactor = opts->reactor;
+
+		/* no reactor given: use a private one if supported, so that
+		 * reception blocks until data arrives instead of polling the
+		 * port from a listener thread
+		 */
+		if (!this->reactor) {
+			this->reactor_own = il_reactor_create(NULL);
+			this->reactor = this->reactor_own;
+		}
 
 		/* allocate serial port */
 		this->ser = ser_create();
 		if (!this->ser) {
 			ilerr__set("Serial port allocation failed (%s)",
 				   sererr_last());
-			goto cleanup_sync_cond;
+			goto cleanup_reactor;
 		}
 
 		/* connect */
@@ -519,11 +2048,12 @@ static il_net_t *il_eusb_net_create(const il_net_opts_t *opts)
 cleanup_ser:
 	ser_destroy(this->ser);
 
-cleanup_sync_cond:
-	osal_cond_destroy(this->sync.cond);
+cleanup_reactor:
+	if (this->reactor_own)
+		il_reactor_destroy(this->reactor_own);
 
-cleanup_sync_lock:
-	osal_mutex_destroy(this->sync.lock);
+cleanup_xfers:
+	xfers_deinit(this);
 
 cleanup_refcnt:
 	il_utils__refcnt_destroy(this->refcnt);
@@ -565,18 +2095,15 @@ static int il_eusb_net_connect(il_net_t *net)
 		return IL_EALREADY;
 	} else if (state == IL_NET_STATE_FAULTY) {
 		/* free resources if faulty */
-		this->stop = 1;
-		osal_thread_join(this->listener, NULL);
+		listener_stop(this);
 
 		il_net__state_set(&this->net, IL_NET_STATE_DISCONNECTED);
 	}
 
 	/* open port */
-	r = ser_open(this->ser, &this->sopts);
-	if (r < 0) {
-		ilerr__set("Serial port open failed (%s)", sererr_last());
-		return IL_EFAIL;
-	}
+	r = port_open(this);
+	if (r < 0)
+		return r;
 
 	/* QUIRK: drive may not be operative immediately */
 	osal_clock_sleep_ms(INIT_WAIT_TIME);
@@ -585,34 +2112,28 @@ static int il_eusb_net_connect(il_net_t *net)
 	il_net__state_set(&this->net, IL_NET_STATE_CONNECTED);
 
 	/* send ascii message to force binary */
-	r = ser_write(this->ser, MSG_A2B, sizeof(MSG_A2B) - 1, NULL);
-	if (r < 0) {
-		ilerr__set("Binary configuration failed (%s)", sererr_last());
-		goto close_ser;
-	}
+	r = net_send(this, MSG_A2B, sizeof(MSG_A2B) - 1, 0);
+	if (r < 0)
+		goto close_port;
 
 	/* send the same message twice in binary (will flush) */
 	val = 1;
 	for (i = 0; i < BIN_FLUSH; i++) {
 		r = il_eusb_net__write(&this->net, 0, UARTCFG_BIN_ADDRESS, &val,
-				       sizeof(val), 0);
+				       sizeof(val), 0, IL_NET_PRIO_CTL);
 		if (r < 0)
-			goto close_ser;
+			goto close_port;
 	}
 
-	/* start listener thread */
-	this->stop = 0;
-
-	this->listener = osal_thread_create(listener, this);
-	if (!this->listener) {
-		ilerr__set("Listener thread creation failed");
-		goto close_ser;
-	}
+	/* start reception */
+	r = listener_start(this);
+	if (r < 0)
+		goto close_port;
 
 	return 0;
 
-close_ser:
-	ser_close(this->ser);
+close_port:
+	port_close(this);
 	il_net__state_set(&this->net, IL_NET_STATE_DISCONNECTED);
 
 	return IL_EFAIL;
@@ -629,21 +2150,86 @@ static void il_eusb_net_disconnect(il_net_t *net)
 	}
 
 	if (il_net_state_get(&this->net) != IL_NET_STATE_DISCONNECTED) {
-		this->stop = 1;
-		osal_thread_join(this->listener, NULL);
+		listener_stop(this);
 
 		il_net__state_set(&this->net, IL_NET_STATE_DISCONNECTED);
 	}
 }
 
+/**
+ * Compute the node scanner idle window.
+ *
+ * @note
+ *	Once the first reply has arrived, the remaining nodes are expected to
+ *	reply within a few round trips, so the scan can end much earlier than
+ *	the default timeout.
+ *
+ * @param [in] start
+ *	Time when the scan request was sent.
+ *
+ * @returns
+ *	Idle window (ms).
+ */
+static int scan_window(const osal_timespec_t *start)
+{
+	osal_timespec_t now;
+	long rtt;
+
+	if (osal_clock_gettime(&now) < 0)
+		return SCAN_TIMEOUT;
+
+	/* round trip time (ms, rounded up) */
+	rtt = (now.s - start->s) * 1000L +
+	      (now.ns - start->ns + OSAL_CLOCK_NANOSPERMSEC - 1) /
+	      OSAL_CLOCK_NANOSPERMSEC;
+
+	return (int)MIN(MAX(SCAN_WINDOW_RTTS * rtt, SCAN_WINDOW_MIN),
+			SCAN_TIMEOUT);
+}
+
+/**
+ * Wait for the next node scanner reply.
+ *
+ * @note
+ *	Transfers lock must be held by the caller.
+ *
+ * @param [in] this
+ *	E-USB Network.
+ * @param [in] xfer
+ *	Scan transfer.
+ * @param [in] start
+ *	Time when the scan request was sent.
+ * @param [in, out] window
+ *	Idle window (ms), adapted on the first reply.
+ *
+ * @returns
+ *	0 if a reply arrived, OSAL_ETIMEDOUT if the window elapsed.
+ */
+static int scan_wait(il_eusb_net_t *this, il_eusb_net_xfer_t *xfer,
+		     const osal_timespec_t *start, int *window)
+{
+	int r;
+	size_t cnt = xfer->cnt;
+
+	r = osal_cond_wait(xfer->cond, this->xfers.lock, *window);
+	if ((r == 0) && (cnt == 0) && (xfer->cnt > 0))
+		*window = scan_window(start);
+
+	return r;
+}
+
 static il_net_servos_list_t *il_eusb_net_servos_list_get(
 	il_net_t *net, il_net_servos_on_found_t on_found, void *ctx)
 {
 	il_eusb_net_t *this = to_eusb_net(net);
 
 	int r;
-	uint8_t id;
+	uint8_t ids[UINT8_MAX];
+	size_t seen = 0;
 	il_eusb_frame_t frame;
+	il_eusb_net_xfer_t *xfer;
+	osal_timespec_t start;
+	int window = SCAN_TIMEOUT;
 
 	il_net_servos_list_t *lst = NULL;
 	il_net_servos_list_t *prev;
@@ -659,7 +2245,7 @@ static il_net_servos_list_t *il_eusb_net_servos_list_get(
 		lst->id = EUSB_VIRTUAL_ID;
 
 		if (on_found)
-			on_found(ctx, id);
+			on_found(ctx, EUSB_VIRTUAL_ID);
 
 		return lst;
 	}
@@ -670,61 +2256,57 @@ static il_net_servos_list_t *il_eusb_net_servos_list_get(
 		return NULL;
 	}
 
-	osal_mutex_lock(this->net.lock);
+	il_net__tx_lock(&this->net, IL_NET_PRIO_BULK);
+
+	/* wait for in-flight transfers (scan requires exclusive access) */
+	osal_mutex_lock(this->xfers.lock);
+
+	while (this->xfers.cnt > 0)
+		(void)xfers_wait(this, IL_NET_PRIO_BULK, 1, SCAN_TIMEOUT);
 
-	/* register synchronous transfer */
-	osal_mutex_lock(this->sync.lock);
+	/* register scan transfer (collects all responses) */
+	xfer = xfer_take(this, 0, UARTCFG_ID_ADDRESS, 0);
 
-	this->sync.id = 0;
-	this->sync.address = UARTCFG_ID_ADDRESS;
-	this->sync.buf = &id;
-	this->sync.sz = sizeof(id);
-	this->sync.complete = 0;
+	xfer->buf = ids;
+	xfer->sz = sizeof(ids);
+	xfer->scan = 1;
+	xfer->cnt = 0;
+	xfer->outstanding = 0;
 
 	il_eusb_frame__init(&frame, 0, UARTCFG_ID_ADDRESS, NULL, 0);
 
 	/* QUIRK: ignore first run, as on cold-boot firmware may issue
 	 * improperly formatted binary messages, leading to no servos found.
 	 */
-	r = ser_write(this->ser, frame.buf, frame.sz, NULL);
-	if (r < 0) {
-		ilerr__ser(r);
-		goto sync_unlock;
-	}
+	(void)osal_clock_gettime(&start);
 
-	osal_mutex_unlock(this->sync.lock);
-	osal_mutex_lock(this->sync.lock);
+	r = net_send(this, frame.buf, frame.sz, 1);
+	if (r < 0)
+		goto release;
 
-	while (r == 0) {
-		if (this->sync.complete)
-			this->sync.complete = 0;
-		else
-			r = osal_cond_wait(this->sync.cond, this->sync.lock,
-					   SCAN_TIMEOUT);
-	}
+	while (r == 0)
+		r = scan_wait(this, xfer, &start, &window);
 
-	/* second try */
-	this->sync.complete = 0;
+	/* second try (window is kept if adapted) */
+	xfer->cnt = 0;
 
-	r = ser_write(this->ser, frame.buf, frame.sz, NULL);
-	if (r < 0) {
-		ilerr__ser(r);
-		goto sync_unlock;
-	}
+	(void)osal_clock_gettime(&start);
 
-	osal_mutex_unlock(this->sync.lock);
-	osal_mutex_lock(this->sync.lock);
+	r = net_send(this, frame.buf, frame.sz, 1);
+	if (r < 0)
+		goto release;
 
-	while (r == 0) {
-		if (this->sync.complete) {
-			this->sync.complete = 0;
+	for (;;) {
+		/* process new responses */
+		while (seen < xfer->cnt) {
+			uint8_t id = ids[seen++];
 
 			/* allocate new list entry */
 			prev = lst;
 			lst = malloc(sizeof(*lst));
 			if (!lst) {
 				il_net_servos_list_destroy(prev);
-				break;
+				goto release;
 			}
 
 			lst->next = prev;
@@ -732,16 +2314,21 @@ static il_net_servos_list_t *il_eusb_net_servos_list_get(
 
 			if (on_found)
 				on_found(ctx, id);
-		} else {
-			r = osal_cond_wait(this->sync.cond, this->sync.lock,
-					   SCAN_TIMEOUT);
 		}
+
+		if (r != 0)
+			break;
+
+		r = scan_wait(this, xfer, &start, &window);
 	}
 
-sync_unlock:
-	osal_mutex_unlock(this->sync.lock);
+release:
+	xfer->scan = 0;
+	xfer_release(this, xfer);
+
+	osal_mutex_unlock(this->xfers.lock);
 
-	osal_mutex_unlock(this->net.lock);
+	il_net__tx_unlock(&this->net, IL_NET_PRIO_BULK);
 
 	return lst;
 }
@@ -886,6 +2473,11 @@ const il_net_ops_t il_eusb_net_ops = {
 	._state_set = il_net_base__state_set,
 	._read = il_eusb_net__read,
 	._write = il_eusb_net__write,
+	._read_async = il_eusb_net__read_async,
+	._write_async = il_eusb_net__write_async,
+	._transfer_batch = il_eusb_net__transfer_batch,
+	._read_segmented = il_eusb_net__read_segmented,
+	._write_segmented = il_eusb_net__write_segmented,
 	._sw_subscribe = il_net_base__sw_subscribe,
 	._sw_unsubscribe = il_net_base__sw_unsubscribe,
 	._emcy_subscribe = il_net_base__emcy_subscribe,
@@ -28,8 +28,12 @@
 #include "../net.h"
 
 #include "ingenialink/eusb/frame.h"
+#include "ingenialink/eusb/vdrive.h"
+#include "ingenialink/reactor.h"
 #include "ingenialink/utils.h"
 
+#include "osal/clock.h"
+
 #define _SER_NO_LEGACY_STDINT
 #include <sercomm/sercomm.h>
 
@@ -39,12 +43,21 @@
 /** Serial port read poll timeout (ms). */
 #define SER_POLL_TIMEOUT	100
 
+/** Reception buffer size. */
+#define RBUF_SZ			512
+
 /** Binary mode ON message (ASCII protocol). */
 #define MSG_A2B			"\r0 W 0x82000 1\r"
 
 /** Node scanner timeout (ms) */
 #define SCAN_TIMEOUT		100
 
+/** Node scanner minimum idle window (ms). */
+#define SCAN_WINDOW_MIN		5
+
+/** Node scanner idle window, in round trip times. */
+#define SCAN_WINDOW_RTTS	4
+
 /** UART node id (index) */
 #define UARTCFG_ID_ADDRESS	0x012000
 
@@ -60,26 +73,99 @@
 /** Emergency address. */
 #define EMCY_ADDRESS		0x011003
 
+/** Fence address (node id, answered by all drives). */
+#define FENCE_ADDRESS		UARTCFG_ID_ADDRESS
+
+/** Orphan transfers expiration time, in read timeouts. */
+#define ORPHAN_TIMEOUTS		4
+
 /** Initialization wait time (ms). */
 #define INIT_WAIT_TIME		500
 
-/** Synchronous transfers context. */
+/** In-flight transfer. */
 typedef struct {
-	/** Node ID. */
+	/** Used flag. */
+	int used;
+	/** Completed flag. */
+	int complete;
+	/** Node ID (0 to match any). */
 	uint8_t id;
 	/** Address. */
 	uint32_t address;
+	/** Segment offset. */
+	uint16_t offset;
+	/** Truncate flag (longer responses are accepted, e.g. segments). */
+	int trunc;
 	/** Buffer. */
 	void *buf;
 	/** Buffer size. */
 	size_t sz;
-	/** Completed flag. */
-	int complete;
-	/** Lock. */
-	osal_mutex_t *lock;
+	/** Sequence number (transmission order). */
+	uint32_t seq;
 	/** Completed condition variable. */
 	osal_cond_t *cond;
-} il_eusb_net_sync_t;
+	/** Completion callback (asynchronous transfers only). */
+	il_net_async_cb_t cb;
+	/** Completion callback context. */
+	void *ctx;
+	/** Data buffer (asynchronous transfers only). */
+	uint8_t data[IL_EUSB_FRAME_MAX_DATA_SZ];
+	/** Expected data (confirmed asynchronous writes). */
+	uint8_t expected[IL_EUSB_FRAME_MAX_DATA_SZ];
+	/** Confirmation flag (confirmed asynchronous writes). */
+	int confirmed;
+	/** Submission time (statistics). */
+	osal_timespec_t start;
+	/** Retry flag (round trip is ambiguous, not measured). */
+	int retry;
+	/** Expiration time (asynchronous transfers only). */
+	osal_timespec_t deadline;
+	/** Scan flag (collects all responses into buffer). */
+	int scan;
+	/** Number of collected responses (scan only). */
+	size_t cnt;
+	/** Number of petitions sent and not yet answered. */
+	size_t outstanding;
+	/**
+	 * Orphan flag (owner is gone, late responses are absorbed so that
+	 * they do not complete newer transfers).
+	 */
+	int orphan;
+	/** Fence flag (resolves the orphans of a node once answered). */
+	int fence;
+} il_eusb_net_xfer_t;
+
+/**
+ * In-flight transfers table.
+ *
+ * @note
+ *	Responses are matched by (node id, address). If multiple transfers
+ *	match, the oldest one (lowest sequence number) is completed first, as
+ *	drives answer in order. Transfers that time out with unanswered
+ *	petitions are kept as orphans until answered, so that a late response
+ *	is not taken as the response of a newer transfer. Orphans are dropped
+ *	once a newer transfer to the same node completes (petition was lost),
+ *	or after ORPHAN_TIMEOUTS read timeouts. A fence (read of a register at
+ *	a different address) is sent ahead of the next transfer to a node with
+ *	orphans, so that they are resolved even if only the same address is
+ *	being polled.
+ */
+typedef struct {
+	/** Transfers. */
+	il_eusb_net_xfer_t xfers[IL_NET_WINDOW_MAX];
+	/** Window depth (usable transfers). */
+	size_t depth;
+	/** Number of transfers in use. */
+	size_t cnt;
+	/** Next sequence number. */
+	uint32_t seq;
+	/** Nodes with orphans pending a fence. */
+	uint8_t fence[256];
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** Transfer available condition variable. */
+	osal_cond_t *avail;
+} il_eusb_net_xfers_t;
 
 /** E-USB Network. */
 typedef struct il_eusb_net {
@@ -89,6 +175,8 @@ typedef struct il_eusb_net {
 	il_utils_refcnt_t *refcnt;
 	/** Virtual flag. */
 	int is_virtual;
+	/** Virtual drive (virtual network only). */
+	il_eusb_vdrive_t *vdrive;
 	/** Serial communications channel. */
 	ser_t *ser;
 	/** Serial communications options. */
@@ -97,8 +185,18 @@ typedef struct il_eusb_net {
 	osal_thread_t *listener;
 	/** Listener stop flag. */
 	int stop;
-	/** Synchronous transfers context. */
-	il_eusb_net_sync_t sync;
+	/** I/O reactor (replaces listener thread if set). */
+	il_reactor_t *reactor;
+	/** Private I/O reactor (used when none is given, if supported). */
+	il_reactor_t *reactor_own;
+	/** I/O reactor source. */
+	il_reactor_src_t *src;
+	/** Reception buffer. */
+	uint8_t rbuf[RBUF_SZ];
+	/** Reception buffer contents size. */
+	size_t rbuf_cnt;
+	/** In-flight transfers. */
+	il_eusb_net_xfers_t xfers;
 } il_eusb_net_t;
 
 #ifdef IL_HAS_DEVMON
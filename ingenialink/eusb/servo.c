@@ -23,7 +23,7 @@
  */
 
 #include "servo.h"
-#include "mc.h"
+#include "../mc.h"
 
 #include <ctype.h>
 #include <string.h>
@@ -32,6 +32,7 @@
 #include <math.h>
 
 #include "public/ingenialink/const.h"
+#include "ingenialink/cache.h"
 #include "ingenialink/err.h"
 #include "ingenialink/registers.h"
 #include "ingenialink/base/servo.h"
@@ -41,144 +42,164 @@
  ******************************************************************************/
 
 /**
- * Obtain the current statusword value.
+ * Registers the cached configuration is derived from (fingerprint), the
+ * serial number (record key) goes first.
+ */
+static const il_reg_t *const cache_fp_regs[] = {
+	&IL_REG_ID_SERIAL,
+	&IL_REG_SW_VERSION,
+	&IL_REG_RATED_TORQUE,
+	&IL_REG_MOTOR_TYPE,
+	&IL_REG_MOTPARAM_PPITCH,
+	&IL_REG_MOTPARAM_STROKE,
+	&IL_REG_PAIR_POLES,
+	&IL_REG_FB_POS_SENSOR,
+	&IL_REG_PRES_ENC_INCR,
+	&IL_REG_PRES_MOTOR_REVS,
+	&IL_REG_FB_VEL_SENSOR,
+	&IL_REG_VRES_ENC_INCR,
+	&IL_REG_VRES_MOTOR_REVS,
+};
+
+/**
+ * Update a cache fingerprint (FNV-1a).
  *
- * @param [in] servo
- *	IngeniaLink servo.
+ * @param [in] fp
+ *	Fingerprint.
+ * @param [in] data
+ *	Data.
+ * @param [in] sz
+ *	Data size.
  *
  * @return
- *	Statusword value.
+ *	Updated fingerprint.
  */
-static uint16_t sw_get(il_servo_t *servo)
+static uint64_t cache_fp_update(uint64_t fp, const void *data, size_t sz)
 {
-	uint16_t sw;
+	const uint8_t *data_ = data;
+	size_t i;
 
-	osal_mutex_lock(servo->sw.lock);
-	sw = servo->sw.value;
-	osal_mutex_unlock(servo->sw.lock);
+	for (i = 0; i < sz; i++) {
+		fp ^= data_[i];
+		fp *= CACHE_FP_PRIME;
+	}
 
-	return sw;
+	return fp;
 }
 
 /**
- * Wait until the statusword changes its value.
+ * Restore the servo configuration from the network cache.
  *
- * @param [in] servo
- *	IngeniaLink servo.
- * @param [in, out] sw
- *	Current statusword value, where next value will be stored.
- * @param [in, out] timeout
- *	Timeout (ms), if positive will be updated with remaining ms.
+ * @note
+ *	The servo fingerprint (firmware version and all the registers the
+ *	configuration is derived from, read in a single batch) is computed and
+ *	kept, so that the cache record can be refreshed later if it is missing
+ *	or stale. Registers that cannot be read are part of the fingerprint
+ *	through their error code.
+ *
+ * @param [in] this
+ *	E-USB servo.
  *
  * @return
- *	0 on success, error code otherwise.
+ *	0 if restored, error code otherwise (including cache not enabled).
  */
-static int sw_wait_change(il_servo_t *servo, uint16_t *sw, int *timeout)
+static int cache_restore(il_eusb_servo_t *this)
 {
-	int r = 0;
-	osal_timespec_t start = { 0, 0 }, end, diff;
-
-	/* obtain start time */
-	if (*timeout > 0) {
-		if (osal_clock_gettime(&start) < 0) {
-			ilerr__set("Could not obtain system time");
-			return IL_EFAIL;
-		}
-	}
+	int r;
+	il_servo_t *servo = &this->servo;
+	il_cache_t *cache;
+	il_net_xfer_t xfers[ARRAY_SIZE(cache_fp_regs)];
+	uint64_t bufs[ARRAY_SIZE(cache_fp_regs)];
+	uint32_t serial;
+	uint64_t fp = CACHE_FP_BASIS;
+	size_t i;
 
-	/* wait for change */
-	osal_mutex_lock(servo->sw.lock);
-
-	if (servo->sw.value == *sw) {
-		r = osal_cond_wait(servo->sw.changed, servo->sw.lock, *timeout);
-		if (r == OSAL_ETIMEDOUT) {
-			ilerr__set("Operation timed out");
-			r = IL_ETIMEDOUT;
-			goto out;
-		} else if (r < 0) {
-			ilerr__set("Statusword wait change failed");
-			r = IL_EFAIL;
-			goto out;
-		}
+	cache = il_net__cache(servo->net);
+	if (!cache)
+		return IL_EFAIL;
+
+	memset(xfers, 0, sizeof(xfers));
+	memset(bufs, 0, sizeof(bufs));
+
+	for (i = 0; i < ARRAY_SIZE(cache_fp_regs); i++) {
+		xfers[i].id = servo->id;
+		xfers[i].address = cache_fp_regs[i]->address;
+		xfers[i].buf = &bufs[i];
+		xfers[i].sz = il_utils__reg_sz(cache_fp_regs[i]->dtype);
 	}
 
-	*sw = servo->sw.value;
+	(void)il_net__transfer_batch(servo->net, xfers, ARRAY_SIZE(xfers),
+				     IL_NET_PRIO_BULK);
 
-out:
-	/* update timeout */
-	if ((*timeout > 0) && (r == 0)) {
-		/* obtain end time */
-		if (osal_clock_gettime(&end) < 0) {
-			ilerr__set("Could not obtain system time");
-			r = IL_EFAIL;
-			goto unlock;
-		}
+	/* serial number is required (record key) */
+	if (xfers[0].r < 0)
+		return xfers[0].r;
 
-		/* compute difference */
-		if ((end.ns - start.ns) < 0) {
-			diff.s = end.s - start.s - 1;
-			diff.ns = end.ns - start.ns + OSAL_CLOCK_NANOSPERSEC;
-		} else {
-			diff.s = end.s - start.s;
-			diff.ns = end.ns - start.ns;
-		}
+	memcpy(&serial, &bufs[0], sizeof(serial));
+	serial = __swap_be_32(serial);
 
-		/* update timeout */
-		*timeout -= diff.s * 1000 + diff.ns / OSAL_CLOCK_NANOSPERMSEC;
-		if (*timeout <= 0) {
-			ilerr__set("Operation timed out");
-			r = IL_ETIMEDOUT;
-		}
+	for (i = 1; i < ARRAY_SIZE(xfers); i++) {
+		if (xfers[i].r == 0)
+			fp = cache_fp_update(fp, &bufs[i], xfers[i].sz);
+		else
+			fp = cache_fp_update(fp, &xfers[i].r,
+					     sizeof(xfers[i].r));
 	}
 
-unlock:
-	osal_mutex_unlock(servo->sw.lock);
+	osal_mutex_lock(this->cache.lock);
 
-	return r;
+	this->cache.valid = 1;
+	this->cache.serial = serial;
+	this->cache.fp = fp;
+
+	r = il_cache__get(cache, serial, fp, &this->cache.rec,
+			  sizeof(this->cache.rec));
+	if (r < 0)
+		memset(&this->cache.rec, 0, sizeof(this->cache.rec));
+
+	osal_mutex_unlock(this->cache.lock);
+
+	if (r < 0)
+		return r;
+
+	osal_mutex_lock(servo->units.lock);
+
+	servo->cfg = this->cache.rec.cfg;
+	il_servo_base__units_factors_update(servo);
+
+	osal_mutex_unlock(servo->units.lock);
+
+	return 0;
 }
 
 /**
- * Wait until the statusword has the requested value
+ * Store the servo configuration (and information, if available) to the
+ * network cache.
  *
  * @note
- *	The timeout is not an absolute timeout, but an interval timeout.
+ *	Storage failures are not fatal, the record will be refreshed on the
+ *	next store.
  *
- * @param [in] servo
- *	IngeniaLink servo.
- * @param [in] msk
- *	Statusword mask.
- * @param [in] val
- *	Statusword value.
- * @param [in] timeout
- *	Timeout (ms).
+ * @param [in] this
+ *	E-USB servo.
  */
-static int sw_wait_value(il_servo_t *servo, uint16_t msk, uint16_t val,
-			 int timeout)
+static void cache_store(il_eusb_servo_t *this)
 {
-	int r = 0;
-	uint16_t result;
+	il_servo_t *servo = &this->servo;
 
-	/* wait until the flag changes to the requested state */
-	osal_mutex_lock(servo->sw.lock);
+	osal_mutex_lock(this->cache.lock);
 
-	do {
-		result = servo->sw.value & msk;
-		if (result != val) {
-			r = osal_cond_wait(servo->sw.changed, servo->sw.lock,
-					   timeout);
-			if (r == OSAL_ETIMEDOUT) {
-				ilerr__set("Operation timed out");
-				r = IL_ETIMEDOUT;
-			} else if (r < 0) {
-				ilerr__set("Statusword wait change failed");
-				r = IL_EFAIL;
-			}
-		}
-	} while ((result != val) && (r == 0));
+	if (this->cache.valid) {
+		osal_mutex_lock(servo->units.lock);
+		this->cache.rec.cfg = servo->cfg;
+		osal_mutex_unlock(servo->units.lock);
 
-	osal_mutex_unlock(servo->sw.lock);
+		(void)il_cache__put(il_net__cache(servo->net),
+				    this->cache.serial, this->cache.fp,
+				    &this->cache.rec, sizeof(this->cache.rec));
+	}
 
-	return r;
+	osal_mutex_unlock(this->cache.lock);
 }
 
 /**
@@ -192,6 +213,7 @@ static void servo_destroy(void *ctx)
 	il_eusb_servo_t *this = ctx;
 
 	il_servo_base__deinit(&this->servo);
+	osal_mutex_destroy(this->cache.lock);
 
 	free(this);
 }
@@ -274,12 +296,24 @@ static il_servo_t *il_eusb_servo_create(il_net_t *net, uint16_t id,
 		return NULL;
 	}
 
+	memset(&this->cache, 0, sizeof(this->cache));
+
+	this->cache.lock = osal_mutex_create();
+	if (!this->cache.lock) {
+		ilerr__set("Servo cache lock allocation failed");
+		goto cleanup_servo;
+	}
+
 	r = il_servo_base__init(&this->servo, net, id, dict);
 	if (r < 0)
-		goto cleanup_servo;
+		goto cleanup_cache_lock;
 
 	this->servo.ops = &il_eusb_servo_ops;
 
+	/* PDS: statusword updates are pushed, enabled requires initial angle */
+	this->servo.pds.cw = &IL_REG_CTL_WORD;
+	this->servo.pds.enabled_msk = IL_MC_SW_IANGLE;
+
 	/* initialize, setup refcnt */
 	this->refcnt = il_utils__refcnt_create(servo_destroy, this);
 	if (!this->refcnt)
@@ -290,12 +324,16 @@ static il_servo_t *il_eusb_servo_create(il_net_t *net, uint16_t id,
 	if (r < 0)
 		goto cleanup_refcnt;
 
-	r = il_servo_units_update(&this->servo);
-	if (r < 0)
-		goto cleanup_refcnt;
+	/* restore configuration from cache, read it otherwise */
+	if (cache_restore(this) < 0) {
+		r = il_servo_units_update(&this->servo);
+		if (r < 0)
+			goto cleanup_refcnt;
+	}
 
 	/* trigger status update (with manual read) */
-	(void)il_servo_raw_read_u16(&this->servo, &IL_REG_STS_WORD, NULL, &sw);
+	(void)il_servo_base__sw_read(&this->servo, &IL_REG_STS_WORD, NULL,
+				     &sw);
 
 	return &this->servo;
 
@@ -305,6 +343,9 @@ cleanup_refcnt:
 cleanup_base:
 	il_servo_base__deinit(&this->servo);
 
+cleanup_cache_lock:
+	osal_mutex_destroy(this->cache.lock);
+
 cleanup_servo:
 	free(this);
 
@@ -363,6 +404,21 @@ static int il_eusb_servo_info_get(il_servo_t *servo, il_servo_info_t *info)
 {
 	int r;
 	size_t i;
+	il_eusb_servo_t *this = to_eusb_servo(servo);
+
+	/* use cached information if available (the name is not part of the
+	 * configuration fingerprint, so it is always read from the servo)
+	 */
+	osal_mutex_lock(this->cache.lock);
+
+	if (this->cache.rec.has_info) {
+		*info = this->cache.rec.info;
+		osal_mutex_unlock(this->cache.lock);
+
+		return il_servo_name_get(servo, info->name, sizeof(info->name));
+	}
+
+	osal_mutex_unlock(this->cache.lock);
 
 	r = il_servo_raw_read_u32(servo, &IL_REG_ID_SERIAL, NULL,
 				  &info->serial);
@@ -403,8 +459,26 @@ static int il_eusb_servo_info_get(il_servo_t *servo, il_servo_info_t *info)
 	if (r < 0)
 		return r;
 
-	return il_servo_raw_read_u32(servo, &IL_REG_ID_REVISION, NULL,
-				     &info->revision);
+	r = il_servo_raw_read_u32(servo, &IL_REG_ID_REVISION, NULL,
+				  &info->revision);
+	if (r < 0)
+		return r;
+
+	/* refresh cache (if enabled) */
+	osal_mutex_lock(this->cache.lock);
+
+	if (this->cache.valid) {
+		this->cache.rec.info = *info;
+		memset(this->cache.rec.info.name, 0,
+		       sizeof(this->cache.rec.info.name));
+		this->cache.rec.has_info = 1;
+	}
+
+	osal_mutex_unlock(this->cache.lock);
+
+	cache_store(this);
+
+	return 0;
 }
 
 static int il_eusb_servo_store_all(il_servo_t *servo)
@@ -469,22 +543,29 @@ static int il_eusb_servo_units_update(il_servo_t *servo)
 			return r;
 	}
 
+	osal_mutex_lock(servo->units.lock);
+
 	servo->cfg.rated_torque = (double)rated_torque;
 	servo->cfg.pos_res = (double)pos_res;
 	servo->cfg.vel_res = (double)vel_res;
 	servo->cfg.acc_res = servo->cfg.pos_res;
 	servo->cfg.dist_scale = (double)dist_scale / 1000000;
 
+	il_servo_base__units_factors_update(servo);
+
+	osal_mutex_unlock(servo->units.lock);
+
+	cache_store(to_eusb_servo(servo));
+
 	return 0;
 }
 
-static double il_eusb_servo_units_factor(il_servo_t *servo, const il_reg_t *reg)
+static double il_eusb_servo_units_factor(il_servo_t *servo, il_reg_phy_t phy)
 {
 	double factor;
 
-	osal_mutex_lock(servo->units.lock);
-
-	switch (reg->phy) {
+	/* units lock is held by the caller (factors update) */
+	switch (phy) {
 	case IL_REG_PHY_TORQUE:
 		switch (servo->units.torque) {
 		case IL_UNITS_TORQUE_NATIVE:
@@ -612,179 +693,9 @@ static double il_eusb_servo_units_factor(il_servo_t *servo, const il_reg_t *reg)
 		break;
 	}
 
-	osal_mutex_unlock(servo->units.lock);
-
 	return factor;
 }
 
-static int il_eusb_servo_disable(il_servo_t *servo)
-{
-	int r;
-	uint16_t sw;
-	il_servo_state_t state;
-	int timeout = PDS_TIMEOUT;
-
-	sw = sw_get(servo);
-
-	do {
-		servo->ops->_state_decode(sw, &state, NULL);
-
-		/* try fault reset if faulty */
-		if ((state == IL_SERVO_STATE_FAULT) ||
-		    (state == IL_SERVO_STATE_FAULTR)) {
-			r = il_servo_fault_reset(servo);
-			if (r < 0)
-				return r;
-
-			sw = sw_get(servo);
-		/* check state and command action to reach disabled */
-		} else if (state != IL_SERVO_STATE_DISABLED) {
-			r = il_servo_raw_write_u16(servo, &IL_REG_CTL_WORD,
-						   NULL, IL_MC_PDS_CMD_DV, 1);
-			if (r < 0)
-				return r;
-
-			/* wait until statusword changes */
-			r = sw_wait_change(servo, &sw, &timeout);
-			if (r < 0)
-				return r;
-		}
-	} while (state != IL_SERVO_STATE_DISABLED);
-
-	return 0;
-}
-
-static int il_eusb_servo_switch_on(il_servo_t *servo, int timeout)
-{
-	int r;
-	uint16_t sw, cmd;
-	il_servo_state_t state;
-	int timeout_ = timeout;
-
-	sw = sw_get(servo);
-
-	do {
-		servo->ops->_state_decode(sw, &state, NULL);
-
-		/* try fault reset if faulty */
-		if ((state == IL_SERVO_STATE_FAULT) ||
-		    (state == IL_SERVO_STATE_FAULTR)) {
-			r = il_servo_fault_reset(servo);
-			if (r < 0)
-				return r;
-
-			sw = sw_get(servo);
-		/* check state and command action to reach switch on */
-		} else if (state != IL_SERVO_STATE_ON) {
-			if (state == IL_SERVO_STATE_NRDY)
-				cmd = IL_MC_PDS_CMD_DV;
-			else if (state == IL_SERVO_STATE_DISABLED)
-				cmd = IL_MC_PDS_CMD_SD;
-			else if (state == IL_SERVO_STATE_RDY)
-				cmd = IL_MC_PDS_CMD_SO;
-			else if (state == IL_SERVO_STATE_ENABLED)
-				cmd = IL_MC_PDS_CMD_DO;
-			else
-				cmd = IL_MC_PDS_CMD_DV;
-
-			r = il_servo_raw_write_u16(servo, &IL_REG_CTL_WORD,
-						   NULL, cmd, 1);
-			if (r < 0)
-				return r;
-
-			/* wait for state change */
-			r = sw_wait_change(servo, &sw, &timeout_);
-			if (r < 0)
-				return r;
-		}
-	} while (state != IL_SERVO_STATE_ON);
-
-	return 0;
-}
-
-static int il_eusb_servo_enable(il_servo_t *servo, int timeout)
-{
-	int r;
-	uint16_t sw, cmd;
-	il_servo_state_t state;
-	int timeout_ = timeout;
-
-	sw = sw_get(servo);
-
-	do {
-		servo->ops->_state_decode(sw, &state, NULL);
-
-		/* try fault reset if faulty */
-		if ((state == IL_SERVO_STATE_FAULT) ||
-		    (state == IL_SERVO_STATE_FAULTR)) {
-			r = il_servo_fault_reset(servo);
-			if (r < 0)
-				return r;
-
-			sw = sw_get(servo);
-		/* check state and command action to reach enabled */
-		} else if ((state != IL_SERVO_STATE_ENABLED) ||
-			   !(sw & IL_MC_SW_IANGLE)) {
-			if (state == IL_SERVO_STATE_NRDY)
-				cmd = IL_MC_PDS_CMD_DV;
-			else if (state == IL_SERVO_STATE_DISABLED)
-				cmd = IL_MC_PDS_CMD_SD;
-			else if (state == IL_SERVO_STATE_RDY)
-				cmd = IL_MC_PDS_CMD_SOEO;
-			else
-				cmd = IL_MC_PDS_CMD_EO;
-
-			r = il_servo_raw_write_u16(servo, &IL_REG_CTL_WORD,
-						   NULL, cmd, 1);
-			if (r < 0)
-				return r;
-
-			/* wait for state change */
-			r = sw_wait_change(servo, &sw, &timeout_);
-			if (r < 0)
-				return r;
-		}
-	} while ((state != IL_SERVO_STATE_ENABLED) || !(sw & IL_MC_SW_IANGLE));
-
-	return 0;
-}
-
-static int il_eusb_servo_fault_reset(il_servo_t *servo)
-{
-	int r;
-	uint16_t sw;
-	il_servo_state_t state;
-	int timeout = PDS_TIMEOUT;
-
-	sw = sw_get(servo);
-
-	do {
-		servo->ops->_state_decode(sw, &state, NULL);
-
-		/* check if faulty, if so try to reset (0->1) */
-		if ((state == IL_SERVO_STATE_FAULT) ||
-		    (state == IL_SERVO_STATE_FAULTR)) {
-			r = il_servo_raw_write_u16(servo, &IL_REG_CTL_WORD,
-						   NULL, 0, 1);
-			if (r < 0)
-				return r;
-
-			r = il_servo_raw_write_u16(servo, &IL_REG_CTL_WORD,
-						   NULL, IL_MC_PDS_CMD_FR, 1);
-			if (r < 0)
-				return r;
-
-			/* wait until statusword changes */
-			r = sw_wait_change(servo, &sw, &timeout);
-			if (r < 0)
-				return r;
-		}
-	} while ((state == IL_SERVO_STATE_FAULT) ||
-		 (state == IL_SERVO_STATE_FAULTR));
-
-	return 0;
-}
-
 static int il_eusb_servo_mode_get(il_servo_t *servo, il_servo_mode_t *mode)
 {
 	int r;
@@ -923,13 +834,14 @@ static int il_eusb_servo_homing_wait(il_servo_t *servo, int timeout)
 	uint16_t sw, state;
 	int timeout_ = timeout;
 
-	sw = sw_get(servo);
+	sw = il_servo_base__sw_get(servo);
 
 	do {
 		state = sw & IL_MC_HOMING_STA_MSK;
 
 		if (state == IL_MC_HOMING_STA_INPROG) {
-			r = sw_wait_change(servo, &sw, &timeout_);
+			r = il_servo_base__sw_wait_change(servo, &sw,
+							  &timeout_);
 			if (r < 0)
 				return r;
 		}
@@ -970,7 +882,7 @@ static int il_eusb_servo_position_set(il_servo_t *servo, double pos,
 				      int immediate, int relative,
 				      int sp_timeout)
 {
-	int r;
+	int r, timeout;
 	uint16_t cmd;
 	il_servo_state_t state;
 	int flags;
@@ -993,7 +905,9 @@ static int il_eusb_servo_position_set(il_servo_t *servo, double pos,
 			return r;
 
 		/* wait set-point ack clear */
-		r = sw_wait_value(servo, IL_MC_PP_SW_SPACK, 0, sp_timeout);
+		timeout = sp_timeout;
+		r = il_servo_base__sw_wait_value(servo, IL_MC_PP_SW_SPACK, 0,
+						 &timeout);
 		if (r < 0)
 			return r;
 
@@ -1012,8 +926,9 @@ static int il_eusb_servo_position_set(il_servo_t *servo, double pos,
 			return r;
 
 		/* wait set-point ack */
-		r = sw_wait_value(servo, IL_MC_PP_SW_SPACK, IL_MC_PP_SW_SPACK,
-				  sp_timeout);
+		timeout = sp_timeout;
+		r = il_servo_base__sw_wait_value(servo, IL_MC_PP_SW_SPACK,
+						 IL_MC_PP_SW_SPACK, &timeout);
 		if (r < 0)
 			return r;
 	}
@@ -1185,7 +1100,8 @@ static int il_eusb_servo_velocity_res_get(il_servo_t *servo, uint32_t *res)
 
 static int il_eusb_servo_wait_reached(il_servo_t *servo, int timeout)
 {
-	return sw_wait_value(servo, IL_MC_SW_TR, IL_MC_SW_TR, timeout);
+	return il_servo_base__sw_wait_value(servo, IL_MC_SW_TR, IL_MC_SW_TR,
+					    &timeout);
 }
 
 /** E-USB servo operations. */
@@ -1230,6 +1146,7 @@ const il_servo_ops_t il_eusb_servo_ops = {
 	.raw_read_u64 = il_servo_base__raw_read_u64,
 	.raw_read_s64 = il_servo_base__raw_read_s64,
 	.raw_read_float = il_servo_base__raw_read_float,
+	.raw_read_str = il_servo_base__raw_read_str,
 	.read = il_servo_base__read,
 	.raw_write_u8 = il_servo_base__raw_write_u8,
 	.raw_write_s8 = il_servo_base__raw_write_s8,
@@ -1240,11 +1157,23 @@ const il_servo_ops_t il_eusb_servo_ops = {
 	.raw_write_u64 = il_servo_base__raw_write_u64,
 	.raw_write_s64 = il_servo_base__raw_write_s64,
 	.raw_write_float = il_servo_base__raw_write_float,
+	.raw_write_str = il_servo_base__raw_write_str,
 	.write = il_servo_base__write,
-	.disable = il_eusb_servo_disable,
-	.switch_on = il_eusb_servo_switch_on,
-	.enable = il_eusb_servo_enable,
-	.fault_reset = il_eusb_servo_fault_reset,
+	.read_async = il_servo_base__read_async,
+	.write_async = il_servo_base__write_async,
+	.read_batch = il_servo_base__read_batch,
+	.write_batch = il_servo_base__write_batch,
+	.reg_bind = il_servo_base__reg_bind,
+	.reg_unbind = il_servo_base__reg_unbind,
+	.reg_read = il_servo_base__reg_read,
+	.reg_write = il_servo_base__reg_write,
+	.write_behind_enable = il_servo_base__write_behind_enable,
+	.write_behind_disable = il_servo_base__write_behind_disable,
+	.write_behind_stats_get = il_servo_base__write_behind_stats_get,
+	.disable = il_servo_base__disable,
+	.switch_on = il_servo_base__switch_on,
+	.enable = il_servo_base__enable,
+	.fault_reset = il_servo_base__fault_reset,
 	.mode_get = il_eusb_servo_mode_get,
 	.mode_set = il_eusb_servo_mode_set,
 	.ol_voltage_get = il_eusb_servo_ol_voltage_get,
@@ -33,9 +33,6 @@
 /** Maximum servo id. */
 #define SERVOID_MAX		127
 
-/** PDS default timeout (ms). */
-#define PDS_TIMEOUT		1000
-
 /** Flags position offset in statusword. */
 #define FLAGS_SW_POS		10
 
@@ -59,12 +56,44 @@
 /** Radians range. */
 #define RAD_RANGE		65535
 
+/** Cache fingerprint FNV-1a offset basis. */
+#define CACHE_FP_BASIS		0xCBF29CE484222325ULL
+
+/** Cache fingerprint FNV-1a prime. */
+#define CACHE_FP_PRIME		0x100000001B3ULL
+
+/** Configuration cache record. */
+typedef struct {
+	/** Configuration. */
+	il_servo_cfg_t cfg;
+	/** Information. */
+	il_servo_info_t info;
+	/** Information available flag. */
+	int has_info;
+} il_eusb_servo_cache_rec_t;
+
+/** Configuration cache state. */
+typedef struct {
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** Fingerprint available flag (cache enabled). */
+	int valid;
+	/** Serial number (record key). */
+	uint32_t serial;
+	/** Fingerprint (firmware version and configuration registers). */
+	uint64_t fp;
+	/** Record. */
+	il_eusb_servo_cache_rec_t rec;
+} il_eusb_servo_cache_t;
+
 /** IngeniaLink servo. */
 typedef struct il_eusb_servo {
 	/** Servo (parent). */
 	il_servo_t servo;
 	/** Reference counter. */
 	il_utils_refcnt_t *refcnt;
+	/** Configuration cache state. */
+	il_eusb_servo_cache_t cache;
 } il_eusb_servo_t;
 
 /** Obtain E-USB servo from parent. */
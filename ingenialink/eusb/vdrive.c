@@ -0,0 +1,910 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "vdrive.h"
+#include "../mc.h"
+#include "monitor.h"
+#include "net.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "public/ingenialink/dict.h"
+#include "ingenialink/err.h"
+#include "ingenialink/registers.h"
+#include "ingenialink/utils.h"
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+/** Built-in registers (always available). */
+static const il_reg_t *builtin_regs[] = {
+	&IL_REG_CTL_WORD,
+	&IL_REG_STS_WORD,
+	&IL_REG_OP_MODE,
+	&IL_REG_OP_MODE_DISP,
+	&IL_REG_POS_ACT,
+	&IL_REG_POS_TGT,
+	&IL_REG_VEL_ACT,
+	&IL_REG_VEL_TGT,
+	&IL_REG_TORQUE_ACT,
+	&IL_REG_TORQUE_TGT,
+};
+
+/** Target registers and their actual value counterparts. */
+static const struct {
+	/** Target register. */
+	const il_reg_t *tgt;
+	/** Actual value register. */
+	const il_reg_t *act;
+} tracked_regs[] = {
+	{ &IL_REG_OP_MODE, &IL_REG_OP_MODE_DISP },
+	{ &IL_REG_POS_TGT, &IL_REG_POS_ACT },
+	{ &IL_REG_VEL_TGT, &IL_REG_VEL_ACT },
+	{ &IL_REG_TORQUE_TGT, &IL_REG_TORQUE_ACT },
+};
+
+/**
+ * Obtain current (monotonic) time in microseconds.
+ */
+static long long now_us(void)
+{
+	osal_timespec_t ts;
+
+	(void)osal_clock_gettime(&ts);
+
+	return (long long)ts.s * 1000000 + ts.ns / OSAL_CLOCK_NANOSPERUSEC;
+}
+
+/**
+ * Find a register.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] address
+ *	Address.
+ * @param [in] offset
+ *	Segment offset.
+ * @param [out] pos
+ *	Where register position (or insertion position if not found) will be
+ *	stored.
+ *
+ * @return
+ *	Register (NULL if not found).
+ */
+static il_eusb_vdrive_reg_t *reg_find(il_eusb_vdrive_t *this,
+				      uint32_t address, uint16_t offset,
+				      size_t *pos)
+{
+	size_t lo = 0, hi = this->regs_cnt;
+
+	/* segments are stored as independent registers */
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if ((this->regs[mid].address < address) ||
+		    ((this->regs[mid].address == address) &&
+		     (this->regs[mid].offset < offset)))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	*pos = lo;
+
+	if ((lo < this->regs_cnt) && (this->regs[lo].address == address) &&
+	    (this->regs[lo].offset == offset))
+		return &this->regs[lo];
+
+	return NULL;
+}
+
+/**
+ * Set register contents (register is created if it does not exist).
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] address
+ *	Address.
+ * @param [in] offset
+ *	Segment offset.
+ * @param [in] data
+ *	Data (NULL to zero).
+ * @param [in] sz
+ *	Data size.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int reg_set(il_eusb_vdrive_t *this, uint32_t address, uint16_t offset,
+		   const void *data, size_t sz)
+{
+	il_eusb_vdrive_reg_t *reg;
+	size_t pos;
+
+	if (sz > IL_EUSB_FRAME_MAX_DATA_SZ) {
+		ilerr__set("Data size is too large");
+		return IL_EINVAL;
+	}
+
+	reg = reg_find(this, address, offset, &pos);
+	if (!reg) {
+		if (this->regs_cnt == this->regs_sz) {
+			il_eusb_vdrive_reg_t *regs;
+			size_t regs_sz;
+
+			regs_sz = this->regs_sz ? this->regs_sz * 2 : 64;
+			regs = realloc(this->regs, regs_sz * sizeof(*regs));
+			if (!regs) {
+				ilerr__set("Registers allocation failed");
+				return IL_ENOMEM;
+			}
+
+			this->regs = regs;
+			this->regs_sz = regs_sz;
+		}
+
+		memmove(&this->regs[pos + 1], &this->regs[pos],
+			(this->regs_cnt - pos) * sizeof(*this->regs));
+		this->regs_cnt++;
+
+		reg = &this->regs[pos];
+		reg->address = address;
+		reg->offset = offset;
+	}
+
+	reg->sz = sz;
+	if (data)
+		memcpy(reg->data, data, sz);
+	else
+		memset(reg->data, 0, sz);
+
+	return 0;
+}
+
+/**
+ * Obtain register contents as an unsigned value.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] address
+ *	Address.
+ *
+ * @return
+ *	Value (lower 32 bits, 0 if the register does not exist).
+ */
+static uint32_t reg_get(il_eusb_vdrive_t *this, uint32_t address)
+{
+	il_eusb_vdrive_reg_t *reg;
+	size_t pos, i;
+	uint32_t val = 0;
+
+	reg = reg_find(this, address, 0, &pos);
+	if (!reg)
+		return 0;
+
+	/* data is stored as transmitted (little endian) */
+	for (i = 0; i < MIN(reg->sz, sizeof(val)); i++)
+		val |= (uint32_t)reg->data[i] << (8 * i);
+
+	return val;
+}
+
+/**
+ * Set register contents from an unsigned value.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] address
+ *	Address.
+ * @param [in] val
+ *	Value.
+ * @param [in] sz
+ *	Register size (up to 4 bytes).
+ */
+static void reg_set_val(il_eusb_vdrive_t *this, uint32_t address,
+			uint32_t val, size_t sz)
+{
+	uint8_t data[sizeof(val)];
+	size_t i;
+
+	for (i = 0; i < sz; i++)
+		data[i] = (uint8_t)(val >> (8 * i));
+
+	(void)reg_set(this, address, 0, data, sz);
+}
+
+/**
+ * Seed registers.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] dict_f
+ *	Dictionary file (optional).
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int regs_seed(il_eusb_vdrive_t *this, const char *dict_f)
+{
+	int r = 0;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(builtin_regs); i++) {
+		r = reg_set(this, builtin_regs[i]->address, 0, NULL,
+			    il_utils__reg_sz(builtin_regs[i]->dtype));
+		if (r < 0)
+			return r;
+	}
+
+	r = reg_set(this, UARTCFG_ID_ADDRESS, 0, &this->id, sizeof(this->id));
+	if (r < 0)
+		return r;
+
+	reg_set_val(this, IL_REG_MONITOR_RESULT_SZ.address, VDRIVE_MONITOR_SZ,
+		    sizeof(uint16_t));
+
+	if (dict_f) {
+		il_dict_t *dict;
+		const char **ids;
+
+		dict = il_dict_create(dict_f);
+		if (!dict)
+			return IL_EFAIL;
+
+		ids = il_dict_reg_ids_get(dict);
+		for (i = 0; ids && ids[i] && (r == 0); i++) {
+			const il_reg_t *reg;
+			size_t pos;
+
+			if (il_dict_reg_get(dict, ids[i], &reg) < 0)
+				continue;
+
+			/* keep built-in registers */
+			if (reg_find(this, reg->address, 0, &pos))
+				continue;
+
+			r = reg_set(this, reg->address, 0, NULL,
+				    il_utils__reg_sz(reg->dtype));
+		}
+
+		if (ids)
+			il_dict_reg_ids_destroy(ids);
+
+		il_dict_destroy(dict);
+	}
+
+	return r;
+}
+
+/**
+ * Queue a frame for transmission.
+ *
+ * @note
+ *	Lock must be held. Frames are transmitted in order, after the
+ *	configured latency (plus jitter) has elapsed.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] address
+ *	Address.
+ * @param [in] offset
+ *	Segment offset.
+ * @param [in] data
+ *	Data.
+ * @param [in] sz
+ *	Data size.
+ */
+static void tx_queue(il_eusb_vdrive_t *this, uint32_t address,
+		     uint16_t offset, const void *data, size_t sz)
+{
+	il_eusb_vdrive_tx_t *tx;
+	long long t;
+	static const uint8_t empty;
+
+	/* drop if full (as a real drive would on overflow) */
+	if (CIRC_SPACE(this->head, this->tail, VDRIVE_QUEUE_SZ) == 0)
+		return;
+
+	tx = &this->queue[this->head];
+
+	/* frames with data are flagged as responses */
+	(void)il_eusb_frame__init_seg(&tx->frame, this->id, address, offset,
+				      data ? data : &empty, sz);
+
+	t = now_us() + this->latency;
+	if (this->jitter > 0)
+		t += (long long)(il_utils__rnd(&this->seed) %
+				 (uint32_t)(2 * this->jitter + 1)) -
+		     this->jitter;
+
+	if (t < this->t_last)
+		t = this->t_last;
+
+	tx->t = t;
+	this->t_last = t;
+
+	this->head = (this->head + 1) & (VDRIVE_QUEUE_SZ - 1);
+	osal_cond_signal(this->cond);
+}
+
+/**
+ * Update the statusword, notifying changes.
+ *
+ * @note
+ *	Lock must be held.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] sw
+ *	New statusword.
+ */
+static void sw_update(il_eusb_vdrive_t *this, uint16_t sw)
+{
+	uint16_t sw_;
+
+	if (sw == this->sw)
+		return;
+
+	this->sw = sw;
+
+	sw_ = __swap_be_16(sw);
+	(void)reg_set(this, STATUSWORD_ADDRESS, 0, &sw_, sizeof(sw_));
+	tx_queue(this, STATUSWORD_ADDRESS, 0, &sw_, sizeof(sw_));
+}
+
+/**
+ * Run the power drive system state machine on a new controlword.
+ *
+ * @note
+ *	Lock must be held. Transitions are immediate.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] cw
+ *	Controlword.
+ */
+static void pds_update(il_eusb_vdrive_t *this, uint16_t cw)
+{
+	uint16_t sw = this->sw;
+	uint16_t state;
+	int dv, qs, sd, so, eo;
+
+	/* decode command */
+	dv = !(cw & IL_MC_CW_EV);
+	qs = (cw & (IL_MC_CW_EV | IL_MC_CW_QS)) == IL_MC_CW_EV;
+	sd = (cw & (IL_MC_CW_SO | IL_MC_CW_EV | IL_MC_CW_QS)) ==
+	     (IL_MC_CW_EV | IL_MC_CW_QS);
+	so = (cw & (IL_MC_CW_SO | IL_MC_CW_EV | IL_MC_CW_QS | IL_MC_CW_EO)) ==
+	     IL_MC_PDS_CMD_SO;
+	eo = (cw & IL_MC_PDS_CMD_EO) == IL_MC_PDS_CMD_EO;
+
+	/* transition */
+	if ((sw & IL_MC_PDS_STA_F_MSK) == IL_MC_PDS_STA_F) {
+		state = IL_MC_PDS_STA_F;
+		if ((cw & IL_MC_CW_FR) && !(this->cw & IL_MC_CW_FR))
+			state = IL_MC_PDS_STA_SOD;
+	} else if ((sw & IL_MC_PDS_STA_SOD_MSK) == IL_MC_PDS_STA_SOD) {
+		state = sd ? IL_MC_PDS_STA_RTSO : IL_MC_PDS_STA_SOD;
+	} else if ((sw & IL_MC_PDS_STA_QSA_MSK) == IL_MC_PDS_STA_QSA) {
+		if (dv)
+			state = IL_MC_PDS_STA_SOD;
+		else if (eo)
+			state = IL_MC_PDS_STA_OE;
+		else
+			state = IL_MC_PDS_STA_QSA;
+	} else if ((sw & IL_MC_PDS_STA_OE_MSK) == IL_MC_PDS_STA_OE) {
+		if (dv)
+			state = IL_MC_PDS_STA_SOD;
+		else if (qs)
+			state = IL_MC_PDS_STA_QSA;
+		else if (sd)
+			state = IL_MC_PDS_STA_RTSO;
+		else if (so)
+			state = IL_MC_PDS_STA_SO;
+		else
+			state = IL_MC_PDS_STA_OE;
+	} else {
+		/* ready to switch on, switched on */
+		if (dv || qs)
+			state = IL_MC_PDS_STA_SOD;
+		else if (sd)
+			state = IL_MC_PDS_STA_RTSO;
+		else if (eo)
+			state = IL_MC_PDS_STA_OE;
+		else if (so)
+			state = IL_MC_PDS_STA_SO;
+		else
+			state = sw & IL_MC_PDS_STA_SO_MSK;
+	}
+
+	sw &= ~(IL_MC_PDS_STA_F_MSK | IL_MC_SW_QS | IL_MC_SW_VE |
+		IL_MC_SW_TR | IL_MC_PP_SW_SPACK);
+	sw |= state;
+
+	if ((state != IL_MC_PDS_STA_SOD) && (state != IL_MC_PDS_STA_F))
+		sw |= IL_MC_SW_VE;
+
+	/* targets are reached immediately, set-points acknowledged */
+	if (state == IL_MC_PDS_STA_OE) {
+		sw |= IL_MC_SW_TR;
+		if (cw & IL_MC_PP_CW_NEWSP)
+			sw |= IL_MC_PP_SW_SPACK;
+	}
+
+	this->cw = cw;
+	sw_update(this, sw);
+}
+
+/**
+ * Raise an emergency (drive enters fault state).
+ *
+ * @note
+ *	Lock must be held.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] data
+ *	Emergency code (as transmitted).
+ * @param [in] sz
+ *	Emergency code size.
+ */
+static void emcy_raise(il_eusb_vdrive_t *this, const void *data, size_t sz)
+{
+	uint16_t sw;
+
+	tx_queue(this, EMCY_ADDRESS, 0, data, sz);
+
+	sw = this->sw & ~(IL_MC_PDS_STA_F_MSK | IL_MC_SW_QS | IL_MC_SW_VE |
+			  IL_MC_SW_TR | IL_MC_PP_SW_SPACK);
+	sw_update(this, sw | IL_MC_PDS_STA_F);
+}
+
+/**
+ * Sample a monitor channel from the register store.
+ *
+ * @note
+ *	Lock must be held.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] ch
+ *	Channel.
+ *
+ * @return
+ *	Sample (0 if the channel is not mapped).
+ */
+static int32_t monitor_sample(il_eusb_vdrive_t *this, int ch)
+{
+	static const il_reg_t *map_regs[] = {
+		&IL_REG_MONITOR_MAP_CH_1,
+		&IL_REG_MONITOR_MAP_CH_2,
+		&IL_REG_MONITOR_MAP_CH_3,
+		&IL_REG_MONITOR_MAP_CH_4
+	};
+
+	uint32_t mapping, address, val;
+
+	mapping = reg_get(this, map_regs[ch]->address);
+	if (!mapping)
+		return 0;
+
+	address = IL_EUSB_FRAME_ADDR((mapping >> MAPPING_IDX_OFFSET) & 0xFFFF,
+				     (mapping >> MAPPING_SIDX_OFFSET) & 0xFF);
+	val = reg_get(this, address);
+
+	/* sign extend narrow registers */
+	switch (mapping & 0xFF) {
+	case 8:
+		return (int8_t)val;
+	case 16:
+		return (int16_t)val;
+	default:
+		return (int32_t)val;
+	}
+}
+
+/**
+ * Fill the monitor result buffer up to the current time.
+ *
+ * @note
+ *	Lock must be held. Triggers are not emulated: acquisition starts when
+ *	the monitor is enabled, and samples due since the last update take the
+ *	current register values.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ */
+static void monitor_update(il_eusb_vdrive_t *this)
+{
+	il_eusb_vdrive_monitor_t *monitor = &this->monitor;
+	long long period, due;
+	int ch;
+
+	if (!monitor->enabled)
+		return;
+
+	period = (long long)reg_get(this, IL_REG_MONITOR_CFG_T_S.address) *
+		 BASE_PERIOD;
+	if (period <= 0)
+		period = BASE_PERIOD;
+
+	due = MIN((now_us() - monitor->t0) / period, VDRIVE_MONITOR_SZ);
+
+	for (; (long long)monitor->filled < due; monitor->filled++) {
+		for (ch = 0; ch < IL_MONITOR_CH_NUM; ch++)
+			monitor->samples[monitor->filled][ch] =
+				monitor_sample(this, ch);
+	}
+
+	reg_set_val(this, IL_REG_MONITOR_RESULT_FILLED.address,
+		    (uint32_t)monitor->filled, sizeof(uint16_t));
+}
+
+/**
+ * Process a monitor register write.
+ *
+ * @note
+ *	Lock must be held. Register contents have already been stored.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] address
+ *	Address.
+ */
+static void monitor_write(il_eusb_vdrive_t *this, uint32_t address)
+{
+	static const il_reg_t *result_regs[] = {
+		&IL_REG_MONITOR_RESULT_CH_1,
+		&IL_REG_MONITOR_RESULT_CH_2,
+		&IL_REG_MONITOR_RESULT_CH_3,
+		&IL_REG_MONITOR_RESULT_CH_4
+	};
+
+	il_eusb_vdrive_monitor_t *monitor = &this->monitor;
+
+	if (address == IL_REG_MONITOR_CFG_ENABLE.address) {
+		int enabled;
+
+		enabled = reg_get(this, address) != 0;
+
+		/* enable (0 -> 1) restarts the acquisition */
+		if (enabled && !monitor->enabled) {
+			monitor->t0 = now_us();
+			monitor->filled = 0;
+			reg_set_val(this, IL_REG_MONITOR_RESULT_FILLED.address,
+				    0, sizeof(uint16_t));
+		} else if (!enabled) {
+			monitor_update(this);
+		}
+
+		monitor->enabled = enabled;
+	} else if (address == IL_REG_MONITOR_RESULT_ENTRY.address) {
+		uint32_t entry;
+		int ch;
+
+		/* expose the selected entry on the result registers */
+		entry = reg_get(this, address);
+
+		for (ch = 0; ch < IL_MONITOR_CH_NUM; ch++) {
+			int32_t sample = 0;
+
+			if (entry < monitor->filled)
+				sample = monitor->samples[entry][ch];
+
+			reg_set_val(this, result_regs[ch]->address,
+				    (uint32_t)sample, sizeof(sample));
+		}
+	}
+}
+
+/**
+ * Process a write request.
+ *
+ * @note
+ *	Lock must be held.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] address
+ *	Address.
+ * @param [in] offset
+ *	Segment offset.
+ * @param [in] data
+ *	Data.
+ * @param [in] sz
+ *	Data size.
+ */
+static void process_write(il_eusb_vdrive_t *this, uint32_t address,
+			  uint16_t offset, const void *data, size_t sz)
+{
+	size_t i;
+
+	/* further segments are just stored */
+	if (offset > 0) {
+		(void)reg_set(this, address, offset, data, sz);
+		return;
+	}
+
+	/* statusword is read-only */
+	if (address == STATUSWORD_ADDRESS)
+		return;
+
+	/* writing an emergency code injects a fault */
+	if (address == EMCY_ADDRESS) {
+		emcy_raise(this, data, sz);
+		return;
+	}
+
+	(void)reg_set(this, address, 0, data, sz);
+
+	if ((address == IL_REG_MONITOR_CFG_ENABLE.address) ||
+	    (address == IL_REG_MONITOR_RESULT_ENTRY.address)) {
+		monitor_write(this, address);
+		return;
+	}
+
+	if ((address == IL_REG_CTL_WORD.address) && (sz == sizeof(uint16_t))) {
+		uint16_t cw;
+
+		memcpy(&cw, data, sizeof(cw));
+		pds_update(this, __swap_be_16(cw));
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(tracked_regs); i++) {
+		if (address != tracked_regs[i].tgt->address)
+			continue;
+
+		/* modes are always displayed, targets reached if enabled */
+		if ((tracked_regs[i].tgt == &IL_REG_OP_MODE) ||
+		    ((this->sw & IL_MC_PDS_STA_OE_MSK) == IL_MC_PDS_STA_OE))
+			(void)reg_set(this, tracked_regs[i].act->address, 0,
+				      data, sz);
+		break;
+	}
+}
+
+/**
+ * Process a frame.
+ *
+ * @note
+ *	Lock must be held.
+ *
+ * @param [in] this
+ *	Virtual drive.
+ * @param [in] frame
+ *	Frame (complete).
+ */
+static void process_frame(il_eusb_vdrive_t *this, const uint8_t *frame)
+{
+	uint8_t id;
+	uint32_t address;
+	uint16_t offset;
+
+	id = il_eusb_frame__raw_get_id(frame);
+	if ((id != this->id) && (id != 0))
+		return;
+
+	address = il_eusb_frame__raw_get_address(frame);
+	offset = il_eusb_frame__raw_get_offset(frame);
+
+	/* requests carrying data (PROT set) are writes, reads otherwise */
+	if (il_eusb_frame__raw_is_resp(frame)) {
+		process_write(this, address, offset,
+			      il_eusb_frame__raw_get_data(frame),
+			      il_eusb_frame__raw_get_sz(frame));
+	} else {
+		il_eusb_vdrive_reg_t *reg;
+		size_t pos;
+
+		if (address == IL_REG_MONITOR_RESULT_FILLED.address)
+			monitor_update(this);
+
+		/* unknown registers answer with no data (read as zero) */
+		reg = reg_find(this, address, offset, &pos);
+		if (reg)
+			tx_queue(this, address, offset, reg->data, reg->sz);
+		else
+			tx_queue(this, address, offset, NULL, 0);
+	}
+}
+
+/**
+ * Transmission thread.
+ *
+ * @param [in] args
+ *	Virtual drive (il_eusb_vdrive_t *).
+ */
+static int vdrive_td(void *args)
+{
+	il_eusb_vdrive_t *this = args;
+
+	osal_mutex_lock(this->lock);
+
+	while (!this->stop) {
+		il_eusb_vdrive_tx_t *tx;
+		il_eusb_frame_t frame;
+		long long remaining;
+
+		if (this->head == this->tail) {
+			(void)osal_cond_wait(this->cond, this->lock, 0);
+			continue;
+		}
+
+		/* wait for the frame transmission time */
+		tx = &this->queue[this->tail];
+
+		remaining = tx->t - now_us();
+		if (remaining >= 1000) {
+			(void)osal_cond_wait(this->cond, this->lock,
+					     (int)(remaining / 1000));
+			continue;
+		} else if (remaining > 0) {
+			/* queued frames are never earlier, no need to wake */
+			osal_mutex_unlock(this->lock);
+			osal_clock_sleep_us((int)remaining);
+			osal_mutex_lock(this->lock);
+			continue;
+		}
+
+		frame = tx->frame;
+		this->tail = (this->tail + 1) & (VDRIVE_QUEUE_SZ - 1);
+
+		osal_mutex_unlock(this->lock);
+		this->on_tx(this->ctx, frame.buf, frame.sz);
+		osal_mutex_lock(this->lock);
+	}
+
+	osal_mutex_unlock(this->lock);
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Internal
+ ******************************************************************************/
+
+il_eusb_vdrive_t *il_eusb_vdrive__create(uint8_t id,
+					 const il_net_virtual_opts_t *opts,
+					 il_eusb_vdrive_on_tx_t on_tx,
+					 void *ctx)
+{
+	il_eusb_vdrive_t *this;
+	int r;
+	uint16_t sw;
+
+	this = calloc(1, sizeof(*this));
+	if (!this) {
+		ilerr__set("Virtual drive allocation failed");
+		return NULL;
+	}
+
+	this->id = id;
+	this->on_tx = on_tx;
+	this->ctx = ctx;
+	this->seed = 0x9E3779B9U ^ id;
+
+	if (opts) {
+		this->latency = opts->latency > 0 ? opts->latency : 0;
+		this->jitter = opts->jitter > 0 ? opts->jitter : 0;
+	}
+
+	r = regs_seed(this, opts ? opts->dict : NULL);
+	if (r < 0)
+		goto cleanup_regs;
+
+	/* power-up state: switch on disabled, initial angle determined */
+	this->sw = IL_MC_PDS_STA_SOD | IL_MC_SW_IANGLE;
+	sw = __swap_be_16(this->sw);
+	(void)reg_set(this, STATUSWORD_ADDRESS, 0, &sw, sizeof(sw));
+
+	this->lock = osal_mutex_create();
+	if (!this->lock) {
+		ilerr__set("Virtual drive lock allocation failed");
+		goto cleanup_regs;
+	}
+
+	this->cond = osal_cond_create();
+	if (!this->cond) {
+		ilerr__set("Virtual drive condition variable allocation failed");
+		goto cleanup_lock;
+	}
+
+	this->td = osal_thread_create(vdrive_td, this);
+	if (!this->td) {
+		ilerr__set("Virtual drive thread creation failed");
+		goto cleanup_cond;
+	}
+
+	return this;
+
+cleanup_cond:
+	osal_cond_destroy(this->cond);
+
+cleanup_lock:
+	osal_mutex_destroy(this->lock);
+
+cleanup_regs:
+	free(this->regs);
+	free(this);
+
+	return NULL;
+}
+
+void il_eusb_vdrive__destroy(il_eusb_vdrive_t *vdrive)
+{
+	osal_mutex_lock(vdrive->lock);
+	vdrive->stop = 1;
+	osal_cond_signal(vdrive->cond);
+	osal_mutex_unlock(vdrive->lock);
+
+	osal_thread_join(vdrive->td, NULL);
+
+	osal_cond_destroy(vdrive->cond);
+	osal_mutex_destroy(vdrive->lock);
+	free(vdrive->regs);
+	free(vdrive);
+}
+
+int il_eusb_vdrive__write(il_eusb_vdrive_t *vdrive, const void *buf,
+			  size_t sz)
+{
+	const uint8_t *buf_ = buf;
+
+	osal_mutex_lock(vdrive->lock);
+
+	while (sz > 0) {
+		size_t n, pos = 0;
+
+		n = MIN(sz, sizeof(vdrive->rbuf) - vdrive->rbuf_cnt);
+		memcpy(&vdrive->rbuf[vdrive->rbuf_cnt], buf_, n);
+		vdrive->rbuf_cnt += n;
+		buf_ += n;
+		sz -= n;
+
+		for (;;) {
+			size_t start, frame_sz;
+
+			frame_sz = il_eusb_frame__find(&vdrive->rbuf[pos],
+						       vdrive->rbuf_cnt - pos,
+						       &start);
+			pos += start;
+			if (frame_sz == 0)
+				break;
+
+			process_frame(vdrive, &vdrive->rbuf[pos]);
+			pos += frame_sz;
+		}
+
+		vdrive->rbuf_cnt -= pos;
+		memmove(vdrive->rbuf, &vdrive->rbuf[pos], vdrive->rbuf_cnt);
+	}
+
+	osal_mutex_unlock(vdrive->lock);
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef VDRIVE_H_
+#define VDRIVE_H_
+
+#include "ingenialink/eusb/vdrive.h"
+
+#include "ingenialink/eusb/frame.h"
+#include "public/ingenialink/monitor.h"
+
+#include "osal/osal.h"
+
+/** Reception buffer size. */
+#define VDRIVE_RBUF_SZ		512
+
+/** Transmission queue size (must be a power of 2). */
+#define VDRIVE_QUEUE_SZ		64
+
+/** Monitor result buffer size (samples). */
+#define VDRIVE_MONITOR_SZ	1024
+
+/** Monitor (sampled from the register store at the configured period). */
+typedef struct {
+	/** Enabled flag. */
+	int enabled;
+	/** Acquisition start time (us). */
+	long long t0;
+	/** Number of filled samples. */
+	size_t filled;
+	/** Samples (per channel). */
+	int32_t samples[VDRIVE_MONITOR_SZ][IL_MONITOR_CH_NUM];
+} il_eusb_vdrive_monitor_t;
+
+/** Register. */
+typedef struct {
+	/** Address. */
+	uint32_t address;
+	/** Segment offset. */
+	uint16_t offset;
+	/** Data size. */
+	size_t sz;
+	/** Data (as transmitted). */
+	uint8_t data[IL_EUSB_FRAME_MAX_DATA_SZ];
+} il_eusb_vdrive_reg_t;
+
+/** Queued frame. */
+typedef struct {
+	/** Transmission time (us). */
+	long long t;
+	/** Frame. */
+	il_eusb_frame_t frame;
+} il_eusb_vdrive_tx_t;
+
+/** E-USB virtual drive. */
+struct il_eusb_vdrive {
+	/** Node ID. */
+	uint8_t id;
+	/** Response latency (us). */
+	int latency;
+	/** Response latency jitter (us). */
+	int jitter;
+	/** Jitter random seed. */
+	uint32_t seed;
+	/** Registers (sorted by address). */
+	il_eusb_vdrive_reg_t *regs;
+	/** Number of registers. */
+	size_t regs_cnt;
+	/** Registers capacity. */
+	size_t regs_sz;
+	/** Last controlword. */
+	uint16_t cw;
+	/** Statusword. */
+	uint16_t sw;
+	/** Monitor. */
+	il_eusb_vdrive_monitor_t monitor;
+	/** Reception buffer. */
+	uint8_t rbuf[VDRIVE_RBUF_SZ];
+	/** Reception buffer contents size. */
+	size_t rbuf_cnt;
+	/** Transmission queue. */
+	il_eusb_vdrive_tx_t queue[VDRIVE_QUEUE_SZ];
+	/** Transmission queue head. */
+	size_t head;
+	/** Transmission queue tail. */
+	size_t tail;
+	/** Last transmission time (us). */
+	long long t_last;
+	/** Transmission callback. */
+	il_eusb_vdrive_on_tx_t on_tx;
+	/** Transmission callback context. */
+	void *ctx;
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** Transmission queue condition variable. */
+	osal_cond_t *cond;
+	/** Transmission thread. */
+	osal_thread_t *td;
+	/** Stop flag. */
+	int stop;
+};
+
+#endif
@@ -30,6 +30,9 @@
 /** MCB frame CRC polynomial (16-CCITT). */
 #define MCB_CRC_POLY	0x1021
 
+/** MCB frame CRC slicing factor (bytes per table lookup round). */
+#define MCB_CRC_SLICES	4
+
 /** MCB frame size (bytes). */
 #define MCB_FRAME_SZ	12
 
@@ -35,168 +35,1071 @@
  ******************************************************************************/
 
 /**
- * Compute CRC of the given buffer.
+ * Initialize in-flight transfers table.
  *
- * @param [in] buf
- *	Buffer.
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] window
+ *	Window depth (0 to use default).
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int xfers_init(il_mcb_net_t *this, int window)
+{
+	il_mcb_net_xfers_t *xfers = &this->xfers;
+	size_t i;
+
+	if (window <= 0)
+		xfers->depth = IL_NET_WINDOW_DEF;
+	else
+		xfers->depth = MIN((size_t)window, IL_NET_WINDOW_MAX);
+
+	xfers->cnt = 0;
+	xfers->seq = 0;
+
+	xfers->lock = osal_mutex_create();
+	if (!xfers->lock) {
+		ilerr__set("Network transfers lock allocation failed");
+		return IL_ENOMEM;
+	}
+
+	xfers->avail = osal_cond_create();
+	if (!xfers->avail) {
+		ilerr__set("Network transfers condition allocation failed");
+		goto cleanup_lock;
+	}
+
+	for (i = 0; i < xfers->depth; i++) {
+		xfers->xfers[i].used = 0;
+		xfers->xfers[i].complete = 1;
+
+		xfers->xfers[i].cond = osal_cond_create();
+		if (!xfers->xfers[i].cond) {
+			ilerr__set("Network transfer condition allocation failed");
+			goto cleanup_conds;
+		}
+	}
+
+	return 0;
+
+cleanup_conds:
+	while (i--)
+		osal_cond_destroy(xfers->xfers[i].cond);
+
+	osal_cond_destroy(xfers->avail);
+
+cleanup_lock:
+	osal_mutex_destroy(xfers->lock);
+
+	return IL_ENOMEM;
+}
+
+/**
+ * De-initialize in-flight transfers table.
+ *
+ * @param [in] this
+ *	MCB Network.
+ */
+static void xfers_deinit(il_mcb_net_t *this)
+{
+	il_mcb_net_xfers_t *xfers = &this->xfers;
+	size_t i;
+
+	for (i = 0; i < xfers->depth; i++)
+		osal_cond_destroy(xfers->xfers[i].cond);
+
+	osal_cond_destroy(xfers->avail);
+	osal_mutex_destroy(xfers->lock);
+}
+
+/**
+ * Obtain the number of in-flight transfers usable by a priority class.
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] prio
+ *	Priority class.
+ *
+ * @returns
+ *	Number of usable transfers.
+ */
+static size_t xfers_limit(il_mcb_net_t *this, il_net_prio_t prio)
+{
+	if ((prio == IL_NET_PRIO_BULK) && (this->xfers.depth > 1))
+		return this->xfers.depth - 1;
+
+	return this->xfers.depth;
+}
+
+/**
+ * Release an in-flight transfer (non-threadsafe).
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] xfer
+ *	Transfer.
+ */
+static void xfer_release(il_mcb_net_t *this, il_mcb_net_xfer_t *xfer)
+{
+	xfer->used = 0;
+	xfer->complete = 1;
+	xfer->orphan = 0;
+
+	this->xfers.cnt--;
+	osal_cond_broadcast(this->xfers.avail);
+}
+
+/**
+ * Reclaim the oldest orphan transfer (non-threadsafe).
+ *
+ * @note
+ *	Used when the window is full: its response is assumed to be lost.
+ *
+ * @param [in] this
+ *	MCB Network.
+ *
+ * @returns
+ *	Non-zero if a transfer was reclaimed.
+ */
+static int xfers_reclaim(il_mcb_net_t *this)
+{
+	il_mcb_net_xfers_t *xfers = &this->xfers;
+	il_mcb_net_xfer_t *oldest = NULL;
+	size_t i;
+
+	for (i = 0; i < xfers->depth; i++) {
+		il_mcb_net_xfer_t *curr = &xfers->xfers[i];
+
+		if (!curr->used || !curr->orphan)
+			continue;
+
+		if (!oldest || ((int32_t)(curr->seq - oldest->seq) < 0))
+			oldest = curr;
+	}
+
+	if (!oldest)
+		return 0;
+
+	xfer_release(this, oldest);
+
+	return 1;
+}
+
+/**
+ * Acquire an in-flight transfer.
+ *
+ * @note
+ *	Network must be acquired for transmission by the caller, so that
+ *	transfers are sent in sequence order. The network is released while
+ *	waiting for a transfer, since owners of in-flight transfers may need
+ *	it before releasing them.
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] id
+ *	Node id (statistics).
+ * @param [in] address
+ *	Address (tag).
+ * @param [out] buf
+ *	Data output buffer (reads only).
  * @param [in] sz
- *	Buffer size (bytes).
+ *	Data buffer size.
+ * @param [in] prio
+ *	Priority class.
+ * @param [out] xfer
+ *	Where the in-flight transfer will be stored.
  *
- * @return
- *	CRC.
+ * @returns
+ *	0 on success, error code otherwise.
  */
-static uint16_t crc_calc(const uint8_t *buf, size_t sz)
+static int xfer_acquire(il_mcb_net_t *this, uint16_t id, uint16_t address,
+			void *buf, size_t sz, il_net_prio_t prio,
+			il_mcb_net_xfer_t **xfer)
 {
-	size_t pos, i;
-	uint16_t result = 0;
+	il_mcb_net_xfers_t *xfers = &this->xfers;
+
+	int r = 0;
+	size_t i;
+
+	osal_mutex_lock(xfers->lock);
+
+	/* wait until a transfer is available (reclaiming orphans first) */
+	while ((xfers->cnt >= xfers_limit(this, prio)) &&
+	       !xfers_reclaim(this)) {
+		osal_mutex_unlock(xfers->lock);
+		il_net__tx_unlock(&this->net, prio);
+
+		osal_mutex_lock(xfers->lock);
+		if (xfers->cnt >= xfers_limit(this, prio))
+			r = osal_cond_wait(xfers->avail, xfers->lock,
+					   this->net.timeout_rd);
+		osal_mutex_unlock(xfers->lock);
+
+		il_net__tx_lock(&this->net, prio);
+		osal_mutex_lock(xfers->lock);
+
+		if (r == OSAL_ETIMEDOUT) {
+			ilerr__set("No transfers available (timed out)");
+			r = IL_ETIMEDOUT;
+			goto unlock;
+		} else if (r < 0) {
+			ilerr__set("Transfer acquisition failed");
+			r = IL_EFAIL;
+			goto unlock;
+		}
+	}
+
+	for (i = 0; i < xfers->depth; i++) {
+		if (!xfers->xfers[i].used)
+			break;
+	}
+
+	*xfer = &xfers->xfers[i];
+
+	(*xfer)->used = 1;
+	(*xfer)->complete = 0;
+	(*xfer)->orphan = 0;
+	(*xfer)->address = address;
+	(*xfer)->id = id;
+	(*xfer)->buf = buf;
+	(*xfer)->sz = sz;
+	(*xfer)->cnt = 0;
+	(*xfer)->seq = xfers->seq++;
+	(*xfer)->r = 0;
+	(*xfer)->nack = 0;
+	(void)osal_clock_gettime(&(*xfer)->start);
 
-	for (pos = 0; pos < sz; pos++) {
-		result ^= (uint16_t)buf[pos] << 8;
+	xfers->cnt++;
 
-		for (i = 0; i < 8; i++) {
-			if ((result & 0x8000) != 0)
-				result = (result << 1) ^ MCB_CRC_POLY;
-			else
-				result <<= 1;
+unlock:
+	osal_mutex_unlock(xfers->lock);
+
+	return r;
+}
+
+/**
+ * Abort all in-flight transfers (e.g. on disconnection).
+ *
+ * @param [in] this
+ *	MCB Network.
+ */
+static void xfers_abort(il_mcb_net_t *this)
+{
+	il_mcb_net_xfers_t *xfers = &this->xfers;
+	size_t i;
+
+	osal_mutex_lock(xfers->lock);
+
+	for (i = 0; i < xfers->depth; i++) {
+		il_mcb_net_xfer_t *xfer = &xfers->xfers[i];
+
+		if (!xfer->used || xfer->complete)
+			continue;
+
+		if (xfer->orphan) {
+			xfer_release(this, xfer);
+			continue;
 		}
+
+		xfer->r = IL_EDISCONN;
+		xfer->complete = 1;
+		osal_cond_signal(xfer->cond);
 	}
 
-	return result;
+	osal_mutex_unlock(xfers->lock);
 }
 
+/**
+ * Send a request.
+ *
+ * @note
+ *	Network must be acquired for transmission by the caller.
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] address
+ *	Address.
+ * @param [in] data
+ *	Data (writes only).
+ * @param [in] sz
+ *	Data size (0 for reads).
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
 static int net_send(il_mcb_net_t *this, uint16_t address, const void *data,
 		    size_t sz)
 {
-	int finished = 0;
 	uint8_t cmd;
-	size_t pending_sz = sz;
+	const uint8_t *data_ = data;
+	uint8_t tx[MCB_TX_FRAMES * MCB_FRAME_SZ];
 
 	cmd = sz ? MCB_CMD_WRITE : MCB_CMD_READ;
 
-	(void)ser_flush(this->ser, SER_QUEUE_ALL);
-
-	while (!finished) {
+	/* encode frames back to back, one write per transmission buffer */
+	do {
 		int r;
-		uint8_t frame[MCB_FRAME_SZ], pending;
-		uint16_t hdr, crc;
-		size_t chunk_sz;
+		size_t chunk_sz, tx_sz;
 
-		/* header */
-		pending = (pending_sz > MCB_DATA_SZ) ? 1 : 0;
+		chunk_sz = MIN(sz, MCB_TX_FRAMES * MCB_DATA_SZ);
 
-		hdr = (address << MCB_ADDR_POS) | (cmd << MCB_CMD_POS) |
-		      (pending << MCB_PENDING_POS);
-		*(uint16_t *)&frame[MCB_HDR_H] = hdr;
+		tx_sz = il_mcb_frame__encode(tx, address, cmd, data_, chunk_sz,
+					     sz > chunk_sz);
 
-		/* data */
-		chunk_sz = MIN(pending_sz, MCB_DATA_SZ);
-		if (chunk_sz)
-			memcpy(&frame[MCB_DATA_POS], data, chunk_sz);
+		r = ser_write(this->ser, tx, tx_sz, NULL);
+		if (r < 0)
+			return ilerr__ser(r);
 
-		memset(&frame[MCB_DATA_POS + chunk_sz], 0,
-		       MCB_DATA_SZ - chunk_sz);
+		il_net__stats_add(&this->net, tx_frames, tx_sz / MCB_FRAME_SZ);
+		il_net__stats_add(&this->net, tx_bytes, tx_sz);
 
-		il_mcb_frame__swap(frame, sizeof(frame));
+		if (data_)
+			data_ += chunk_sz;
+		sz -= chunk_sz;
+	} while (sz);
 
-		/* crc */
-		crc = crc_calc(frame, MCB_PAYLOAD_SZ);
-		*(uint16_t *)&frame[MCB_CRC_H] = __swap_le_16(crc);
+	return 0;
+}
 
-		/* send frame */
-		r = ser_write(this->ser, frame, sizeof(frame), NULL);
-		if (r < 0)
-			return ilerr__ser(r);
+/**
+ * Submit a transfer.
+ *
+ * @note
+ *	Network must be acquired for transmission by the caller.
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] id
+ *	Node id (statistics).
+ * @param [in] address
+ *	Address.
+ * @param [in] write
+ *	Write flag.
+ * @param [in, out] buf
+ *	Data buffer (output for reads, input for writes).
+ * @param [in] sz
+ *	Data size.
+ * @param [in] prio
+ *	Priority class.
+ * @param [out] xfer
+ *	Where the in-flight transfer will be stored.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int xfer_submit(il_mcb_net_t *this, uint16_t id, uint16_t address,
+		       int write, void *buf, size_t sz, il_net_prio_t prio,
+		       il_mcb_net_xfer_t **xfer)
+{
+	int r;
+
+	/* writes are acknowledged with a single (empty) frame */
+	if (write)
+		r = xfer_acquire(this, id, address, NULL, 0, prio, xfer);
+	else
+		r = xfer_acquire(this, id, address, buf, sz, prio, xfer);
 
-		/* update pending */
-		pending_sz -= chunk_sz;
-		if (!pending_sz)
-			finished = 1;
+	if (r < 0)
+		return r;
+
+	r = net_send(this, address, write ? buf : NULL, write ? sz : 0);
+	if (r < 0) {
+		osal_mutex_lock(this->xfers.lock);
+		xfer_release(this, *xfer);
+		osal_mutex_unlock(this->xfers.lock);
 	}
 
-	return 0;
+	return r;
 }
 
-static int net_recv(il_mcb_net_t *this, uint16_t address, uint8_t *buf,
-		    size_t sz)
+/**
+ * Detach from a transfer (unconfirmed writes).
+ *
+ * @note
+ *	The transfer is released once its response arrives (or immediately if
+ *	it already arrived).
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] xfer
+ *	Transfer.
+ */
+static void xfer_detach(il_mcb_net_t *this, il_mcb_net_xfer_t *xfer)
 {
-	int finished = 0;
-	size_t pending_sz = sz;
-
-	while (!finished) {
-		uint8_t frame[MCB_FRAME_SZ];
-		size_t block_sz = 0;
-		uint16_t crc, hdr;
-
-		/* read next frame */
-		while (block_sz < MCB_FRAME_SZ) {
-			int r;
-			size_t chunk_sz;
-
-			r = ser_read(this->ser, &frame[block_sz],
-				     sizeof(frame) - block_sz, &chunk_sz);
-			if (r == SER_EEMPTY) {
-				r = ser_read_wait(this->ser);
-				if (r < 0)
-					return ilerr__ser(r);
-			} else if (r < 0) {
-				return ilerr__ser(r);
-			} else {
-				block_sz += chunk_sz;
-			}
-		}
+	osal_mutex_lock(this->xfers.lock);
 
-		/* process frame: validate CRC, address, ACK */
-		crc = *(uint16_t *)&frame[MCB_CRC_H];
-		crc = __swap_le_16(crc);
-		if (crc_calc(frame, MCB_PAYLOAD_SZ) != crc) {
-			ilerr__set("Communications error (CRC mismatch)");
-			return IL_EIO;
+	if (xfer->complete)
+		xfer_release(this, xfer);
+	else
+		xfer->orphan = 1;
+
+	osal_mutex_unlock(this->xfers.lock);
+}
+
+/**
+ * Wait for a transfer to complete, releasing it afterwards.
+ *
+ * @note
+ *	If the transfer does not complete, it is left as an orphan so that its
+ *	late response (if any) is absorbed.
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] xfer
+ *	Transfer.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int xfer_wait(il_mcb_net_t *this, il_mcb_net_xfer_t *xfer)
+{
+	int r = 0;
+	int timeout;
+
+	timeout = il_net__timeout_rd(&this->net, xfer->id);
+
+	osal_mutex_lock(this->xfers.lock);
+
+	while (!xfer->complete) {
+		r = osal_cond_wait(xfer->cond, this->xfers.lock, timeout);
+		if (r == OSAL_ETIMEDOUT) {
+			ilerr__set("Reception timed out");
+			il_net__stats_add(&this->net, timeouts, 1);
+			il_net__timeout_backoff(&this->net, xfer->id);
+			r = IL_ETIMEDOUT;
+			break;
+		} else if (r < 0) {
+			ilerr__set("Reception failed");
+			r = IL_EFAIL;
+			break;
 		}
+	}
+
+	if (xfer->complete && (xfer->r < 0)) {
+		r = xfer->r;
+
+		if (r == IL_EDISCONN)
+			ilerr__set("Network disconnected");
+		else if (xfer->nack)
+			ilerr__set("Communications error (NACK -> %08x)",
+				   xfer->err);
+		else
+			ilerr__set("Unexpected pending data");
+	}
+
+	/* the caller buffer is no longer valid for a late response */
+	if (xfer->complete) {
+		xfer_release(this, xfer);
+	} else {
+		xfer->orphan = 1;
+		xfer->buf = NULL;
+	}
+
+	osal_mutex_unlock(this->xfers.lock);
+
+	return r;
+}
+
+/**
+ * Find a node (nodes lock must be held).
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] id
+ *	Node id.
+ *
+ * @returns
+ *	Node (NULL if not found).
+ */
+static il_mcb_net_node_t *node_find(il_mcb_net_t *this, uint16_t id)
+{
+	il_mcb_net_node_t *node;
+
+	for (node = this->nodes; node; node = node->next) {
+		if (node->id == id)
+			return node;
+	}
+
+	return NULL;
+}
+
+/**
+ * Process statusword and last error read responses.
+ *
+ * @note
+ *	Any statusword read (background poll or explicit) updates subscribers.
+ *	The last error register latches the last error, so emergencies are
+ *	notified when it changes. The first value read is only taken as a
+ *	reference.
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] id
+ *	Node id.
+ * @param [in] address
+ *	Address.
+ * @param [in] data
+ *	Response data.
+ * @param [in] sz
+ *	Response data size.
+ */
+static void process_events(il_mcb_net_t *this, uint16_t id, uint16_t address,
+			   const uint8_t *data, size_t sz)
+{
+	il_mcb_net_node_t *node;
+	int sw_valid = 0, emcy_valid = 0;
+	uint16_t sw;
+	uint32_t code;
+
+	osal_mutex_lock(this->nodes_lock);
+
+	node = node_find(this, id);
+	if (!node)
+		goto unlock;
+
+	if ((address == node->sw_addr) && (sz >= sizeof(sw))) {
+		memcpy(&sw, data, sizeof(sw));
+		sw = __swap_be_16(sw);
+		sw_valid = 1;
+	} else if ((address == node->error_addr) && (sz >= sizeof(code))) {
+		memcpy(&code, data, sizeof(code));
+		code = __swap_be_32(code);
 
-		il_mcb_frame__swap(frame, sizeof(frame));
+		emcy_valid = node->error_last_valid &&
+			     (code != node->error_last) && code;
+
+		node->error_last = code;
+		node->error_last_valid = 1;
+	}
 
-		hdr = *(uint16_t *)&frame[MCB_HDR_H];
+unlock:
+	osal_mutex_unlock(this->nodes_lock);
+
+	if (sw_valid)
+		il_net__sw_notify(&this->net, id, sw);
+	else if (emcy_valid)
+		il_net__emcy_notify(&this->net, id, code);
+}
+
+/**
+ * Process a response frame.
+ *
+ * @note
+ *	Data is streamed into the oldest in-flight transfer with a matching
+ *	address, which completes once the last chunk (no pending data) is
+ *	received. Short responses are zero-extended. Orphans older than the
+ *	answered transfer will not be answered (responses are sent in order),
+ *	so they are released.
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] hdr
+ *	Frame header.
+ * @param [in] data
+ *	Frame data.
+ */
+static void process_sync(il_mcb_net_t *this, uint16_t hdr,
+			 const uint8_t *data)
+{
+	il_mcb_net_xfers_t *xfers = &this->xfers;
+	il_mcb_net_xfer_t *xfer = NULL;
+	size_t i;
+	uint16_t address, id = 0;
+	size_t cnt = 0;
 
-		if (((hdr & MCB_CMD_MSK) >> MCB_CMD_POS) != MCB_CMD_ACK) {
-			uint32_t err;
+	address = (hdr & MCB_ADDR_MSK) >> MCB_ADDR_POS;
 
-			err = __swap_be_32(*(uint32_t *)&frame[MCB_DATA_POS]);
+	osal_mutex_lock(xfers->lock);
 
-			ilerr__set("Communications error (NACK -> %08x)", err);
-			return IL_EIO;
+	/* look for the oldest matching in-flight transfer */
+	for (i = 0; i < xfers->depth; i++) {
+		il_mcb_net_xfer_t *curr = &xfers->xfers[i];
+
+		if (!curr->used || curr->complete)
+			continue;
+
+		if (curr->address == address) {
+			if (!xfer || ((int32_t)(curr->seq - xfer->seq) < 0))
+				xfer = curr;
 		}
+	}
 
-		if (((hdr & MCB_ADDR_MSK) >> MCB_ADDR_POS) != address) {
-			ilerr__set("Communications error (bad address)");
-			return IL_EIO;
+	if (!xfer)
+		goto unlock;
+
+	for (i = 0; i < xfers->depth; i++) {
+		il_mcb_net_xfer_t *curr = &xfers->xfers[i];
+
+		if (curr->used && curr->orphan && (curr != xfer) &&
+		    ((int32_t)(curr->seq - xfer->seq) < 0))
+			xfer_release(this, curr);
+	}
+
+	if (((hdr & MCB_CMD_MSK) >> MCB_CMD_POS) != MCB_CMD_ACK) {
+		uint32_t err;
+
+		memcpy(&err, data, sizeof(err));
+
+		xfer->r = IL_EIO;
+		xfer->nack = 1;
+		xfer->err = __swap_be_32(err);
+	} else if (xfer->cnt < xfer->sz) {
+		size_t data_sz;
+
+		/* store data (discarded by orphans) */
+		data_sz = MIN(xfer->sz - xfer->cnt, MCB_DATA_SZ);
+		if (xfer->buf)
+			memcpy(&xfer->buf[xfer->cnt], data, data_sz);
+		xfer->cnt += data_sz;
+
+		if ((xfer->cnt == xfer->sz) && (hdr & MCB_PENDING_MSK))
+			xfer->r = IL_EIO;
+	}
+
+	/* last chunk: complete (writes are acknowledged by one frame) */
+	if (xfer->nack || (xfer->sz == 0) || !(hdr & MCB_PENDING_MSK)) {
+		if ((xfer->r == 0) && !xfer->orphan)
+			il_net__stats_rtt_add(&this->net, xfer->id,
+					      &xfer->start);
+
+		if (xfer->buf)
+			memset(&xfer->buf[xfer->cnt], 0, xfer->sz - xfer->cnt);
+
+		/* single chunk reads may carry events */
+		if ((xfer->r == 0) && (xfer->cnt <= MCB_DATA_SZ)) {
+			id = xfer->id;
+			cnt = xfer->cnt;
 		}
 
-		if (!pending_sz) {
-			finished = 1;
+		if (xfer->orphan) {
+			xfer_release(this, xfer);
 		} else {
-			size_t data_sz;
-
-			/* store data */
-			data_sz = MIN(pending_sz, MCB_DATA_SZ);
-			memcpy(buf, &frame[MCB_DATA_POS], data_sz);
-			buf += data_sz;
-
-			/* update pending size */
-			pending_sz -= data_sz;
-			if (!pending_sz) {
-				if (hdr & MCB_PENDING_MSK) {
-					ilerr__set("Unexpected pending data");
-					return IL_EIO;
-				}
-
-				finished = 1;
+			xfer->complete = 1;
+			osal_cond_signal(xfer->cond);
+		}
+	}
+
+unlock:
+	osal_mutex_unlock(xfers->lock);
+
+	if (cnt)
+		process_events(this, id, address, data, cnt);
+}
+
+/**
+ * Process reception buffer.
+ *
+ * @note
+ *	Frames are validated by their CRC. On mismatch, the stream is
+ *	re-synchronized byte by byte until a valid frame is found.
+ *
+ * @param [in] this
+ *	MCB Network.
+ *
+ * @returns
+ *	Number of bytes consumed.
+ */
+static size_t process_rbuf(il_mcb_net_t *this)
+{
+	size_t pos = 0;
+
+	while ((this->rbuf_cnt - pos) >= MCB_FRAME_SZ) {
+		uint16_t hdr;
+		uint8_t data[MCB_DATA_SZ];
+
+		if (il_mcb_frame__decode(&this->rbuf[pos], &hdr, data) < 0) {
+			if (!this->resync) {
+				il_net__stats_add(&this->net, crc_errors, 1);
+				il_net__stats_add(&this->net, resyncs, 1);
+				this->resync = 1;
 			}
+
+			pos++;
+			continue;
+		}
+
+		this->resync = 0;
+
+		il_net__stats_add(&this->net, rx_frames, 1);
+
+		process_sync(this, hdr, data);
+
+		pos += MCB_FRAME_SZ;
+	}
+
+	return pos;
+}
+
+/**
+ * Listener thread.
+ *
+ * @param [in] args
+ *	MCB Network (il_mcb_net_t *).
+ */
+static int listener(void *args)
+{
+	il_mcb_net_t *this = args;
+
+	while (!this->stop) {
+		int r;
+		size_t added, used;
+
+		/* read more bytes */
+		r = ser_read(this->ser, &this->rbuf[this->rbuf_cnt],
+			     sizeof(this->rbuf) - this->rbuf_cnt, &added);
+		if (r == SER_EEMPTY) {
+			r = ser_read_wait(this->ser);
+			if (r == SER_ETIMEDOUT)
+				continue;
+			else if (r < 0)
+				goto err;
+		} else if ((r < 0) || ((r == 0) && (added == 0))) {
+			goto err;
+		} else {
+			il_net__stats_add(&this->net, rx_bytes, added);
+
+			/* process buffer, keep unprocessed tail */
+			this->rbuf_cnt += added;
+			used = process_rbuf(this);
+			this->rbuf_cnt -= used;
+			memmove(this->rbuf, &this->rbuf[used], this->rbuf_cnt);
+		}
+	}
+
+	ser_close(this->ser);
+	xfers_abort(this);
+
+	return 0;
+
+err:
+	ser_close(this->ser);
+	il_net__state_set(&this->net, IL_NET_STATE_FAULTY);
+	xfers_abort(this);
+
+	return IL_EFAIL;
+}
+
+/**
+ * Start listener thread.
+ *
+ * @param [in] this
+ *	MCB Network.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int listener_start(il_mcb_net_t *this)
+{
+	il_mcb_net_node_t *node;
+
+	this->rbuf_cnt = 0;
+	this->resync = 0;
+	this->stop = 0;
+
+	osal_mutex_lock(this->nodes_lock);
+	for (node = this->nodes; node; node = node->next)
+		node->error_last_valid = 0;
+	osal_mutex_unlock(this->nodes_lock);
+
+	this->listener = osal_thread_create(listener, this);
+	if (!this->listener) {
+		ilerr__set("Listener thread creation failed");
+		return IL_EFAIL;
+	}
+
+	return 0;
+}
+
+/**
+ * Stop listener thread (closes the port).
+ *
+ * @param [in] this
+ *	MCB Network.
+ */
+static void listener_stop(il_mcb_net_t *this)
+{
+	this->stop = 1;
+	osal_thread_join(this->listener, NULL);
+}
+
+/**
+ * Add a node to the poll list.
+ *
+ * @param [in, out] ids
+ *	Node IDs (NET_SUBS_SZ entries).
+ * @param [in, out] what
+ *	Registers to poll of each node (POLL_SW, POLL_EMCY).
+ * @param [in, out] cnt
+ *	Number of nodes.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] flag
+ *	Register to poll.
+ */
+static void poll_add(uint16_t *ids, uint8_t *what, size_t *cnt, uint16_t id,
+		     uint8_t flag)
+{
+	size_t i;
+
+	for (i = 0; i < *cnt; i++) {
+		if (ids[i] == id) {
+			what[i] |= flag;
+			return;
 		}
 	}
 
+	if (*cnt < NET_SUBS_SZ) {
+		ids[*cnt] = id;
+		what[*cnt] = flag;
+		(*cnt)++;
+	}
+}
+
+/**
+ * Obtain the nodes with subscribers (poll list).
+ *
+ * @param [in] net
+ *	Network.
+ * @param [out] ids
+ *	Node IDs (NET_SUBS_SZ entries).
+ * @param [out] what
+ *	Registers to poll of each node (POLL_SW, POLL_EMCY).
+ *
+ * @return
+ *	Number of nodes.
+ */
+static size_t poll_list(il_net_t *net, uint16_t *ids, uint8_t *what)
+{
+	size_t cnt = 0;
+	int slot;
+
+	osal_mutex_lock(net->sw_subs.lock);
+	for (slot = 0; slot < net->sw_subs.sz; slot++) {
+		il_net_sw_subscriber_t *sub = net->sw_subs.slots[slot];
+
+		if (sub)
+			poll_add(ids, what, &cnt, sub->id, POLL_SW);
+	}
+	osal_mutex_unlock(net->sw_subs.lock);
+
+	osal_mutex_lock(net->emcy_subs.lock);
+	for (slot = 0; slot < net->emcy_subs.sz; slot++) {
+		il_net_emcy_subscriber_t *sub = net->emcy_subs.slots[slot];
+
+		if (sub)
+			poll_add(ids, what, &cnt, sub->id, POLL_EMCY);
+	}
+	osal_mutex_unlock(net->emcy_subs.lock);
+
+	return cnt;
+}
+
+/**
+ * Statusword/emergencies poller thread.
+ *
+ * @note
+ *	Only nodes with subscribers are polled. Responses are processed by the
+ *	listener, as any other read.
+ *
+ * @param [in] args
+ *	MCB Network (il_mcb_net_t *).
+ */
+static int poller(void *args)
+{
+	il_mcb_net_t *this = args;
+	il_net_t *net = &this->net;
+
+	osal_mutex_lock(this->poll_lock);
+
+	while (!this->poll_stop) {
+		uint16_t ids[NET_SUBS_SZ];
+		uint8_t what[NET_SUBS_SZ];
+		size_t cnt, i;
+
+		(void)osal_cond_wait(this->poll_wake, this->poll_lock,
+				     this->poll_period);
+		if (this->poll_stop)
+			break;
+
+		osal_mutex_unlock(this->poll_lock);
+
+		cnt = poll_list(net, ids, what);
+		for (i = 0; i < cnt; i++) {
+			il_mcb_net_node_t *node;
+			uint32_t sw_addr, error_addr;
+			uint8_t buf[4];
+
+			if (il_net_state_get(net) != IL_NET_STATE_CONNECTED)
+				break;
+
+			/* nodes without known registers are not polled */
+			osal_mutex_lock(this->nodes_lock);
+			node = node_find(this, ids[i]);
+			sw_addr = node ? node->sw_addr : NODE_ADDR_NONE;
+			error_addr = node ? node->error_addr : NODE_ADDR_NONE;
+			osal_mutex_unlock(this->nodes_lock);
+
+			if ((what[i] & POLL_SW) && (sw_addr != NODE_ADDR_NONE))
+				(void)il_net__read(net, ids[i], sw_addr, buf,
+						   sizeof(uint16_t),
+						   IL_NET_PRIO_CTL);
+
+			if ((what[i] & POLL_EMCY) &&
+			    (error_addr != NODE_ADDR_NONE))
+				(void)il_net__read(net, ids[i], error_addr, buf,
+						   sizeof(uint32_t),
+						   IL_NET_PRIO_CTL);
+		}
+
+		osal_mutex_lock(this->poll_lock);
+	}
+
+	osal_mutex_unlock(this->poll_lock);
+
 	return 0;
 }
 
+/**
+ * Initialize statusword/emergencies poller.
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] period
+ *	Poll period (ms, 0 to use default, negative to disable).
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int poller_init(il_mcb_net_t *this, int period)
+{
+	this->poller = NULL;
+
+	if (period < 0)
+		return 0;
+
+	this->poll_period = period ? period : IL_NET_SW_POLL_DEF;
+	this->poll_stop = 0;
+
+	this->poll_lock = osal_mutex_create();
+	if (!this->poll_lock) {
+		ilerr__set("Poller lock allocation failed");
+		return IL_ENOMEM;
+	}
+
+	this->poll_wake = osal_cond_create();
+	if (!this->poll_wake) {
+		ilerr__set("Poller condition allocation failed");
+		goto cleanup_lock;
+	}
+
+	this->poller = osal_thread_create(poller, this);
+	if (!this->poller) {
+		ilerr__set("Poller thread creation failed");
+		goto cleanup_wake;
+	}
+
+	return 0;
+
+cleanup_wake:
+	osal_cond_destroy(this->poll_wake);
+
+cleanup_lock:
+	osal_mutex_destroy(this->poll_lock);
+
+	return IL_EFAIL;
+}
+
+/**
+ * De-initialize statusword/emergencies poller.
+ *
+ * @param [in] this
+ *	MCB Network.
+ */
+static void poller_deinit(il_mcb_net_t *this)
+{
+	if (!this->poller)
+		return;
+
+	osal_mutex_lock(this->poll_lock);
+	this->poll_stop = 1;
+	osal_cond_signal(this->poll_wake);
+	osal_mutex_unlock(this->poll_lock);
+
+	osal_thread_join(this->poller, NULL);
+
+	osal_cond_destroy(this->poll_wake);
+	osal_mutex_destroy(this->poll_lock);
+}
+
+/**
+ * Transfer (single, synchronous).
+ *
+ * @param [in] this
+ *	MCB Network.
+ * @param [in] id
+ *	Node id (statistics).
+ * @param [in] address
+ *	Address.
+ * @param [in] write
+ *	Write flag.
+ * @param [in, out] buf
+ *	Data buffer (output for reads, input for writes).
+ * @param [in] sz
+ *	Data size.
+ * @param [in] confirmed
+ *	Wait for the write acknowledge (writes only).
+ * @param [in] prio
+ *	Priority class.
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int net_transfer(il_mcb_net_t *this, uint16_t id, uint16_t address,
+			int write, void *buf, size_t sz, int confirmed,
+			il_net_prio_t prio)
+{
+	int r;
+	il_mcb_net_xfer_t *xfer;
+
+	if (il_net_state_get(&this->net) != IL_NET_STATE_CONNECTED) {
+		ilerr__set("Network is not connected");
+		return IL_ESTATE;
+	}
+
+	il_net__tx_lock(&this->net, prio);
+	r = xfer_submit(this, id, address, write, buf, sz, prio, &xfer);
+	il_net__tx_unlock(&this->net, prio);
+
+	if (r < 0)
+		return r;
+
+	if (write && !confirmed) {
+		xfer_detach(this, xfer);
+		return 0;
+	}
+
+	return xfer_wait(this, xfer);
+}
+
+/**
+ * De-initialize nodes events registers.
+ *
+ * @param [in] this
+ *	MCB Network.
+ */
+static void nodes_deinit(il_mcb_net_t *this)
+{
+	il_mcb_net_node_t *node, *next;
+
+	for (node = this->nodes; node; node = next) {
+		next = node->next;
+		free(node);
+	}
+
+	osal_mutex_destroy(this->nodes_lock);
+}
+
 /**
  * Monitor event callback.
  */
@@ -220,11 +1123,17 @@ static void mcb_net_destroy(void *ctx)
 {
 	il_mcb_net_t *this = ctx;
 
+	poller_deinit(this);
+
 	if (il_net_state_get(&this->net) != IL_NET_STATE_DISCONNECTED)
-		ser_close(this->ser);
+		listener_stop(this);
 
 	ser_destroy(this->ser);
 
+	nodes_deinit(this);
+
+	xfers_deinit(this);
+
 	il_net_base__deinit(&this->net);
 
 	free(this);
@@ -248,49 +1157,105 @@ static void il_mcb_net__release(il_net_t *net)
 	il_utils__refcnt_release(this->refcnt);
 }
 
-static int il_mcb_net__read(il_net_t *net, uint16_t id, uint32_t address,
-			    void *buf, size_t sz)
+int il_mcb_net__node_set(il_net_t *net, uint16_t id, uint32_t sw_addr,
+			 uint32_t error_addr)
 {
 	il_mcb_net_t *this = to_mcb_net(net);
+	il_mcb_net_node_t *node;
+	int r = 0;
+
+	osal_mutex_lock(this->nodes_lock);
+
+	node = node_find(this, id);
+	if (!node) {
+		node = malloc(sizeof(*node));
+		if (!node) {
+			ilerr__set("Network node allocation failed");
+			r = IL_ENOMEM;
+			goto unlock;
+		}
 
-	int r;
-
-	(void)id;
-
-	osal_mutex_lock(this->net.lock);
-
-	r = net_send(this, (uint16_t)address, NULL, 0);
-	if (r < 0)
-		goto unlock;
+		node->id = id;
+		node->next = this->nodes;
+		this->nodes = node;
+	}
 
-	r = net_recv(this, (uint16_t)address, buf, sz);
+	node->sw_addr = sw_addr;
+	node->error_addr = error_addr;
+	node->error_last_valid = 0;
 
 unlock:
-	osal_mutex_unlock(this->net.lock);
+	osal_mutex_unlock(this->nodes_lock);
 
 	return r;
 }
 
+static int il_mcb_net__read(il_net_t *net, uint16_t id, uint32_t address,
+			    void *buf, size_t sz, il_net_prio_t prio)
+{
+	il_mcb_net_t *this = to_mcb_net(net);
+
+	return net_transfer(this, id, (uint16_t)address, 0, buf, sz, 1, prio);
+}
+
 static int il_mcb_net__write(il_net_t *net, uint16_t id, uint32_t address,
-			     const void *buf, size_t sz, int confirmed)
+			     const void *buf, size_t sz, int confirmed,
+			     il_net_prio_t prio)
 {
 	il_mcb_net_t *this = to_mcb_net(net);
 
-	int r;
+	return net_transfer(this, id, (uint16_t)address, 1, (void *)buf, sz,
+			    confirmed, prio);
+}
 
-	(void)id;
-	(void)confirmed;
+static int il_mcb_net__transfer_batch(il_net_t *net, il_net_xfer_t *xfers,
+				      size_t cnt, il_net_prio_t prio)
+{
+	il_mcb_net_t *this = to_mcb_net(net);
 
-	osal_mutex_lock(this->net.lock);
+	int r = 0;
+	size_t head = 0, tail = 0, limit;
+	il_mcb_net_xfer_t *inflight[IL_NET_WINDOW_MAX];
 
-	r = net_send(this, (uint16_t)address, buf, sz);
-	if (r < 0)
-		goto unlock;
+	if (il_net_state_get(&this->net) != IL_NET_STATE_CONNECTED) {
+		ilerr__set("Network is not connected");
+		return IL_ESTATE;
+	}
 
-	r = net_recv(this, (uint16_t)address, NULL, 0);
+	limit = xfers_limit(this, prio);
+
+	/* keep the window full: submit ahead, collect in order */
+	while (tail < cnt) {
+		il_net__tx_lock(&this->net, prio);
+
+		while ((head < cnt) && ((head - tail) < limit)) {
+			il_net_xfer_t *curr = &xfers[head];
+
+			curr->r = xfer_submit(this, curr->id,
+					      (uint16_t)curr->address,
+					      curr->write, curr->buf, curr->sz,
+					      prio, &inflight[head % limit]);
+			if (curr->r < 0) {
+				inflight[head % limit] = NULL;
+			/* unconfirmed writes: not waited for */
+			} else if (curr->write && !curr->confirmed) {
+				xfer_detach(this, inflight[head % limit]);
+				inflight[head % limit] = NULL;
+			}
 
-unlock:
-	osal_mutex_unlock(this->net.lock);
+			head++;
+		}
+
+		il_net__tx_unlock(&this->net, prio);
+
+		if (inflight[tail % limit])
+			xfers[tail].r = xfer_wait(this, inflight[tail % limit]);
+
+		if ((xfers[tail].r < 0) && (r == 0))
+			r = xfers[tail].r;
+
+		tail++;
+	}
 
 	return r;
 }
@@ -323,17 +1288,34 @@ static il_net_t *il_mcb_net_create(const il_net_opts_t *opts)
 	if (!this->refcnt)
 		goto cleanup_net;
 
+	/* initialize in-flight transfers */
+	r = xfers_init(this, opts->window);
+	if (r < 0)
+		goto cleanup_refcnt;
+
+	/* initialize nodes events registers */
+	this->nodes_lock = osal_mutex_create();
+	if (!this->nodes_lock) {
+		ilerr__set("Network nodes lock allocation failed");
+		goto cleanup_xfers;
+	}
+
+	/* start statusword/emergencies poller */
+	r = poller_init(this, opts->sw_poll);
+	if (r < 0)
+		goto cleanup_nodes;
+
 	/* allocate serial port */
 	this->ser = ser_create();
 	if (!this->ser) {
 		ilerr__set("Serial port allocation failed (%s)", sererr_last());
-		goto cleanup_refcnt;
+		goto cleanup_poller;
 	}
 
 	/* open serial port */
 	this->sopts.port = il_net_port_get(&this->net);
 	this->sopts.baudrate = BAUDRATE_DEF;
-	this->sopts.timeouts.rd = opts->timeout_rd;
+	this->sopts.timeouts.rd = SER_POLL_TIMEOUT;
 	this->sopts.timeouts.wr = opts->timeout_wr;
 
 	r = il_net_connect(&this->net);
@@ -345,6 +1327,15 @@ static il_net_t *il_mcb_net_create(const il_net_opts_t *opts)
 cleanup_ser:
 	ser_destroy(this->ser);
 
+cleanup_poller:
+	poller_deinit(this);
+
+cleanup_nodes:
+	nodes_deinit(this);
+
+cleanup_xfers:
+	xfers_deinit(this);
+
 cleanup_refcnt:
 	il_utils__refcnt_destroy(this->refcnt);
 
@@ -367,11 +1358,20 @@ static void il_mcb_net_destroy(il_net_t *net)
 static int il_mcb_net_connect(il_net_t *net)
 {
 	int r;
+	il_net_state_t state;
+
 	il_mcb_net_t *this = to_mcb_net(net);
 
-	if (il_net_state_get(&this->net) == IL_NET_STATE_CONNECTED) {
+	/* check state, proceed only if not connected */
+	state = il_net_state_get(&this->net);
+	if (state == IL_NET_STATE_CONNECTED) {
 		ilerr__set("Network already connected");
 		return IL_EALREADY;
+	} else if (state == IL_NET_STATE_FAULTY) {
+		/* free resources if faulty */
+		listener_stop(this);
+
+		il_net__state_set(&this->net, IL_NET_STATE_DISCONNECTED);
 	}
 
 	r = ser_open(this->ser, &this->sopts);
@@ -380,8 +1380,19 @@ static int il_mcb_net_connect(il_net_t *net)
 		return IL_EFAIL;
 	}
 
+	/* discard stale data (once, requests are not flushed) */
+	(void)ser_flush(this->ser, SER_QUEUE_ALL);
+
 	il_net__state_set(&this->net, IL_NET_STATE_CONNECTED);
 
+	/* start reception */
+	r = listener_start(this);
+	if (r < 0) {
+		ser_close(this->ser);
+		il_net__state_set(&this->net, IL_NET_STATE_DISCONNECTED);
+		return r;
+	}
+
 	return 0;
 }
 
@@ -390,7 +1401,8 @@ static void il_mcb_net_disconnect(il_net_t *net)
 	il_mcb_net_t *this = to_mcb_net(net);
 
 	if (il_net_state_get(&this->net) != IL_NET_STATE_DISCONNECTED) {
-		ser_close(this->ser);
+		listener_stop(this);
+
 		il_net__state_set(&this->net, IL_NET_STATE_DISCONNECTED);
 	}
 }
@@ -403,7 +1415,8 @@ static il_net_servos_list_t *il_mcb_net_servos_list_get(
 	il_net_servos_list_t *lst;
 
 	/* try to read the vendor id register to see if a servo is alive */
-	r = il_net__read(net, 1, VENDOR_ID_ADDR, &vid, sizeof(vid));
+	r = il_net__read(net, 1, VENDOR_ID_ADDR, &vid, sizeof(vid),
+			 IL_NET_PRIO_BULK);
 	if (r < 0)
 		return NULL;
 
@@ -524,6 +1537,11 @@ const il_net_ops_t il_mcb_net_ops = {
 	._state_set = il_net_base__state_set,
 	._read = il_mcb_net__read,
 	._write = il_mcb_net__write,
+	._read_async = il_net_base__read_async,
+	._write_async = il_net_base__write_async,
+	._transfer_batch = il_mcb_net__transfer_batch,
+	._read_segmented = il_net_base__read_segmented,
+	._write_segmented = il_net_base__write_segmented,
 	._sw_subscribe = il_net_base__sw_subscribe,
 	._sw_unsubscribe = il_net_base__sw_unsubscribe,
 	._emcy_subscribe = il_net_base__emcy_subscribe,
@@ -26,6 +26,7 @@
 #define MCB_NET_H_
 
 #include "../net.h"
+#include "frame.h"
 
 #include "ingenialink/utils.h"
 
@@ -40,6 +41,108 @@
 /** Vendor ID register address. */
 #define VENDOR_ID_ADDR		0x0010
 
+/** Node register not available. */
+#define NODE_ADDR_NONE		UINT32_MAX
+
+/** Poll the node statusword. */
+#define POLL_SW			0x01
+
+/** Poll the node last error. */
+#define POLL_EMCY		0x02
+
+/** Maximum number of frames per transmission. */
+#define MCB_TX_FRAMES		8
+
+/** Serial port read poll timeout (ms). */
+#define SER_POLL_TIMEOUT	100
+
+/** Reception buffer size. */
+#define RBUF_SZ			(32 * MCB_FRAME_SZ)
+
+/** In-flight transfer. */
+typedef struct {
+	/** Used flag. */
+	int used;
+	/** Completed flag. */
+	int complete;
+	/**
+	 * Orphan flag: nobody waits for the response (unconfirmed write, or
+	 * timed out transfer), which is absorbed when it arrives.
+	 */
+	int orphan;
+	/** Address (tag). */
+	uint16_t address;
+	/** Node ID (statistics). */
+	uint16_t id;
+	/** Buffer. */
+	uint8_t *buf;
+	/** Buffer size. */
+	size_t sz;
+	/** Received data size. */
+	size_t cnt;
+	/** Sequence number (transmission order). */
+	uint32_t seq;
+	/** Result (error code). */
+	int r;
+	/** NACK flag. */
+	int nack;
+	/** NACK error code. */
+	uint32_t err;
+	/** Completed condition variable. */
+	osal_cond_t *cond;
+	/** Submission time (statistics). */
+	osal_timespec_t start;
+} il_mcb_net_xfer_t;
+
+/**
+ * In-flight transfers table.
+ *
+ * @note
+ *	Responses are tagged by address. If multiple transfers match, the
+ *	oldest one (lowest sequence number) is served first, as the drive
+ *	answers in order. Multi-chunk responses are streamed into the transfer
+ *	buffer as frames arrive. Frames carry no sequence number, so timed out
+ *	transfers are kept as orphans until their late response arrives (or a
+ *	newer transfer is answered), so that it does not complete the next
+ *	transfer with the same address.
+ */
+typedef struct {
+	/** Transfers. */
+	il_mcb_net_xfer_t xfers[IL_NET_WINDOW_MAX];
+	/** Window depth (usable transfers). */
+	size_t depth;
+	/** Number of transfers in use. */
+	size_t cnt;
+	/** Next sequence number. */
+	uint32_t seq;
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** Transfer available condition variable. */
+	osal_cond_t *avail;
+} il_mcb_net_xfers_t;
+
+/**
+ * Node events registers and state.
+ *
+ * @note
+ *	Register addresses are resolved from the servo dictionary, MCB drives
+ *	have no fixed statusword or last error addresses.
+ */
+typedef struct il_mcb_net_node {
+	/** Node ID. */
+	uint16_t id;
+	/** Statusword register address (NODE_ADDR_NONE if not available). */
+	uint32_t sw_addr;
+	/** Last error register address (NODE_ADDR_NONE if not available). */
+	uint32_t error_addr;
+	/** Last error register value (emergencies are notified on change). */
+	uint32_t error_last;
+	/** Last error register value valid flag. */
+	int error_last_valid;
+	/** Next node. */
+	struct il_mcb_net_node *next;
+} il_mcb_net_node_t;
+
 /** MCB network. */
 typedef struct il_mcb_net {
 	/** Network (parent). */
@@ -50,6 +153,32 @@ typedef struct il_mcb_net {
 	ser_t *ser;
 	/** Serial communications options. */
 	ser_opts_t sopts;
+	/** Listener thread. */
+	osal_thread_t *listener;
+	/** Listener stop flag. */
+	int stop;
+	/** Reception buffer. */
+	uint8_t rbuf[RBUF_SZ];
+	/** Reception buffer contents size. */
+	size_t rbuf_cnt;
+	/** Resynchronization flag (looking for a valid frame). */
+	int resync;
+	/** In-flight transfers. */
+	il_mcb_net_xfers_t xfers;
+	/** Statusword/emergencies poller thread (NULL if disabled). */
+	osal_thread_t *poller;
+	/** Poller period (ms). */
+	int poll_period;
+	/** Poller stop flag. */
+	int poll_stop;
+	/** Poller lock. */
+	osal_mutex_t *poll_lock;
+	/** Poller wake up condition variable (stop). */
+	osal_cond_t *poll_wake;
+	/** Nodes events registers and state. */
+	il_mcb_net_node_t *nodes;
+	/** Nodes lock. */
+	osal_mutex_t *nodes_lock;
 } il_mcb_net_t;
 
 /** MCB network device monitor */
@@ -72,4 +201,26 @@ typedef struct il_mcb_net_dev_mon {
 /** Obtain MCB Network device monitor from parent. */
 #define to_mcb_mon(ptr) container_of(ptr, struct il_mcb_net_dev_mon, mon)
 
+/**
+ * Set the events registers of a node.
+ *
+ * @note
+ *	Statusword and last error reads of the node (background polls or
+ *	explicit reads) are then notified to subscribers.
+ *
+ * @param [in] net
+ *	IngeniaLink network.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] sw_addr
+ *	Statusword register address (NODE_ADDR_NONE if not available).
+ * @param [in] error_addr
+ *	Last error register address (NODE_ADDR_NONE if not available).
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+int il_mcb_net__node_set(il_net_t *net, uint16_t id, uint32_t sw_addr,
+			 uint32_t error_addr);
+
 #endif
@@ -23,6 +23,8 @@
  */
 
 #include "servo.h"
+#include "net.h"
+#include "../mc.h"
 
 #include <string.h>
 
@@ -40,6 +42,36 @@ static int not_supported(void)
 	return IL_ENOTSUP;
 }
 
+/**
+ * Register the node events registers (statusword, last error) in the network.
+ *
+ * @note
+ *	Registers are resolved from the dictionary, so events are not
+ *	available until a dictionary with them is loaded.
+ *
+ * @param [in] servo
+ *	IngeniaLink servo.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int events_regs_set(il_servo_t *servo)
+{
+	const il_reg_t *reg;
+	uint32_t sw_addr = NODE_ADDR_NONE, error_addr = NODE_ADDR_NONE;
+
+	if (servo->dict) {
+		if (il_dict_reg_get(servo->dict, STATUSWORD_ID, &reg) == 0)
+			sw_addr = reg->address;
+
+		if (il_dict_reg_get(servo->dict, ERROR_LAST_ID, &reg) == 0)
+			error_addr = reg->address;
+	}
+
+	return il_mcb_net__node_set(servo->net, servo->id, sw_addr,
+				    error_addr);
+}
+
 /**
  * Destroy servo instance.
  *
@@ -85,9 +117,27 @@ void il_mcb_servo__release(il_servo_t *servo)
 void il_mcb_servo__state_decode(uint16_t sw, il_servo_state_t *state,
 				int *flags)
 {
-	(void)sw;
-	(void)state;
-	(void)flags;
+	if ((sw & IL_MC_PDS_STA_NRTSO_MSK) == IL_MC_PDS_STA_NRTSO)
+		*state = IL_SERVO_STATE_NRDY;
+	else if ((sw & IL_MC_PDS_STA_SOD_MSK) == IL_MC_PDS_STA_SOD)
+		*state = IL_SERVO_STATE_DISABLED;
+	else if ((sw & IL_MC_PDS_STA_RTSO_MSK) == IL_MC_PDS_STA_RTSO)
+		*state = IL_SERVO_STATE_RDY;
+	else if ((sw & IL_MC_PDS_STA_SO_MSK) == IL_MC_PDS_STA_SO)
+		*state = IL_SERVO_STATE_ON;
+	else if ((sw & IL_MC_PDS_STA_OE_MSK) == IL_MC_PDS_STA_OE)
+		*state = IL_SERVO_STATE_ENABLED;
+	else if ((sw & IL_MC_PDS_STA_QSA_MSK) == IL_MC_PDS_STA_QSA)
+		*state = IL_SERVO_STATE_QSTOP;
+	else if ((sw & IL_MC_PDS_STA_FRA_MSK) == IL_MC_PDS_STA_FRA)
+		*state = IL_SERVO_STATE_FAULTR;
+	else if ((sw & IL_MC_PDS_STA_F_MSK) == IL_MC_PDS_STA_F)
+		*state = IL_SERVO_STATE_FAULT;
+	else
+		*state = IL_SERVO_STATE_NRDY;
+
+	if (flags)
+		*flags = (int)(sw >> FLAGS_SW_POS);
 }
 
 /*******************************************************************************
@@ -100,6 +150,7 @@ static il_servo_t *il_mcb_servo_create(il_net_t *net, uint16_t id,
 	int r;
 
 	il_mcb_servo_t *this;
+	uint16_t sw;
 
 	/* allocate servo */
 	this = malloc(sizeof(*this));
@@ -114,11 +165,24 @@ static il_servo_t *il_mcb_servo_create(il_net_t *net, uint16_t id,
 
 	this->servo.ops = &il_mcb_servo_ops;
 
+	/* PDS: statusword is read back after commands (no pushed updates) */
+	this->servo.pds.cw_id = CONTROLWORD_ID;
+	this->servo.pds.sw_id = STATUSWORD_ID;
+
+	r = events_regs_set(&this->servo);
+	if (r < 0)
+		goto cleanup_base;
+
 	/* initialize, setup refcnt */
 	this->refcnt = il_utils__refcnt_create(servo_destroy, this);
 	if (!this->refcnt)
 		goto cleanup_base;
 
+	/* trigger status update (with manual read) */
+	if (this->servo.dict)
+		(void)il_servo_base__sw_read(&this->servo, NULL, STATUSWORD_ID,
+					     &sw);
+
 	return &this->servo;
 
 cleanup_base:
@@ -144,6 +208,24 @@ static int il_mcb_servo_reset(il_servo_t *servo)
 	return not_supported();
 }
 
+static int il_mcb_servo_dict_load(il_servo_t *servo, const char *dict)
+{
+	int r;
+	uint16_t sw;
+
+	r = il_servo_base__dict_load(servo, dict);
+	if (r < 0)
+		return r;
+
+	r = events_regs_set(servo);
+	if (r < 0)
+		return r;
+
+	(void)il_servo_base__sw_read(servo, NULL, STATUSWORD_ID, &sw);
+
+	return 0;
+}
+
 static int il_mcb_servo_name_get(il_servo_t *servo, char *name, size_t sz)
 {
 	(void)servo;
@@ -203,42 +285,13 @@ static int il_mcb_servo_units_update(il_servo_t *servo)
 	return not_supported();
 }
 
-static double il_mcb_servo_units_factor(il_servo_t *servo, const il_reg_t *reg)
-{
-	(void)servo;
-	(void)reg;
-
-	return not_supported();
-}
-
-static int il_mcb_servo_disable(il_servo_t *servo)
-{
-	(void)servo;
-
-	return not_supported();
-}
-
-static int il_mcb_servo_switch_on(il_servo_t *servo, int timeout)
-{
-	(void)servo;
-	(void)timeout;
-
-	return not_supported();
-}
-
-static int il_mcb_servo_enable(il_servo_t *servo, int timeout)
-{
-	(void)servo;
-	(void)timeout;
-
-	return not_supported();
-}
-
-static int il_mcb_servo_fault_reset(il_servo_t *servo)
+static double il_mcb_servo_units_factor(il_servo_t *servo, il_reg_phy_t phy)
 {
 	(void)servo;
+	(void)phy;
 
-	return not_supported();
+	/* no units support: native */
+	return 1.;
 }
 
 static int il_mcb_servo_mode_get(il_servo_t *servo, il_servo_mode_t *mode)
@@ -397,7 +450,7 @@ const il_servo_ops_t il_mcb_servo_ops = {
 	.emcy_subscribe = il_servo_base__emcy_subscribe,
 	.emcy_unsubscribe = il_servo_base__emcy_unsubscribe,
 	.dict_get = il_servo_base__dict_get,
-	.dict_load = il_servo_base__dict_load,
+	.dict_load = il_mcb_servo_dict_load,
 	.name_get = il_mcb_servo_name_get,
 	.name_set = il_mcb_servo_name_set,
 	.info_get = il_mcb_servo_info_get,
@@ -423,6 +476,7 @@ const il_servo_ops_t il_mcb_servo_ops = {
 	.raw_read_u64 = il_servo_base__raw_read_u64,
 	.raw_read_s64 = il_servo_base__raw_read_s64,
 	.raw_read_float = il_servo_base__raw_read_float,
+	.raw_read_str = il_servo_base__raw_read_str,
 	.read = il_servo_base__read,
 	.raw_write_u8 = il_servo_base__raw_write_u8,
 	.raw_write_s8 = il_servo_base__raw_write_s8,
@@ -433,11 +487,23 @@ const il_servo_ops_t il_mcb_servo_ops = {
 	.raw_write_u64 = il_servo_base__raw_write_u64,
 	.raw_write_s64 = il_servo_base__raw_write_s64,
 	.raw_write_float = il_servo_base__raw_write_float,
+	.raw_write_str = il_servo_base__raw_write_str,
 	.write = il_servo_base__write,
-	.disable = il_mcb_servo_disable,
-	.switch_on = il_mcb_servo_switch_on,
-	.enable = il_mcb_servo_enable,
-	.fault_reset = il_mcb_servo_fault_reset,
+	.read_async = il_servo_base__read_async,
+	.write_async = il_servo_base__write_async,
+	.read_batch = il_servo_base__read_batch,
+	.write_batch = il_servo_base__write_batch,
+	.reg_bind = il_servo_base__reg_bind,
+	.reg_unbind = il_servo_base__reg_unbind,
+	.reg_read = il_servo_base__reg_read,
+	.reg_write = il_servo_base__reg_write,
+	.write_behind_enable = il_servo_base__write_behind_enable,
+	.write_behind_disable = il_servo_base__write_behind_disable,
+	.write_behind_stats_get = il_servo_base__write_behind_stats_get,
+	.disable = il_servo_base__disable,
+	.switch_on = il_servo_base__switch_on,
+	.enable = il_servo_base__enable,
+	.fault_reset = il_servo_base__fault_reset,
 	.mode_get = il_mcb_servo_mode_get,
 	.mode_set = il_mcb_servo_mode_set,
 	.ol_voltage_get = il_mcb_servo_ol_voltage_get,
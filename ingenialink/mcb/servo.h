@@ -27,6 +27,18 @@
 
 #include "../servo.h"
 
+/** Flags position offset in statusword. */
+#define FLAGS_SW_POS		10
+
+/** Controlword register ID (dictionary). */
+#define CONTROLWORD_ID		"DRV_STATE_CONTROL"
+
+/** Statusword register ID (dictionary). */
+#define STATUSWORD_ID		"DRV_STATE_STATUS"
+
+/** Last error register ID (dictionary). */
+#define ERROR_LAST_ID		"DRV_DIAG_ERROR_LAST"
+
 /** IngeniaLink servo. */
 typedef struct il_mcb_servo {
 	/** Servo (parent). */
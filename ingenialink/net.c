@@ -24,9 +24,668 @@
 
 #include "net.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "ingenialink/err.h"
+#ifdef IL_HAS_PROT_EUSB
+#include "ingenialink/registers.h"
+#endif
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+/** Network whose events are being delivered by the calling thread. */
+static thread_local il_net_t *delivering;
+
+/**
+ * Queue a subscriber event.
+ *
+ * @param [in] evts
+ *	Events queue.
+ * @param [in] type
+ *	Event type.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] value
+ *	Event value.
+ *
+ * @return
+ *	0 on success, IL_EFAIL if the queue is full.
+ */
+static int events_push(il_net_evts_t *evts, il_net_evt_type_t type,
+		       uint16_t id, uint32_t value)
+{
+	il_net_evt_t *evt;
+	uint32_t pos;
+
+	pos = osal_atomic_load_u32(&evts->head);
+	for (;;) {
+		int32_t dif;
+
+		evt = &evts->evts[pos & (NET_EVTS_SZ - 1)];
+		dif = (int32_t)(osal_atomic_load_u32(&evt->seq) - pos);
+
+		/* slot free: claim position (pos updated if lost) */
+		if (dif == 0) {
+			if (osal_atomic_cas_u32(&evts->head, &pos, pos + 1))
+				break;
+		/* slot not consumed yet: queue is full */
+		} else if (dif < 0) {
+			return IL_EFAIL;
+		/* position claimed by another producer */
+		} else {
+			pos = osal_atomic_load_u32(&evts->head);
+		}
+	}
+
+	evt->type = type;
+	evt->id = id;
+	evt->value = value;
+
+	/* publish */
+	osal_atomic_store_u32(&evt->seq, pos + 1);
+
+	return 0;
+}
+
+/**
+ * Coalesce a statusword update.
+ *
+ * @note
+ *	Once a node statusword is coalesced, newer updates of the node replace
+ *	it until it is delivered, so that they are never delivered out of
+ *	order. Nodes share a slot if their IDs have the same low byte, which
+ *	can only hold one of them at a time.
+ *
+ * @param [in] evts
+ *	Events queue.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] sw
+ *	Statusword.
+ * @param [in] force
+ *	Coalesce even if there is no pending coalesced statusword.
+ *
+ * @return
+ *	0 if coalesced, IL_EFAIL otherwise.
+ */
+static int events_sw_coalesce(il_net_evts_t *evts, uint16_t id, uint32_t sw,
+			      int force)
+{
+	volatile uint32_t *slot = &evts->sw[NET_SUBS_BUCKET(id)];
+	uint32_t prev, tag;
+
+	tag = ((uint32_t)(id >> 8) << NET_EVT_SW_ID_POS) | NET_EVT_SW_PENDING;
+
+	prev = osal_atomic_load_u32(slot);
+	do {
+		if (prev & NET_EVT_SW_PENDING) {
+			/* slot in use by another node */
+			if ((prev & ~0xFFFFU) != tag)
+				return IL_EFAIL;
+		} else if (!force) {
+			return IL_EFAIL;
+		}
+	} while (!osal_atomic_cas_u32(slot, &prev, (sw & 0xFFFF) | tag));
+
+	osal_atomic_store_u32(&evts->sw_coalesced, 1);
+
+	return 0;
+}
+
+/**
+ * Dequeue a subscriber event.
+ *
+ * @note
+ *	Must be called with the consumer lock held.
+ *
+ * @param [in] evts
+ *	Events queue.
+ * @param [out] evt
+ *	Where the event will be stored.
+ *
+ * @return
+ *	0 on success, IL_EFAIL if the queue is empty.
+ */
+static int events_pop(il_net_evts_t *evts, il_net_evt_t *evt)
+{
+	il_net_evt_t *slot;
+
+	slot = &evts->evts[evts->tail & (NET_EVTS_SZ - 1)];
+	if ((int32_t)(osal_atomic_load_u32(&slot->seq) - (evts->tail + 1)) < 0)
+		return IL_EFAIL;
+
+	evt->type = slot->type;
+	evt->id = slot->id;
+	evt->value = slot->value;
+
+	/* release slot for the next lap */
+	osal_atomic_store_u32(&slot->seq, evts->tail + NET_EVTS_SZ);
+	evts->tail++;
+
+	return 0;
+}
+
+/**
+ * Check if there are pending subscriber events.
+ *
+ * @param [in] evts
+ *	Events queue.
+ *
+ * @return
+ *	Non-zero if there are pending events.
+ */
+static int events_pending(il_net_evts_t *evts)
+{
+	il_net_evt_t *slot;
+
+	slot = &evts->evts[evts->tail & (NET_EVTS_SZ - 1)];
+
+	return ((int32_t)(osal_atomic_load_u32(&slot->seq) -
+			  (evts->tail + 1)) >= 0) ||
+	       osal_atomic_load_u32(&evts->sw_coalesced);
+}
+
+/**
+ * Free subscribers unsubscribed from callbacks.
+ *
+ * @note
+ *	Must be called from the events context once the delivery has
+ *	completed, so that no delivery can be using them.
+ *
+ * @param [in] net
+ *	Network.
+ */
+static void events_retired_free(il_net_t *net)
+{
+	il_net_sw_subscriber_t *sw_sub;
+	il_net_emcy_subscriber_t *emcy_sub;
+
+	while (net->sw_subs.retired) {
+		sw_sub = net->sw_subs.retired;
+		net->sw_subs.retired = sw_sub->retired_next;
+		free(sw_sub);
+	}
+
+	while (net->emcy_subs.retired) {
+		emcy_sub = net->emcy_subs.retired;
+		net->emcy_subs.retired = emcy_sub->retired_next;
+		free(emcy_sub);
+	}
+}
+
+/**
+ * Deliver a subscriber event.
+ *
+ * @note
+ *	Subscribers are looked up without locking. The reader epoch is odd
+ *	while callbacks run, so that unsubscribed entries are only freed once
+ *	no delivery can be using them. Callbacks may unsubscribe (e.g. destroy
+ *	a servo): the calling thread is marked as delivering the network
+ *	events, so that unsubscribed entries are retired instead of waiting
+ *	for this very delivery, and freed once it completes.
+ *
+ * @param [in] net
+ *	Network.
+ * @param [in] evt
+ *	Event.
+ */
+static void events_deliver(il_net_t *net, const il_net_evt_t *evt)
+{
+	il_net_t *delivering_ = delivering;
+
+	delivering = net;
+
+	if (evt->type == NET_EVT_SW) {
+		il_net_sw_subscriber_lst_t *subs = &net->sw_subs;
+		il_net_sw_subscriber_t *sub;
+
+		osal_atomic_store_u32(&subs->epoch, subs->epoch + 1);
+
+		sub = osal_atomic_load_ptr((void *volatile *)&subs->subs[
+			NET_SUBS_BUCKET(evt->id)]);
+		for (; sub; sub = osal_atomic_load_ptr(
+				    (void *volatile *)&sub->next)) {
+			if ((sub->id == evt->id) &&
+			    !osal_atomic_load_u32(&sub->retired))
+				sub->cb(sub->ctx, (uint16_t)evt->value);
+		}
+
+		osal_atomic_store_u32(&subs->epoch, subs->epoch + 1);
+	} else {
+		il_net_emcy_subscriber_lst_t *subs = &net->emcy_subs;
+		il_net_emcy_subscriber_t *sub;
+
+		osal_atomic_store_u32(&subs->epoch, subs->epoch + 1);
+
+		sub = osal_atomic_load_ptr((void *volatile *)&subs->subs[
+			NET_SUBS_BUCKET(evt->id)]);
+		for (; sub; sub = osal_atomic_load_ptr(
+				    (void *volatile *)&sub->next)) {
+			if ((sub->id == evt->id) &&
+			    !osal_atomic_load_u32(&sub->retired))
+				sub->cb(sub->ctx, evt->value);
+		}
+
+		osal_atomic_store_u32(&subs->epoch, subs->epoch + 1);
+	}
+
+	delivering = delivering_;
+
+	events_retired_free(net);
+}
+
+/**
+ * Deliver coalesced statuswords.
+ *
+ * @note
+ *	Must be called with the consumer lock held, once the queue is empty
+ *	(queued statuswords of a node are older than its coalesced one).
+ *
+ * @param [in] net
+ *	Network.
+ *
+ * @return
+ *	Number of delivered events.
+ */
+static int events_sw_flush(il_net_t *net)
+{
+	il_net_evts_t *evts = net->evts;
+	il_net_evt_t evt;
+	uint32_t i, sw;
+	int n = 0;
+
+	if (!osal_atomic_load_u32(&evts->sw_coalesced))
+		return 0;
+
+	osal_atomic_store_u32(&evts->sw_coalesced, 0);
+
+	evt.type = NET_EVT_SW;
+	for (i = 0; i < NET_SUBS_SZ; i++) {
+		sw = osal_atomic_load_u32(&evts->sw[i]);
+		while (sw & NET_EVT_SW_PENDING) {
+			if (osal_atomic_cas_u32(&evts->sw[i], &sw,
+						sw & ~NET_EVT_SW_PENDING)) {
+				evt.id = (uint16_t)(
+					((sw >> NET_EVT_SW_ID_POS) << 8) | i);
+				evt.value = sw & 0xFFFF;
+				events_deliver(net, &evt);
+				n++;
+				break;
+			}
+		}
+	}
+
+	return n;
+}
+
+/**
+ * Deliver pending subscriber events.
+ *
+ * @note
+ *	At most one queue length of events is delivered, so that it returns
+ *	even if producers are faster than subscribers. Coalesced statuswords
+ *	are delivered once the queue has been emptied.
+ *
+ * @param [in] net
+ *	Network.
+ *
+ * @return
+ *	Number of delivered events.
+ */
+static int events_process(il_net_t *net)
+{
+	il_net_evts_t *evts = net->evts;
+	il_net_evt_t evt;
+	int n = 0;
+
+	osal_mutex_lock(evts->consumer);
+
+	while (n < NET_EVTS_SZ) {
+		if (events_pop(evts, &evt) < 0) {
+			n += events_sw_flush(net);
+			break;
+		}
+
+		events_deliver(net, &evt);
+		n++;
+	}
+
+	osal_mutex_unlock(evts->consumer);
+
+	il_net__stats_add(net, events, n);
+
+	return n;
+}
+
+/**
+ * Subscriber events dispatcher.
+ *
+ * @note
+ *	Sleeps until events are queued (or the dispatcher is stopped), so an
+ *	idle network causes no wake-ups.
+ *
+ * @param [in] args
+ *	Network.
+ */
+static int events_dispatcher(void *args)
+{
+	il_net_t *net = args;
+	il_net_evts_t *evts = net->evts;
+
+	while (!osal_atomic_load_u32(&evts->stop)) {
+		if (events_process(net) > 0)
+			continue;
+
+		osal_mutex_lock(evts->lock);
+		if (!osal_atomic_load_u32(&evts->stop) &&
+		    !events_pending(evts))
+			(void)osal_cond_wait(evts->avail, evts->lock, 0);
+		osal_mutex_unlock(evts->lock);
+	}
+
+	return 0;
+}
+
+/**
+ * Queue a subscriber event and wake up the dispatcher.
+ *
+ * @note
+ *	Statusword updates are never dropped: if the queue is full (or the
+ *	node has a pending coalesced statusword) the latest one is coalesced.
+ *
+ * @param [in] net
+ *	Network.
+ * @param [in] type
+ *	Event type.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] value
+ *	Event value.
+ */
+static void events_notify(il_net_t *net, il_net_evt_type_t type, uint16_t id,
+			  uint32_t value)
+{
+	il_net_evts_t *evts = net->evts;
+
+	if ((type == NET_EVT_SW) &&
+	    (events_sw_coalesce(evts, id, value, 0) == 0)) {
+		il_net__stats_add(net, events_coalesced, 1);
+	} else if (events_push(evts, type, id, value) < 0) {
+		if ((type == NET_EVT_SW) &&
+		    (events_sw_coalesce(evts, id, value, 1) == 0)) {
+			il_net__stats_add(net, events_coalesced, 1);
+		} else {
+			il_net__stats_add(net, events_dropped, 1);
+			return;
+		}
+	}
+
+	if (evts->mode == IL_NET_DISPATCH_THREAD) {
+		osal_mutex_lock(evts->lock);
+		osal_cond_signal(evts->avail);
+		osal_mutex_unlock(evts->lock);
+	}
+}
+
+/**
+ * Find a write-behind entry.
+ *
+ * @note
+ *	Write-behind lock must be held.
+ *
+ * @param [in] wb
+ *	Write-behind writer.
+ * @param [in] id
+ *	Node ID.
+ * @param [in] address
+ *	Address.
+ *
+ * @return
+ *	Entry (NULL if not found).
+ */
+static il_net_wb_entry_t *wb_find(il_net_wb_t *wb, uint16_t id,
+				  uint32_t address)
+{
+	il_net_wb_entry_t *entry;
+
+	for (entry = wb->entries; entry; entry = entry->next) {
+		if ((entry->id == id) && (entry->address == address))
+			return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * Obtain the next write-behind entry to be served.
+ *
+ * @note
+ *	Write-behind lock must be held.
+ *
+ * @param [in] wb
+ *	Write-behind writer.
+ *
+ * @return
+ *	Oldest pending entry (NULL if none).
+ */
+static il_net_wb_entry_t *wb_next(il_net_wb_t *wb)
+{
+	il_net_wb_entry_t *entry, *next = NULL;
+
+	for (entry = wb->entries; entry; entry = entry->next) {
+		if (entry->pending && (!next || (entry->order < next->order)))
+			next = entry;
+	}
+
+	return next;
+}
+
+/**
+ * Update write-behind entry statistics after a transmission.
+ *
+ * @note
+ *	Write-behind lock must be held.
+ *
+ * @param [in] entry
+ *	Entry.
+ * @param [in] r
+ *	Transmission result.
+ */
+static void wb_stats_update(il_net_wb_entry_t *entry, int r)
+{
+	osal_timespec_t now;
+	double dt, rate;
+
+	if (r < 0) {
+		entry->stats.errors++;
+		return;
+	}
+
+	entry->stats.writes++;
+
+	if (osal_clock_gettime(&now) < 0)
+		return;
+
+	/* effective rate: smoothed inverse of the inter-write time */
+	if (entry->last.s || entry->last.ns) {
+		dt = (double)(now.s - entry->last.s) +
+		     (double)(now.ns - entry->last.ns) / OSAL_CLOCK_NANOSPERSEC;
+		if (dt > 0.) {
+			rate = 1. / dt;
+			if (entry->stats.rate == 0.)
+				entry->stats.rate = rate;
+			else
+				entry->stats.rate += (rate - entry->stats.rate) /
+						     (1 << NET_WB_RATE_GAIN);
+		}
+	}
+
+	entry->last = now;
+}
+
+/**
+ * Write-behind writer.
+ *
+ * @param [in] args
+ *	Network.
+ */
+static int wb_writer(void *args)
+{
+	il_net_t *net = args;
+	il_net_wb_t *wb = net->wb;
+
+	osal_mutex_lock(wb->lock);
+
+	while (!wb->stop) {
+		il_net_wb_entry_t *entry;
+		uint8_t buf[NET_WB_DATA_SZ];
+		size_t sz;
+		int confirmed, r;
+
+		entry = wb_next(wb);
+		if (!entry) {
+			(void)osal_cond_wait(wb->pending, wb->lock, 0);
+			continue;
+		}
+
+		/* take the newest value, newer requests will be pending again */
+		memcpy(buf, entry->buf, entry->sz);
+		sz = entry->sz;
+		confirmed = entry->confirmed;
+
+		entry->pending = 0;
+		wb->busy = entry;
+
+		osal_mutex_unlock(wb->lock);
+
+		r = il_net__write(net, entry->id, entry->address, buf, sz,
+				  confirmed, IL_NET_PRIO_CTL);
+
+		osal_mutex_lock(wb->lock);
+
+		wb_stats_update(entry, r);
+
+		wb->busy = NULL;
+		osal_cond_broadcast(wb->idle);
+	}
+
+	osal_mutex_unlock(wb->lock);
+
+	return 0;
+}
+
+#ifdef IL_HAS_DEVMON
+
+/**
+ * Obtain the identity of a discovered node.
+ *
+ * @note
+ *	Identity registers are read in a single batch. Fields are left to zero
+ *	if not available.
+ *
+ * @param [in] net
+ *	Network.
+ * @param [in, out] node
+ *	Discovered node.
+ */
+static void discovery_identity_get(il_net_t *net, il_net_discovery_list_t *node)
+{
+#ifdef IL_HAS_PROT_EUSB
+	il_net_xfer_t xfers[2];
+	uint32_t serial, prod_code;
+
+	if (net->prot != IL_NET_PROT_EUSB)
+		return;
+
+	xfers[0].id = node->id;
+	xfers[0].address = IL_REG_ID_SERIAL.address;
+	xfers[0].buf = &serial;
+	xfers[0].sz = sizeof(serial);
+	xfers[0].write = 0;
+
+	xfers[1].id = node->id;
+	xfers[1].address = IL_REG_ID_PROD_CODE.address;
+	xfers[1].buf = &prod_code;
+	xfers[1].sz = sizeof(prod_code);
+	xfers[1].write = 0;
+
+	(void)il_net__transfer_batch(net, xfers, ARRAY_SIZE(xfers),
+				     IL_NET_PRIO_BULK);
+
+	if (xfers[0].r == 0)
+		node->serial = __swap_be_32(serial);
+
+	if (xfers[1].r == 0)
+		node->prod_code = __swap_be_32(prod_code);
+#else
+	(void)net;
+	(void)node;
+#endif
+}
+
+/**
+ * Network discovery worker.
+ *
+ * @param [in] args
+ *	Worker (il_net_discovery_worker_t *).
+ *
+ * @returns
+ *	0 on success, error code otherwise.
+ */
+static int discovery_worker(void *args)
+{
+	il_net_discovery_worker_t *worker = args;
+	il_net_discovery_t *disc = worker->disc;
+
+	il_net_opts_t opts;
+	il_net_t *net;
+	il_net_servos_list_t *ids, *id;
+
+	il_net_opts_init(&opts);
+	opts.port = worker->port;
+
+	net = il_net_create(disc->prot, &opts);
+	if (!net)
+		return IL_EFAIL;
+
+	ids = il_net_servos_list_get(net, NULL, NULL);
+	il_net_servos_list_foreach(id, ids) {
+		il_net_discovery_list_t *node, **pos;
+
+		node = calloc(1, sizeof(*node));
+		if (!node)
+			break;
+
+		strncpy(node->port, worker->port, sizeof(node->port) - 1);
+		node->id = id->id;
+
+		discovery_identity_get(net, node);
+
+		/* keep nodes ordered by id */
+		pos = &worker->lst;
+		while (*pos && ((*pos)->id < node->id))
+			pos = &(*pos)->next;
+
+		node->next = *pos;
+		*pos = node;
+
+		if (disc->on_found) {
+			osal_mutex_lock(disc->lock);
+			disc->on_found(disc->ctx, worker->port, node->id);
+			osal_mutex_unlock(disc->lock);
+		}
+	}
+
+	il_net_servos_list_destroy(ids);
+	il_net_destroy(net);
+
+	return 0;
+}
+
+#endif
 
 /*******************************************************************************
  * Internal
@@ -47,16 +706,577 @@ void il_net__state_set(il_net_t *net, il_net_state_t state)
 	net->ops->_state_set(net, state);
 }
 
+int il_net__events_init(il_net_t *net, il_net_dispatch_t mode)
+{
+	int r;
+	il_net_evts_t *evts;
+	uint32_t i;
+
+	evts = calloc(1, sizeof(*evts));
+	if (!evts) {
+		ilerr__set("Network events queue allocation failed");
+		return IL_ENOMEM;
+	}
+
+	for (i = 0; i < NET_EVTS_SZ; i++)
+		evts->evts[i].seq = i;
+
+	evts->mode = mode;
+
+	evts->consumer = osal_mutex_create();
+	if (!evts->consumer) {
+		ilerr__set("Network events consumer lock allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_evts;
+	}
+
+	evts->lock = osal_mutex_create();
+	if (!evts->lock) {
+		ilerr__set("Network events lock allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_consumer;
+	}
+
+	evts->avail = osal_cond_create();
+	if (!evts->avail) {
+		ilerr__set("Network events condition allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_lock;
+	}
+
+	net->evts = evts;
+
+	if (mode == IL_NET_DISPATCH_THREAD) {
+		evts->dispatcher = osal_thread_create(events_dispatcher, net);
+		if (!evts->dispatcher) {
+			ilerr__set("Network events dispatcher creation failed");
+			r = IL_EFAIL;
+			goto cleanup_avail;
+		}
+	}
+
+	return 0;
+
+cleanup_avail:
+	net->evts = NULL;
+	osal_cond_destroy(evts->avail);
+
+cleanup_lock:
+	osal_mutex_destroy(evts->lock);
+
+cleanup_consumer:
+	osal_mutex_destroy(evts->consumer);
+
+cleanup_evts:
+	free(evts);
+
+	return r;
+}
+
+void il_net__events_deinit(il_net_t *net)
+{
+	il_net_evts_t *evts = net->evts;
+
+	if (evts->dispatcher) {
+		osal_mutex_lock(evts->lock);
+		osal_atomic_store_u32(&evts->stop, 1);
+		osal_cond_signal(evts->avail);
+		osal_mutex_unlock(evts->lock);
+
+		osal_thread_join(evts->dispatcher, NULL);
+	}
+
+	osal_cond_destroy(evts->avail);
+	osal_mutex_destroy(evts->lock);
+	osal_mutex_destroy(evts->consumer);
+	free(evts);
+}
+
+int il_net__wb_init(il_net_t *net)
+{
+	int r;
+	il_net_wb_t *wb;
+
+	wb = calloc(1, sizeof(*wb));
+	if (!wb) {
+		ilerr__set("Network write-behind allocation failed");
+		return IL_ENOMEM;
+	}
+
+	wb->lock = osal_mutex_create();
+	if (!wb->lock) {
+		ilerr__set("Network write-behind lock allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_wb;
+	}
+
+	wb->pending = osal_cond_create();
+	if (!wb->pending) {
+		ilerr__set("Network write-behind condition allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_lock;
+	}
+
+	wb->idle = osal_cond_create();
+	if (!wb->idle) {
+		ilerr__set("Network write-behind condition allocation failed");
+		r = IL_ENOMEM;
+		goto cleanup_pending;
+	}
+
+	net->wb = wb;
+
+	return 0;
+
+cleanup_pending:
+	osal_cond_destroy(wb->pending);
+
+cleanup_lock:
+	osal_mutex_destroy(wb->lock);
+
+cleanup_wb:
+	free(wb);
+
+	return r;
+}
+
+void il_net__wb_deinit(il_net_t *net)
+{
+	il_net_wb_t *wb = net->wb;
+	il_net_wb_entry_t *entry, *next;
+
+	if (wb->writer) {
+		osal_mutex_lock(wb->lock);
+		wb->stop = 1;
+		osal_cond_signal(wb->pending);
+		osal_mutex_unlock(wb->lock);
+
+		osal_thread_join(wb->writer, NULL);
+	}
+
+	for (entry = wb->entries; entry; entry = next) {
+		next = entry->next;
+		free(entry);
+	}
+
+	osal_cond_destroy(wb->idle);
+	osal_cond_destroy(wb->pending);
+	osal_mutex_destroy(wb->lock);
+	free(wb);
+}
+
+int il_net__wb_enable(il_net_t *net, uint16_t id, uint32_t address)
+{
+	int r = 0;
+	il_net_wb_t *wb = net->wb;
+	il_net_wb_entry_t *entry;
+
+	osal_mutex_lock(wb->lock);
+
+	if (wb_find(wb, id, address)) {
+		ilerr__set("Write-behind already enabled");
+		r = IL_EALREADY;
+		goto unlock;
+	}
+
+	/* writer is only created on first use */
+	if (!wb->writer) {
+		wb->writer = osal_thread_create(wb_writer, net);
+		if (!wb->writer) {
+			ilerr__set("Network write-behind writer creation failed");
+			r = IL_EFAIL;
+			goto unlock;
+		}
+	}
+
+	entry = calloc(1, sizeof(*entry));
+	if (!entry) {
+		ilerr__set("Write-behind entry allocation failed");
+		r = IL_ENOMEM;
+		goto unlock;
+	}
+
+	entry->id = id;
+	entry->address = address;
+	entry->next = wb->entries;
+	wb->entries = entry;
+
+	osal_atomic_store_u32(&wb->cnt, wb->cnt + 1);
+
+unlock:
+	osal_mutex_unlock(wb->lock);
+
+	return r;
+}
+
+int il_net__wb_disable(il_net_t *net, uint16_t id, uint32_t address)
+{
+	int r = 0;
+	il_net_wb_t *wb = net->wb;
+	il_net_wb_entry_t *entry, **prev;
+
+	osal_mutex_lock(wb->lock);
+
+	for (prev = &wb->entries; *prev; prev = &(*prev)->next) {
+		if (((*prev)->id == id) && ((*prev)->address == address))
+			break;
+	}
+
+	entry = *prev;
+	if (!entry) {
+		osal_mutex_unlock(wb->lock);
+		ilerr__set("Write-behind not enabled");
+		return IL_EINVAL;
+	}
+
+	*prev = entry->next;
+
+	osal_atomic_store_u32(&wb->cnt, wb->cnt - 1);
+
+	/* wait for an ongoing transmission of the entry */
+	while (wb->busy == entry)
+		(void)osal_cond_wait(wb->idle, wb->lock, 0);
+
+	osal_mutex_unlock(wb->lock);
+
+	/* flush pending value */
+	if (entry->pending)
+		r = il_net__write(net, id, address, entry->buf, entry->sz,
+				  entry->confirmed, IL_NET_PRIO_CTL);
+
+	free(entry);
+
+	return r;
+}
+
+void il_net__wb_drop(il_net_t *net, uint16_t id)
+{
+	il_net_wb_t *wb = net->wb;
+	il_net_wb_entry_t *entry, **prev;
+
+	osal_mutex_lock(wb->lock);
+
+	prev = &wb->entries;
+	while (*prev) {
+		entry = *prev;
+		if (entry->id != id) {
+			prev = &entry->next;
+			continue;
+		}
+
+		*prev = entry->next;
+
+		osal_atomic_store_u32(&wb->cnt, wb->cnt - 1);
+
+		/* wait for an ongoing transmission of the entry */
+		while (wb->busy == entry)
+			(void)osal_cond_wait(wb->idle, wb->lock, 0);
+
+		free(entry);
+	}
+
+	osal_mutex_unlock(wb->lock);
+}
+
+int il_net__wb_write(il_net_t *net, uint16_t id, uint32_t address,
+		     const void *buf, size_t sz, int confirmed)
+{
+	int queued = 0;
+	il_net_wb_t *wb = net->wb;
+	il_net_wb_entry_t *entry;
+
+	/* fast path: write-behind not enabled on any register */
+	if (!osal_atomic_load_u32(&wb->cnt) || (sz > NET_WB_DATA_SZ))
+		return 0;
+
+	osal_mutex_lock(wb->lock);
+
+	entry = wb_find(wb, id, address);
+	if (!entry)
+		goto unlock;
+
+	entry->stats.requests++;
+
+	if (entry->pending) {
+		entry->stats.coalesced++;
+	} else {
+		entry->pending = 1;
+		entry->order = wb->order++;
+		osal_cond_signal(wb->pending);
+	}
+
+	memcpy(entry->buf, buf, sz);
+	entry->sz = sz;
+	entry->confirmed = confirmed;
+
+	queued = 1;
+
+unlock:
+	osal_mutex_unlock(wb->lock);
+
+	return queued;
+}
+
+int il_net__wb_stats_get(il_net_t *net, uint16_t id, uint32_t address,
+			 il_net_wb_stats_t *stats)
+{
+	int r = 0;
+	il_net_wb_t *wb = net->wb;
+	il_net_wb_entry_t *entry;
+
+	osal_mutex_lock(wb->lock);
+
+	entry = wb_find(wb, id, address);
+	if (!entry) {
+		ilerr__set("Write-behind not enabled");
+		r = IL_EINVAL;
+	} else {
+		*stats = entry->stats;
+	}
+
+	osal_mutex_unlock(wb->lock);
+
+	return r;
+}
+
+int il_net__in_delivery(il_net_t *net)
+{
+	return delivering == net;
+}
+
+void il_net__sw_notify(il_net_t *net, uint16_t id, uint16_t sw)
+{
+	events_notify(net, NET_EVT_SW, id, sw);
+}
+
+void il_net__emcy_notify(il_net_t *net, uint16_t id, uint32_t code)
+{
+	events_notify(net, NET_EVT_EMCY, id, code);
+}
+
+il_cache_t *il_net__cache(il_net_t *net)
+{
+	return net->cache;
+}
+
+void il_net__stats_rtt_add(il_net_t *net, uint16_t id,
+			   const osal_timespec_t *start)
+{
+	osal_timespec_t now;
+	long us, v;
+	size_t i;
+	il_net_rto_t *rto;
+	uint64_t srtt, rttvar, err;
+
+	if (id >= NET_STATS_NODES)
+		return;
+
+	if (osal_clock_gettime(&now) < 0)
+		return;
+
+	us = (now.s - start->s) * 1000000L + (now.ns - start->ns) / 1000L;
+	if (us < 0)
+		us = 0;
+
+	/* bucket: floor(log2(us)), clamped */
+	for (i = 0, v = us; (v >>= 1) > 0 && i < IL_NET_STATS_RTT_BUCKETS - 1;
+	     i++)
+		;
+
+	osal_atomic_add_u64(&net->rtt[id][i], 1);
+
+	/* estimator (RFC 6298: alpha = 1/8, beta = 1/4) */
+	rto = &net->rto[id];
+
+	srtt = osal_atomic_load_u64(&rto->srtt);
+	rttvar = osal_atomic_load_u64(&rto->rttvar);
+
+	if (srtt == 0) {
+		srtt = (uint64_t)us + 1;
+		rttvar = (uint64_t)us / 2;
+	} else {
+		err = (srtt > (uint64_t)us) ? srtt - (uint64_t)us :
+					      (uint64_t)us - srtt;
+		rttvar = (3 * rttvar + err) / 4;
+		srtt = (7 * srtt + (uint64_t)us) / 8;
+		if (srtt == 0)
+			srtt = 1;
+	}
+
+	osal_atomic_store_u64(&rto->rttvar, rttvar);
+	osal_atomic_store_u64(&rto->srtt, srtt);
+	osal_atomic_store_u32(&rto->backoff, 0);
+}
+
+int il_net__timeout_rd(il_net_t *net, uint16_t id)
+{
+	il_net_rto_t *rto;
+	uint64_t srtt, timeout;
+
+	if (!net->adaptive || (id >= NET_STATS_NODES))
+		return net->timeout_rd;
+
+	rto = &net->rto[id];
+
+	srtt = osal_atomic_load_u64(&rto->srtt);
+	if (srtt == 0)
+		return net->timeout_rd;
+
+	/* RTO = SRTT + max(G, 4 * RTTVAR), doubled on every back-off */
+	timeout = srtt + MAX(NET_RTO_GRANULARITY,
+			     4 * osal_atomic_load_u64(&rto->rttvar));
+	timeout <<= osal_atomic_load_u32(&rto->backoff);
+
+	/* us -> ms (rounded up), bounded */
+	timeout = (timeout + 999) / 1000;
+
+	return (int)MIN(MAX(timeout, IL_NET_TIMEOUT_RD_MIN),
+			(uint64_t)net->timeout_rd);
+}
+
+void il_net__timeout_backoff(il_net_t *net, uint16_t id)
+{
+	il_net_rto_t *rto;
+	uint32_t backoff;
+
+	if (id >= NET_STATS_NODES)
+		return;
+
+	rto = &net->rto[id];
+
+	/* timeouts of waiters and the listener may race, all must count */
+	backoff = osal_atomic_load_u32(&rto->backoff);
+	while (backoff < NET_RTO_BACKOFF_MAX) {
+		if (osal_atomic_cas_u32(&rto->backoff, &backoff, backoff + 1))
+			break;
+	}
+}
+
+void il_net__tx_lock(il_net_t *net, il_net_prio_t prio)
+{
+	il_net_sched_t *sched = &net->sched;
+
+	uint32_t ticket;
+	int timed;
+	osal_timespec_t start, end;
+
+	/* only account waits whose both clock reads succeed */
+	timed = (prio == IL_NET_PRIO_CTL) && (osal_clock_gettime(&start) == 0);
+
+	osal_mutex_lock(sched->lock);
+
+	ticket = sched->next[prio]++;
+
+	/* wait for our turn (control requests go first) */
+	while (sched->busy || (sched->serving[prio] != ticket) ||
+	       ((prio == IL_NET_PRIO_BULK) &&
+		(sched->next[IL_NET_PRIO_CTL] !=
+		 sched->serving[IL_NET_PRIO_CTL])))
+		(void)osal_cond_wait(sched->turn, sched->lock, 0);
+
+	sched->busy = 1;
+
+	/* account waiting time (serialized by the scheduler lock) */
+	if (timed && (osal_clock_gettime(&end) == 0)) {
+		uint64_t wait;
+
+		wait = (uint64_t)((end.s - start.s) * 1000000L +
+				  (end.ns - start.ns) / 1000L);
+
+		il_net__stats_add(net, ctl_requests, 1);
+		il_net__stats_add(net, ctl_wait, wait);
+		if (wait > osal_atomic_load_u64(&net->stats.ctl_wait_max))
+			osal_atomic_store_u64(&net->stats.ctl_wait_max, wait);
+	}
+
+	osal_mutex_unlock(sched->lock);
+}
+
+void il_net__tx_unlock(il_net_t *net, il_net_prio_t prio)
+{
+	il_net_sched_t *sched = &net->sched;
+
+	osal_mutex_lock(sched->lock);
+
+	sched->busy = 0;
+	sched->serving[prio]++;
+
+	osal_cond_broadcast(sched->turn);
+
+	osal_mutex_unlock(sched->lock);
+}
+
+int il_net__tx_contended(il_net_t *net, il_net_prio_t prio)
+{
+	il_net_sched_t *sched = &net->sched;
+	uint32_t waiting;
+
+	osal_mutex_lock(sched->lock);
+	waiting = sched->next[IL_NET_PRIO_CTL] -
+		  sched->serving[IL_NET_PRIO_CTL];
+	osal_mutex_unlock(sched->lock);
+
+	/* a control holder owns one of the tickets */
+	if (prio == IL_NET_PRIO_CTL)
+		return waiting > 1;
+
+	return waiting > 0;
+}
+
+void il_net__tx_yield(il_net_t *net, il_net_prio_t prio)
+{
+	if (il_net__tx_contended(net, prio)) {
+		il_net__tx_unlock(net, prio);
+		il_net__tx_lock(net, prio);
+	}
+}
+
 int il_net__write(il_net_t *net, uint16_t id, uint32_t address, const void *buf,
-		  size_t sz, int confirmed)
+		  size_t sz, int confirmed, il_net_prio_t prio)
 {
-	return net->ops->_write(net, id, address, buf, sz, confirmed);
+	return net->ops->_write(net, id, address, buf, sz, confirmed, prio);
 }
 
 int il_net__read(il_net_t *net, uint16_t id, uint32_t address, void *buf,
-		 size_t sz)
+		 size_t sz, il_net_prio_t prio)
+{
+	return net->ops->_read(net, id, address, buf, sz, prio);
+}
+
+int il_net__read_async(il_net_t *net, uint16_t id, uint32_t address,
+		       size_t sz, il_net_async_cb_t cb, void *ctx,
+		       il_net_prio_t prio)
+{
+	return net->ops->_read_async(net, id, address, sz, cb, ctx, prio);
+}
+
+int il_net__write_async(il_net_t *net, uint16_t id, uint32_t address,
+			const void *buf, size_t sz, int confirmed,
+			il_net_async_cb_t cb, void *ctx, il_net_prio_t prio)
+{
+	return net->ops->_write_async(net, id, address, buf, sz, confirmed, cb,
+				      ctx, prio);
+}
+
+int il_net__transfer_batch(il_net_t *net, il_net_xfer_t *xfers, size_t cnt,
+			   il_net_prio_t prio)
+{
+	return net->ops->_transfer_batch(net, xfers, cnt, prio);
+}
+
+int il_net__read_segmented(il_net_t *net, uint16_t id, uint32_t address,
+			   void *buf, size_t sz, il_net_progress_cb_t cb,
+			   void *ctx)
 {
-	return net->ops->_read(net, id, address, buf, sz);
+	return net->ops->_read_segmented(net, id, address, buf, sz, cb, ctx);
+}
+
+int il_net__write_segmented(il_net_t *net, uint16_t id, uint32_t address,
+			    const void *buf, size_t sz, int confirmed,
+			    il_net_progress_cb_t cb, void *ctx)
+{
+	return net->ops->_write_segmented(net, id, address, buf, sz, confirmed,
+					  cb, ctx);
 }
 
 int il_net__sw_subscribe(il_net_t *net, uint16_t id,
@@ -85,6 +1305,17 @@ void il_net__emcy_unsubscribe(il_net_t *net, int slot)
  * Public
  ******************************************************************************/
 
+void il_net_opts_init(il_net_opts_t *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+
+	opts->timeout_rd = IL_NET_TIMEOUT_RD_DEF;
+	opts->timeout_wr = IL_NET_TIMEOUT_WR_DEF;
+	opts->window = IL_NET_WINDOW_DEF;
+	opts->dispatch = IL_NET_DISPATCH_THREAD;
+	opts->sw_poll = IL_NET_SW_POLL_DEF;
+}
+
 il_net_t *il_net_create(il_net_prot_t prot, const il_net_opts_t *opts)
 {
 	switch (prot) {
@@ -139,6 +1370,99 @@ il_net_servos_list_t *il_net_servos_list_get(il_net_t *net,
 	return net->ops->servos_list_get(net, on_found, ctx);
 }
 
+int il_net_transfer_batch(il_net_t *net, il_net_xfer_t *xfers, size_t cnt)
+{
+	return il_net__transfer_batch(net, xfers, cnt, IL_NET_PRIO_BULK);
+}
+
+int il_net_read_segmented(il_net_t *net, uint16_t id, uint32_t address,
+			  void *buf, size_t sz, il_net_progress_cb_t cb,
+			  void *ctx)
+{
+	return il_net__read_segmented(net, id, address, buf, sz, cb, ctx);
+}
+
+int il_net_write_segmented(il_net_t *net, uint16_t id, uint32_t address,
+			   const void *buf, size_t sz, int confirmed,
+			   il_net_progress_cb_t cb, void *ctx)
+{
+	return il_net__write_segmented(net, id, address, buf, sz, confirmed,
+				       cb, ctx);
+}
+
+void il_net_stats_get(il_net_t *net, il_net_stats_t *stats)
+{
+	stats->tx_frames = osal_atomic_load_u64(&net->stats.tx_frames);
+	stats->tx_bytes = osal_atomic_load_u64(&net->stats.tx_bytes);
+	stats->rx_frames = osal_atomic_load_u64(&net->stats.rx_frames);
+	stats->rx_bytes = osal_atomic_load_u64(&net->stats.rx_bytes);
+	stats->timeouts = osal_atomic_load_u64(&net->stats.timeouts);
+	stats->resyncs = osal_atomic_load_u64(&net->stats.resyncs);
+	stats->mismatches = osal_atomic_load_u64(&net->stats.mismatches);
+	stats->crc_errors = osal_atomic_load_u64(&net->stats.crc_errors);
+	stats->ctl_requests = osal_atomic_load_u64(&net->stats.ctl_requests);
+	stats->ctl_wait = osal_atomic_load_u64(&net->stats.ctl_wait);
+	stats->ctl_wait_max = osal_atomic_load_u64(&net->stats.ctl_wait_max);
+	stats->events = osal_atomic_load_u64(&net->stats.events);
+	stats->events_dropped = osal_atomic_load_u64(&net->stats.events_dropped);
+	stats->events_coalesced =
+		osal_atomic_load_u64(&net->stats.events_coalesced);
+}
+
+int il_net_events_process(il_net_t *net)
+{
+	if (net->evts->mode != IL_NET_DISPATCH_MANUAL) {
+		ilerr__set("Events are delivered by the dispatcher thread");
+		return IL_ESTATE;
+	}
+
+	return events_process(net);
+}
+
+int il_net_timeout_rd_get(il_net_t *net, uint16_t id)
+{
+	return il_net__timeout_rd(net, id);
+}
+
+int il_net_stats_rtt_get(il_net_t *net, uint16_t id, uint64_t *hist)
+{
+	size_t i;
+
+	if (id >= NET_STATS_NODES) {
+		ilerr__set("Node id out of range");
+		return IL_EINVAL;
+	}
+
+	for (i = 0; i < IL_NET_STATS_RTT_BUCKETS; i++)
+		hist[i] = osal_atomic_load_u64(&net->rtt[id][i]);
+
+	return 0;
+}
+
+void il_net_stats_reset(il_net_t *net)
+{
+	size_t id, i;
+
+	osal_atomic_store_u64(&net->stats.tx_frames, 0);
+	osal_atomic_store_u64(&net->stats.tx_bytes, 0);
+	osal_atomic_store_u64(&net->stats.rx_frames, 0);
+	osal_atomic_store_u64(&net->stats.rx_bytes, 0);
+	osal_atomic_store_u64(&net->stats.timeouts, 0);
+	osal_atomic_store_u64(&net->stats.resyncs, 0);
+	osal_atomic_store_u64(&net->stats.mismatches, 0);
+	osal_atomic_store_u64(&net->stats.crc_errors, 0);
+	osal_atomic_store_u64(&net->stats.ctl_requests, 0);
+	osal_atomic_store_u64(&net->stats.ctl_wait, 0);
+	osal_atomic_store_u64(&net->stats.ctl_wait_max, 0);
+	osal_atomic_store_u64(&net->stats.events, 0);
+	osal_atomic_store_u64(&net->stats.events_dropped, 0);
+	osal_atomic_store_u64(&net->stats.events_coalesced, 0);
+
+	for (id = 0; id < NET_STATS_NODES; id++)
+		for (i = 0; i < IL_NET_STATS_RTT_BUCKETS; i++)
+			osal_atomic_store_u64(&net->rtt[id][i], 0);
+}
+
 void il_net_servos_list_destroy(il_net_servos_list_t *lst)
 {
 	il_net_servos_list_t *curr;
@@ -202,6 +1526,90 @@ void il_net_dev_mon_stop(il_net_dev_mon_t *mon)
 	mon->ops->stop(mon);
 }
 
+il_net_discovery_list_t *il_net_discovery_list_get(
+		il_net_prot_t prot, il_net_discovery_on_found_t on_found,
+		void *ctx)
+{
+	il_net_dev_list_t *devs, *dev;
+	il_net_discovery_t disc;
+	il_net_discovery_worker_t *workers;
+	il_net_discovery_list_t *lst = NULL, **tail = &lst;
+	size_t cnt = 0, i;
+
+	devs = il_net_dev_list_get(prot);
+	if (!devs)
+		return NULL;
+
+	il_net_dev_list_foreach(dev, devs)
+		cnt++;
+
+	workers = calloc(cnt, sizeof(*workers));
+	if (!workers) {
+		ilerr__set("Discovery workers allocation failed");
+		goto cleanup_devs;
+	}
+
+	disc.prot = prot;
+	disc.on_found = on_found;
+	disc.ctx = ctx;
+	disc.lock = osal_mutex_create();
+	if (!disc.lock) {
+		ilerr__set("Discovery lock allocation failed");
+		goto cleanup_workers;
+	}
+
+	/* probe all devices concurrently */
+	i = 0;
+	il_net_dev_list_foreach(dev, devs) {
+		workers[i].disc = &disc;
+		workers[i].port = dev->port;
+		workers[i].thread = osal_thread_create(discovery_worker,
+						       &workers[i]);
+		/* fallback to in-place probing */
+		if (!workers[i].thread)
+			(void)discovery_worker(&workers[i]);
+
+		i++;
+	}
+
+	/* collect results (devices order) */
+	for (i = 0; i < cnt; i++) {
+		if (workers[i].thread)
+			osal_thread_join(workers[i].thread, NULL);
+
+		*tail = workers[i].lst;
+		while (*tail)
+			tail = &(*tail)->next;
+	}
+
+	if (!lst)
+		ilerr__set("No nodes found");
+
+	osal_mutex_destroy(disc.lock);
+
+cleanup_workers:
+	free(workers);
+
+cleanup_devs:
+	il_net_dev_list_destroy(devs);
+
+	return lst;
+}
+
+void il_net_discovery_list_destroy(il_net_discovery_list_t *lst)
+{
+	il_net_discovery_list_t *curr;
+
+	curr = lst;
+	while (curr) {
+		il_net_discovery_list_t *tmp;
+
+		tmp = curr->next;
+		free(curr);
+		curr = tmp;
+	}
+}
+
 il_net_dev_list_t *il_net_dev_list_get(il_net_prot_t prot)
 {
 	switch (prot) {
@@ -30,11 +30,190 @@
 
 #include "osal/osal.h"
 
-/** Statusword subscribers default array size. */
-#define SW_SUBS_SZ_DEF		10
+/** Subscribers table size (power of 2, buckets indexed by node ID). */
+#define NET_SUBS_SZ		256
 
-/** Emergency subscribers default array size. */
-#define EMCY_SUBS_SZ_DEF	10
+/** Subscribers table bucket of a node. */
+#define NET_SUBS_BUCKET(id)	((id) & (NET_SUBS_SZ - 1))
+
+/** Subscribers slots default array size. */
+#define NET_SUBS_SLOTS_DEF	16
+
+/** Subscribers grace period polling interval (ms). */
+#define NET_SUBS_GRACE_POLL	1
+
+/** Number of nodes with round trip time statistics. */
+#define NET_STATS_NODES		256
+
+/** Round trip time estimator clock granularity (us). */
+#define NET_RTO_GRANULARITY	1000
+
+/** Maximum number of timeout back-offs. */
+#define NET_RTO_BACKOFF_MAX	8
+
+/**
+ * Round trip time estimator (per node).
+ *
+ * @note
+ *	Updated from the transport reception context (serialized by the
+ *	transport), read lock-free from any context.
+ */
+typedef struct {
+	/** Smoothed round trip time (us, 0 if not measured). */
+	uint64_t srtt;
+	/** Round trip time variation (us). */
+	uint64_t rttvar;
+	/** Number of consecutive timeouts (back-off). */
+	volatile uint32_t backoff;
+} il_net_rto_t;
+
+/** Add a value to a statistics counter (lock-free). */
+#define il_net__stats_add(net, field, v) \
+	osal_atomic_add_u64(&(net)->stats.field, (uint64_t)(v))
+
+/** Transmission scheduler. */
+typedef struct {
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** Turn changed condition. */
+	osal_cond_t *turn;
+	/** Busy flag (network acquired). */
+	int busy;
+	/** Next ticket (per class). */
+	uint32_t next[IL_NET_PRIO_CNT];
+	/** Ticket being served (per class). */
+	uint32_t serving[IL_NET_PRIO_CNT];
+} il_net_sched_t;
+
+/** Subscriber events queue size (power of 2). */
+#define NET_EVTS_SZ		256
+
+/** Coalesced statusword pending flag. */
+#define NET_EVT_SW_PENDING	0x10000U
+
+/** Coalesced statusword node ID (high byte) position. */
+#define NET_EVT_SW_ID_POS	17
+
+/** Subscriber event types. */
+typedef enum {
+	/** Statusword update. */
+	NET_EVT_SW,
+	/** Emergency. */
+	NET_EVT_EMCY,
+} il_net_evt_type_t;
+
+/** Subscriber event (queue slot). */
+typedef struct {
+	/** Sequence number (slot state). */
+	volatile uint32_t seq;
+	/** Type. */
+	il_net_evt_type_t type;
+	/** Node ID. */
+	uint16_t id;
+	/** Value (statusword or emergency code). */
+	uint32_t value;
+} il_net_evt_t;
+
+/**
+ * Subscriber events queue.
+ *
+ * @note
+ *	Bounded lock-free multiple-producer single-consumer queue: each slot
+ *	sequence number tells if it is free for the producer of a given
+ *	position or ready for the consumer. Producers never block: if the
+ *	consumer falls behind, statusword updates are coalesced (only the
+ *	latest one of each node is kept, flagged as pending) and emergencies
+ *	are dropped (and counted). The lock is only used to wake up the
+ *	dispatcher thread.
+ */
+typedef struct {
+	/** Events. */
+	il_net_evt_t evts[NET_EVTS_SZ];
+	/** Producers position. */
+	volatile uint32_t head;
+	/** Consumer position. */
+	uint32_t tail;
+	/**
+	 * Coalesced statuswords (indexed by node ID low byte, with the high
+	 * byte at NET_EVT_SW_ID_POS, NET_EVT_SW_PENDING if pending).
+	 */
+	volatile uint32_t sw[NET_SUBS_SZ];
+	/** Coalesced statuswords available flag. */
+	volatile uint32_t sw_coalesced;
+	/** Dispatch mode. */
+	il_net_dispatch_t mode;
+	/** Consumer lock (serializes delivery). */
+	osal_mutex_t *consumer;
+	/** Dispatcher lock. */
+	osal_mutex_t *lock;
+	/** Events available condition. */
+	osal_cond_t *avail;
+	/** Dispatcher thread. */
+	osal_thread_t *dispatcher;
+	/** Dispatcher stop flag (atomic). */
+	volatile uint32_t stop;
+} il_net_evts_t;
+
+/** Write-behind data buffer size. */
+#define NET_WB_DATA_SZ		8
+
+/** Write-behind rate estimator gain (1/2^n). */
+#define NET_WB_RATE_GAIN	3
+
+/** Write-behind entry (per node and address). */
+typedef struct il_net_wb_entry {
+	/** Node ID. */
+	uint16_t id;
+	/** Address. */
+	uint32_t address;
+	/** Pending data. */
+	uint8_t buf[NET_WB_DATA_SZ];
+	/** Pending data size. */
+	size_t sz;
+	/** Pending write confirmation flag. */
+	int confirmed;
+	/** Pending flag. */
+	int pending;
+	/** Service order (oldest pending entry is served first). */
+	uint64_t order;
+	/** Last transmission time. */
+	osal_timespec_t last;
+	/** Statistics. */
+	il_net_wb_stats_t stats;
+	/** Next entry. */
+	struct il_net_wb_entry *next;
+} il_net_wb_entry_t;
+
+/**
+ * Write-behind (latest value wins) writer.
+ *
+ * @note
+ *	Writes to enabled registers only update the entry pending value, and a
+ *	writer thread (created on first use) transmits the newest value of each
+ *	pending entry as soon as the network is available. The number of
+ *	entries is also kept atomically, so that writes skip the lock if none
+ *	is enabled.
+ */
+typedef struct {
+	/** Entries. */
+	il_net_wb_entry_t *entries;
+	/** Number of entries. */
+	volatile uint32_t cnt;
+	/** Next service order. */
+	uint64_t order;
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** Pending entries condition. */
+	osal_cond_t *pending;
+	/** Writer idle condition. */
+	osal_cond_t *idle;
+	/** Entry being transmitted. */
+	il_net_wb_entry_t *busy;
+	/** Writer thread. */
+	osal_thread_t *writer;
+	/** Writer stop flag. */
+	int stop;
+} il_net_wb_t;
 
 /** Statusword update subscriber. */
 struct il_net_sw_subscriber {
@@ -44,22 +223,44 @@ struct il_net_sw_subscriber {
 	il_net_sw_subscriber_cb_t cb;
 	/** Callback context. */
 	void *ctx;
+	/** Next subscriber (same bucket). */
+	il_net_sw_subscriber_t *volatile next;
+	/** Unsubscribed flag (skipped by deliveries in progress). */
+	volatile uint32_t retired;
+	/** Next retired subscriber (freed once the delivery completes). */
+	il_net_sw_subscriber_t *retired_next;
 };
 
 /**
  * Statusword update subscribers.
  *
  * @note
- *	This is implemented using a dynamic array so that traverse is more
- *	efficient.
+ *	Subscribers are chained in a table of buckets indexed by node ID, read
+ *	without locking (read-mostly): writers (serialized by a lock) publish
+ *	and unlink entries atomically, and unlinked entries are only freed
+ *	once the reader (events delivery) has completed any delivery that may
+ *	have seen them (reader epoch). Unsubscribing from a callback cannot
+ *	wait for the delivery it runs in, so entries are then retired and
+ *	freed by the events context once the delivery completes. A node may
+ *	have any number of subscribers. Slots (returned on subscription) are
+ *	only used by writers.
  */
 typedef struct {
-	/** Array of subscribers. */
-	il_net_sw_subscriber_t *subs;
-	/** Array size. */
+	/** Subscribers (chains, indexed by node ID bucket). */
+	il_net_sw_subscriber_t *volatile subs[NET_SUBS_SZ];
+	/** Subscribers by slot (il_net_sw_subscriber_t). */
+	void **slots;
+	/**
+	 * Subscribers unsubscribed from a callback (only accessed from the
+	 * events context).
+	 */
+	il_net_sw_subscriber_t *retired;
+	/** Number of slots. */
 	int sz;
-	/** Lock. */
+	/** Writers lock. */
 	osal_mutex_t *lock;
+	/** Reader epoch (odd while delivering). */
+	volatile uint32_t epoch;
 } il_net_sw_subscriber_lst_t;
 
 /** Emergency subscriber. */
@@ -70,22 +271,36 @@ struct il_net_emcy_subscriber {
 	il_net_emcy_subscriber_cb_t cb;
 	/** Callback context. */
 	void *ctx;
+	/** Next subscriber (same bucket). */
+	il_net_emcy_subscriber_t *volatile next;
+	/** Unsubscribed flag (skipped by deliveries in progress). */
+	volatile uint32_t retired;
+	/** Next retired subscriber (freed once the delivery completes). */
+	il_net_emcy_subscriber_t *retired_next;
 };
 
 /**
  * Emergency subscribers.
  *
  * @note
- *	This is implemented using a dynamic array so that traverse is more
- *	efficient.
+ *	See il_net_sw_subscriber_lst_t.
  */
 typedef struct {
-	/** Array of subscribers. */
-	il_net_emcy_subscriber_t *subs;
-	/** Array size. */
+	/** Subscribers (chains, indexed by node ID bucket). */
+	il_net_emcy_subscriber_t *volatile subs[NET_SUBS_SZ];
+	/** Subscribers by slot (il_net_emcy_subscriber_t). */
+	void **slots;
+	/**
+	 * Subscribers unsubscribed from a callback (only accessed from the
+	 * events context).
+	 */
+	il_net_emcy_subscriber_t *retired;
+	/** Number of slots. */
 	int sz;
-	/** Lock. */
+	/** Writers lock. */
 	osal_mutex_t *lock;
+	/** Reader epoch (odd while delivering). */
+	volatile uint32_t epoch;
 } il_net_emcy_subscriber_lst_t;
 
 /** Network. */
@@ -98,8 +313,12 @@ struct il_net {
 	int timeout_rd;
 	/** Write timeout. */
 	int timeout_wr;
-	/** Network lock. */
-	osal_mutex_t *lock;
+	/** Adaptive read timeout flag. */
+	int adaptive;
+	/** Read retries. */
+	int retries;
+	/** Transmission scheduler. */
+	il_net_sched_t sched;
 	/** Network state. */
 	il_net_state_t state;
 	/** Network state lock. */
@@ -108,6 +327,18 @@ struct il_net {
 	il_net_sw_subscriber_lst_t sw_subs;
 	/** Emergency subcribers. */
 	il_net_emcy_subscriber_lst_t emcy_subs;
+	/** Subscriber events queue. */
+	il_net_evts_t *evts;
+	/** Write-behind writer. */
+	il_net_wb_t *wb;
+	/** Statistics (updated atomically). */
+	il_net_stats_t stats;
+	/** Round trip time histograms (per node). */
+	uint64_t (*rtt)[IL_NET_STATS_RTT_BUCKETS];
+	/** Round trip time estimators (per node). */
+	il_net_rto_t *rto;
+	/** Servo configuration cache (optional). */
+	il_cache_t *cache;
 	/** Operations. */
 	const il_net_ops_t *ops;
 };
@@ -117,6 +348,30 @@ struct il_net_dev_mon {
 	/** Operations. */
 	const il_net_dev_mon_ops_t *ops;
 };
+
+/** Network discovery shared context. */
+typedef struct {
+	/** Protocol. */
+	il_net_prot_t prot;
+	/** Node found callback. */
+	il_net_discovery_on_found_t on_found;
+	/** Callback context. */
+	void *ctx;
+	/** Callback lock. */
+	osal_mutex_t *lock;
+} il_net_discovery_t;
+
+/** Network discovery (per device) worker. */
+typedef struct {
+	/** Shared context. */
+	il_net_discovery_t *disc;
+	/** Port. */
+	const char *port;
+	/** Discovered nodes. */
+	il_net_discovery_list_t *lst;
+	/** Thread. */
+	osal_thread_t *thread;
+} il_net_discovery_worker_t;
 #endif
 
 /** Network implementations. */
@@ -0,0 +1,763 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "reactor.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include "ingenialink/err.h"
+
+#ifdef __linux__
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+/**
+ * Obtain current (monotonic) time in milliseconds.
+ */
+static long long now_ms(void)
+{
+	osal_timespec_t ts;
+
+	(void)osal_clock_gettime(&ts);
+
+	return (long long)ts.s * 1000 + ts.ns / OSAL_CLOCK_NANOSPERMSEC;
+}
+
+/**
+ * Obtain the termios speed of a baudrate.
+ *
+ * @param [in] baudrate
+ *	Baudrate.
+ *
+ * @return
+ *	Speed (B0 if not supported).
+ */
+static speed_t baudrate_speed(int baudrate)
+{
+	switch (baudrate) {
+	case 9600:
+		return B9600;
+	case 19200:
+		return B19200;
+	case 38400:
+		return B38400;
+	case 57600:
+		return B57600;
+	case 115200:
+		return B115200;
+	case 230400:
+		return B230400;
+	case 460800:
+		return B460800;
+	case 921600:
+		return B921600;
+	default:
+		return B0;
+	}
+}
+
+/**
+ * Configure a port as a raw 8N1 line without flow control.
+ *
+ * @param [in] fd
+ *	Port file descriptor.
+ * @param [in] baudrate
+ *	Baudrate.
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int port_configure(int fd, int baudrate)
+{
+	struct termios tio;
+	speed_t speed;
+
+	speed = baudrate_speed(baudrate);
+	if (speed == B0) {
+		ilerr__set("Unsupported baudrate (%d)", baudrate);
+		return IL_EINVAL;
+	}
+
+	if (tcgetattr(fd, &tio) < 0) {
+		ilerr__set("Port configuration failed (%s)", strerror(errno));
+		return IL_EFAIL;
+	}
+
+	cfmakeraw(&tio);
+	tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+
+	if ((cfsetispeed(&tio, speed) < 0) || (cfsetospeed(&tio, speed) < 0) ||
+	    (tcsetattr(fd, TCSANOW, &tio) < 0)) {
+		ilerr__set("Port configuration failed (%s)", strerror(errno));
+		return IL_EFAIL;
+	}
+
+	(void)tcflush(fd, TCIOFLUSH);
+
+	return 0;
+}
+
+/**
+ * Run a source callback.
+ *
+ * @note
+ *	Thread lock must be held. The lock is released while the callback runs,
+ *	and the source is marked as busy so that it can not be detached. Tick
+ *	callbacks disarm the source unless they request otherwise.
+ *
+ * @param [in] td
+ *	Reactor thread.
+ * @param [in] src
+ *	Source.
+ * @param [in] tick
+ *	Run the tick callback instead of the data available callback.
+ */
+static void src_run(il_reactor_td_t *td, il_reactor_src_t *src, int tick)
+{
+	int r = 0, armed = 0;
+
+	td->busy = src;
+
+	/* disarm before running, so that concurrent arms are not lost */
+	if (tick)
+		osal_atomic_store_u32(&src->armed, 0);
+
+	osal_mutex_unlock(td->lock);
+
+	if (tick)
+		armed = src->on_tick(src->ctx);
+	else
+		r = src->on_read(src->ctx);
+
+	osal_mutex_lock(td->lock);
+	td->busy = NULL;
+
+	if (armed)
+		osal_atomic_store_u32(&src->armed, 1);
+
+	/* disable source on errors, owner is expected to detach it */
+	if (r < 0) {
+		src->enabled = 0;
+		(void)epoll_ctl(td->epfd, EPOLL_CTL_DEL, src->fd, NULL);
+	}
+
+	osal_cond_broadcast(td->idle);
+}
+
+/**
+ * Check if a source is attached to a thread.
+ *
+ * @note
+ *	Thread lock must be held.
+ */
+static int src_attached(il_reactor_td_t *td, il_reactor_src_t *src)
+{
+	il_reactor_src_t *curr;
+
+	for (curr = td->srcs; curr; curr = curr->next) {
+		if (curr == src)
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Check if any enabled source is armed.
+ *
+ * @note
+ *	Thread lock must be held.
+ */
+static int td_armed(il_reactor_td_t *td)
+{
+	il_reactor_src_t *src;
+
+	for (src = td->srcs; src; src = src->next) {
+		if (src->enabled && osal_atomic_load_u32(&src->armed))
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Run tick callbacks of all enabled and armed sources.
+ *
+ * @note
+ *	Thread lock must be held. Sources may be detached while callbacks run,
+ *	so the list is rescanned after each callback.
+ */
+static void td_tick(il_reactor_td_t *td)
+{
+	il_reactor_src_t *src;
+
+	td->tick++;
+
+	for (;;) {
+		for (src = td->srcs; src; src = src->next) {
+			if (src->enabled && src->tick != td->tick &&
+			    osal_atomic_load_u32(&src->armed))
+				break;
+		}
+
+		if (!src)
+			break;
+
+		src->tick = td->tick;
+		src_run(td, src, 1);
+	}
+}
+
+/**
+ * Reactor I/O thread.
+ *
+ * @param [in] args
+ *	Reactor thread (il_reactor_td_t *).
+ */
+static int reactor_td(void *args)
+{
+	il_reactor_td_t *td = args;
+
+	struct epoll_event evs[REACTOR_EVENTS_MAX];
+	long long next_tick;
+
+	if (td->cpu >= 0) {
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+		CPU_SET(td->cpu, &set);
+
+		/* pinning is best-effort */
+		(void)pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+
+	next_tick = -1;
+
+	osal_mutex_lock(td->lock);
+
+	while (!td->stop) {
+		int n, i, timeout = -1;
+
+		/* tick only while sources are armed, idle ones sleep */
+		if (td_armed(td)) {
+			long long now = now_ms();
+
+			if (next_tick < 0)
+				next_tick = now + REACTOR_TICK;
+
+			if (now >= next_tick) {
+				td_tick(td);
+				next_tick = -1;
+				continue;
+			}
+
+			timeout = (int)(next_tick - now);
+		} else {
+			next_tick = -1;
+		}
+
+		osal_mutex_unlock(td->lock);
+		n = epoll_wait(td->epfd, evs, REACTOR_EVENTS_MAX, timeout);
+		osal_mutex_lock(td->lock);
+
+		for (i = 0; i < n && !td->stop; i++) {
+			il_reactor_src_t *src = evs[i].data.ptr;
+
+			/* wake-up event */
+			if (!src) {
+				uint64_t val;
+
+				(void)!read(td->evfd, &val, sizeof(val));
+				continue;
+			}
+
+			/* source may have been detached meanwhile */
+			if (!src_attached(td, src) || !src->enabled)
+				continue;
+
+			src->events = evs[i].events;
+			src_run(td, src, 0);
+		}
+	}
+
+	osal_mutex_unlock(td->lock);
+
+	return 0;
+}
+
+/**
+ * Initialize a reactor thread.
+ *
+ * @param [in] td
+ *	Reactor thread.
+ * @param [in] cpu
+ *	CPU to pin the thread to (-1 to not pin).
+ *
+ * @return
+ *	0 on success, error code otherwise.
+ */
+static int td_init(il_reactor_td_t *td, int cpu)
+{
+	int r;
+	struct epoll_event ev;
+
+	td->cpu = cpu;
+
+	td->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (td->epfd < 0) {
+		ilerr__set("epoll creation failed (%s)", strerror(errno));
+		return IL_EFAIL;
+	}
+
+	td->evfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (td->evfd < 0) {
+		ilerr__set("Stop event creation failed (%s)", strerror(errno));
+		r = IL_EFAIL;
+		goto cleanup_epfd;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+
+	if (epoll_ctl(td->epfd, EPOLL_CTL_ADD, td->evfd, &ev) < 0) {
+		ilerr__set("Stop event registration failed (%s)",
+			   strerror(errno));
+		r = IL_EFAIL;
+		goto cleanup_evfd;
+	}
+
+	td->lock = osal_mutex_create();
+	if (!td->lock) {
+		ilerr__set("Reactor lock allocation failed");
+		r = IL_EFAIL;
+		goto cleanup_evfd;
+	}
+
+	td->idle = osal_cond_create();
+	if (!td->idle) {
+		ilerr__set("Reactor condition variable allocation failed");
+		r = IL_EFAIL;
+		goto cleanup_lock;
+	}
+
+	td->stop = 0;
+	td->td = osal_thread_create(reactor_td, td);
+	if (!td->td) {
+		ilerr__set("Reactor thread creation failed");
+		r = IL_EFAIL;
+		goto cleanup_idle;
+	}
+
+	return 0;
+
+cleanup_idle:
+	osal_cond_destroy(td->idle);
+
+cleanup_lock:
+	osal_mutex_destroy(td->lock);
+
+cleanup_evfd:
+	close(td->evfd);
+
+cleanup_epfd:
+	close(td->epfd);
+
+	return r;
+}
+
+/**
+ * De-initialize a reactor thread.
+ *
+ * @param [in] td
+ *	Reactor thread.
+ */
+static void td_deinit(il_reactor_td_t *td)
+{
+	uint64_t val = 1;
+
+	osal_mutex_lock(td->lock);
+	td->stop = 1;
+	osal_mutex_unlock(td->lock);
+
+	/* wake up thread */
+	(void)!write(td->evfd, &val, sizeof(val));
+
+	osal_thread_join(td->td, NULL);
+
+	osal_cond_destroy(td->idle);
+	osal_mutex_destroy(td->lock);
+	close(td->evfd);
+	close(td->epfd);
+}
+
+/*******************************************************************************
+ * Internal
+ ******************************************************************************/
+
+il_reactor_src_t *il_reactor__attach(il_reactor_t *reactor, const char *port,
+				     int baudrate, il_reactor_on_read_t on_read,
+				     il_reactor_on_tick_t on_tick, void *ctx)
+{
+	il_reactor_src_t *src;
+	il_reactor_td_t *td;
+	struct epoll_event ev;
+	size_t i;
+
+	src = calloc(1, sizeof(*src));
+	if (!src) {
+		ilerr__set("Reactor source allocation failed");
+		return NULL;
+	}
+
+	src->fd = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (src->fd < 0) {
+		ilerr__set("Port open failed (%s)", strerror(errno));
+		goto cleanup_src;
+	}
+
+	if (port_configure(src->fd, baudrate) < 0)
+		goto cleanup_fd;
+
+	src->enabled = 1;
+	src->on_read = on_read;
+	src->on_tick = on_tick;
+	src->ctx = ctx;
+
+	/* assign to the least loaded thread */
+	td = &reactor->tds[0];
+	for (i = 1; i < reactor->n; i++) {
+		if (reactor->tds[i].cnt < td->cnt)
+			td = &reactor->tds[i];
+	}
+
+	src->td = td;
+
+	osal_mutex_lock(td->lock);
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = src;
+
+	if (epoll_ctl(td->epfd, EPOLL_CTL_ADD, src->fd, &ev) < 0) {
+		osal_mutex_unlock(td->lock);
+		ilerr__set("Port registration failed (%s)", strerror(errno));
+		goto cleanup_fd;
+	}
+
+	src->tick = td->tick;
+	src->next = td->srcs;
+	td->srcs = src;
+	td->cnt++;
+
+	osal_mutex_unlock(td->lock);
+
+	return src;
+
+cleanup_fd:
+	close(src->fd);
+
+cleanup_src:
+	free(src);
+
+	return NULL;
+}
+
+void il_reactor__detach(il_reactor_src_t *src)
+{
+	il_reactor_td_t *td = src->td;
+	il_reactor_src_t **curr;
+
+	osal_mutex_lock(td->lock);
+
+	if (src->enabled)
+		(void)epoll_ctl(td->epfd, EPOLL_CTL_DEL, src->fd, NULL);
+
+	for (curr = &td->srcs; *curr; curr = &(*curr)->next) {
+		if (*curr == src) {
+			*curr = src->next;
+			td->cnt--;
+			break;
+		}
+	}
+
+	while (td->busy == src)
+		(void)osal_cond_wait(td->idle, td->lock, 0);
+
+	osal_mutex_unlock(td->lock);
+
+	close(src->fd);
+	free(src);
+}
+
+int il_reactor__read(il_reactor_src_t *src, void *buf, size_t sz,
+		     size_t *recvd)
+{
+	ssize_t r;
+
+	*recvd = 0;
+
+	r = read(src->fd, buf, sz);
+	if (r < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return 0;
+
+		ilerr__set("Reception failed (%s)", strerror(errno));
+		return IL_EIO;
+	}
+
+	/* no data, report hang-ups */
+	if (r == 0 && (src->events & (EPOLLHUP | EPOLLERR))) {
+		ilerr__set("Port disconnected");
+		return IL_EDISCONN;
+	}
+
+	*recvd = (size_t)r;
+
+	return 0;
+}
+
+int il_reactor__write(il_reactor_src_t *src, const void *buf, size_t sz,
+		      int timeout)
+{
+	const uint8_t *data = buf;
+
+	while (sz > 0) {
+		ssize_t r;
+		struct pollfd pfd;
+
+		r = write(src->fd, data, sz);
+		if (r > 0) {
+			data += r;
+			sz -= (size_t)r;
+			continue;
+		}
+
+		if ((r < 0) && (errno != EAGAIN) && (errno != EINTR)) {
+			ilerr__set("Transmission failed (%s)", strerror(errno));
+			return IL_EIO;
+		}
+
+		/* output queue full: wait until there is room */
+		pfd.fd = src->fd;
+		pfd.events = POLLOUT;
+		pfd.revents = 0;
+
+		r = poll(&pfd, 1, timeout);
+		if (r == 0) {
+			ilerr__set("Transmission timed out");
+			return IL_ETIMEDOUT;
+		} else if ((r < 0) && (errno != EINTR)) {
+			ilerr__set("Transmission failed (%s)", strerror(errno));
+			return IL_EIO;
+		} else if ((r > 0) && (pfd.revents & (POLLHUP | POLLERR))) {
+			ilerr__set("Port disconnected");
+			return IL_EDISCONN;
+		}
+	}
+
+	return 0;
+}
+
+void il_reactor__arm(il_reactor_src_t *src)
+{
+	il_reactor_td_t *td = src->td;
+	uint64_t val = 1;
+
+	if (osal_atomic_load_u32(&src->armed))
+		return;
+
+	osal_atomic_store_u32(&src->armed, 1);
+
+	/* wake up thread, so that it starts ticking */
+	(void)!write(td->evfd, &val, sizeof(val));
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+il_reactor_t *il_reactor_create(const il_reactor_opts_t *opts)
+{
+	il_reactor_t *reactor;
+	size_t n = 1, i;
+	int pin = 0;
+	long cpus = 1;
+
+	if (opts) {
+		if (opts->threads > 0)
+			n = opts->threads;
+		pin = opts->pin;
+	}
+
+	if (pin) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		if (cpus < 1)
+			cpus = 1;
+	}
+
+	reactor = malloc(sizeof(*reactor));
+	if (!reactor) {
+		ilerr__set("Reactor allocation failed");
+		return NULL;
+	}
+
+	reactor->tds = calloc(n, sizeof(*reactor->tds));
+	if (!reactor->tds) {
+		ilerr__set("Reactor threads allocation failed");
+		goto cleanup_reactor;
+	}
+
+	for (reactor->n = 0; reactor->n < n; reactor->n++) {
+		int r;
+
+		r = td_init(&reactor->tds[reactor->n],
+			    pin ? (int)(reactor->n % (size_t)cpus) : -1);
+		if (r < 0)
+			goto cleanup_tds;
+	}
+
+	return reactor;
+
+cleanup_tds:
+	for (i = 0; i < reactor->n; i++)
+		td_deinit(&reactor->tds[i]);
+
+	free(reactor->tds);
+
+cleanup_reactor:
+	free(reactor);
+
+	return NULL;
+}
+
+void il_reactor_destroy(il_reactor_t *reactor)
+{
+	size_t i;
+
+	for (i = 0; i < reactor->n; i++)
+		td_deinit(&reactor->tds[i]);
+
+	free(reactor->tds);
+	free(reactor);
+}
+
+#else
+
+/*******************************************************************************
+ * Internal (not supported)
+ ******************************************************************************/
+
+il_reactor_src_t *il_reactor__attach(il_reactor_t *reactor, const char *port,
+				     int baudrate, il_reactor_on_read_t on_read,
+				     il_reactor_on_tick_t on_tick, void *ctx)
+{
+	(void)reactor;
+	(void)port;
+	(void)baudrate;
+	(void)on_read;
+	(void)on_tick;
+	(void)ctx;
+
+	ilerr__set("I/O reactor not supported");
+
+	return NULL;
+}
+
+void il_reactor__detach(il_reactor_src_t *src)
+{
+	(void)src;
+}
+
+int il_reactor__read(il_reactor_src_t *src, void *buf, size_t sz,
+		     size_t *recvd)
+{
+	(void)src;
+	(void)buf;
+	(void)sz;
+
+	*recvd = 0;
+
+	return IL_ENOTSUP;
+}
+
+int il_reactor__write(il_reactor_src_t *src, const void *buf, size_t sz,
+		      int timeout)
+{
+	(void)src;
+	(void)buf;
+	(void)sz;
+	(void)timeout;
+
+	return IL_ENOTSUP;
+}
+
+void il_reactor__arm(il_reactor_src_t *src)
+{
+	(void)src;
+}
+
+/*******************************************************************************
+ * Public (not supported)
+ ******************************************************************************/
+
+il_reactor_t *il_reactor_create(const il_reactor_opts_t *opts)
+{
+	(void)opts;
+
+	ilerr__set("I/O reactor not supported");
+
+	return NULL;
+}
+
+void il_reactor_destroy(il_reactor_t *reactor)
+{
+	(void)reactor;
+}
+
+#endif
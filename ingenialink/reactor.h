@@ -0,0 +1,100 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017-2018 Ingenia-CAT S.L.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef REACTOR_H_
+#define REACTOR_H_
+
+#include "ingenialink/reactor.h"
+
+#include "osal/osal.h"
+
+/** Tick period (ms). */
+#define REACTOR_TICK		100
+
+/** Maximum number of events retrieved per wait. */
+#define REACTOR_EVENTS_MAX	16
+
+/** Reactor I/O thread. */
+typedef struct il_reactor_td il_reactor_td_t;
+
+/** Reactor source. */
+struct il_reactor_src {
+	/** Owner thread. */
+	il_reactor_td_t *td;
+	/** Port file descriptor. */
+	int fd;
+	/** Last received events. */
+	uint32_t events;
+	/** Enabled flag (cleared on reception errors). */
+	int enabled;
+	/** Armed flag (tick requested). */
+	volatile uint32_t armed;
+	/** Last tick generation. */
+	unsigned int tick;
+	/** Data available callback. */
+	il_reactor_on_read_t on_read;
+	/** Periodic tick callback. */
+	il_reactor_on_tick_t on_tick;
+	/** Callbacks context. */
+	void *ctx;
+	/** Next source. */
+	struct il_reactor_src *next;
+};
+
+/** Reactor I/O thread. */
+struct il_reactor_td {
+	/** Thread. */
+	osal_thread_t *td;
+	/** CPU the thread is pinned to (-1 if not pinned). */
+	int cpu;
+	/** epoll instance. */
+	int epfd;
+	/** Wake-up event (stop or tick armed). */
+	int evfd;
+	/** Stop flag. */
+	int stop;
+	/** Lock. */
+	osal_mutex_t *lock;
+	/** Source idle condition variable. */
+	osal_cond_t *idle;
+	/** Attached sources. */
+	il_reactor_src_t *srcs;
+	/** Number of attached sources. */
+	size_t cnt;
+	/** Source whose callbacks are being run. */
+	il_reactor_src_t *busy;
+	/** Tick generation. */
+	unsigned int tick;
+};
+
+/** I/O reactor. */
+struct il_reactor {
+	/** I/O threads. */
+	il_reactor_td_t *tds;
+	/** Number of I/O threads. */
+	size_t n;
+};
+
+#endif
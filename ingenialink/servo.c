@@ -24,7 +24,18 @@
 
 #include "servo.h"
 
+#include <string.h>
+
+#ifndef IL_HAS_DEVMON
+# ifdef _WIN32
+#  include <stdio.h>
+# else
+#  include <glob.h>
+# endif
+#endif
+
 #include "ingenialink/err.h"
+#include "ingenialink/base/servo.h"
 
 /*******************************************************************************
  * Internal
@@ -154,7 +165,7 @@ int il_servo_units_update(il_servo_t *servo)
 
 double il_servo_units_factor(il_servo_t *servo, const il_reg_t *reg)
 {
-	return servo->ops->units_factor(servo, reg);
+	return il_servo_base__units_factor(servo, reg);
 }
 
 il_units_torque_t il_servo_units_torque_get(il_servo_t *servo)
@@ -251,6 +262,12 @@ int il_servo_raw_read_float(il_servo_t *servo, const il_reg_t *reg,
 	return servo->ops->raw_read_float(servo, reg, id, buf);
 }
 
+int il_servo_raw_read_str(il_servo_t *servo, const il_reg_t *reg,
+			  const char *id, char *buf, size_t sz)
+{
+	return servo->ops->raw_read_str(servo, reg, id, buf, sz);
+}
+
 int il_servo_read(il_servo_t *servo, const il_reg_t *reg, const char *id,
 		  double *buf)
 {
@@ -311,12 +328,88 @@ int il_servo_raw_write_float(il_servo_t *servo, const il_reg_t *reg,
 	return servo->ops->raw_write_float(servo, reg, id, val, confirm);
 }
 
+int il_servo_raw_write_str(il_servo_t *servo, const il_reg_t *reg,
+			   const char *id, const char *val, int confirm)
+{
+	return servo->ops->raw_write_str(servo, reg, id, val, confirm);
+}
+
 int il_servo_write(il_servo_t *servo, const il_reg_t *reg, const char *id,
 		   double val, int confirm)
 {
 	return servo->ops->write(servo, reg, id, val, confirm);
 }
 
+int il_servo_read_async(il_servo_t *servo, const il_reg_t *reg, const char *id,
+			il_servo_async_cb_t cb, void *ctx)
+{
+	return servo->ops->read_async(servo, reg, id, cb, ctx);
+}
+
+int il_servo_write_async(il_servo_t *servo, const il_reg_t *reg,
+			 const char *id, double val, int confirm,
+			 il_servo_async_cb_t cb, void *ctx)
+{
+	return servo->ops->write_async(servo, reg, id, val, confirm, cb, ctx);
+}
+
+int il_servo_read_batch(il_servo_batch_t *batch, size_t cnt)
+{
+	if (cnt == 0)
+		return 0;
+
+	/* entries may span servos and networks, first entry dispatches */
+	return batch[0].servo->ops->read_batch(batch, cnt);
+}
+
+int il_servo_write_batch(il_servo_batch_t *batch, size_t cnt)
+{
+	if (cnt == 0)
+		return 0;
+
+	/* entries may span servos and networks, first entry dispatches */
+	return batch[0].servo->ops->write_batch(batch, cnt);
+}
+
+il_servo_reg_handle_t *il_servo_reg_bind(il_servo_t *servo,
+					 const il_reg_t *reg, const char *id)
+{
+	return servo->ops->reg_bind(servo, reg, id);
+}
+
+void il_servo_reg_unbind(il_servo_reg_handle_t *hnd)
+{
+	hnd->servo->ops->reg_unbind(hnd);
+}
+
+int il_servo_reg_read(il_servo_reg_handle_t *hnd, double *buf)
+{
+	return hnd->servo->ops->reg_read(hnd, buf);
+}
+
+int il_servo_reg_write(il_servo_reg_handle_t *hnd, double val, int confirm)
+{
+	return hnd->servo->ops->reg_write(hnd, val, confirm);
+}
+
+int il_servo_write_behind_enable(il_servo_t *servo, const il_reg_t *reg,
+				  const char *id)
+{
+	return servo->ops->write_behind_enable(servo, reg, id);
+}
+
+int il_servo_write_behind_disable(il_servo_t *servo, const il_reg_t *reg,
+				  const char *id)
+{
+	return servo->ops->write_behind_disable(servo, reg, id);
+}
+
+int il_servo_write_behind_stats_get(il_servo_t *servo, const il_reg_t *reg,
+				    const char *id, il_net_wb_stats_t *stats)
+{
+	return servo->ops->write_behind_stats_get(servo, reg, id, stats);
+}
+
 int il_servo_disable(il_servo_t *servo)
 {
 	return servo->ops->disable(servo);
@@ -429,40 +522,140 @@ int il_servo_wait_reached(il_servo_t *servo, int timeout)
 int il_servo_lucky(il_net_prot_t prot, il_net_t **net, il_servo_t **servo,
 		   const char *dict)
 {
-	il_net_dev_list_t *devs, *dev;
-	il_net_servos_list_t *servo_ids, *servo_id;
+	il_net_discovery_list_t *nodes, *node;
+
+	*net = NULL;
 
-	/* scan all available network devices */
-	devs = il_net_dev_list_get(prot);
-	il_net_dev_list_foreach(dev, devs) {
+	/* probe all available network devices at once */
+	nodes = il_net_discovery_list_get(prot, NULL, NULL);
+	il_net_discovery_list_foreach(node, nodes) {
 		il_net_opts_t opts;
 
-		opts.port = dev->port;
-		opts.timeout_rd = IL_NET_TIMEOUT_RD_DEF;
-		opts.timeout_wr = IL_NET_TIMEOUT_WR_DEF;
+		/* (re)create network when moving to another device */
+		if (*net && (strcmp(il_net_port_get(*net), node->port) != 0)) {
+			il_net_destroy(*net);
+			*net = NULL;
+		}
 
-		*net = il_net_create(prot, &opts);
-		if (!*net)
-			continue;
+		if (!*net) {
+			il_net_opts_init(&opts);
+			opts.port = node->port;
+
+			*net = il_net_create(prot, &opts);
+			if (!*net)
+				continue;
+		}
 
-		/* try to connect to any available servo */
-		servo_ids = il_net_servos_list_get(*net, NULL, NULL);
-		il_net_servos_list_foreach(servo_id, servo_ids) {
-			*servo = il_servo_create(*net, servo_id->id, dict);
-			/* found */
-			if (*servo) {
-				il_net_servos_list_destroy(servo_ids);
-				il_net_dev_list_destroy(devs);
+		/* try to connect to the servo */
+		*servo = il_servo_create(*net, node->id, dict);
+		/* found */
+		if (*servo) {
+			il_net_discovery_list_destroy(nodes);
 
-				return 0;
-			}
+			return 0;
 		}
+	}
 
-		il_net_servos_list_destroy(servo_ids);
+	if (*net)
 		il_net_destroy(*net);
+
+	il_net_discovery_list_destroy(nodes);
+
+	ilerr__set("No connected servos found");
+	return IL_EFAIL;
+}
+
+#else
+
+#ifndef _WIN32
+/** Well-known serial port names (probed without device monitoring). */
+static const char *const lucky_ports[] = {
+	"/dev/ttyACM*", "/dev/ttyUSB*", "/dev/cu.usbmodem*"
+};
+#endif
+
+/**
+ * Try to connect to the first available servo on a port.
+ *
+ * @param [in] prot
+ *	Network protocol.
+ * @param [in] port
+ *	Port.
+ * @param [out] net
+ *	Where the servo network will be stored.
+ * @param [out] servo
+ *	Where the first available servo will be stored.
+ * @param [in] dict
+ *	Dictionary (optional).
+ *
+ * @return
+ *	0 if a servo is found, IL_EFAIL otherwise.
+ */
+static int lucky_probe(il_net_prot_t prot, const char *port, il_net_t **net,
+		       il_servo_t **servo, const char *dict)
+{
+	il_net_opts_t opts;
+	il_net_servos_list_t *servo_ids, *servo_id;
+
+	il_net_opts_init(&opts);
+	opts.port = port;
+
+	*net = il_net_create(prot, &opts);
+	if (!*net)
+		return IL_EFAIL;
+
+	/* try to connect to any available servo */
+	servo_ids = il_net_servos_list_get(*net, NULL, NULL);
+	il_net_servos_list_foreach(servo_id, servo_ids) {
+		*servo = il_servo_create(*net, servo_id->id, dict);
+		/* found */
+		if (*servo) {
+			il_net_servos_list_destroy(servo_ids);
+			return 0;
+		}
+	}
+
+	il_net_servos_list_destroy(servo_ids);
+	il_net_destroy(*net);
+	*net = NULL;
+
+	return IL_EFAIL;
+}
+
+int il_servo_lucky(il_net_prot_t prot, il_net_t **net, il_servo_t **servo,
+		   const char *dict)
+{
+#ifdef _WIN32
+	int i;
+	char port[LUCKY_PORT_SZ];
+
+	/* probe the well-known serial port names */
+	for (i = 1; i <= LUCKY_COM_MAX; i++) {
+		(void)snprintf(port, sizeof(port), "COM%d", i);
+		if (lucky_probe(prot, port, net, servo, dict) == 0)
+			return 0;
 	}
+#else
+	size_t i, j;
+
+	/* probe the ports matching the well-known serial port names */
+	for (i = 0; i < ARRAY_SIZE(lucky_ports); i++) {
+		glob_t ports;
 
-	il_net_dev_list_destroy(devs);
+		if (glob(lucky_ports[i], 0, NULL, &ports) != 0)
+			continue;
+
+		for (j = 0; j < ports.gl_pathc; j++) {
+			if (lucky_probe(prot, ports.gl_pathv[j], net, servo,
+					dict) == 0) {
+				globfree(&ports);
+				return 0;
+			}
+		}
+
+		globfree(&ports);
+	}
+#endif
 
 	ilerr__set("No connected servos found");
 	return IL_EFAIL;
@@ -36,17 +36,20 @@
 /** State external subscribers default array size. */
 #define STATE_SUBS_SZ_DEF	10
 
-/** State external subscribers period timeout (ms). */
-#define STATE_SUBS_TIMEOUT	100
-
-/** Emergencies queue size. */
-#define EMCY_QUEUE_SZ		4
-
 /** Emergency external subscribers default array size. */
 #define EMCY_SUBS_SZ_DEF	10
 
-/** Emergency external subscribers monitor period timeout (ms). */
-#define EMCY_SUBS_TIMEOUT	100
+/** Highest COM port probed without device monitoring (Windows). */
+#define LUCKY_COM_MAX		32
+
+/** Probed port name size (Windows). */
+#define LUCKY_PORT_SZ		16
+
+/** PDS default timeout (ms). */
+#define PDS_TIMEOUT		1000
+
+/** Units factors table size (one per physical units type). */
+#define UNITS_FACTORS_SZ	(IL_REG_PHY_RAD + 1)
 
 /** Servo units. */
 typedef struct {
@@ -60,6 +63,11 @@ typedef struct {
 	il_units_vel_t vel;
 	/** Acceleration. */
 	il_units_acc_t acc;
+	/**
+	 * Conversion factors, indexed by physical units type (stored as
+	 * double bit patterns, loaded atomically without locking).
+	 */
+	volatile uint64_t factors[UNITS_FACTORS_SZ];
 } il_servo_units_t;
 
 /** Servo configuration. */
@@ -92,30 +100,26 @@ typedef struct {
 	size_t sz;
 	/** Lock. */
 	osal_mutex_t *lock;
-	/** Monitor. */
-	osal_thread_t *monitor;
-	/** Monitor stop flag. */
-	int stop;
 } il_servo_emcy_subscriber_lst_t;
 
 /** Emergencies subcription. */
 typedef struct {
-	/** Queue head. */
-	size_t head;
-	/** Queue tail. */
-	size_t tail;
-	/** Queue size. */
-	size_t sz;
-	/** Queue. */
-	uint32_t queue[EMCY_QUEUE_SZ];
-	/** Lock. */
-	osal_mutex_t *lock;
-	/** Not empty condition. */
-	osal_cond_t *not_empty;
 	/** Assigned subscription slot. */
 	int slot;
 } il_servo_emcy_t;
 
+/** Asynchronous transfer context. */
+typedef struct {
+	/** Servo. */
+	il_servo_t *servo;
+	/** Register. */
+	const il_reg_t *reg;
+	/** Completion callback. */
+	il_servo_async_cb_t cb;
+	/** Completion callback context. */
+	void *ctx;
+} il_servo_async_t;
+
 /** State update subscriber. */
 typedef struct {
 	/** Callback. */
@@ -132,10 +136,6 @@ typedef struct {
 	size_t sz;
 	/** Lock. */
 	osal_mutex_t *lock;
-	/** Monitor. */
-	osal_thread_t *monitor;
-	/** Monitor stop flag. */
-	int stop;
 } il_servo_state_subscriber_lst_t;
 
 /** Statusword updates subcription. */
@@ -150,6 +150,67 @@ typedef struct {
 	int slot;
 } il_servo_sw_t;
 
+/**
+ * Power drive system (PDS) registers.
+ *
+ * @note
+ *	Registers are either pre-defined or resolved by ID from the dictionary
+ *	on use. If the controlword is not available PDS commands fail with
+ *	IL_ENOTSUP.
+ */
+typedef struct {
+	/** Controlword register (pre-defined, NULL to use ID). */
+	const il_reg_t *cw;
+	/** Controlword register ID (NULL if not available). */
+	const char *cw_id;
+	/**
+	 * Statusword register (pre-defined, NULL to use ID), read after each
+	 * command on networks where updates are not pushed.
+	 */
+	const il_reg_t *sw;
+	/** Statusword register ID (NULL if not read after commands). */
+	const char *sw_id;
+	/** Statusword bits that must also be set in the enabled state. */
+	uint16_t enabled_msk;
+} il_servo_pds_t;
+
+/** Register value (host byte order). */
+typedef union {
+	/** Unsigned 8-bit value. */
+	uint8_t u8;
+	/** Signed 8-bit value. */
+	int8_t s8;
+	/** Unsigned 16-bit value. */
+	uint16_t u16;
+	/** Signed 16-bit value. */
+	int16_t s16;
+	/** Unsigned 32-bit value. */
+	uint32_t u32;
+	/** Signed 32-bit value. */
+	int32_t s32;
+	/** Unsigned 64-bit value. */
+	uint64_t u64;
+	/** Signed 64-bit value. */
+	int64_t s64;
+	/** Float value. */
+	float flt;
+} il_servo_reg_value_t;
+
+/** Register handle. */
+struct il_servo_reg_handle {
+	/** Servo. */
+	il_servo_t *servo;
+	/** Register (validated copy). */
+	il_reg_t reg;
+	/** Register data size. */
+	size_t sz;
+	/**
+	 * Units factor (entry of the servo units factors table, NULL if the
+	 * register has no units).
+	 */
+	volatile uint64_t *factor;
+};
+
 /** IngeniaLink servo. */
 struct il_servo {
 	/** Associated IngeniaLink network. */
@@ -166,12 +227,19 @@ struct il_servo {
 	il_servo_mode_t mode;
 	/** Statusword subscription. */
 	il_servo_sw_t sw;
+	/** PDS registers. */
+	il_servo_pds_t pds;
 	/** External state change subscriptors. */
 	il_servo_state_subscriber_lst_t state_subs;
 	/** Emergency subscription. */
 	il_servo_emcy_t emcy;
 	/** External emergency subscriptors. */
 	il_servo_emcy_subscriber_lst_t emcy_subs;
+	/**
+	 * Set while notifying subscribers (events context), flags the servo
+	 * as destroyed from one of the callbacks.
+	 */
+	int *destroyed;
 	/** Operations. */
 	const il_servo_ops_t *ops;
 };
@@ -89,3 +89,24 @@ void il_utils__refcnt_release(il_utils_refcnt_t *refcnt)
 		il_utils__refcnt_destroy(refcnt);
 	}
 }
+
+size_t il_utils__reg_sz(il_reg_dtype_t dtype)
+{
+	switch (dtype) {
+	case IL_REG_DTYPE_U8:
+	case IL_REG_DTYPE_S8:
+		return 1;
+	case IL_REG_DTYPE_U16:
+	case IL_REG_DTYPE_S16:
+		return 2;
+	case IL_REG_DTYPE_U32:
+	case IL_REG_DTYPE_S32:
+	case IL_REG_DTYPE_FLOAT:
+		return 4;
+	case IL_REG_DTYPE_U64:
+	case IL_REG_DTYPE_S64:
+		return 8;
+	default:
+		return 0;
+	}
+}
@@ -128,3 +128,8 @@ void osal_clock_sleep_ms(int ms)
 	usleep(ms * 1000);
 }
 
+void osal_clock_sleep_us(int us)
+{
+	usleep(us);
+}
+
@@ -99,3 +99,9 @@ void osal_clock_sleep_ms(int ms)
 	Sleep(ms);
 }
 
+void osal_clock_sleep_us(int us)
+{
+	/* no sub-millisecond sleep available, round up */
+	Sleep((us + 999) / 1000);
+}
+